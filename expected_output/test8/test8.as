@@ -0,0 +1,7 @@
+.extern AAA
+.extern BBB
+.extern CCC
+MAIN:	jmp AAA
+	jmp BBB
+	jmp CCC
+	hlt
@@ -0,0 +1,4 @@
+Z:	mov r1, r2
+.extern Z
+	jmp Z
+	hlt
@@ -0,0 +1,7 @@
+; a macro that calls itself
+mcr m_loop
+	inc r1
+	m_loop
+endmcr
+	m_loop
+	hlt
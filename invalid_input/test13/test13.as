@@ -0,0 +1,7 @@
+; calls with a wrong number of arguments
+mcr m_move src, dst
+	mov src, dst
+endmcr
+	m_move #3
+	m_move #3, r1, r2
+	hlt
@@ -0,0 +1,66 @@
+; each macro calls the one before it four times
+mcr m0 x
+	inc x
+endmcr
+mcr m1 x
+	m0 x
+	m0 x
+	m0 x
+	m0 x
+endmcr
+mcr m2 x
+	m1 x
+	m1 x
+	m1 x
+	m1 x
+endmcr
+mcr m3 x
+	m2 x
+	m2 x
+	m2 x
+	m2 x
+endmcr
+mcr m4 x
+	m3 x
+	m3 x
+	m3 x
+	m3 x
+endmcr
+mcr m5 x
+	m4 x
+	m4 x
+	m4 x
+	m4 x
+endmcr
+mcr m6 x
+	m5 x
+	m5 x
+	m5 x
+	m5 x
+endmcr
+mcr m7 x
+	m6 x
+	m6 x
+	m6 x
+	m6 x
+endmcr
+mcr m8 x
+	m7 x
+	m7 x
+	m7 x
+	m7 x
+endmcr
+mcr m9 x
+	m8 x
+	m8 x
+	m8 x
+	m8 x
+endmcr
+mcr m10 x
+	m9 x
+	m9 x
+	m9 x
+	m9 x
+endmcr
+	m10 r1
+	hlt
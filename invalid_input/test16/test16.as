@@ -0,0 +1,9 @@
+; invalid constant expressions
+.define A = 4000*4000*4000
+.define B = 1/0
+.define C = (1+2
+.define D = 2047+1
+.define E = 1<<40
+.define F = 5%0
+MAIN:	prn #1+
+	hlt
@@ -28,9 +28,27 @@
  * @param assembler_data A pointer to the assembler data structure.
  * @param input_file     The input file to be processed.
  * @param macro_table    The macro table containing macro definitions.
+ * @param macro_calls    The expansions of the macros (macro_call_t) in the input file, or NULL. The lines of an
+ *                       expansion are instantiated from the parsed lines of the previous expansions, and the
+ *                       queue is emptied.
  * @return               Returns 0 on success, or a non-zero value on failure.
  */
-int assembler_first_pass(assembler_data_t *assembler_data, FILE *input_file, HashTable *macro_table);
+int assembler_first_pass(assembler_data_t *assembler_data, FILE *input_file, HashTable *macro_table, Queue *macro_calls);
+
+/* Reads the next line of a source into line, like fgets. Returns NULL at the end of the source. */
+typedef char *(*first_pass_line_reader)(char *line, int size, void *source);
+
+/**
+ * Performs the first pass of the assembler on a source that is not a stream, like assembler_first_pass.
+ *
+ * @param assembler_data A pointer to the assembler data structure.
+ * @param read_line      Reads the lines of the source, it must split them exactly like fgets.
+ * @param source         Passed to every call of read_line.
+ * @param macro_table    The macro table containing macro definitions.
+ * @param macro_calls    The expansions of the macros in the source, or NULL, see assembler_first_pass.
+ * @return               Returns 0 on success, or a non-zero value on failure.
+ */
+int assembler_first_pass_lines(assembler_data_t *assembler_data, first_pass_line_reader read_line, void *source, HashTable *macro_table, Queue *macro_calls);
 
 
 /**
@@ -75,6 +93,27 @@ int free_assembler_data(assembler_data_t *assembler_data);
 void clear_assembler_data(assembler_data_t *assembler_data);
 
 
+/**
+ * Returns the memory the structures of the current file take: the context itself, the symbols,
+ * the parsed instruction lines kept in memory, the extern uses and the errors and warnings.
+ *
+ * @param assembler_data The pointer to the assembler data structure.
+ * @return The number of bytes.
+ */
+size_t get_assembler_data_memory_size(const assembler_data_t *assembler_data);
+
+
+/**
+ * Checks the memory budget of the current file after a line, when it has a budget: spills the
+ * parsed instruction lines that are over their share, and records the memory in use.
+ * The first time the file is over its budget an error is added.
+ *
+ * @param assembler_data The pointer to the assembler data structure.
+ * @return SUCCESS, USER_ERR if the file is over its budget, or FUNC_ERR if spilling failed.
+ */
+int check_memory_budget(assembler_data_t *assembler_data);
+
+
 /**
  * Initializes the action into binary map.
  * This function performs the initialization of the action into binary map.
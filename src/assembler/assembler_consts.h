@@ -21,6 +21,7 @@
 #define COMMENT_LINE_PREFIX (';')
 #define LABEL_POSTFIX (':')
 #define COMMA (',')
+#define EXPRESSION_OPERATORS ("+-*/%<>&|()") /* the characters that make an operand a constant expression */
 
 #define IC_INITIAL_VALUE (100)
 #define MAX_RESERVED_SYMBOL_NAME (5)
@@ -30,5 +31,7 @@
 #define INVALID (-1)
 #define END_OF_LINE (-1)
 #define MAX_NUM_OPERAND (2)
+#define MAX_EXPRESSION_VALUE (1073741824L) /* bound of the intermediate values of a constant expression */
+#define MAX_SHIFT_COUNT (30)
 
 #endif /* ASSEMBLER_CONST_H */
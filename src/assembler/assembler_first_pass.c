@@ -15,13 +15,17 @@
 
 #include "../logger/logger.h"
 #include "../general_const/general_const.h"
+#include "../stats/stats.h"
 
 #include "../hash_table/hash_table.h"
 #include "../string_vector/string_vector.h"
+#include "../pre_processor/preprocessor.h"
 
 /* =========================== internal functions declarations ================== */
 void _free_data(void *ptr);
 void _do_nothing(void *prt);
+line_template_t *_get_line_template(Queue *macro_calls, macro_call_t **macro_call, int line_count, const char *line);
+char *_read_file_line(char *line, int size, void *input_file);
 
 
 /* =========================== internal functions implementations ================= */
@@ -39,6 +43,44 @@ void _do_nothing(void *ptr)
 	return;
 }
 
+line_template_t *_get_line_template(Queue *macro_calls, macro_call_t **macro_call, int line_count, const char *line)
+{
+	int line_index = 0;
+
+	if (macro_calls == NULL)
+	{
+		return NULL;
+	}
+	/* the expansions are in the order of the lines, drop the ones that already ended */
+	while (*macro_call == NULL ||
+		   line_count >= (*macro_call)->first_line + string_vector_get_size((*macro_call)->macro->macro_content))
+	{
+		free(*macro_call);
+		*macro_call = (macro_call_t *)queue_dequeue(macro_calls);
+		if (*macro_call == NULL)
+		{
+			return NULL;
+		}
+	}
+	if (line_count < (*macro_call)->first_line)
+	{
+		return NULL;
+	}
+
+	line_index = line_count - (*macro_call)->first_line;
+	/* a line that was split because it is too long doesn't match the content of the macro */
+	if (strcmp(line, string_vector_at((*macro_call)->macro->macro_content, line_index)) != 0)
+	{
+		return NULL;
+	}
+	return &(*macro_call)->macro->line_templates[line_index];
+}
+
+char *_read_file_line(char *line, int size, void *input_file)
+{
+	return fgets(line, size, (FILE *)input_file);
+}
+
 /*=============================================================================== */
 
 assembler_data_t *init_assembler_data(int should_allocate_memory)
@@ -47,16 +89,18 @@ assembler_data_t *init_assembler_data(int should_allocate_memory)
 
 	LOG(INFO, PARAMS, "initializing assembler data \n");
 
-	assembler_data = (assembler_data_t *)malloc(sizeof(assembler_data_t));
+	assembler_data = (assembler_data_t *)stats_malloc(sizeof(assembler_data_t));
 	memset(assembler_data, 0, sizeof(assembler_data_t));
 	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(assembler_data, "Memory allocation for the assembler_data failed", NULL);
 
-	assembler_data->IC = 100;
+	assembler_data->IC = IC_INITIAL_VALUE;
 	assembler_data->DC = 0;
 
 	init_line_handlers_arr(assembler_data);
 	assembler_data->symbol_table = hash_table_init();
 	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(assembler_data->symbol_table, "Initialization of symbol_table failed", NULL);
+	assembler_data->labels = intern_pool_create();
+	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(assembler_data->labels, "Initialization of labels failed", NULL);
 
 	/*initializing action_into_binary_map */
 	if (init_action_into_binary_map(assembler_data) != SUCCESS)
@@ -78,12 +122,12 @@ assembler_data_t *init_assembler_data(int should_allocate_memory)
 	}
 
 	/*initializing parsed_instruction_lines */
-	assembler_data->parsed_instruction_lines = queue_create();
+	assembler_data->parsed_instruction_lines = deque_create();
 	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(assembler_data->parsed_instruction_lines, "Initialization of parsed_instruction_lines failed", NULL);
 
-	/*initializing extern_symbols */
-	assembler_data->extern_symbols = queue_create();
-	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(assembler_data->extern_symbols, "Initialization of extern_symbols failed", NULL);
+	/*initializing entry_symbols */
+	assembler_data->entry_symbols = deque_create();
+	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(assembler_data->entry_symbols, "Initialization of entry_symbols failed", NULL);
 
 	/*initializing line_count */
 	assembler_data->line_count = 1;
@@ -98,11 +142,11 @@ int init_action_into_binary_map(assembler_data_t *assembler_data)
 	int i = 0;
 
 	assembler_data->action_into_binary_map = hash_table_init();
-	if (assembler_data->action_into_binary_map == NULL)
+	if (assembler_data->action_into_binary_map == NULL || hash_table_reserve(assembler_data->action_into_binary_map, NUM_INSTRUCTIONS) != SUCCESS)
 	{
 		return ERR;
 	}
-	assembler_data->instruction_code_arr = (int *)malloc(NUM_INSTRUCTIONS * sizeof(int));
+	assembler_data->instruction_code_arr = (int *)stats_malloc(NUM_INSTRUCTIONS * sizeof(int));
 	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(assembler_data->instruction_code_arr, "Memory allocation for array failed at init_action_into_binary_map", ERR);
 
 	for (i = 0; i < NUM_INSTRUCTIONS; i++)
@@ -132,12 +176,18 @@ int free_assembler_data(assembler_data_t *assembler_data)
 	free(assembler_data->instruction_code_arr);
 	hash_table_free(assembler_data->action_into_binary_map, _do_nothing);
 	hash_table_free(assembler_data->symbol_table, _free_data);
+	intern_pool_free(assembler_data->labels); /* after the symbol table, its keys are in the pool */
 
 	string_vector_free(assembler_data->warning_founds);
 	string_vector_free(assembler_data->error_founds);
 
-	queue_destroy(assembler_data->parsed_instruction_lines, _free_data);
-	queue_destroy(assembler_data->extern_symbols, _free_data);
+	deque_destroy(assembler_data->parsed_instruction_lines, _free_data);
+	free_extern_uses(&assembler_data->extern_uses);
+	deque_destroy(assembler_data->entry_symbols, NULL);
+	if (assembler_data->spilled_lines != NULL)
+	{
+		fclose(assembler_data->spilled_lines);
+	}
 
 	free(assembler_data);
 
@@ -152,32 +202,112 @@ void clear_assembler_data(assembler_data_t *assembler_data)
 		return;
 	}
 	hash_table_clear(assembler_data->symbol_table, _free_data);
+	intern_pool_clear(assembler_data->labels);
 	string_vector_clear(assembler_data->error_founds);
 	string_vector_clear(assembler_data->warning_founds);
-	queue_clear(assembler_data->parsed_instruction_lines, _free_data);
-	queue_clear(assembler_data->extern_symbols, _free_data);
-
-	assembler_data->IC = 0; /* (instruction counter) */
+	deque_clear(assembler_data->parsed_instruction_lines, _free_data);
+	clear_extern_uses(&assembler_data->extern_uses);
+	deque_clear(assembler_data->entry_symbols, NULL);
+	if (assembler_data->spilled_lines != NULL)
+	{
+		fclose(assembler_data->spilled_lines);
+		assembler_data->spilled_lines = NULL;
+	}
+	assembler_data->num_spilled_lines = 0;
+	assembler_data->num_read_spilled_lines = 0;
+	memory_budget_begin_file(&assembler_data->memory_budget);
+
+	/* reset to the values init_assembler_data sets, so a reused assembler_data behaves like a new one.
+	 * The encoding of a register operand adds its bits to the word, so the words must be zero again */
+	memset(assembler_data->machine_binary_code, 0, sizeof(assembler_data->machine_binary_code));
+	memset(assembler_data->data_memory, 0, sizeof(assembler_data->data_memory));
+	assembler_data->IC = IC_INITIAL_VALUE; /* (instruction counter) */
 	assembler_data->DC = 0; /* (data counter) */
 	assembler_data->line_count = 1;
+	assembler_data->has_entry = FALSE;
+	assembler_data->is_first_operand_register = FALSE;
+	assembler_data->num_defines = 0;
 }
 
-int assembler_first_pass(assembler_data_t *assembler_data, FILE *input_file, HashTable *macro_table)
+size_t get_assembler_data_memory_size(const assembler_data_t *assembler_data)
+{
+	const HashTable *symbol_table = assembler_data->symbol_table;
+	size_t size = sizeof(assembler_data_t);
+
+	size += (symbol_table->capacity + symbol_table->old_capacity) * sizeof(HashNode *);
+	size += symbol_table->size * (sizeof(HashNode) + sizeof(symbol_t));
+	size += intern_pool_memory_size(assembler_data->labels);
+	size += deque_get_size(assembler_data->parsed_instruction_lines) * sizeof(instruction_line_t);
+	size += get_extern_uses_memory_size(&assembler_data->extern_uses);
+	size += deque_get_size(assembler_data->entry_symbols) * sizeof(symbol_t *);
+	size += string_vector_get_num_bytes(assembler_data->error_founds);
+	size += string_vector_get_num_bytes(assembler_data->warning_founds);
+	return size;
+}
+
+int check_memory_budget(assembler_data_t *assembler_data)
+{
+	memory_budget_t *memory_budget = &assembler_data->memory_budget;
+	char log_error[MAX_LINE_SIZE];
+	int was_exceeded = memory_budget->is_exceeded;
+
+	if (!memory_budget_is_limited(memory_budget))
+	{
+		return SUCCESS;
+	}
+	if (spill_parsed_instruction_lines(assembler_data) != SUCCESS)
+	{
+		return FUNC_ERR;
+	}
+	if (memory_budget_update(memory_budget, get_assembler_data_memory_size(assembler_data)))
+	{
+		return SUCCESS;
+	}
+	if (!was_exceeded)
+	{
+		sprintf(log_error, "memory budget of %lu bytes exceeded in line: %d, will not continue", (unsigned long)memory_budget->limit, assembler_data->line_count);
+		PUSH_ERROR_AND_LOG(log_error, assembler_data->error_founds);
+	}
+	return USER_ERR;
+}
+
+int assembler_first_pass(assembler_data_t *assembler_data, FILE *input_file, HashTable *macro_table, Queue *macro_calls)
+{
+	return assembler_first_pass_lines(assembler_data, _read_file_line, input_file, macro_table, macro_calls);
+}
+
+int assembler_first_pass_lines(assembler_data_t *assembler_data, first_pass_line_reader read_line, void *source, HashTable *macro_table, Queue *macro_calls)
 {
 	enum line_type line_type = 0;
 	int found_symbol = FALSE;
 	char line[MAX_LINE_SIZE];
 	char log_error[MAX_LINE_SIZE];
+	macro_call_t *macro_call = NULL;
+	line_template_t *line_template = NULL;
+	int budget_ret = SUCCESS;
 
 	memset(line, NEWLINE_CHARACTER, MAX_LINE_SIZE);
 
-	while (fgets(line, MAX_LINE_SIZE, input_file) != NULL)
+	while (budget_ret == SUCCESS && read_line(line, MAX_LINE_SIZE, source) != NULL)
 	{
 		if ( ERR == is_line_too_long(line, assembler_data->line_count, assembler_data->warning_founds))
 		{
 			return FUNC_ERR;
 		}
 
+		line_template = _get_line_template(macro_calls, &macro_call, assembler_data->line_count, line);
+		if (line_template != NULL && can_instantiate_line_template(line_template, assembler_data))
+		{
+			/* this line of the macro was already parsed at a previous expansion */
+			stats_add(STATS_COUNTER__LINE_EMPTY + line_template->line_type, 1);
+			stats_add(STATS_COUNTER__MACRO_LINES_REUSED, 1);
+			instantiate_line_template(line_template, assembler_data);
+			budget_ret = check_memory_budget(assembler_data);
+			assembler_data->line_count++;
+			memset(line, NEWLINE_CHARACTER, MAX_LINE_SIZE);
+			continue;
+		}
+
 		line_type = identify_line_type(line);
 
  		if (is_symbol(line))
@@ -185,21 +315,34 @@ int assembler_first_pass(assembler_data_t *assembler_data, FILE *input_file, Has
 			found_symbol = TRUE;
 		}
 		/* execute handler for line according to line_type */
-		if (line_type < MAX_LINE_TYPE)
+		if (line_type < MAX_LINE_TYPE && line_template != NULL && !found_symbol)
+		{
+			stats_add(STATS_COUNTER__LINE_EMPTY + line_type, 1);
+			handle_line_and_set_template(line, line_type, line_template, assembler_data, macro_table);
+		}
+		else if (line_type < MAX_LINE_TYPE)
 		{
+			stats_add(STATS_COUNTER__LINE_EMPTY + line_type, 1);
 			assembler_data->line_handlers_arr[line_type](line, assembler_data, found_symbol, macro_table);
 		}
 		else 
 		{
+			stats_add(STATS_COUNTER__LINE_UNKNOWN, 1);
 			sprintf(log_error, "line type was not identified in line: %d", assembler_data->line_count);
 			PUSH_ERROR_AND_LOG(log_error, assembler_data->error_founds);
 		}
 		found_symbol = FALSE;
+		budget_ret = check_memory_budget(assembler_data);
 		assembler_data->line_count++;
 		memset(line, NEWLINE_CHARACTER, MAX_LINE_SIZE);
 
 	}
 
+	free(macro_call);
+	if (budget_ret == FUNC_ERR)
+	{
+		return FUNC_ERR;
+	}
 	add_value_to_all_data_symbol(assembler_data);
 
 	if (string_vector_get_size(assembler_data->error_founds) > 0)
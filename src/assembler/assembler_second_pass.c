@@ -15,14 +15,14 @@
 #include "assembler_consts.h"
 #include "../logger/logger.h"
 #include "../general_const/general_const.h"
+#include "../stats/stats.h"
 #include "../hash_table/hash_table.h"
-#include "../dynamic_queue/dynamic_queue.h"
+#include "../chunked_deque/chunked_deque.h"
 #include "../assembler_helper/assembler_helper.h"
 
 
 /* --------------------- internal function declarations -------------------------*/
 void _validate_entry_value(const char *key, void *data, void *assembler_data);
-extern_user_t * _init_extern_user(const char *label_name, short address);
 int _build_rest_of_instruction_code(assembler_data_t *assembler_data, instruction_line_t *instruction_line);
 
 /*--------------------------------- internal function definitions -------------*/
@@ -47,15 +47,6 @@ void _validate_entry_value(const char *key, void *data, void *assembler_data)
 }
 
 
-extern_user_t * _init_extern_user(const char *label_name, short address)
-{
-	extern_user_t *extern_user = (extern_user_t *)malloc(sizeof(extern_user_t));
-	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(extern_user, "Memory allocation failed in _init_extern_user", NULL);
-
-	extern_user->address = address;
-	strcpy(extern_user->label_name, label_name);
-	return extern_user;
-}
 
 int _build_rest_of_instruction_code(assembler_data_t *assembler_data, instruction_line_t *instruction_line)
 {
@@ -70,8 +61,7 @@ int _build_rest_of_instruction_code(assembler_data_t *assembler_data, instructio
 
 	symbol_t *symbol;
 	char log_error[MAX_LINE_SIZE];
-	extern_user_t *extern_user;
-	char *label_name;
+	const char *label_name;
 
 	UNUSED(assembler_data);
 	UNUSED(instruction_line);
@@ -90,6 +80,7 @@ int _build_rest_of_instruction_code(assembler_data_t *assembler_data, instructio
 		{
 		case ADDRESSING__DIRECT:
 		{
+			/* the name is interned like the symbol names, so its symbol is matched by the pointer */
 			label_name = instruction_line->operand_data_arr[i].operand.name;
 			symbol = (symbol_t *)hash_table_lookup(assembler_data->symbol_table, label_name);
 			if (symbol == NULL)
@@ -105,10 +96,9 @@ int _build_rest_of_instruction_code(assembler_data_t *assembler_data, instructio
 			}
 
 			is_external = symbol->symbol_location == SYMBOL__EXTERN;
-			if (is_external && instruction_line->L != -1)
+			if (is_external && instruction_line->L != -1 && add_extern_use(assembler_data, symbol, curr_IC) != SUCCESS)
 			{
-				extern_user = _init_extern_user(label_name, curr_IC);
-				queue_enqueue(assembler_data->extern_symbols, extern_user);
+				return FUNC_ERR;
 			}
 			word = set_bits_short(word, is_external ? ARE_EXTERNAL : ARE_RELOCATABLE, 2, 0);
 
@@ -134,8 +124,10 @@ int _build_rest_of_instruction_code(assembler_data_t *assembler_data, instructio
 			is_external = symbol->symbol_location == SYMBOL__EXTERN;
 			if (is_external && instruction_line->L != -1)
 			{
-				extern_user = _init_extern_user(label_name, curr_IC);
-				queue_enqueue(assembler_data->extern_symbols, extern_user);
+				if (add_extern_use(assembler_data, symbol, curr_IC) != SUCCESS)
+				{
+					return FUNC_ERR;
+				}
 			}
 			else
 			{
@@ -171,7 +163,17 @@ int assembler_second_pass(assembler_data_t *assembler_data, FILE *input_file)
 	enum line_type line_type;
 	char line[MAX_LINE_SIZE];
 	instruction_line_t *instruction_line;
+	instruction_line_t spilled_line;
+	DequeIterator entry_iterator;
+	void *entry_symbol = NULL;
+	int budget_ret = SUCCESS;
+	int build_ret = SUCCESS;
 
+	if (assembler_data->memory_budget.is_exceeded)
+	{
+		/* the first pass stopped in the middle of the file, its error was already added */
+		return USER_ERR;
+	}
 	assembler_data->line_count = 1;
 	assembler_data->IC = IC_INITIAL_VALUE;
 
@@ -191,7 +193,7 @@ int assembler_second_pass(assembler_data_t *assembler_data, FILE *input_file)
 
 		if (line_type == LINE__INSTRUCTION)
 		{
-			instruction_line = (instruction_line_t *)queue_dequeue(assembler_data->parsed_instruction_lines);
+			instruction_line = next_parsed_instruction_line(assembler_data, &spilled_line);
 			if (instruction_line == NULL)
 			{
 				LOG(ERROR, PARAMS, "failed to dequeue instruction line");
@@ -199,22 +201,42 @@ int assembler_second_pass(assembler_data_t *assembler_data, FILE *input_file)
 			}
 			if (instruction_line->L == -1)
 			{
-				free(instruction_line);
+				if (instruction_line != &spilled_line)
+				{
+					free(instruction_line);
+				}
 				continue;
 			}
-			_build_rest_of_instruction_code(assembler_data, instruction_line);
+			build_ret = _build_rest_of_instruction_code(assembler_data, instruction_line);
 			assembler_data->IC += instruction_line->L;
 			
-			/* no need anymore for data inside instruction line */
-			free(instruction_line);
+			/* no need anymore for data inside instruction line, a spilled line is only a copy */
+			if (instruction_line != &spilled_line)
+			{
+				free(instruction_line);
+			}
+			if (build_ret == FUNC_ERR)
+			{
+				return FUNC_ERR;
+			}
+			budget_ret = check_memory_budget(assembler_data);
+			if (budget_ret != SUCCESS)
+			{
+				return budget_ret;
+			}
 		}
 		++assembler_data->line_count;
 		memset(line, NEWLINE_CHARACTER, MAX_LINE_SIZE);
 
 	}
-    hash_table_for_each(assembler_data->symbol_table, _validate_entry_value, assembler_data);
+	/* only the entry symbols are checked, in the order of their .entry lines */
+	deque_iterator_init(assembler_data->entry_symbols, &entry_iterator);
+	while (deque_iterator_next(&entry_iterator, &entry_symbol))
+	{
+		_validate_entry_value(((symbol_t *)entry_symbol)->symbol_name, entry_symbol, assembler_data);
+	}
 
-	if (!queue_is_empty(assembler_data->parsed_instruction_lines))
+	if (!deque_is_empty(assembler_data->parsed_instruction_lines))
 	{
 		LOG(ERROR, PARAMS, "parsed_instruction_lines is not empty even though we finished reading the file");
 		return FUNC_ERR;
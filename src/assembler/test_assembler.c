@@ -32,7 +32,7 @@ void test_wrong_input_1()
         return;
     }
 	printf("file opened successfully\n");
-    assembler_first_pass(assembler_data, input_file, macro_table);
+    assembler_first_pass(assembler_data, input_file, macro_table, NULL);
     assembler_second_pass(assembler_data, input_file);
 	
     free_assembler_data(assembler_data);
@@ -128,7 +128,7 @@ void simple_test_first_pass()
         printf("inputfile openning failed");
         return;
     }
-    assembler_first_pass(assembler_data, input_file, macro_table);
+    assembler_first_pass(assembler_data, input_file, macro_table, NULL);
 
     if (res == SUCCESS)
     {
@@ -156,7 +156,7 @@ void simple_test_first_pass_check_binary()
         printf("input file opening  failed");
         return;
     }
-    assembler_first_pass(assembler_data, input_file, macro_table);
+    assembler_first_pass(assembler_data, input_file, macro_table, NULL);
 
     /* MAIN:            mov     r3, LIST[sz] */
     res += _test_code_instruction_mem_val(assembler_data, 100, convert14BitBinaryToDecimal("00000000111000"));
@@ -241,7 +241,7 @@ void test_first_second_pass_check_binary()
         return;
     }
 	printf("file opened successfully\n");
-    assembler_first_pass(assembler_data, input_file, macro_table);
+    assembler_first_pass(assembler_data, input_file, macro_table, NULL);
 
     assembler_second_pass(assembler_data, input_file);
 
@@ -335,7 +335,7 @@ void test_first_second_pass_check_binary_2()
         return;
     }
 	printf("file opened successfully\n");
-    assembler_first_pass(assembler_data, input_file, macro_table);
+    assembler_first_pass(assembler_data, input_file, macro_table, NULL);
 
     assembler_second_pass(assembler_data, input_file);
 
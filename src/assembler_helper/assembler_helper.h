@@ -10,10 +10,15 @@
 #ifndef ASSEMBLER_HELPER_H
 #define ASSEMBLER_HELPER_H
 
+#include <stdio.h>
+
 #include "../hash_table/hash_table.h"
 #include "../string_vector/string_vector.h"
 #include "../assembler/assembler_consts.h"
 #include "../dynamic_queue/dynamic_queue.h"
+#include "../chunked_deque/chunked_deque.h"
+#include "../intern_pool/intern_pool.h"
+#include "../memory_budget/memory_budget.h"
 #include "../general_const/general_const.h"
 
 /* forward declaration for assembler_data_t*/
@@ -33,6 +38,31 @@ typedef enum line_type
 
 } line_type_t;
 
+/* the order of the lines of the .ent file (--ent-sort) */
+enum entry_order
+{
+	ENTRY_ORDER__DEFINITION, /* the order of the .entry lines */
+	ENTRY_ORDER__ADDRESS
+};
+
+/* one use of an extern symbol in the code */
+typedef struct extern_use
+{
+	int symbol_id; /* the index of the name of the symbol in extern_uses_t.names */
+	short address;
+} extern_use_t;
+
+/* the uses of the extern symbols of a file, as flat arrays that grow by doubling */
+typedef struct extern_uses
+{
+	extern_use_t *uses; /* in the order of the code, so by address */
+	size_t num_uses;
+	size_t uses_capacity;
+	const char **names; /* by symbol id, in the order of the first use of every symbol. The names belong to the labels pool */
+	int num_names;
+	int names_capacity;
+} extern_uses_t;
+
 /*======================================================================*/
 
 typedef struct assembler_data
@@ -48,24 +78,22 @@ typedef struct assembler_data
 	StringVector *warning_founds; /* vector for the warnings found in the given file */
 	short line_count; /* line counter */ 
 	line_handler line_handlers_arr[MAX_LINE_TYPE]; /* array of function pointers for handling different types of lines */
-	Queue *parsed_instruction_lines; /* queue for the parsed instruction lines */
-	Queue *extern_symbols; /* queue for the extern symbols */
+	ChunkedDeque *parsed_instruction_lines; /* deque for the parsed instruction lines */
+	extern_uses_t extern_uses; /* the uses of the extern symbols, for the .ext file */
+	int is_ext_grouped; /* TRUE to write every extern symbol once in the .ext file, followed by the addresses of its uses */
 	int has_entry; /* True if we found at least one entry label in the file*/
+	ChunkedDeque *entry_symbols; /* the symbol_t of every .entry, in the order of the .entry lines. The symbols belong to symbol_table */
+	enum entry_order entry_order; /* the order build_entry_file writes entry_symbols in */
 	int *instruction_code_arr; /* array for the instructions code */
+	short is_first_operand_register; /* True while encoding an instruction whose source operand is a register */
+	int num_defines; /* number of times a .define constant was added, a line template is valid only with the same number */
+	intern_pool_t *labels; /* one copy of the name of every symbol of the file */
+	memory_budget_t memory_budget; /* the memory budget of the file, see --memory-budget */
+	FILE *spilled_lines; /* the oldest parsed instruction lines, once they were over their share of the budget. NULL if there are none */
+	int num_spilled_lines; /* number of lines in spilled_lines */
+	int num_read_spilled_lines; /* number of lines of spilled_lines the second pass read */
 } assembler_data_t;
 
-/**
- * Calculates the number of words required for an instruction code.
- *
- * This function takes a pointer to an instruction_line struct and calculates the number of words
- * required to represent the instruction code. The calculation is based on the specific instruction
- * and its operands.
- *
- * @param instruction_line A pointer to the instruction_line struct representing the instruction.
- * @return The number of words required for the instruction code.
- */
-short calc_num_word_for_instruction_code(struct instruction_line *instruction_line);
-
 
 /**
  * Initializes the line handlers array.
@@ -100,11 +128,6 @@ int identify_line_type(char *line);
 
 /* ================================== symbol ===================== */
 
-typedef struct extern_user {
-	char label_name[MAX_LABEL_SIZE];
-	short address;
-} extern_user_t;
-
 enum symbol_location
 {
 	SYMBOL__ENTRY,
@@ -120,7 +143,7 @@ enum memory_type
 
 typedef struct symbol
 {
-	char symbol_name[MAX_LABEL_SIZE];
+	const char *symbol_name; /* interned in the labels pool of the file, it is also the key of the symbol in the symbol table */
 	short symbol_location;
 	short memory_type;
 /*  The size of num_elements is 6 bits.
@@ -129,6 +152,8 @@ typedef struct symbol
  	short num_elements;
 /* value of an address or const defined, which is max 12 bits. */
 	short symbol_value;
+/* 1 + the symbol id of an extern symbol in extern_uses once it was used, 0 before */
+	short extern_id;
 } symbol_t;
 
 /* ================================== directive_line ===================== */
@@ -148,21 +173,20 @@ enum directive_type
 
 typedef struct directive_line
 {
-	char label[MAX_LABEL_SIZE];
+	const char *label; /* interned in the labels pool, NULL when the line has no label */
 	int directive_type;
 	char *data_ptr; /* pointer to the actual data */
 	short num_elements;
 } directive_line_t;
 
 /* ================================== instruction_line ===================== */
-/* This two-dimensional array defines the valid addressing types for operands
- * in each instruction . 
- * A value of 1 indicates that the corresponding addressing type is valid, while a value
- * of 0 indicates that it is invalid.
- * The first four elements in each row represent the valid addressing types for the first operand,
- * and the last four elements represent the valid addressing types for the second operand. 
+/* This array defines the valid addressing types for operands in each instruction, as a bitmask.
+ * A set bit indicates that the corresponding addressing type is valid, while a clear bit
+ * indicates that it is invalid.
+ * The four low bits represent the valid addressing types for the first operand,
+ * and the four high bits represent the valid addressing types for the second operand.
  */
-extern const short valid_addressing_types_for_instructions[NUM_INSTRUCTIONS][MAX_POSSIBLE_ADDRESSING_TYPE_FOR_TWO_OPERANDS];
+extern const unsigned char valid_addressing_types_for_instructions[NUM_INSTRUCTIONS];
 
 /* This array represents the number of operands for each instruction, indexed by the instruction code.
  * Each element in the array corresponds to a specific instruction code (0-15), indicating the number of operands that instruction expects.
@@ -178,6 +202,19 @@ enum addressing_type
 	ADDRESSING__DATA_INDEX,
 	ADDRESSING__DIRECT_REGISTER
 };
+#define MAX_ADDRESSING_TYPE (ADDRESSING__DIRECT_REGISTER + 1) /* also the addressing type of a missing operand in instruction_encodings */
+
+/* everything the first word of an instruction depends on, precomputed */
+typedef struct instruction_encoding
+{
+	short first_word; /* the first word of the instruction, with its ARE bits clear */
+	char num_words; /* the number of words of the instruction (L) */
+} instruction_encoding_t;
+
+/* The encoding of every instruction, indexed by the instruction code and the addressing types
+ * of the source and the destination operands.
+ */
+extern const instruction_encoding_t instruction_encodings[NUM_INSTRUCTIONS][MAX_ADDRESSING_TYPE + 1][MAX_ADDRESSING_TYPE + 1];
 
 /* possible types for operand defined in instruction line*/
 typedef enum
@@ -191,7 +228,7 @@ typedef enum
 /* represents operand of type data index defined in instruction line*/
 typedef struct data_index
 {
-	char arr_name[MAX_LABEL_SIZE];
+	const char *arr_name; /* interned in the labels pool */
 	short arr_index;
 } data_index_t;
 
@@ -199,7 +236,7 @@ typedef struct data_index
 typedef union operand
 {
 	short number;
-	char name[MAX_LABEL_SIZE];
+	const char *name; /* interned in the labels pool */
 	data_index_t data_index;
 } operand_t;
 
@@ -214,13 +251,28 @@ typedef struct operand_data
 /* represents parsed data of instruction line */
 typedef struct instruction_line
 {
-	char label[MAX_LABEL_SIZE]; /* not always exists*/
+	const char *label; /* interned in the labels pool, NULL when the line has no label */
 	char instruction_name[INSTRUCTION_LENGTH + 1]; /* for example: mov, sub ..*/
 	short instruction_code; /* the code of the instruction  for example for mov: 0*/
 	operand_data_t operand_data_arr[MAX_NUM_OPERAND]; /* array of operands */
 	short L; /* num of words needed for the instruction line*/
 } instruction_line_t;
 
+/* ================================== line_template ===================== */
+/* The parsed form of a line of a macro content. The first pass parses a macro line at the first
+ * expansion of the macro, and instantiates the next expansions of the line from the template,
+ * so only what depends on the position of the line (IC, DC and line numbers) is computed again.
+ * Only lines without a label, that were parsed without errors or warnings, are kept. */
+typedef struct line_template
+{
+	int is_parsed; /* TRUE if the template can be instantiated */
+	short line_type;
+	int num_defines; /* the num_defines of assembler_data when the line was parsed, the constants values may be used by the line */
+	instruction_line_t instruction_line; /* for an instruction line */
+	short num_data_values; /* for a .data or .string line */
+	short data_values[MAX_LINE_SIZE];
+} line_template_t;
+
 /* ================================== const_define_line ===================== */
 /* format: define const_name = const_value_integer
 	example .define len = 4
@@ -238,6 +290,16 @@ int handle_comment_or_empty_line(const char *line, assembler_data_t *assembler_d
 int handle_directive_line(const char *line, assembler_data_t *assembler_data, short found_symbol, HashTable *macro_table);
 int handle_instruction_line(const char *line, assembler_data_t *assembler_data, short found_symbol, HashTable *macro_table);
 int handle_const_defined_line(const char *line, assembler_data_t *assembler_data, short found_symbol, HashTable *macro_table);
+int handle_parsed_instruction_line(assembler_data_t *assembler_data, instruction_line_t *instruction_line, int parse_ret_val, short found_symbol);
+
+/* line template functions declarations */
+int handle_line_and_set_template(const char *line, int line_type, line_template_t *line_template, assembler_data_t *assembler_data, HashTable *macro_table);
+int can_instantiate_line_template(const line_template_t *line_template, assembler_data_t *assembler_data);
+int instantiate_line_template(const line_template_t *line_template, assembler_data_t *assembler_data);
+
+/* parsed instruction lines spilling functions declarations */
+int spill_parsed_instruction_lines(assembler_data_t *assembler_data);
+instruction_line_t *next_parsed_instruction_line(assembler_data_t *assembler_data, instruction_line_t *spilled_line);
 
 /* line type identification functions declarations */
 int identify_comment_line(char *line);
@@ -249,8 +311,7 @@ int identify_instruction_line(char *line);
 /* instruction line helper functions declarations */
 int parse_instruction_line(const char *line, assembler_data_t *assembler_data, instruction_line_t **instruction_line, HashTable *macro_table);
 short get_IC_value(assembler_data_t *assembler_data);
-short calc_num_word_for_instruction_code(instruction_line_t *instruction_line);
-short build_first_word(instruction_line_t *instruction_line);
+const instruction_encoding_t *get_instruction_encoding(const instruction_line_t *instruction_line);
 short _get_sum_memory(assembler_data_t *assembler_data);
 void set_first_word(assembler_data_t *assembler_data, short i_mem_code, short instruction_code_first_word);
 short build_word_and_set_in_memory(assembler_data_t *assembler_data, instruction_line_t *instruction_line, short i_mem_code, short num_operand);
@@ -293,7 +354,12 @@ int set_directive_type_extern(char *line, char *directive_name, assembler_data_t
 /* const define handler */
 int parse_const_define_line(const char *line, HashTable *macro_table, assembler_data_t *assembler_data, const_define_line_t **const_define_line);
 
-/* symbol handler */
+/* expression handler */
+int is_const_expression(const char *text, int text_size);
+int evaluate_const_expression(const char *expression, int expression_size, HashTable *symbol_table, int *value, int line_count, StringVector *error_founds);
+
+/* symbol handler, the label_name of init_symbol_data and init_symbol_location_data must be interned in assembler_data->labels */
+int lookup_symbol_for_update(assembler_data_t *assembler_data, const char *label_name, symbol_t **symbol);
 void init_symbol_data(symbol_t *symbol, const char *label_name, enum memory_type memory_type, short symbol_value, short num_elements);
 void init_symbol_location_data(symbol_t *symbol, const char *label_name, enum symbol_location symbol_location);
 void update_symbol_data(symbol_t *symbol, const char *label_name, enum memory_type memory_type, short symbol_value, short num_elements);
@@ -304,6 +370,12 @@ void add_value_to_data_symbol(const char *key, void *data, void *IC);
 void add_value_to_all_data_symbol(assembler_data_t *assembler_data);
 int find_symbol_value(int *found_value , char *lookup_name, HashTable *symbol_table);
 
+/* extern uses functions declarations */
+int add_extern_use(assembler_data_t *assembler_data, symbol_t *symbol, short address);
+void clear_extern_uses(extern_uses_t *extern_uses);
+void free_extern_uses(extern_uses_t *extern_uses);
+size_t get_extern_uses_memory_size(const extern_uses_t *extern_uses);
+
 /*label_handler*/
 int handle_label(char **line, char *label_name , int line_type, HashTable *macro_table, assembler_data_t *assembler_data);
 
@@ -15,6 +15,7 @@
 #include "../utils/utils.h"
 #include "../logger/logger.h"
 #include "../general_const/general_const.h"
+#include "../stats/stats.h"
 #include "../hash_table/hash_table.h"
 #include "../string_vector/string_vector.h"
 
@@ -24,11 +25,12 @@ int parse_const_define_line(const char *line, HashTable *macro_table, assembler_
 	int i = 0;
 	int const_name_size = 0;
 	int const_value_size = 0;
+	int ret_val = SUCCESS;
 	char const_value_content[MAX_INTEGER_LENGTH + 1];
 	char log_error[MAX_LINE_SIZE];
 	char *line_runner = (char *)line;
 
-	*const_define_line = (const_define_line_t *)malloc(sizeof(const_define_line_t));
+	*const_define_line = (const_define_line_t *)stats_malloc(sizeof(const_define_line_t));
 	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(*const_define_line, "Memory allocation for const_define_line failed", FUNC_ERR);
 
 
@@ -80,7 +82,21 @@ int parse_const_define_line(const char *line, HashTable *macro_table, assembler_
 		PUSH_ERROR_AND_RETURN( log_error, USER_ERR, assembler_data->error_founds);
 	}
 
-	strcpy(const_value_content, line_runner);
+	/* in case the value is an expression, or another const. it is evaluated now and only the value is kept */
+	const_value_size = strcspn(line_runner, "\n");
+	while (const_value_size > 0 && isspace(line_runner[const_value_size - 1]))
+	{
+		--const_value_size;
+	}
+	if (is_const_expression(line_runner, const_value_size) || isalpha(*line_runner))
+	{
+		ret_val = evaluate_const_expression(line_runner, const_value_size, assembler_data->symbol_table, &(*const_define_line)->const_value,
+											assembler_data->line_count, assembler_data->error_founds);
+		return ret_val;
+	}
+	const_value_size = 0;
+
+	strncpy(const_value_content, line_runner, MAX_INTEGER_LENGTH);
 
 	if (*line_runner == '-') /*in case the const value is negative*/
 	{
@@ -15,8 +15,66 @@
 #include "../utils/utils.h"
 #include "../logger/logger.h"
 #include "../general_const/general_const.h"
+#include "../stats/stats.h"
 #include "../hash_table/hash_table.h"
 #include "../string_vector/string_vector.h"
+#include "../intern_pool/intern_pool.h"
+
+/* =========================== internal functions declarations ================== */
+int _try_data_array_fast_set(const char *line, assembler_data_t *assembler_data, int curr_DC);
+
+/* =========================== internal functions implementations ================= */
+
+int _try_data_array_fast_set(const char *line, assembler_data_t *assembler_data, int curr_DC)
+{
+	short *data_memory = assembler_data->data_memory + curr_DC;
+	const char *digits_end = NULL;
+	long value = 0;
+	int is_negative = FALSE;
+	int is_overflow = FALSE;
+
+	/* one pass over a list of plain numbers, anything else is left to data_array_validation_and_set */
+	for (;;)
+	{
+		while (IS_SPACE_CHAR(*line) && *line != NEWLINE_CHARACTER)
+		{
+			++line;
+		}
+		is_negative = *line == '-';
+		line += is_negative;
+		if (!IS_DIGIT_CHAR(*line))
+		{
+			return FALSE;
+		}
+		digits_end = scan_decimal_digits(line, MAX_EXPRESSION_VALUE, &value, &is_overflow);
+		if (is_overflow || digits_end - line + is_negative > MAX_INTEGER_LENGTH)
+		{
+			return FALSE;
+		}
+		line = digits_end;
+		value = is_negative ? -value : value;
+		if (value > MAX_INTEGER_VALUE || value < MIN_INTEGER_VALUE)
+		{
+			return FALSE;
+		}
+		*data_memory++ = value;
+
+		while (IS_SPACE_CHAR(*line) && *line != NEWLINE_CHARACTER)
+		{
+			++line;
+		}
+		if (*line == NEWLINE_CHARACTER)
+		{
+			return TRUE;
+		}
+		if (*line++ != COMMA)
+		{
+			return FALSE;
+		}
+	}
+}
+
+/*=============================================================================== */
 
 int find_directive_line_type_from_begin(const char *line)
 {
@@ -77,7 +135,6 @@ int find_directive_line_type(const char *line)
 
 int parse_and_set_directive_line(const char *line, assembler_data_t *assembler_data, HashTable *macro_table, directive_line_t **directive_line)
 {
-	int i = 0;
 	char directive_name[MAX_LABEL_SIZE];
 	int directive_name_size = 0;
 	char log_error[MAX_LINE_SIZE];
@@ -86,10 +143,11 @@ int parse_and_set_directive_line(const char *line, assembler_data_t *assembler_d
 	int ret_val;
 	int directive_type;
 
-	*directive_line = (directive_line_t *)malloc(sizeof(directive_line_t));
+	*directive_line = (directive_line_t *)stats_malloc(sizeof(directive_line_t));
 	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(*directive_line, "Memory allocation for directive_line failed", FUNC_ERR);
+	(*directive_line)->label = NULL;
 
-	while( isspace(*line_runner))/* skipping possible white spaces*/
+	while( IS_SPACE_CHAR(*line_runner))/* skipping possible white spaces*/
 	{
 		++line_runner;
 	}
@@ -102,17 +160,11 @@ int parse_and_set_directive_line(const char *line, assembler_data_t *assembler_d
 		{
 				return ret_val;
 		}
-		strcpy((*directive_line)->label, label_name);
-	}
-	else
-	{
-		(*directive_line)->label[0] = NULL_TERMINATOR;
+		(*directive_line)->label = intern_pool_intern(assembler_data->labels, label_name);
+		CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN((*directive_line)->label, "Interning a label failed", FUNC_ERR);
 	}
 
-	for (i = 0; !isspace(line_runner[i]); i++)
-	{
-		++directive_name_size;
-	}
+	directive_name_size = find_space_char(line_runner) - line_runner;
 	strncpy(directive_name, line_runner + 1, directive_name_size - 1); /* remove the char '.' from the name*/
 	directive_name[directive_name_size - 1] = NULL_TERMINATOR;
 
@@ -152,8 +204,9 @@ int parse_and_set_directive_line(const char *line, assembler_data_t *assembler_d
 
 int allocate_memory_and_set_data_for_str(assembler_data_t *assembler_data, directive_line_t *directive_line, const char *line)
 {
-	short curr_DC = assembler_data->DC;
-	short i = 0;
+	short *data_memory = assembler_data->data_memory + assembler_data->DC;
+	const char *data_ptr = directive_line->data_ptr;
+	const char *data_end = data_ptr + directive_line->num_elements - 1; /* the last element is the null terminator */
 
 	if (_get_sum_memory(assembler_data) + directive_line->num_elements >= MEMORY_SIZE)
 	{
@@ -161,13 +214,19 @@ int allocate_memory_and_set_data_for_str(assembler_data_t *assembler_data, direc
 		return USER_ERR;
 	}
 
-	for (i = 0; i < directive_line->num_elements - 1; ++i)
+	/* widening the chars into words, four at a time */
+	for (; data_end - data_ptr >= 4; data_ptr += 4, data_memory += 4)
 	{
-		assembler_data->data_memory[curr_DC] = directive_line->data_ptr[i];
-		++curr_DC;
-
+		data_memory[0] = data_ptr[0];
+		data_memory[1] = data_ptr[1];
+		data_memory[2] = data_ptr[2];
+		data_memory[3] = data_ptr[3];
+	}
+	while (data_ptr < data_end)
+	{
+		*data_memory++ = *data_ptr++;
 	}
-	assembler_data->data_memory[curr_DC] = NULL_TERMINATOR;
+	*data_memory = NULL_TERMINATOR;
 	assembler_data->DC += directive_line->num_elements;
 
 	return SUCCESS;
@@ -189,12 +248,21 @@ int data_array_validation_and_set(char *line, assembler_data_t *assembler_data,
 	char log_error[MAX_LINE_SIZE];
 	char potential_const_define[MAX_LABEL_SIZE];
 	int potential_const_define_size = 0;
-	char number_value[MAX_INTEGER_LENGTH];
+	long number_value = 0;
+	int is_overflow = FALSE;
 	int number_size = 0;
 	int num_to_save = 0;
 	short elements_counter = 0;
+	int element_size = 0;
+	int ret_val = SUCCESS;
 	int i = 0;
 
+	/* most .data lines are lists of plain numbers, only the other lines, and the lines with errors, are parsed below */
+	if (_try_data_array_fast_set(line, assembler_data, curr_DC))
+	{
+		return SUCCESS;
+	}
+
 	/* This loop runs as long as it doesn't reach the end of the line*/
 	for(elements_counter = 0 ; line[0] != NEWLINE_CHARACTER ; ++elements_counter)
 	{
@@ -214,11 +282,23 @@ int data_array_validation_and_set(char *line, assembler_data_t *assembler_data,
 			PUSH_ERROR_AND_RETURN(log_error, USER_ERR, assembler_data->error_founds);
 		}
 
+		element_size = strcspn(line, ",\n");
+		/* in case a member of the array is a constant expression */
+		if (is_const_expression(line, element_size))
+		{
+			ret_val = evaluate_const_expression(line, element_size, assembler_data->symbol_table, &num_to_save, assembler_data->line_count, assembler_data->error_founds);
+			if (ret_val != SUCCESS)
+			{
+				return ret_val;
+			}
+			line += element_size;
+		}
+
 		/* in case a member of the array is a const*/
-		if (isalpha(*line))
+		else if (IS_ALPHA_CHAR(*line))
 		{
 			strncpy(potential_const_define, line , MAX_LABEL_SIZE -1);
-			while(!isspace(*line) && (*line != COMMA))
+			while(!IS_SPACE_CHAR(*line) && (*line != COMMA))
 			{
 				++potential_const_define_size;
 				++line;
@@ -232,14 +312,14 @@ int data_array_validation_and_set(char *line, assembler_data_t *assembler_data,
 			}	
 		}
 
-		else if (isdigit(*line) || (*line) == '-')
+		else if (IS_DIGIT_CHAR(*line) || (*line) == '-')
 		{
-			while(isdigit(*line) || (*line) == '-')
+			while(IS_DIGIT_CHAR(*line) || (*line) == '-')
 			{
 				++number_size;
 				++line;
 			}
-			if(!isspace(*line) && (*line) != COMMA)
+			if(!IS_SPACE_CHAR(*line) && (*line) != COMMA)
 			{
 				sprintf(log_error, "invalid char for an array: '%c' found in line: %d", (*line) , assembler_data->line_count);
 				PUSH_ERROR_AND_RETURN(log_error, USER_ERR, assembler_data->error_founds);
@@ -249,10 +329,9 @@ int data_array_validation_and_set(char *line, assembler_data_t *assembler_data,
 				sprintf(log_error, "Number exceeds memory capacity. found in line: %d", assembler_data->line_count);
 				PUSH_ERROR_AND_RETURN(log_error, USER_ERR, assembler_data->error_founds);
 			}
-			/* line -= number_size;*/
-			strncpy(number_value, line - number_size , number_size);
-			number_value[number_size] = NULL_TERMINATOR;
-		    num_to_save = atoi(number_value);
+			/* parsing in place, the number is a '-' and digits */
+			scan_decimal_digits(line - number_size + (line[-number_size] == '-'), MAX_EXPRESSION_VALUE, &number_value, &is_overflow);
+			num_to_save = line[-number_size] == '-' ? -number_value : number_value;
 
 			if(num_to_save > MAX_INTEGER_VALUE||num_to_save < MIN_INTEGER_VALUE)
 			{
@@ -270,7 +349,7 @@ int data_array_validation_and_set(char *line, assembler_data_t *assembler_data,
 		assembler_data->data_memory[curr_DC] = num_to_save;
 		++curr_DC;
 		number_size = 0;
-		for(i = 0; isspace(line[i]) && line[i] !=  NEWLINE_CHARACTER ; i++);
+		for(i = 0; IS_SPACE_CHAR(line[i]) && line[i] !=  NEWLINE_CHARACTER ; i++);
 		line += i;
 	}
 	return SUCCESS;
@@ -279,13 +358,20 @@ int data_array_validation_and_set(char *line, assembler_data_t *assembler_data,
 
 void deal_with_more_than_two_quotation_marks(char *data_content, int *i, int *data_content_size)
 {
-	for (; data_content[*i] != NEWLINE_CHARACTER; (*i)++)
+	int last_quote = -1;
+	const char *line_end = find_char(data_content, NEWLINE_CHARACTER);
+	const char *quote = find_char(data_content, STRING_PREFIX_OR_POSTFIX);
+
+	/* the chars from *i up to the last quote of the line are a part of the string. The last quote is found
+	 * in one pass, instead of looking for a quote after each of the chars */
+	for (; quote < line_end; quote = find_char(quote + 1, STRING_PREFIX_OR_POSTFIX))
 	{
-		if (strchr(data_content + (*i), STRING_PREFIX_OR_POSTFIX) == NULL)
-		{
-			return;
-		}
-		(*data_content_size)++;
+		last_quote = quote - data_content;
+	}
+	if (*i <= last_quote)
+	{
+		*data_content_size += last_quote + 1 - *i;
+		*i = last_quote + 1;
 	}
 }
 
@@ -305,7 +391,7 @@ int set_directive_type_data(char *line, char *directive_name, assembler_data_t *
 	(*directive_line)->directive_type = DIR__DATA;
 	line += strlen(directive_name) + 1; 
 
-	for (i = 0; !isdigit(line[i]) && line[i] != NEWLINE_CHARACTER; i++);
+	for (i = 0; !IS_DIGIT_CHAR(line[i]) && line[i] != NEWLINE_CHARACTER; i++);
 
 	(*directive_line)->num_elements = count_commas(line) + 1;
 	(*directive_line)->data_ptr = line + i;
@@ -367,7 +453,7 @@ int set_directive_type_string(char *line, char *directive_name, assembler_data_t
 
 	for ( ; line[i] != NEWLINE_CHARACTER; i++)
 	{
-		if (!isspace(line[i]))
+		if (!IS_SPACE_CHAR(line[i]))
 		{
 			sprintf(log_error, "non whitespaces char after the string, found in line: %d", assembler_data->line_count);
 			PUSH_ERROR_AND_RETURN(log_error, USER_ERR, assembler_data->error_founds);
@@ -397,7 +483,7 @@ int set_directive_type_entry(char *line, char *directive_name, assembler_data_t
 		PUSH_ERROR_AND_RETURN(log_error, USER_ERR, assembler_data->error_founds);
 	}
 
-	if((*directive_line)->label[0] != NULL_TERMINATOR)
+	if((*directive_line)->label != NULL)
 	{
 		sprintf(log_warning, "line: %d Label detected in entry line",  assembler_data->line_count);
 		PUSH_WARNING(log_warning, assembler_data->warning_founds);
@@ -428,7 +514,7 @@ int set_directive_type_extern(char *line, char *directive_name, assembler_data_t
 		PUSH_ERROR_AND_RETURN(log_error, USER_ERR, assembler_data->error_founds);
 	}
 
-	if((*directive_line)->label[0] != NULL_TERMINATOR)
+	if((*directive_line)->label != NULL)
 	{
 		sprintf(log_warning, "Label detected in a directive extern line, line number: %d",  assembler_data->line_count);
 		PUSH_WARNING(log_warning, assembler_data->warning_founds);
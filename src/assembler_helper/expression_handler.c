@@ -0,0 +1,335 @@
+/* *******************************************************************
+ * Authors: Daniel Oren, Elisheva Cirota
+ *
+ * @file  expression_handler.c
+ * @brief This file contains the implementation of the constant expression evaluation.
+ *
+ * A constant expression is made of integers, .define constants, parentheses, unary + and -, and
+ * the binary operators * / % + - << >> & | with the precedence of C. It is evaluated once, when
+ * its line is parsed, and only the value is kept. The division and the remainder truncate
+ * toward zero, and >> is an arithmetic shift.
+ *********************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <ctype.h>
+
+#include "assembler_helper.h"
+#include "../logger/logger.h"
+#include "../general_const/general_const.h"
+#include "../hash_table/hash_table.h"
+#include "../string_vector/string_vector.h"
+
+typedef struct expression_parser
+{
+	const char *runner; /* the next character to parse */
+	const char *end; /* the end of the expression */
+	HashTable *symbol_table; /* the .define constants */
+	int line_count;
+	StringVector *error_founds;
+} expression_parser_t;
+
+/* =========================== internal functions declarations ================== */
+void _skip_expression_whitespace(expression_parser_t *parser);
+int _is_expression_operator(expression_parser_t *parser, const char *operator);
+int _check_expression_value(expression_parser_t *parser, long value);
+int _parse_primary(expression_parser_t *parser, long *value);
+int _parse_unary(expression_parser_t *parser, long *value);
+int _parse_multiplicative(expression_parser_t *parser, long *value);
+int _parse_additive(expression_parser_t *parser, long *value);
+int _parse_shift(expression_parser_t *parser, long *value);
+int _parse_and(expression_parser_t *parser, long *value);
+int _parse_or(expression_parser_t *parser, long *value);
+
+/* =========================== internal functions implementations ================= */
+
+void _skip_expression_whitespace(expression_parser_t *parser)
+{
+	while (parser->runner < parser->end && isspace(*parser->runner))
+	{
+		++parser->runner;
+	}
+}
+
+int _is_expression_operator(expression_parser_t *parser, const char *operator)
+{
+	int operator_size = strlen(operator);
+
+	_skip_expression_whitespace(parser);
+	if (parser->end - parser->runner < operator_size || strncmp(parser->runner, operator, operator_size) != 0)
+	{
+		return FALSE;
+	}
+	parser->runner += operator_size;
+	return TRUE;
+}
+
+int _check_expression_value(expression_parser_t *parser, long value)
+{
+	char log_error[MAX_LINE_SIZE];
+
+	if (value > MAX_EXPRESSION_VALUE || value < -MAX_EXPRESSION_VALUE)
+	{
+		sprintf(log_error, "expression value overflows. found in line: %d", parser->line_count);
+		PUSH_ERROR_AND_RETURN(log_error, USER_ERR, parser->error_founds);
+	}
+	return SUCCESS;
+}
+
+int _parse_primary(expression_parser_t *parser, long *value)
+{
+	char log_error[MAX_LINE_SIZE + MAX_LABEL_SIZE];
+	char const_name[MAX_LABEL_SIZE];
+	int const_value = 0;
+	int name_size = 0;
+	int ret = SUCCESS;
+
+	_skip_expression_whitespace(parser);
+	if (_is_expression_operator(parser, "("))
+	{
+		ret = _parse_or(parser, value);
+		if (ret == SUCCESS && !_is_expression_operator(parser, ")"))
+		{
+			sprintf(log_error, "missing ')' in expression. found in line: %d", parser->line_count);
+			PUSH_ERROR_AND_RETURN(log_error, USER_ERR, parser->error_founds);
+		}
+		return ret;
+	}
+	if (parser->runner < parser->end && isdigit(*parser->runner))
+	{
+		for (*value = 0; parser->runner < parser->end && isdigit(*parser->runner); ++parser->runner)
+		{
+			*value = *value * 10 + (*parser->runner - '0');
+			if ((ret = _check_expression_value(parser, *value)) != SUCCESS)
+			{
+				return ret;
+			}
+		}
+		return SUCCESS;
+	}
+	if (parser->runner < parser->end && isalpha(*parser->runner))
+	{
+		for (; parser->runner + name_size < parser->end && isalnum(parser->runner[name_size]); ++name_size)
+			;
+		if (name_size < MAX_LABEL_SIZE)
+		{
+			memcpy(const_name, parser->runner, name_size);
+			const_name[name_size] = NULL_TERMINATOR;
+			if (find_symbol_value(&const_value, const_name, parser->symbol_table) == SUCCESS)
+			{
+				parser->runner += name_size;
+				*value = const_value;
+				return SUCCESS;
+			}
+		}
+		sprintf(log_error, "invalid const name: %.*s. found in line: %d", name_size < MAX_LABEL_SIZE ? name_size : MAX_LABEL_SIZE - 1,
+				parser->runner, parser->line_count);
+		PUSH_ERROR_AND_RETURN(log_error, USER_ERR, parser->error_founds);
+	}
+	sprintf(log_error, "invalid expression. found in line: %d", parser->line_count);
+	PUSH_ERROR_AND_RETURN(log_error, USER_ERR, parser->error_founds);
+}
+
+int _parse_unary(expression_parser_t *parser, long *value)
+{
+	int ret = SUCCESS;
+
+	if (_is_expression_operator(parser, "-"))
+	{
+		ret = _parse_unary(parser, value);
+		*value = -*value;
+		return ret;
+	}
+	if (_is_expression_operator(parser, "+"))
+	{
+		return _parse_unary(parser, value);
+	}
+	return _parse_primary(parser, value);
+}
+
+int _parse_multiplicative(expression_parser_t *parser, long *value)
+{
+	char log_error[MAX_LINE_SIZE];
+	long right = 0;
+	long quotient = 0;
+	char operator = NULL_TERMINATOR;
+	int ret = _parse_unary(parser, value);
+
+	while (ret == SUCCESS)
+	{
+		if (_is_expression_operator(parser, "*"))
+		{
+			operator = '*';
+		}
+		else if (_is_expression_operator(parser, "/"))
+		{
+			operator = '/';
+		}
+		else if (_is_expression_operator(parser, "%"))
+		{
+			operator = '%';
+		}
+		else
+		{
+			break;
+		}
+		if ((ret = _parse_unary(parser, &right)) != SUCCESS)
+		{
+			break;
+		}
+		if (operator == '*')
+		{
+			/* both operands are bounded by MAX_EXPRESSION_VALUE, so the check doesn't overflow */
+			if (right != 0 && labs(*value) > MAX_EXPRESSION_VALUE / labs(right))
+			{
+				sprintf(log_error, "expression value overflows. found in line: %d", parser->line_count);
+				PUSH_ERROR_AND_RETURN(log_error, USER_ERR, parser->error_founds);
+			}
+			*value *= right;
+			continue;
+		}
+		if (right == 0)
+		{
+			sprintf(log_error, "division by zero in expression. found in line: %d", parser->line_count);
+			PUSH_ERROR_AND_RETURN(log_error, USER_ERR, parser->error_founds);
+		}
+		/* the division of negative numbers is implementation defined in C89, it is done on the absolute values */
+		quotient = labs(*value) / labs(right);
+		quotient = (*value < 0) != (right < 0) ? -quotient : quotient;
+		*value = operator == '/' ? quotient : *value - quotient * right;
+	}
+	return ret;
+}
+
+int _parse_additive(expression_parser_t *parser, long *value)
+{
+	long right = 0;
+	int is_minus = FALSE;
+	int ret = _parse_multiplicative(parser, value);
+
+	while (ret == SUCCESS && ((is_minus = _is_expression_operator(parser, "-")) || _is_expression_operator(parser, "+")))
+	{
+		ret = _parse_multiplicative(parser, &right);
+		if (ret == SUCCESS)
+		{
+			*value = is_minus ? *value - right : *value + right;
+			ret = _check_expression_value(parser, *value);
+		}
+	}
+	return ret;
+}
+
+int _parse_shift(expression_parser_t *parser, long *value)
+{
+	char log_error[MAX_LINE_SIZE];
+	long right = 0;
+	int is_left = FALSE;
+	int ret = _parse_additive(parser, value);
+
+	while (ret == SUCCESS && ((is_left = _is_expression_operator(parser, "<<")) || _is_expression_operator(parser, ">>")))
+	{
+		if ((ret = _parse_additive(parser, &right)) != SUCCESS)
+		{
+			break;
+		}
+		if (right < 0 || right > MAX_SHIFT_COUNT)
+		{
+			sprintf(log_error, "invalid shift count %ld in expression. found in line: %d", right, parser->line_count);
+			PUSH_ERROR_AND_RETURN(log_error, USER_ERR, parser->error_founds);
+		}
+		if (is_left)
+		{
+			if (labs(*value) > MAX_EXPRESSION_VALUE >> right)
+			{
+				sprintf(log_error, "expression value overflows. found in line: %d", parser->line_count);
+				PUSH_ERROR_AND_RETURN(log_error, USER_ERR, parser->error_founds);
+			}
+			*value *= 1L << right;
+		}
+		else
+		{
+			/* an arithmetic shift, even where >> of a negative number isn't */
+			*value = *value >= 0 ? *value >> right : -((-*value - 1) >> right) - 1;
+		}
+	}
+	return ret;
+}
+
+int _parse_and(expression_parser_t *parser, long *value)
+{
+	long right = 0;
+	int ret = _parse_shift(parser, value);
+
+	while (ret == SUCCESS && _is_expression_operator(parser, "&"))
+	{
+		ret = _parse_shift(parser, &right);
+		*value &= right;
+	}
+	return ret;
+}
+
+int _parse_or(expression_parser_t *parser, long *value)
+{
+	long right = 0;
+	int ret = _parse_and(parser, value);
+
+	while (ret == SUCCESS && _is_expression_operator(parser, "|"))
+	{
+		ret = _parse_and(parser, &right);
+		*value |= right;
+	}
+	return ret;
+}
+
+/*=============================================================================== */
+
+int is_const_expression(const char *text, int text_size)
+{
+	int i = 0;
+	int is_number = TRUE;
+	int is_name = TRUE;
+	int has_operator = FALSE;
+
+	/* a plain number or a plain name keeps being parsed, and reported, as before */
+	for (i = 0; i < text_size; ++i)
+	{
+		is_number = is_number && (isdigit(text[i]) || (i == 0 && text[i] == '-'));
+		is_name = is_name && (isalpha(text[i]) || (i > 0 && isdigit(text[i])));
+		has_operator = has_operator || strchr(EXPRESSION_OPERATORS, text[i]) != NULL;
+	}
+	return has_operator && !is_number && !is_name;
+}
+
+int evaluate_const_expression(const char *expression, int expression_size, HashTable *symbol_table, int *value, int line_count, StringVector *error_founds)
+{
+	expression_parser_t parser;
+	char log_error[MAX_LINE_SIZE];
+	long expression_value = 0;
+	int ret = SUCCESS;
+
+	parser.runner = expression;
+	parser.end = expression + expression_size;
+	parser.symbol_table = symbol_table;
+	parser.line_count = line_count;
+	parser.error_founds = error_founds;
+
+	ret = _parse_or(&parser, &expression_value);
+	if (ret != SUCCESS)
+	{
+		return ret;
+	}
+	_skip_expression_whitespace(&parser);
+	if (parser.runner != parser.end)
+	{
+		sprintf(log_error, "invalid expression. found in line: %d", line_count);
+		PUSH_ERROR_AND_RETURN(log_error, USER_ERR, error_founds);
+	}
+	if (expression_value > MAX_INTEGER_VALUE || expression_value < MIN_INTEGER_VALUE)
+	{
+		sprintf(log_error, "expression value %ld exceeds memory capacity. found in line: %d", expression_value, line_count);
+		PUSH_ERROR_AND_RETURN(log_error, USER_ERR, error_founds);
+	}
+	*value = (int)expression_value;
+	return SUCCESS;
+}
@@ -9,34 +9,71 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
-#include <ctype.h> 
 
 #include "assembler_helper.h"
 #include "../utils/utils.h"
 #include "../logger/logger.h"
 #include "../general_const/general_const.h"
+#include "../stats/stats.h"
 #include "../hash_table/hash_table.h"
 #include "../string_vector/string_vector.h"
-
-
-const short valid_addressing_types_for_instructions[NUM_INSTRUCTIONS][MAX_POSSIBLE_ADDRESSING_TYPE_FOR_TWO_OPERANDS] = {
-	{1, 1, 1, 1, 0, 1, 1, 1}, /* 0  mov */
-	{1, 1, 1, 1, 1, 1, 1, 1}, /* 1  cmp */
-	{1, 1, 1, 1, 0, 1, 1, 1}, /* 2  add */
-	{1, 1, 1, 1, 0, 1, 1, 1}, /* 3  sub */
-	{0, 0, 0, 0, 0, 1, 1, 1}, /* 4  not */
-	{0, 0, 0, 0, 0, 1, 1, 1}, /* 5  clr */
-	{0, 1, 1, 0, 0, 1, 1, 1}, /* 6  lea */
-	{0, 0, 0, 0, 0, 1, 1, 1}, /* 7  inc */
-	{0, 0, 0, 0, 0, 1, 1, 1}, /* 8  dec */
-	{0, 0, 0, 0, 0, 1, 0, 1}, /* 9  jmp */
-	{0, 0, 0, 0, 0, 1, 0, 1}, /* 10 bne */
-	{0, 0, 0, 0, 0, 1, 1, 1}, /* 11 red */
-	{0, 0, 0, 0, 1, 1, 1, 1}, /* 12 prn */
-	{0, 0, 0, 0, 0, 1, 0, 1}, /* 13 jsr */
-	{0, 0, 0, 0, 0, 0, 0, 0}, /* 14 rts */
-	{0, 0, 0, 0, 0, 0, 0, 0}, /* 15 hlt */
-};
+#include "../intern_pool/intern_pool.h"
+
+
+/* bit (4 * operand number + addressing type) is set when the addressing type is valid for the operand */
+#define ADDRESSING_MASK_MOV (0xEF)
+#define ADDRESSING_MASK_CMP (0xFF)
+#define ADDRESSING_MASK_ADD (0xEF)
+#define ADDRESSING_MASK_SUB (0xEF)
+#define ADDRESSING_MASK_NOT (0xE0)
+#define ADDRESSING_MASK_CLR (0xE0)
+#define ADDRESSING_MASK_LEA (0xE6)
+#define ADDRESSING_MASK_INC (0xE0)
+#define ADDRESSING_MASK_DEC (0xE0)
+#define ADDRESSING_MASK_JMP (0xA0)
+#define ADDRESSING_MASK_BNE (0xA0)
+#define ADDRESSING_MASK_RED (0xE0)
+#define ADDRESSING_MASK_PRN (0xF0)
+#define ADDRESSING_MASK_JSR (0xA0)
+#define ADDRESSING_MASK_RTS (0x00)
+#define ADDRESSING_MASK_HLT (0x00)
+
+const unsigned char valid_addressing_types_for_instructions[NUM_INSTRUCTIONS] = {
+	ADDRESSING_MASK_MOV, ADDRESSING_MASK_CMP, ADDRESSING_MASK_ADD, ADDRESSING_MASK_SUB,
+	ADDRESSING_MASK_NOT, ADDRESSING_MASK_CLR, ADDRESSING_MASK_LEA, ADDRESSING_MASK_INC,
+	ADDRESSING_MASK_DEC, ADDRESSING_MASK_JMP, ADDRESSING_MASK_BNE, ADDRESSING_MASK_RED,
+	ADDRESSING_MASK_PRN, ADDRESSING_MASK_JSR, ADDRESSING_MASK_RTS, ADDRESSING_MASK_HLT};
+
+/* the fields of an entry of instruction_encodings, as constant expressions. MAX_ADDRESSING_TYPE is a missing operand */
+#define ENCODING_OPERAND_WORDS(mode) ((mode) == MAX_ADDRESSING_TYPE ? 0 : (mode) == ADDRESSING__DATA_INDEX ? 2 : 1)
+#define ENCODING_FIRST_WORD(code, src, dst) (((code) << 6) | ((src) == MAX_ADDRESSING_TYPE ? 0 : (src) << 4) | ((dst) == MAX_ADDRESSING_TYPE ? 0 : (dst) << 2))
+#define ENCODING_NUM_WORDS(src, dst) \
+	(1 + ENCODING_OPERAND_WORDS(src) + ENCODING_OPERAND_WORDS(dst) - ((src) == ADDRESSING__DIRECT_REGISTER && (dst) == ADDRESSING__DIRECT_REGISTER))
+#define ENCODING(code, src, dst) {ENCODING_FIRST_WORD(code, src, dst), ENCODING_NUM_WORDS(src, dst)}
+#define ENCODING_SRC(code, src)                                                                                                     \
+	{ENCODING(code, src, ADDRESSING__IMMEDIATE), ENCODING(code, src, ADDRESSING__DIRECT), ENCODING(code, src, ADDRESSING__DATA_INDEX), \
+	 ENCODING(code, src, ADDRESSING__DIRECT_REGISTER), ENCODING(code, src, MAX_ADDRESSING_TYPE)}
+#define ENCODING_ROW(code)                                                                                                      \
+	{ENCODING_SRC(code, ADDRESSING__IMMEDIATE), ENCODING_SRC(code, ADDRESSING__DIRECT), ENCODING_SRC(code, ADDRESSING__DATA_INDEX), \
+	 ENCODING_SRC(code, ADDRESSING__DIRECT_REGISTER), ENCODING_SRC(code, MAX_ADDRESSING_TYPE)}
+
+const instruction_encoding_t instruction_encodings[NUM_INSTRUCTIONS][MAX_ADDRESSING_TYPE + 1][MAX_ADDRESSING_TYPE + 1] = {
+	ENCODING_ROW(0),
+	ENCODING_ROW(1),
+	ENCODING_ROW(2),
+	ENCODING_ROW(3),
+	ENCODING_ROW(4),
+	ENCODING_ROW(5),
+	ENCODING_ROW(6),
+	ENCODING_ROW(7),
+	ENCODING_ROW(8),
+	ENCODING_ROW(9),
+	ENCODING_ROW(10),
+	ENCODING_ROW(11),
+	ENCODING_ROW(12),
+	ENCODING_ROW(13),
+	ENCODING_ROW(14),
+	ENCODING_ROW(15)};
 
 const short num_operands_for_instructions[NUM_INSTRUCTIONS] = {2, 2, 2, 2, 1, 1, 2, 1, 1, 1, 1, 1, 1, 1, 0, 0};
 
@@ -51,8 +88,9 @@ int parse_instruction_line(const char *line, assembler_data_t *assembler_data, i
 	int ret_val;
 	char *label_postfix_ptr = strchr(line, LABEL_POSTFIX);
 
-	*instruction_line = (instruction_line_t *)malloc(sizeof(instruction_line_t));
+	*instruction_line = (instruction_line_t *)stats_malloc(sizeof(instruction_line_t));
 	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(*instruction_line, "Memory allocation for instruction_line failed", FUNC_ERR);
+	(*instruction_line)->label = NULL;
 
 	if (skip_whitespace(&line_runner, assembler_data->line_count , assembler_data->error_founds)) /* skipping whitespaces between words*/
 	{
@@ -70,7 +108,8 @@ int parse_instruction_line(const char *line, assembler_data_t *assembler_data, i
 			{
 					return ret_val;
 			}
-			strcpy((*instruction_line)->label, label_name);
+			(*instruction_line)->label = intern_pool_intern(assembler_data->labels, label_name);
+			CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN((*instruction_line)->label, "Interning a label failed", FUNC_ERR);
 		}
 	}
 
@@ -119,77 +158,17 @@ short get_IC_value(assembler_data_t *assembler_data)
 	return assembler_data->IC;
 }
 
-short calc_num_word_for_instruction_code(instruction_line_t *instruction_line)
+const instruction_encoding_t *get_instruction_encoding(const instruction_line_t *instruction_line)
 {
-	short i;
-	short L = 1; /* each instruction code has at least one word*/
-	short num_operands = 0;
+	int first_mode = instruction_line->operand_data_arr[0].type != OPERAND_TYPE__NO_OPERAND ? instruction_line->operand_data_arr[0].addressing_type : MAX_ADDRESSING_TYPE;
+	int second_mode = instruction_line->operand_data_arr[1].type != OPERAND_TYPE__NO_OPERAND ? instruction_line->operand_data_arr[1].addressing_type : MAX_ADDRESSING_TYPE;
 
-	for (i = 0; i < MAX_NUM_OPERAND; ++i)
-	{
-		if (instruction_line->operand_data_arr[i].type != OPERAND_TYPE__NO_OPERAND)
-		{
-			num_operands++;
-			/* Increment L based on operand type, addressing for specific optimization*/
-			switch (instruction_line->operand_data_arr[i].addressing_type)
-			{
-			case ADDRESSING__IMMEDIATE:
-			case ADDRESSING__DIRECT:
-			{
-				L++;
-				break;
-			}
-			case ADDRESSING__DIRECT_REGISTER:
-			{
-				L++;
-				break;
-			}
-			case ADDRESSING__DATA_INDEX:
-			{
-				/* needs 2, one for the address of the arr, one for the index */
-				L += 2;
-				break;
-			}
-			}
-		}
-	}
-	/* Specific scenario optimization: both operands use direct register addressing
-	Assuming a specific case where L should be adjusted if both operands meet certain conditions */
-	if (num_operands == MAX_NUM_OPERAND &&
-		instruction_line->operand_data_arr[0].addressing_type == ADDRESSING__DIRECT_REGISTER &&
-		instruction_line->operand_data_arr[1].addressing_type == ADDRESSING__DIRECT_REGISTER)
+	/* the operand of a one operand instruction is its destination */
+	if (second_mode == MAX_ADDRESSING_TYPE)
 	{
-		L -= 1;
+		return &instruction_encodings[instruction_line->instruction_code][MAX_ADDRESSING_TYPE][first_mode];
 	}
-	return L;
-}
-
-short build_first_word(instruction_line_t *instruction_line)
-{
-	static const short NUM_BITS_ADDRESSING_TYPE = 2;
-	static const short NUM_BITS_INSTRUCTION_CODE = 4;
-
-	static const short STARTING_BIT_SRC_OPERAND = 4;
-	static const short STARTING_BIT_DEST_OPERAND = 2;
-	static const short STARTING_BIT_INSTRUCTION_CODE = 6;
-
-	short word = 0;
-	short start_bit_for_first_operand = STARTING_BIT_DEST_OPERAND;
-
-	if (instruction_line->operand_data_arr[1].type != OPERAND_TYPE__NO_OPERAND)
-	{
-		start_bit_for_first_operand = STARTING_BIT_SRC_OPERAND;
-		word = set_bits_short(word, instruction_line->operand_data_arr[1].addressing_type, NUM_BITS_ADDRESSING_TYPE, STARTING_BIT_DEST_OPERAND);
-	}
-
-	if (instruction_line->operand_data_arr[0].type != OPERAND_TYPE__NO_OPERAND)
-	{
-		word = set_bits_short(word, instruction_line->operand_data_arr[0].addressing_type, NUM_BITS_ADDRESSING_TYPE, start_bit_for_first_operand);
-	}
-
-	word = set_bits_short(word, instruction_line->instruction_code, NUM_BITS_INSTRUCTION_CODE, STARTING_BIT_INSTRUCTION_CODE);
-
-	return word;
+	return &instruction_encodings[instruction_line->instruction_code][first_mode][second_mode];
 }
 
 short _get_sum_memory(assembler_data_t *assembler_data)
@@ -211,7 +190,6 @@ short build_word_and_set_in_memory(assembler_data_t *assembler_data, instruction
 	short word = 0;
 	short addressing_type = instruction_line->operand_data_arr[num_operand].addressing_type;
 	short word_address = i_mem_code;
-	static short is_first_operand_register = FALSE;
 	int starting_bit_for_register = 0;
 
 	switch (addressing_type)
@@ -228,14 +206,14 @@ short build_word_and_set_in_memory(assembler_data_t *assembler_data, instruction
 	{
 		if (num_operand == 0)
 		{
-			is_first_operand_register = TRUE;
+			assembler_data->is_first_operand_register = TRUE;
 			assembler_data->machine_binary_code[(word_address)] = 0;
 		}
 		else {
-			if (is_first_operand_register)
+			if (assembler_data->is_first_operand_register)
 			{
 				word_address -= 1;
-				is_first_operand_register = FALSE;
+				assembler_data->is_first_operand_register = FALSE;
 			}
 		}
 		word = assembler_data->machine_binary_code[(word_address)];
@@ -261,7 +239,7 @@ short build_word_and_set_in_memory(assembler_data_t *assembler_data, instruction
 	if (num_operand == 1 || addressing_type != ADDRESSING__DIRECT_REGISTER)
 	{
 		/* unset value of this flag for next instruction line */
-		is_first_operand_register = FALSE;
+		assembler_data->is_first_operand_register = FALSE;
 	}
 	return word_address;
 }
@@ -283,7 +261,7 @@ int zero_operands_instruction(char *line, instruction_line_t **instruction_line,
 
 	for (; line[i] != NEWLINE_CHARACTER; i++) /*validating that there are no non whitespaces characters after the instruction */
 	{
-		if (!isspace(line[i]))
+		if (!IS_SPACE_CHAR(line[i]))
 		{
 			sprintf(log_error, "there are non whitespaces characters after the instruction defenition in line: %d", assembler_data->line_count);
 			PUSH_ERROR_AND_RETURN( log_error, USER_ERR, assembler_data->error_founds);
@@ -313,17 +291,14 @@ int one_operand_instruction(char *line, instruction_line_t **instruction_line, a
 		PUSH_ERROR_AND_RETURN( log_error, USER_ERR, assembler_data->error_founds);
 	}
 
-	strcpy(operand_name, line + i);
-	for (; !isspace(line[i]); i++)
-	{
-		operand_size++;
-	}
+	operand_size = find_space_char(line) - line;
+	strncpy(operand_name, line, operand_size);
 	operand_name[operand_size] = NULL_TERMINATOR;
 	(*instruction_line)->operand_data_arr[1].type = OPERAND_TYPE__NO_OPERAND;
 
 	for( i= operand_size ; line[i]!= NEWLINE_CHARACTER; ++i)
 	{
-		if( !isspace(line[i]))
+		if( !IS_SPACE_CHAR(line[i]))
 		{
 			sprintf(log_error, "too many operands for instruction in line: %d", assembler_data->line_count);
 			PUSH_ERROR_AND_RETURN( log_error, USER_ERR, assembler_data->error_founds);
@@ -392,7 +367,7 @@ int two_operands_instruction(char *line, instruction_line_t **instruction_line,
 		}
 
 		strcpy(operand_name, line + i);
-		for (; !isspace(line[i]) && line[i] != COMMA && line[i] !=  NEWLINE_CHARACTER; i++)
+		for (; !IS_SPACE_CHAR(line[i]) && line[i] != COMMA && line[i] !=  NEWLINE_CHARACTER; i++)
 		{
 			operand_size++;
 		}
@@ -409,7 +384,7 @@ int two_operands_instruction(char *line, instruction_line_t **instruction_line,
 		}
 		else
 		{
-			while(isspace(*line) && (*line) !=  NEWLINE_CHARACTER)
+			while(IS_SPACE_CHAR(*line) && (*line) !=  NEWLINE_CHARACTER)
 			{
 				++line;
 			}
@@ -528,10 +503,13 @@ int identify_operand_define_index_addressing(char *operand_name, char **open_pos
 int set_operand_define_index_addressing(char *operand_name, char *open_pos, char *close_pos, int operand_number, instruction_line_t **instruction_line, assembler_data_t *assembler_data)
 {
 	int index = 0;
-	char index_name[MAX_LABEL_SIZE + 1];
+	long index_value = 0;
+	int is_overflow = FALSE;
+	char index_name[MAX_LINE_SIZE]; /* an index may be a constant expression, longer than a label */
 	int index_size = 0;
 	char array_name[MAX_LABEL_SIZE + 1];
 	int array_name_size = 0;
+	int ret_val = SUCCESS;
 	char log_error[MAX_LINE_SIZE];
 
 	if (open_pos > close_pos)
@@ -548,7 +526,20 @@ int set_operand_define_index_addressing(char *operand_name, char *open_pos, char
 	strncpy(index_name, operand_name + array_name_size + 1, index_size);
 	index_name[index_size] = NULL_TERMINATOR;
 
-	if (!isdigit(index_name[0]) && index_name[0] != '-') /*in case the index is const define name*/
+	if (is_const_expression(index_name, index_size)) /*in case the index is a constant expression*/
+	{
+		ret_val = evaluate_const_expression(index_name, index_size, assembler_data->symbol_table, &index, assembler_data->line_count, assembler_data->error_founds);
+		if (ret_val != SUCCESS)
+		{
+			return ret_val;
+		}
+		if (index < 0)
+		{
+			sprintf(log_error, "index %d is out of range. found in line: %d", index, assembler_data->line_count);
+			PUSH_ERROR_AND_RETURN( log_error, USER_ERR, assembler_data->error_founds);
+		}
+	}
+	else if (!IS_DIGIT_CHAR(index_name[0]) && index_name[0] != '-') /*in case the index is const define name*/
 	{
 		if( find_symbol_value(&index , index_name, assembler_data->symbol_table) == ERR)
 		{
@@ -558,17 +549,20 @@ int set_operand_define_index_addressing(char *operand_name, char *open_pos, char
 	}
 	else if(index_name[0] == '-')
 	{
-		sprintf(log_error, "index %d is out of range. found in line: %d", atoi(index_name), assembler_data->line_count);
+		scan_decimal_digits(index_name + 1, MAX_EXPRESSION_VALUE, &index_value, &is_overflow);
+		sprintf(log_error, "index %ld is out of range. found in line: %d", -index_value, assembler_data->line_count);
 		PUSH_ERROR_AND_RETURN( log_error, USER_ERR, assembler_data->error_founds);
 	}
 	else
 	{
-		index = atoi(index_name);
+		scan_decimal_digits(index_name, MAX_EXPRESSION_VALUE, &index_value, &is_overflow);
+		index = index_value;
 	}
 
 	(*instruction_line)->operand_data_arr[operand_number].type = OPERAND_TYPE__DATA_INDEX;
 	(*instruction_line)->operand_data_arr[operand_number].addressing_type = ADDRESSING__DATA_INDEX;
-	strcpy((*instruction_line)->operand_data_arr[operand_number].operand.data_index.arr_name, array_name);
+	(*instruction_line)->operand_data_arr[operand_number].operand.data_index.arr_name = intern_pool_intern(assembler_data->labels, array_name);
+	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN((*instruction_line)->operand_data_arr[operand_number].operand.data_index.arr_name, "Interning an array name failed", FUNC_ERR);
 	(*instruction_line)->operand_data_arr[operand_number].operand.data_index.arr_index = index;
 
 	if (is_operand_addressing_valid(ADDRESSING__DATA_INDEX, (*instruction_line)->instruction_code, operand_number) == ERR)
@@ -586,7 +580,8 @@ int set_operand_direct_addressing(char *operand_name, int operand_number, instru
 	char log_error[MAX_LINE_SIZE];
 	(*instruction_line)->operand_data_arr[operand_number].type = OPERAND_TYPE__NAME;
 	(*instruction_line)->operand_data_arr[operand_number].addressing_type = ADDRESSING__DIRECT;
-	strcpy((*instruction_line)->operand_data_arr[operand_number].operand.name, operand_name);
+	(*instruction_line)->operand_data_arr[operand_number].operand.name = intern_pool_intern(assembler_data->labels, operand_name);
+	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN((*instruction_line)->operand_data_arr[operand_number].operand.name, "Interning an operand name failed", FUNC_ERR);
 
 	if (is_operand_addressing_valid(ADDRESSING__DIRECT, (*instruction_line)->instruction_code, operand_number) == ERR)
 	{
@@ -601,6 +596,9 @@ int set_operand_immediate_addressing(char *operand_name, int operand_number, ins
 {
 	int i = 0;
 	int number_val = 0;
+	long digits_value = 0;
+	int is_overflow = FALSE;
+	int ret_val = SUCCESS;
 	char log_error[MAX_LINE_SIZE];
 
 	(*instruction_line)->operand_data_arr[operand_number].type = OPERAND_TYPE__NUMBER;
@@ -608,12 +606,20 @@ int set_operand_immediate_addressing(char *operand_name, int operand_number, ins
 
 	operand_name += 1; /* skipping the char # to extract the integer*/
 
-	if( isspace(operand_name[0]))
+	if( IS_SPACE_CHAR(operand_name[0]))
 	{
 		sprintf(log_error, "whitespaces found between '#' and const define value. in line: %d", assembler_data->line_count);
 		PUSH_ERROR_AND_RETURN( log_error, USER_ERR, assembler_data->error_founds);
 	}
-	if (!isdigit(operand_name[0]) && operand_name[0] != '-') /* in case the number is const define name */
+	if (is_const_expression(operand_name, strlen(operand_name))) /* in case the number is a constant expression */
+	{
+		ret_val = evaluate_const_expression(operand_name, strlen(operand_name), assembler_data->symbol_table, &number_val, assembler_data->line_count, assembler_data->error_founds);
+		if (ret_val != SUCCESS)
+		{
+			return ret_val;
+		}
+	}
+	else if (!IS_DIGIT_CHAR(operand_name[0]) && operand_name[0] != '-') /* in case the number is const define name */
 	{
 		if( find_symbol_value(&number_val , operand_name, assembler_data->symbol_table) == ERR)
 		{
@@ -635,16 +641,13 @@ int set_operand_immediate_addressing(char *operand_name, int operand_number, ins
 			PUSH_ERROR_AND_RETURN( log_error, USER_ERR, assembler_data->error_founds);
 		}
 
-		for (; operand_name[i] != NULL_TERMINATOR; i++)
+		if (*scan_decimal_digits(operand_name + i, MAX_EXPRESSION_VALUE, &digits_value, &is_overflow) != NULL_TERMINATOR)
 		{
-			if (!isdigit(operand_name[i]))
-			{
-				sprintf(log_error, "Syntax error at line %d: Non-numeric characters found after # symbol.", assembler_data->line_count);
-				PUSH_ERROR_AND_RETURN( log_error, USER_ERR, assembler_data->error_founds);
-			}
+			sprintf(log_error, "Syntax error at line %d: Non-numeric characters found after # symbol.", assembler_data->line_count);
+			PUSH_ERROR_AND_RETURN( log_error, USER_ERR, assembler_data->error_founds);
 		}
 
-		number_val = atoi(operand_name);
+		number_val = i ? -digits_value : digits_value;
 	}
 
 	if (number_val > MAX_INTEGER_VALUE || number_val < MIN_INTEGER_VALUE)
@@ -672,7 +675,7 @@ int is_operand_addressing_valid(int addressing_type, short instruction_code, int
 		addressing_type += 4;
 	}
 
-	if (valid_addressing_types_for_instructions[instruction_code][addressing_type])
+	if ((valid_addressing_types_for_instructions[instruction_code] >> addressing_type) & 1)
 	{
 		return SUCCESS;
 	}
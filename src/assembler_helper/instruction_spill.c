@@ -0,0 +1,205 @@
+/* *******************************************************************
+ * Authors: Daniel Oren, Elisheva Cirota
+ *
+ * @file  instruction_spill.c
+ * @brief This file contains the implementation of the spilling of parsed instruction lines
+ * to a temporary file, when they are over their share of the memory budget.
+ *
+ * The oldest lines are spilled, so the file always holds the first lines of the input file and
+ * the deque the last ones, and the second pass reads the file before the deque. A line is
+ * written in a compact form that has only what the second pass needs: the number of words,
+ * the instruction code and the operands. The names of the operands are kept in the labels pool
+ * until the end of the file, so a spilled line only has their interned pointers.
+ *********************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "assembler_helper.h"
+#include "../logger/logger.h"
+#include "../general_const/general_const.h"
+#include "../memory_budget/memory_budget.h"
+
+/* =========================== internal functions declarations ================== */
+int _spill_write_name(FILE *file, const char *name);
+int _spill_read_name(FILE *file, const char **name);
+int _spill_write_line(FILE *file, const instruction_line_t *instruction_line);
+int _spill_read_line(FILE *file, instruction_line_t *instruction_line);
+
+/* =========================== internal functions implementations ================= */
+
+int _spill_write_name(FILE *file, const char *name)
+{
+	/* the temporary file is read back by this process, before the labels pool is cleared */
+	return fwrite(&name, sizeof(const char *), 1, file) == 1;
+}
+
+int _spill_read_name(FILE *file, const char **name)
+{
+	return fread(name, sizeof(const char *), 1, file) == 1;
+}
+
+int _spill_write_line(FILE *file, const instruction_line_t *instruction_line)
+{
+	const operand_data_t *operand_data = NULL;
+	unsigned char type = 0;
+	unsigned char addressing_type = 0;
+	int is_ok = TRUE;
+	int i = 0;
+
+	is_ok &= fwrite(&instruction_line->L, sizeof(short), 1, file) == 1;
+	if (instruction_line->L == -1)
+	{
+		/* the line failed to parse, the second pass only skips it */
+		return is_ok;
+	}
+	is_ok &= fwrite(&instruction_line->instruction_code, sizeof(short), 1, file) == 1;
+	for (i = 0; i < MAX_NUM_OPERAND && is_ok; ++i)
+	{
+		operand_data = &instruction_line->operand_data_arr[i];
+		type = (unsigned char)operand_data->type;
+		addressing_type = (unsigned char)operand_data->addressing_type;
+		is_ok &= fwrite(&type, sizeof(type), 1, file) == 1;
+		if (operand_data->type == OPERAND_TYPE__NO_OPERAND)
+		{
+			break;
+		}
+		is_ok &= fwrite(&addressing_type, sizeof(addressing_type), 1, file) == 1;
+		switch (operand_data->type)
+		{
+		case OPERAND_TYPE__NAME:
+			is_ok &= _spill_write_name(file, operand_data->operand.name);
+			break;
+		case OPERAND_TYPE__DATA_INDEX:
+			is_ok &= _spill_write_name(file, operand_data->operand.data_index.arr_name);
+			is_ok &= fwrite(&operand_data->operand.data_index.arr_index, sizeof(short), 1, file) == 1;
+			break;
+		default:
+			is_ok &= fwrite(&operand_data->operand.number, sizeof(short), 1, file) == 1;
+			break;
+		}
+	}
+	return is_ok;
+}
+
+int _spill_read_line(FILE *file, instruction_line_t *instruction_line)
+{
+	operand_data_t *operand_data = NULL;
+	unsigned char type = 0;
+	unsigned char addressing_type = 0;
+	int i = 0;
+
+	memset(instruction_line, 0, sizeof(instruction_line_t));
+	for (i = 0; i < MAX_NUM_OPERAND; ++i)
+	{
+		instruction_line->operand_data_arr[i].type = OPERAND_TYPE__NO_OPERAND;
+	}
+	if (fread(&instruction_line->L, sizeof(short), 1, file) != 1)
+	{
+		return FALSE;
+	}
+	if (instruction_line->L == -1)
+	{
+		return TRUE;
+	}
+	if (fread(&instruction_line->instruction_code, sizeof(short), 1, file) != 1)
+	{
+		return FALSE;
+	}
+	for (i = 0; i < MAX_NUM_OPERAND; ++i)
+	{
+		operand_data = &instruction_line->operand_data_arr[i];
+		if (fread(&type, sizeof(type), 1, file) != 1)
+		{
+			return FALSE;
+		}
+		operand_data->type = (operand_type)type;
+		if (operand_data->type == OPERAND_TYPE__NO_OPERAND)
+		{
+			break;
+		}
+		if (fread(&addressing_type, sizeof(addressing_type), 1, file) != 1)
+		{
+			return FALSE;
+		}
+		operand_data->addressing_type = (enum addressing_type)addressing_type;
+		switch (operand_data->type)
+		{
+		case OPERAND_TYPE__NAME:
+			if (!_spill_read_name(file, &operand_data->operand.name))
+			{
+				return FALSE;
+			}
+			break;
+		case OPERAND_TYPE__DATA_INDEX:
+			if (!_spill_read_name(file, &operand_data->operand.data_index.arr_name) ||
+				fread(&operand_data->operand.data_index.arr_index, sizeof(short), 1, file) != 1)
+			{
+				return FALSE;
+			}
+			break;
+		default:
+			if (fread(&operand_data->operand.number, sizeof(short), 1, file) != 1)
+			{
+				return FALSE;
+			}
+			break;
+		}
+	}
+	return TRUE;
+}
+
+/*=============================================================================== */
+
+int spill_parsed_instruction_lines(assembler_data_t *assembler_data)
+{
+	size_t max_lines = memory_budget_share(&assembler_data->memory_budget, MEMORY_BUDGET_LINES_SHARE) / sizeof(instruction_line_t);
+	instruction_line_t *instruction_line = NULL;
+	int is_ok = TRUE;
+
+	if (deque_get_size(assembler_data->parsed_instruction_lines) <= max_lines)
+	{
+		return SUCCESS;
+	}
+	if (assembler_data->spilled_lines == NULL)
+	{
+		assembler_data->spilled_lines = tmpfile();
+		CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(assembler_data->spilled_lines, "failed to create a temporary file for the parsed instruction lines", FUNC_ERR);
+	}
+
+	/* down to half of the share, so the next lines are spilled in batches and not one by one */
+	while (deque_get_size(assembler_data->parsed_instruction_lines) > max_lines / 2 && is_ok)
+	{
+		instruction_line = (instruction_line_t *)deque_pop_front(assembler_data->parsed_instruction_lines);
+		is_ok = _spill_write_line(assembler_data->spilled_lines, instruction_line);
+		free(instruction_line);
+		++assembler_data->num_spilled_lines;
+	}
+	if (!is_ok)
+	{
+		LOG(ERROR, PARAMS, "failed to write a parsed instruction line to the temporary file");
+		return FUNC_ERR;
+	}
+	return SUCCESS;
+}
+
+instruction_line_t *next_parsed_instruction_line(assembler_data_t *assembler_data, instruction_line_t *spilled_line)
+{
+	if (assembler_data->num_read_spilled_lines == assembler_data->num_spilled_lines)
+	{
+		return (instruction_line_t *)deque_pop_front(assembler_data->parsed_instruction_lines);
+	}
+	if (assembler_data->num_read_spilled_lines == 0 && fseek(assembler_data->spilled_lines, 0, SEEK_SET) != 0)
+	{
+		LOG(ERROR, PARAMS, "fseek failed on the temporary file of the parsed instruction lines");
+		return NULL;
+	}
+	if (!_spill_read_line(assembler_data->spilled_lines, spilled_line))
+	{
+		LOG(ERROR, PARAMS, "failed to read a parsed instruction line from the temporary file");
+		return NULL;
+	}
+	++assembler_data->num_read_spilled_lines;
+	return spilled_line;
+}
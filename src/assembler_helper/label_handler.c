@@ -9,9 +9,9 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
-#include <ctype.h> 
 
 #include "../pre_processor/preprocessor_consts.h"
+#include "../pre_processor/preprocessor.h"
 #include "assembler_helper.h"
 #include "../utils/utils.h"
 #include "../logger/logger.h"
@@ -88,7 +88,7 @@ int validate_first_char_label_name(char *label_name,  int line_count, StringVect
 {
 	char log_error[MAX_LINE_SIZE];
 
-	if (!isalpha(label_name[0]))
+	if (!IS_ALPHA_CHAR(label_name[0]))
 	{
 		sprintf(log_error, "Invalid label name: %s, should start with a letter. line: %d", label_name, line_count);
 		PUSH_ERROR_AND_RETURN( log_error , USER_ERR, error_founds);
@@ -100,15 +100,12 @@ int validate_first_char_label_name(char *label_name,  int line_count, StringVect
 int validate_label_name_characters(char *label_name,  int line_count, StringVector *error_founds)
 {
 	char log_error[MAX_LINE_SIZE];
-	int i;
+	int i = label_name[0] == NULL_TERMINATOR ? 0 : 1 + label_char_span(label_name + 1); /* the first char is validated apart */
 
-	for( i = 1 ; i < strlen(label_name) ; ++i)
+	if (label_name[i] != NULL_TERMINATOR)
 	{
-		if (!isalpha(label_name[i]) && !isdigit(label_name[i]))
-		{
-			sprintf(log_error, "character '%c' is invalid for a label name. found in line: %d", label_name[i], line_count);
-			PUSH_ERROR_AND_RETURN( log_error , USER_ERR, error_founds);
-		}
+		sprintf(log_error, "character '%c' is invalid for a label name. found in line: %d", label_name[i], line_count);
+		PUSH_ERROR_AND_RETURN( log_error , USER_ERR, error_founds);
 	}
 	
 	return SUCCESS;
@@ -195,10 +192,10 @@ int validate_is_label_name_dupe(char *label_name, int line_type, HashTable *symb
 
 int validate_is_label_name_macro(char *label_name, HashTable *macro_table, int line_count, StringVector *error_founds)
 {
-	StringVector *macro_data_content = hash_table_lookup(macro_table, label_name);
+	macro_data_t *macro_data = hash_table_lookup(macro_table, label_name);
 	char log_error[MAX_LINE_SIZE];
 
-	if (macro_data_content != NULL)
+	if (macro_data != NULL)
 	{
 		sprintf(log_error, "Invalid label name: %s, label name can't be macro name. found in line: %d", label_name, line_count);
 		PUSH_ERROR_AND_RETURN( log_error, USER_ERR, error_founds);
@@ -251,7 +248,7 @@ int handle_label(char **line, char *label_name, int line_type, HashTable *macro_
 	int i = 0;
 	
 	
-	for (; !isspace((*line)[i]) && (*line)[i] != NEWLINE_CHARACTER; i++) /* getting label size*/
+	for (; !IS_SPACE_CHAR((*line)[i]) && (*line)[i] != NEWLINE_CHARACTER; i++) /* getting label size*/
 	{
 		++label_size;
 	}
@@ -318,19 +315,11 @@ int validate_label_for_direct_addressing(char *operand_name)
 {
 	int i;
 
-	if (!isalpha(operand_name[0]))
+	if (!IS_ALPHA_CHAR(operand_name[0]) || operand_name[label_char_span(operand_name)] != NULL_TERMINATOR)
 	{
 		return ERR;
 	}
 
-	for (i = 1; i < strlen(operand_name); i++)
-	{
-		if (!isalpha(operand_name[i]) && !isdigit(operand_name[i]))
-		{
-			return ERR;
-		}
-	}
-
 	for (i = 0; i < NUM_OF_REGISTERS; i++)
 	{
 		if (strcmp(operand_name, REGISTERS_NAMES[i]) == 0)
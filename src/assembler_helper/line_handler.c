@@ -15,6 +15,7 @@
 #include "../utils/utils.h"
 #include "../logger/logger.h"
 #include "../general_const/general_const.h"
+#include "../stats/stats.h"
 #include "../hash_table/hash_table.h"
 #include "../string_vector/string_vector.h"
 
@@ -108,30 +109,36 @@ int handle_directive_line(const char *line, assembler_data_t *assembler_data, sh
 
 int handle_instruction_line(const char *line, assembler_data_t *assembler_data, short found_symbol, HashTable *macro_table)
 {
-	int i = 0;
 	instruction_line_t *instruction_line = NULL;
-	short instruction_code_first_word = 0;
-	short curr_IC = 0;
-	short addressing_type = 0;
 	int ret_val = SUCCESS;
 
 	ret_val = parse_instruction_line(line, assembler_data, &instruction_line, macro_table);
-	if (ret_val == FUNC_ERR)
+	return handle_parsed_instruction_line(assembler_data, instruction_line, ret_val, found_symbol);
+}
+
+int handle_parsed_instruction_line(assembler_data_t *assembler_data, instruction_line_t *instruction_line, int parse_ret_val, short found_symbol)
+{
+	int i = 0;
+	const instruction_encoding_t *encoding = NULL;
+	short curr_IC = 0;
+	short addressing_type = 0;
+
+	if (parse_ret_val == FUNC_ERR)
 	{
 		/* allocation failed, need to return */
 		return FUNC_ERR;
 	}
-	else if(ret_val == USER_ERR) 
+	else if(parse_ret_val == USER_ERR) 
 	{
 		instruction_line->L = -1; /* mark this line as failed to parse line */
-		if (SUCCESS != queue_enqueue(assembler_data->parsed_instruction_lines, instruction_line))
+		if (SUCCESS != deque_push_back(assembler_data->parsed_instruction_lines, instruction_line))
 		{
 			LOG(ERROR, PARAMS, "failed to enqueue instruction line, exiting ...");
 			return FUNC_ERR;;
 		}
 		return USER_ERR;
 	}
-	if (SUCCESS != queue_enqueue(assembler_data->parsed_instruction_lines, instruction_line))
+	if (SUCCESS != deque_push_back(assembler_data->parsed_instruction_lines, instruction_line))
 	{
 		LOG(ERROR, PARAMS, "failed to enqueue instruction line, exiting ...");
 		return FUNC_ERR;;
@@ -145,16 +152,16 @@ int handle_instruction_line(const char *line, assembler_data_t *assembler_data,
 		}
 	}
 
-	/* build first word of instruction code */
-	instruction_line->L = calc_num_word_for_instruction_code(instruction_line);
+	/* build first word of instruction code, the table has both the first word and L */
+	encoding = get_instruction_encoding(instruction_line);
+	instruction_line->L = encoding->num_words;
 	curr_IC = assembler_data->IC;
 	if (allocate_mem_for_instruction_code(assembler_data, instruction_line->L) != SUCCESS)
 	{
 		LOG(ERROR, PARAMS, "failed to allocate memory for instruction code, exiting ...");
 		return ERR;
 	}
-	instruction_code_first_word = build_first_word(instruction_line);
-	set_first_word(assembler_data, curr_IC, instruction_code_first_word);
+	set_first_word(assembler_data, curr_IC, encoding->first_word);
 
 	for (i = 0; i < MAX_NUM_OPERAND; ++i)
 	{
@@ -291,3 +298,106 @@ int identify_instruction_line(char *line)
 {
 	return find_instruction(line);
 }
+
+int handle_line_and_set_template(const char *line, int line_type, line_template_t *line_template, assembler_data_t *assembler_data, HashTable *macro_table)
+{
+	int num_errors = string_vector_get_size(assembler_data->error_founds);
+	int num_warnings = string_vector_get_size(assembler_data->warning_founds);
+	short curr_DC = assembler_data->DC;
+	instruction_line_t *instruction_line = NULL;
+	int ret_val = SUCCESS;
+
+	line_template->is_parsed = FALSE;
+	if (line_type == LINE__INSTRUCTION)
+	{
+		ret_val = parse_instruction_line(line, assembler_data, &instruction_line, macro_table);
+		if (ret_val == SUCCESS)
+		{
+			line_template->instruction_line = *instruction_line;
+		}
+		ret_val = handle_parsed_instruction_line(assembler_data, instruction_line, ret_val, FALSE);
+	}
+	else
+	{
+		ret_val = assembler_data->line_handlers_arr[line_type](line, assembler_data, FALSE, macro_table);
+	}
+
+	/* a label is validated against the symbol table, which changes between the expansions */
+	if (ret_val != SUCCESS || strchr(line, LABEL_POSTFIX) != NULL ||
+		num_errors != string_vector_get_size(assembler_data->error_founds) ||
+		num_warnings != string_vector_get_size(assembler_data->warning_founds))
+	{
+		/* the line will be parsed again at the next expansion, with its diagnostics */
+		return ret_val;
+	}
+
+	switch (line_type)
+	{
+	case LINE__EMPTY:
+	case LINE__COMMENT:
+	case LINE__INSTRUCTION:
+	{
+		break;
+	}
+	case LINE__DIRECTIVE:
+	{
+		/* only .data and .string lines are kept, .entry and .extern lines change the symbol table */
+		if (assembler_data->DC == curr_DC || assembler_data->DC - curr_DC > MAX_LINE_SIZE)
+		{
+			return ret_val;
+		}
+		line_template->num_data_values = assembler_data->DC - curr_DC;
+		memcpy(line_template->data_values, assembler_data->data_memory + curr_DC, line_template->num_data_values * sizeof(short));
+		break;
+	}
+	default:
+	{
+		/* a .define line changes the symbol table */
+		return ret_val;
+	}
+	}
+
+	line_template->line_type = line_type;
+	line_template->num_defines = assembler_data->num_defines;
+	line_template->is_parsed = TRUE;
+	return ret_val;
+}
+
+int can_instantiate_line_template(const line_template_t *line_template, assembler_data_t *assembler_data)
+{
+	if (!line_template->is_parsed || line_template->num_defines != assembler_data->num_defines)
+	{
+		return FALSE;
+	}
+	/* when the data doesn't fit, the line is handled again to fail the same way */
+	if (line_template->line_type == LINE__DIRECTIVE &&
+		_get_sum_memory(assembler_data) + line_template->num_data_values >= MEMORY_SIZE)
+	{
+		return FALSE;
+	}
+	return TRUE;
+}
+
+int instantiate_line_template(const line_template_t *line_template, assembler_data_t *assembler_data)
+{
+	instruction_line_t *instruction_line = NULL;
+
+	switch (line_template->line_type)
+	{
+	case LINE__INSTRUCTION:
+	{
+		/* the deque owns its instruction lines, so every expansion gets a copy */
+		instruction_line = (instruction_line_t *)stats_malloc(sizeof(instruction_line_t));
+		CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(instruction_line, "Memory allocation for instruction_line failed", FUNC_ERR);
+		*instruction_line = line_template->instruction_line;
+		return handle_parsed_instruction_line(assembler_data, instruction_line, SUCCESS, FALSE);
+	}
+	case LINE__DIRECTIVE:
+	{
+		memcpy(assembler_data->data_memory + assembler_data->DC, line_template->data_values, line_template->num_data_values * sizeof(short));
+		assembler_data->DC += line_template->num_data_values;
+		break;
+	}
+	}
+	return SUCCESS;
+}
@@ -15,16 +15,53 @@
 #include "../utils/utils.h"
 #include "../logger/logger.h"
 #include "../general_const/general_const.h"
+#include "../stats/stats.h"
 #include "../hash_table/hash_table.h"
 #include "../string_vector/string_vector.h"
 
+#define EXTERN_USES_INITIAL_CAPACITY (16)
+
+int lookup_symbol_for_update(assembler_data_t *assembler_data, const char *label_name, symbol_t **symbol)
+{
+	symbol_t *library_symbol = NULL;
+	const char *interned_name = NULL;
+
+	*symbol = (symbol_t *)hash_table_lookup_local(assembler_data->symbol_table, label_name);
+	if (*symbol != NULL || assembler_data->symbol_table->fallback == NULL)
+	{
+		return SUCCESS;
+	}
+	library_symbol = (symbol_t *)hash_table_lookup_local(assembler_data->symbol_table->fallback, label_name);
+	if (library_symbol == NULL)
+	{
+		return SUCCESS;
+	}
+
+	/* the macro library is shared, so its symbol is copied to the input file before it is changed */
+	interned_name = intern_pool_intern(assembler_data->labels, label_name);
+	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(interned_name, "Interning a symbol name failed", FUNC_ERR);
+	*symbol = (symbol_t *)stats_malloc(sizeof(symbol_t));
+	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(*symbol, "Memory allocation for symbol failed", FUNC_ERR);
+	**symbol = *library_symbol;
+	(*symbol)->symbol_name = interned_name;
+	(*symbol)->extern_id = 0; /* the symbol ids belong to the extern uses of the input file */
+	if (SUCCESS != hash_table_insert_borrowed(assembler_data->symbol_table, interned_name, *symbol))
+	{
+		free(*symbol);
+		*symbol = NULL;
+		return FUNC_ERR;
+	}
+	return SUCCESS;
+}
+
 void init_symbol_data(symbol_t *symbol, const char *label_name, enum memory_type memory_type, short symbol_value, short num_elements)
 {
 	symbol->memory_type = memory_type;
 	symbol->symbol_value = symbol_value;
-	strcpy(symbol->symbol_name, label_name);
+	symbol->symbol_name = label_name;
 	symbol->symbol_location = -1;
 	symbol->num_elements = num_elements;
+	symbol->extern_id = 0;
 }
 
 void update_symbol_data(symbol_t *symbol, const char *label_name, enum memory_type memory_type, short symbol_value, short num_elements)
@@ -38,7 +75,8 @@ void init_symbol_location_data(symbol_t *symbol, const char *label_name, enum sy
 {
 	symbol->symbol_location = symbol_location;
 	symbol->symbol_value = (symbol_location == SYMBOL__EXTERN) ? 0 : -1;
-	strcpy(symbol->symbol_name, label_name);
+	symbol->symbol_name = label_name;
+	symbol->extern_id = 0;
 }
 
 void update_symbol_location_data(symbol_t *symbol, enum symbol_location symbol_location)
@@ -49,8 +87,19 @@ void update_symbol_location_data(symbol_t *symbol, enum symbol_location symbol_l
 
 int init_and_add_symbol_table(assembler_data_t *assembler_data, const char *label_name, enum memory_type memory_type, short symbol_value, short num_elements)
 {
-	symbol_t *symbol = hash_table_lookup(assembler_data->symbol_table, label_name);
+	symbol_t *symbol = NULL;
+	const char *interned_name = NULL;
 	char log_error[MAX_LINE_SIZE];
+
+	if (SUCCESS != lookup_symbol_for_update(assembler_data, label_name, &symbol))
+	{
+		return FUNC_ERR;
+	}
+	if (memory_type == MEM_TYPE__DEFINE)
+	{
+		/* the lines that use constants can't be instantiated from their templates anymore */
+		++assembler_data->num_defines;
+	}
 	if (symbol)
 	{
 		if (symbol->symbol_value != -1)
@@ -71,12 +120,14 @@ int init_and_add_symbol_table(assembler_data_t *assembler_data, const char *labe
 	}
 	else
 	{
-		/* allocate memory for the new symbol*/
-		symbol = (symbol_t *)malloc(sizeof(symbol_t));
+		/* allocate memory for the new symbol, its name is kept once in the labels pool */
+		interned_name = intern_pool_intern(assembler_data->labels, label_name);
+		CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(interned_name, "Interning a symbol name failed", FUNC_ERR);
+		symbol = (symbol_t *)stats_malloc(sizeof(symbol_t));
 		CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(symbol, "Memory allocation for symbol failed", FUNC_ERR);
 
-		init_symbol_data(symbol, label_name, memory_type, symbol_value, num_elements);
-		if (SUCCESS !=  hash_table_insert(assembler_data->symbol_table, label_name, symbol))
+		init_symbol_data(symbol, interned_name, memory_type, symbol_value, num_elements);
+		if (SUCCESS !=  hash_table_insert_borrowed(assembler_data->symbol_table, interned_name, symbol))
 		{
 			LOG(ERROR, PARAMS, "failed to insert symbol %s to symbol table, exiting ...", label_name);
 			return USER_ERR;
@@ -92,7 +143,9 @@ int init_and_add_location_to_symbol_table(assembler_data_t *assembler_data, cons
 	int i = 0;
 	int label_size = 0;
 	char label_name_temp[MAX_LINE_SIZE];
+	const char *interned_name = NULL;
 	symbol_t *symbol = NULL;
+	int is_location_set = FALSE;
 	
 	memset(label_name_temp, 0, MAX_LINE_SIZE);
 
@@ -103,7 +156,10 @@ int init_and_add_location_to_symbol_table(assembler_data_t *assembler_data, cons
 
 	strncpy(label_name_temp, label_name_from_line, label_size);
 	label_name_temp[label_size] = NULL_TERMINATOR;
-	symbol = (symbol_t *)hash_table_lookup(assembler_data->symbol_table, label_name_temp);
+	if (SUCCESS != lookup_symbol_for_update(assembler_data, label_name_temp, &symbol))
+	{
+		return FUNC_ERR;
+	}
 	if (symbol)
 	{
 		if (symbol->symbol_location != -1)
@@ -116,25 +172,35 @@ int init_and_add_location_to_symbol_table(assembler_data_t *assembler_data, cons
 		{
 			/* just update existing symbol*/
 			update_symbol_location_data(symbol, symbol_location);
+			is_location_set = TRUE;
 		}
 	}
 	else
 	{
-		/* allocate memory for the new symbol*/
-		symbol = (symbol_t *)malloc(sizeof(symbol_t));
-		memset(symbol, 0, sizeof(symbol_t));
+		/* allocate memory for the new symbol, its name is kept once in the labels pool */
+		interned_name = intern_pool_intern(assembler_data->labels, label_name_temp);
+		CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(interned_name, "Interning a symbol name failed", FUNC_ERR);
+		symbol = (symbol_t *)stats_malloc(sizeof(symbol_t));
 		CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(symbol, "Memory allocation for symbol failed", FUNC_ERR);
+		memset(symbol, 0, sizeof(symbol_t));
 
-		init_symbol_location_data(symbol, label_name_temp, symbol_location);
-		if (SUCCESS !=  hash_table_insert(assembler_data->symbol_table, label_name_temp, symbol))
+		init_symbol_location_data(symbol, interned_name, symbol_location);
+		if (SUCCESS !=  hash_table_insert_borrowed(assembler_data->symbol_table, interned_name, symbol))
 		{
 			LOG(ERROR, PARAMS, "failed to insert symbol %s to symbol table, exiting ...", label_name_temp);
 			return USER_ERR;
 		}
+		is_location_set = TRUE;
 	}
 	if (symbol_location == SYMBOL__ENTRY)
 	{
 		assembler_data->has_entry = TRUE;
+		/* the .ent file lists the entries in the order of their .entry lines, not in the order of the symbol table */
+		if (is_location_set && deque_push_back(assembler_data->entry_symbols, symbol) != SUCCESS)
+		{
+			LOG(ERROR, PARAMS, "failed to add symbol %s to the entry symbols", label_name_temp);
+			return FUNC_ERR;
+		}
 	}
 	return SUCCESS;
 }
@@ -201,3 +267,58 @@ int find_symbol_value(int *found_value , char *lookup_name, HashTable *symbol_ta
 	(*found_value) = symbol->symbol_value;
 	return SUCCESS;
 }
+
+int add_extern_use(assembler_data_t *assembler_data, symbol_t *symbol, short address)
+{
+	extern_uses_t *extern_uses = &assembler_data->extern_uses;
+	extern_use_t *new_uses = NULL;
+	const char **new_names = NULL;
+	size_t new_uses_capacity = 0;
+	int new_names_capacity = 0;
+
+	if (symbol->extern_id == 0)
+	{
+		/* the first use of the symbol gives it the next symbol id */
+		if (extern_uses->num_names == extern_uses->names_capacity)
+		{
+			new_names_capacity = extern_uses->names_capacity == 0 ? EXTERN_USES_INITIAL_CAPACITY : extern_uses->names_capacity * 2;
+			new_names = (const char **)stats_realloc((void *)extern_uses->names, new_names_capacity * sizeof(const char *));
+			CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(new_names, "Memory allocation failed in add_extern_use", FUNC_ERR);
+			extern_uses->names = new_names;
+			extern_uses->names_capacity = new_names_capacity;
+		}
+		extern_uses->names[extern_uses->num_names++] = symbol->symbol_name;
+		symbol->extern_id = (short)extern_uses->num_names;
+	}
+	if (extern_uses->num_uses == extern_uses->uses_capacity)
+	{
+		new_uses_capacity = extern_uses->uses_capacity == 0 ? EXTERN_USES_INITIAL_CAPACITY : extern_uses->uses_capacity * 2;
+		new_uses = (extern_use_t *)stats_realloc(extern_uses->uses, new_uses_capacity * sizeof(extern_use_t));
+		CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(new_uses, "Memory allocation failed in add_extern_use", FUNC_ERR);
+		extern_uses->uses = new_uses;
+		extern_uses->uses_capacity = new_uses_capacity;
+	}
+	extern_uses->uses[extern_uses->num_uses].symbol_id = symbol->extern_id - 1;
+	extern_uses->uses[extern_uses->num_uses].address = address;
+	++extern_uses->num_uses;
+	return SUCCESS;
+}
+
+void clear_extern_uses(extern_uses_t *extern_uses)
+{
+	/* the arrays are kept for the next file */
+	extern_uses->num_uses = 0;
+	extern_uses->num_names = 0;
+}
+
+void free_extern_uses(extern_uses_t *extern_uses)
+{
+	free(extern_uses->uses);
+	free((void *)extern_uses->names);
+	memset(extern_uses, 0, sizeof(extern_uses_t));
+}
+
+size_t get_extern_uses_memory_size(const extern_uses_t *extern_uses)
+{
+	return extern_uses->uses_capacity * sizeof(extern_use_t) + extern_uses->names_capacity * sizeof(const char *);
+}
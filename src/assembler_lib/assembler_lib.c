@@ -0,0 +1,262 @@
+/* *******************************************************************
+ * Authors: Daniel Oren, Elisheva Cirota
+ *
+ * @file assembler_lib.c
+ * @brief This file contains the implementation of the assembler library.
+ *
+ * The pre processor and the passes read and write streams, so the library runs them on memory
+ * streams: fmemopen for the source, and open_memstream for the pre processed source.
+ *********************************************************************/
+#define _POSIX_C_SOURCE 200809L /* for fmemopen and open_memstream */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "assembler_lib.h"
+#include "../assembler_main/assembler_main.h"
+#include "../ext_ent_file_builder/ext_ent_file_builder.h"
+#include "../logger/logger.h"
+#include "../general_const/general_const.h"
+#include "../stats/stats.h"
+
+struct assembler_lib
+{
+	assembler_context_t *context;
+};
+
+/* =========================== internal functions declarations ================== */
+void _assembler_lib_copy_words(short *dest, int capacity, const short *src, int size, int *dest_size, int *is_truncated);
+void _assembler_lib_add_diagnostics(StringVector *messages, assembler_lib_severity_t severity, assembler_lib_result_t *result);
+void _assembler_lib_add_symbol(const char *key, void *data, void *result);
+void _assembler_lib_add_entry(const char *key, void *data, void *result);
+void _assembler_lib_add_extern_use(const char *name, short address, assembler_lib_result_t *lib_result);
+int _assembler_lib_fill_outputs(assembler_data_t *assembler_data, assembler_lib_result_t *result);
+int _assembler_lib_run(assembler_lib_t *lib, const char *source, size_t source_size, assembler_lib_result_t *result);
+
+/* =========================== internal functions implementations ================= */
+
+void _assembler_lib_copy_words(short *dest, int capacity, const short *src, int size, int *dest_size, int *is_truncated)
+{
+	*dest_size = size;
+	if (size > capacity)
+	{
+		*is_truncated = TRUE;
+		size = capacity;
+	}
+	if (size > 0)
+	{
+		memcpy(dest, src, size * sizeof(short));
+	}
+}
+
+void _assembler_lib_add_diagnostics(StringVector *messages, assembler_lib_severity_t severity, assembler_lib_result_t *result)
+{
+	int num_messages = string_vector_get_size(messages);
+	assembler_lib_diagnostic_t *diagnostic = NULL;
+	int i = 0;
+
+	for (i = 0; i < num_messages; ++i, ++result->num_diagnostics)
+	{
+		if (result->num_diagnostics >= result->diagnostics_capacity)
+		{
+			result->is_truncated = TRUE;
+			continue;
+		}
+		diagnostic = &result->diagnostics[result->num_diagnostics];
+		diagnostic->severity = severity;
+		strncpy(diagnostic->message, string_vector_at(messages, i), ASSEMBLER_LIB_MAX_DIAGNOSTIC_SIZE - 1);
+		diagnostic->message[ASSEMBLER_LIB_MAX_DIAGNOSTIC_SIZE - 1] = NULL_TERMINATOR;
+	}
+}
+
+void _assembler_lib_add_symbol(const char *key, void *data, void *result)
+{
+	symbol_t *symbol = (symbol_t *)data;
+	assembler_lib_result_t *lib_result = (assembler_lib_result_t *)result;
+	assembler_lib_symbol_t *lib_symbol = NULL;
+
+	if (lib_result->num_symbols >= lib_result->symbols_capacity)
+	{
+		lib_result->is_truncated = TRUE;
+		++lib_result->num_symbols;
+		return;
+	}
+	lib_symbol = &lib_result->symbols[lib_result->num_symbols++];
+	strcpy(lib_symbol->name, symbol->symbol_name);
+	lib_symbol->value = symbol->symbol_value;
+	lib_symbol->location = symbol->symbol_location == SYMBOL__ENTRY	   ? ASSEMBLER_LIB_SYMBOL__ENTRY
+						   : symbol->symbol_location == SYMBOL__EXTERN ? ASSEMBLER_LIB_SYMBOL__EXTERN
+																	   : ASSEMBLER_LIB_SYMBOL__LOCAL;
+	lib_symbol->type = symbol->memory_type == MEM_TYPE__DATA	 ? ASSEMBLER_LIB_SYMBOL__DATA
+					   : symbol->memory_type == MEM_TYPE__DEFINE ? ASSEMBLER_LIB_SYMBOL__DEFINE
+																 : ASSEMBLER_LIB_SYMBOL__CODE;
+}
+
+void _assembler_lib_add_entry(const char *key, void *data, void *result)
+{
+	symbol_t *symbol = (symbol_t *)data;
+	assembler_lib_result_t *lib_result = (assembler_lib_result_t *)result;
+
+	if (symbol->symbol_location != SYMBOL__ENTRY)
+	{
+		return;
+	}
+	if (lib_result->num_entries >= lib_result->entries_capacity)
+	{
+		lib_result->is_truncated = TRUE;
+		++lib_result->num_entries;
+		return;
+	}
+	strcpy(lib_result->entries[lib_result->num_entries].name, symbol->symbol_name);
+	lib_result->entries[lib_result->num_entries].address = symbol->symbol_value;
+	++lib_result->num_entries;
+}
+
+void _assembler_lib_add_extern_use(const char *name, short address, assembler_lib_result_t *lib_result)
+{
+	if (lib_result->num_extern_uses >= lib_result->extern_uses_capacity)
+	{
+		lib_result->is_truncated = TRUE;
+		++lib_result->num_extern_uses;
+		return;
+	}
+	strcpy(lib_result->extern_uses[lib_result->num_extern_uses].name, name);
+	lib_result->extern_uses[lib_result->num_extern_uses].address = address;
+	++lib_result->num_extern_uses;
+}
+
+int _assembler_lib_fill_outputs(assembler_data_t *assembler_data, assembler_lib_result_t *result)
+{
+	const extern_uses_t *extern_uses = &assembler_data->extern_uses;
+	symbol_t **entry_symbols = NULL;
+	int num_entry_symbols = 0;
+	size_t j = 0;
+	int i = 0;
+
+	_assembler_lib_copy_words(result->code, result->code_capacity, assembler_data->machine_binary_code + IC_INITIAL_VALUE,
+							  assembler_data->IC - IC_INITIAL_VALUE, &result->code_size, &result->is_truncated);
+	_assembler_lib_copy_words(result->data, result->data_capacity, assembler_data->data_memory,
+							  assembler_data->DC, &result->data_size, &result->is_truncated);
+	hash_table_for_each(assembler_data->symbol_table, _assembler_lib_add_symbol, result);
+	/* the entries are listed in the order of the .ent file */
+	entry_symbols = get_ordered_entry_symbols(assembler_data, &num_entry_symbols);
+	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(entry_symbols, "Memory allocation failed in _assembler_lib_fill_outputs", FUNC_ERR);
+	for (i = 0; i < num_entry_symbols; ++i)
+	{
+		_assembler_lib_add_entry(entry_symbols[i]->symbol_name, entry_symbols[i], result);
+	}
+	free(entry_symbols);
+	for (j = 0; j < extern_uses->num_uses; ++j)
+	{
+		_assembler_lib_add_extern_use(extern_uses->names[extern_uses->uses[j].symbol_id], extern_uses->uses[j].address, result);
+	}
+	return SUCCESS;
+}
+
+int _assembler_lib_run(assembler_lib_t *lib, const char *source, size_t source_size, assembler_lib_result_t *result)
+{
+	general_data_pre_process_t *pre_process_data = lib->context->pre_process_data;
+	assembler_data_t *assembler_data = lib->context->assembler_data;
+	FILE *source_stream = NULL;
+	FILE *pre_processed_stream = NULL;
+	char *pre_processed = NULL;
+	size_t pre_processed_size = 0;
+	int ret = SUCCESS;
+
+	source_stream = fmemopen((void *)source, source_size, "r");
+	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(source_stream, "fmemopen failed in _assembler_lib_run", FUNC_ERR);
+	pre_processed_stream = open_memstream(&pre_processed, &pre_processed_size);
+	if (pre_processed_stream == NULL)
+	{
+		LOG(ERROR, PARAMS, "open_memstream failed in _assembler_lib_run");
+		fclose(source_stream);
+		return FUNC_ERR;
+	}
+
+	ret = pre_process_stream(pre_process_data, source_stream, pre_processed_stream);
+	fclose(source_stream);
+	fclose(pre_processed_stream);
+	_assembler_lib_add_diagnostics(pre_process_data->error_founds, ASSEMBLER_LIB_SEVERITY__ERROR, result);
+	_assembler_lib_add_diagnostics(pre_process_data->warning_founds, ASSEMBLER_LIB_SEVERITY__WARNING, result);
+	if (ret != SUCCESS)
+	{
+		free(pre_processed);
+		return ret == USER_ERR ? USER_ERR : FUNC_ERR;
+	}
+
+	pre_processed_stream = fmemopen(pre_processed, pre_processed_size, "r");
+	if (pre_processed_stream == NULL)
+	{
+		LOG(ERROR, PARAMS, "fmemopen failed in _assembler_lib_run");
+		free(pre_processed);
+		return FUNC_ERR;
+	}
+	ret = assembler_first_pass(assembler_data, pre_processed_stream, pre_process_data->macro_table, pre_process_data->macro_calls);
+	if (ret != FUNC_ERR)
+	{
+		ret = assembler_second_pass(assembler_data, pre_processed_stream);
+	}
+	fclose(pre_processed_stream);
+	free(pre_processed);
+	if (ret == FUNC_ERR)
+	{
+		return FUNC_ERR;
+	}
+
+	_assembler_lib_add_diagnostics(assembler_data->error_founds, ASSEMBLER_LIB_SEVERITY__ERROR, result);
+	_assembler_lib_add_diagnostics(assembler_data->warning_founds, ASSEMBLER_LIB_SEVERITY__WARNING, result);
+	if (string_vector_get_size(assembler_data->error_founds) > 0)
+	{
+		return USER_ERR;
+	}
+	return _assembler_lib_fill_outputs(assembler_data, result);
+}
+
+/*=============================================================================== */
+
+assembler_lib_t *assembler_lib_create()
+{
+	assembler_lib_t *lib = NULL;
+
+	logger_set_enabled(FALSE);
+	lib = (assembler_lib_t *)stats_malloc(sizeof(assembler_lib_t));
+	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(lib, "Memory allocation failed in assembler_lib_create", NULL);
+
+	lib->context = init_assembler_context();
+	if (lib->context == NULL)
+	{
+		free(lib);
+		return NULL;
+	}
+	return lib;
+}
+
+void assembler_lib_free(assembler_lib_t *lib)
+{
+	if (lib != NULL)
+	{
+		free_assembler_context(lib->context);
+		free(lib);
+	}
+}
+
+int assembler_lib_assemble(assembler_lib_t *lib, const char *source, size_t source_size, assembler_lib_result_t *result)
+{
+	int ret = SUCCESS;
+
+	result->code_size = 0;
+	result->data_size = 0;
+	result->num_symbols = 0;
+	result->num_extern_uses = 0;
+	result->num_entries = 0;
+	result->num_diagnostics = 0;
+	result->is_truncated = FALSE;
+
+	ret = _assembler_lib_run(lib, source, source_size, result);
+
+	/* the instance is ready for the next source */
+	clear_pre_process_data(lib->context->pre_process_data);
+	clear_assembler_data(lib->context->assembler_data);
+	return ret;
+}
@@ -0,0 +1,136 @@
+/* *******************************************************************
+ * Authors: Daniel Oren, Elisheva Cirota
+ *
+ * @file assembler_lib.h
+ * @brief This file contains the API of the assembler library (libassembler.a).
+ *
+ * The library assembles source text from a memory buffer, without touching the filesystem, and
+ * returns the results in buffers that the caller owns. An assembler_lib_t keeps its tables between
+ * calls, so assembling many small sources with the same instance is cheap. An instance must not be
+ * used by two threads at the same time, but different instances can.
+ *
+ * Every output of assembler_lib_assemble is an array given by the caller with its capacity.
+ * The library always sets the real number of elements, copies as many as fit, and sets
+ * is_truncated when one of the arrays was too small. An array may be NULL with capacity 0 when
+ * the caller is not interested in it.
+ *
+ *********************************************************************/
+
+#ifndef ASSEMBLER_LIB_H
+#define ASSEMBLER_LIB_H
+
+#include <stdlib.h>
+
+#include "../general_const/general_const.h"
+
+#define ASSEMBLER_LIB_MAX_DIAGNOSTIC_SIZE (256)
+#define ASSEMBLER_LIB_CODE_START_ADDRESS (100) /* address of the first word of the code image */
+
+/* severity of a diagnostic */
+typedef enum assembler_lib_severity
+{
+	ASSEMBLER_LIB_SEVERITY__ERROR,
+	ASSEMBLER_LIB_SEVERITY__WARNING
+} assembler_lib_severity_t;
+
+/* an error or warning, as the assembler prints it */
+typedef struct assembler_lib_diagnostic
+{
+	assembler_lib_severity_t severity;
+	char message[ASSEMBLER_LIB_MAX_DIAGNOSTIC_SIZE]; /* truncated when longer */
+} assembler_lib_diagnostic_t;
+
+/* where a symbol was declared */
+typedef enum assembler_lib_symbol_location
+{
+	ASSEMBLER_LIB_SYMBOL__LOCAL,
+	ASSEMBLER_LIB_SYMBOL__ENTRY,
+	ASSEMBLER_LIB_SYMBOL__EXTERN
+} assembler_lib_symbol_location_t;
+
+/* what a symbol refers to */
+typedef enum assembler_lib_symbol_type
+{
+	ASSEMBLER_LIB_SYMBOL__CODE,
+	ASSEMBLER_LIB_SYMBOL__DATA,
+	ASSEMBLER_LIB_SYMBOL__DEFINE /* a constant of .define */
+} assembler_lib_symbol_type_t;
+
+/* a symbol of the symbol table */
+typedef struct assembler_lib_symbol
+{
+	char name[MAX_LABEL_SIZE];
+	short value; /* the address of a label, or the value of a constant */
+	assembler_lib_symbol_location_t location;
+	assembler_lib_symbol_type_t type;
+} assembler_lib_symbol_t;
+
+/* a use of an extern symbol (a line of the .ext file), or an entry (a line of the .ent file) */
+typedef struct assembler_lib_symbol_address
+{
+	char name[MAX_LABEL_SIZE];
+	short address;
+} assembler_lib_symbol_address_t;
+
+/* the outputs of assembling one source. The caller sets the arrays and the capacities. */
+typedef struct assembler_lib_result
+{
+	short *code; /* the code image, its first word is at ASSEMBLER_LIB_CODE_START_ADDRESS */
+	int code_capacity;
+	int code_size;
+
+	short *data; /* the data image, it follows the code image */
+	int data_capacity;
+	int data_size;
+
+	assembler_lib_symbol_t *symbols;
+	int symbols_capacity;
+	int num_symbols;
+
+	assembler_lib_symbol_address_t *extern_uses;
+	int extern_uses_capacity;
+	int num_extern_uses;
+
+	assembler_lib_symbol_address_t *entries;
+	int entries_capacity;
+	int num_entries;
+
+	assembler_lib_diagnostic_t *diagnostics;
+	int diagnostics_capacity;
+	int num_diagnostics;
+
+	int is_truncated; /* TRUE if at least one of the arrays was too small */
+} assembler_lib_result_t;
+
+typedef struct assembler_lib assembler_lib_t;
+
+/**
+ * Creates an instance of the assembler library.
+ * The log file of the assembler is disabled, the library never writes it.
+ *
+ * @return A pointer to the new instance, or NULL on memory allocation failure.
+ */
+assembler_lib_t *assembler_lib_create();
+
+/**
+ * Frees an instance of the assembler library.
+ *
+ * @param lib The instance to free.
+ */
+void assembler_lib_free(assembler_lib_t *lib);
+
+/**
+ * Assembles source text.
+ *
+ * The diagnostics are always filled. The images, the symbols, the extern uses and the entries
+ * are filled only when the source has no errors.
+ *
+ * @param lib The instance to assemble with.
+ * @param source The source text, the content of a .as file. It doesn't have to be null terminated.
+ * @param source_size The size of the source text in bytes.
+ * @param result The caller owned buffers for the outputs.
+ * @return SUCCESS, USER_ERR if the source has errors, or FUNC_ERR on internal failure.
+ */
+int assembler_lib_assemble(assembler_lib_t *lib, const char *source, size_t source_size, assembler_lib_result_t *result);
+
+#endif /* ASSEMBLER_LIB_H */
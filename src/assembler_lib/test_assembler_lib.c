@@ -0,0 +1,219 @@
+/* *******************************************************************
+ * Authors: Daniel Oren, Elisheva Cirota
+ *
+ * @file  test_assembler_lib.c
+ * @brief This file contains the tests of the assembler library.
+ *
+ * The outputs of the library are compared with the output files of the command line assembler
+ * in expected_output.
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "assembler_lib.h"
+#include "../general_const/general_const.h"
+#include "../utils/utils.h"
+
+#define TEST_LIB_CAPACITY (1024)
+#define TEST_LIB_SMALL_CAPACITY (2)
+#define TEST_LIB_OB_WORD_SIZE (7)
+#define TEST_LIB_OB_WORD_MASK (0x3FFF) /* the .ob file has the 14 bits of a word */
+#define TEST_LIB_SOURCE_NAME ("valid_input/test1/test1.as")
+
+static short g_code[TEST_LIB_CAPACITY];
+static short g_data[TEST_LIB_CAPACITY];
+static assembler_lib_symbol_t g_symbols[TEST_LIB_CAPACITY];
+static assembler_lib_symbol_address_t g_extern_uses[TEST_LIB_CAPACITY];
+static assembler_lib_symbol_address_t g_entries[TEST_LIB_CAPACITY];
+static assembler_lib_diagnostic_t g_diagnostics[TEST_LIB_CAPACITY];
+
+/* all the arrays of the result get the same capacity */
+void _test_lib_set_capacity(assembler_lib_result_t *result, int capacity)
+{
+	memset(result, 0, sizeof(assembler_lib_result_t));
+	result->code = g_code;
+	result->code_capacity = capacity;
+	result->data = g_data;
+	result->data_capacity = capacity;
+	result->symbols = g_symbols;
+	result->symbols_capacity = capacity;
+	result->extern_uses = g_extern_uses;
+	result->extern_uses_capacity = capacity;
+	result->entries = g_entries;
+	result->entries_capacity = capacity;
+	result->diagnostics = g_diagnostics;
+	result->diagnostics_capacity = capacity;
+}
+
+/* the images of the result are the words of the .ob file */
+int _test_lib_compare_ob(const char *ob_file_name, const assembler_lib_result_t *result)
+{
+	const char lut[] = "*#%!";
+	char encoded_word[TEST_LIB_OB_WORD_SIZE + 1];
+	FILE *ob_file = fopen(ob_file_name, "r");
+	int code_size = 0;
+	int data_size = 0;
+	int address = 0;
+	int word = 0;
+	int expected_word = 0;
+	int is_equal = TRUE;
+	int i = 0;
+	int j = 0;
+
+	if (ob_file == NULL)
+	{
+		return FALSE;
+	}
+	is_equal = fscanf(ob_file, "%d %d", &code_size, &data_size) == 2 && code_size == result->code_size && data_size == result->data_size;
+	for (i = 0; i < code_size + data_size && is_equal; ++i)
+	{
+		is_equal = fscanf(ob_file, "%d %7s", &address, encoded_word) == 2 && address == ASSEMBLER_LIB_CODE_START_ADDRESS + i;
+		for (j = 0, word = 0; j < TEST_LIB_OB_WORD_SIZE && is_equal; ++j)
+		{
+			is_equal = strchr(lut, encoded_word[j]) != NULL;
+			word = word * 4 + (int)(strchr(lut, encoded_word[j]) - lut);
+		}
+		expected_word = (i < code_size ? result->code[i] : result->data[i - code_size]) & TEST_LIB_OB_WORD_MASK;
+		is_equal = is_equal && word == expected_word;
+	}
+	fclose(ob_file);
+	return is_equal;
+}
+
+/* the names and addresses are the lines of the .ent or the .ext file, in the same order */
+int _test_lib_compare_symbol_addresses(const char *file_name, const assembler_lib_symbol_address_t *addresses, int num_addresses)
+{
+	char name[MAX_LABEL_SIZE];
+	FILE *file = fopen(file_name, "r");
+	int address = 0;
+	int is_equal = TRUE;
+	int i = 0;
+
+	if (file == NULL)
+	{
+		return num_addresses == 0;
+	}
+	for (i = 0; is_equal && fscanf(file, "%31s %d", name, &address) == 2; ++i)
+	{
+		is_equal = i < num_addresses && strcmp(name, addresses[i].name) == 0 && address == addresses[i].address;
+	}
+	fclose(file);
+	return is_equal && i == num_addresses;
+}
+
+/* assembles test1 and compares the outputs with the files of the command line assembler */
+int _test_lib_assemble_test1(assembler_lib_t *lib)
+{
+	assembler_lib_result_t result;
+	char *source = NULL;
+	size_t source_size = 0;
+	int ret = SUCCESS;
+
+	if (read_file_to_buffer(TEST_LIB_SOURCE_NAME, &source, &source_size) != SUCCESS)
+	{
+		return FALSE;
+	}
+	_test_lib_set_capacity(&result, TEST_LIB_CAPACITY);
+	ret = assembler_lib_assemble(lib, source, source_size, &result);
+	free(source);
+
+	return ret == SUCCESS && !result.is_truncated &&
+		   _test_lib_compare_ob("expected_output/test1/test1.ob", &result) &&
+		   _test_lib_compare_symbol_addresses("expected_output/test1/test1.ent", result.entries, result.num_entries) &&
+		   _test_lib_compare_symbol_addresses("expected_output/test1/test1.ext", result.extern_uses, result.num_extern_uses);
+}
+
+void test_assembler_lib_assemble(assembler_lib_t *lib)
+{
+	printf("%s test_assembler_lib_assemble\n", _test_lib_assemble_test1(lib) ? "SUCCESS" : "FAILURE");
+}
+
+/* the arrays that are too small get their first elements, and the real sizes are still set */
+void test_assembler_lib_truncated(assembler_lib_t *lib)
+{
+	assembler_lib_result_t result;
+	short first_words[TEST_LIB_SMALL_CAPACITY];
+	char *source = NULL;
+	size_t source_size = 0;
+	int is_ok = TRUE;
+
+	if (read_file_to_buffer(TEST_LIB_SOURCE_NAME, &source, &source_size) != SUCCESS)
+	{
+		printf("FAILURE test_assembler_lib_truncated read_file_to_buffer\n");
+		return;
+	}
+	_test_lib_set_capacity(&result, TEST_LIB_CAPACITY);
+	is_ok &= assembler_lib_assemble(lib, source, source_size, &result) == SUCCESS;
+	memcpy(first_words, g_code, sizeof(first_words));
+
+	_test_lib_set_capacity(&result, TEST_LIB_SMALL_CAPACITY);
+	memset(g_code, 0, sizeof(g_code));
+	is_ok &= assembler_lib_assemble(lib, source, source_size, &result) == SUCCESS;
+	free(source);
+
+	is_ok &= result.is_truncated;
+	is_ok &= result.code_size > TEST_LIB_SMALL_CAPACITY && result.data_size > TEST_LIB_SMALL_CAPACITY;
+	is_ok &= result.num_extern_uses > TEST_LIB_SMALL_CAPACITY && result.num_symbols > TEST_LIB_SMALL_CAPACITY;
+	is_ok &= memcmp(first_words, g_code, sizeof(first_words)) == 0 && g_code[TEST_LIB_SMALL_CAPACITY] == 0;
+	printf("%s test_assembler_lib_truncated\n", is_ok ? "SUCCESS" : "FAILURE");
+}
+
+/* a source with errors has only diagnostics */
+void test_assembler_lib_errors(assembler_lib_t *lib)
+{
+	const char source[] = "MAIN:\tmov r1\n\thlt\n";
+	assembler_lib_result_t result;
+	int is_ok = TRUE;
+
+	_test_lib_set_capacity(&result, TEST_LIB_CAPACITY);
+	is_ok &= assembler_lib_assemble(lib, source, strlen(source), &result) == USER_ERR;
+	is_ok &= result.num_diagnostics > 0 && result.diagnostics[0].severity == ASSEMBLER_LIB_SEVERITY__ERROR;
+	is_ok &= result.code_size == 0 && result.data_size == 0 && result.num_symbols == 0;
+	is_ok &= result.num_extern_uses == 0 && result.num_entries == 0 && !result.is_truncated;
+	printf("%s test_assembler_lib_errors\n", is_ok ? "SUCCESS" : "FAILURE");
+}
+
+/* an empty source is assembled into empty images */
+void test_assembler_lib_empty(assembler_lib_t *lib)
+{
+	assembler_lib_result_t result;
+	int is_ok = TRUE;
+
+	_test_lib_set_capacity(&result, TEST_LIB_CAPACITY);
+	is_ok &= assembler_lib_assemble(lib, "", 0, &result) == SUCCESS;
+	is_ok &= result.code_size == 0 && result.data_size == 0 && result.num_symbols == 0;
+	is_ok &= result.num_extern_uses == 0 && result.num_entries == 0 && result.num_diagnostics == 0;
+	printf("%s test_assembler_lib_empty\n", is_ok ? "SUCCESS" : "FAILURE");
+}
+
+/* the instance is reused after all the other calls, nothing of them is left in its tables */
+void test_assembler_lib_reuse(assembler_lib_t *lib)
+{
+	printf("%s test_assembler_lib_reuse\n", _test_lib_assemble_test1(lib) ? "SUCCESS" : "FAILURE");
+}
+
+void test_assembler_lib()
+{
+	assembler_lib_t *lib = assembler_lib_create();
+
+	if (lib == NULL)
+	{
+		printf("FAILURE assembler_lib_create\n");
+		return;
+	}
+	test_assembler_lib_assemble(lib);
+	test_assembler_lib_truncated(lib);
+	test_assembler_lib_errors(lib);
+	test_assembler_lib_empty(lib);
+	test_assembler_lib_reuse(lib);
+	assembler_lib_free(lib);
+}
+
+/* uncomment this line to run test_assembler_lib */
+/*int main()
+{
+	test_assembler_lib();
+	return SUCCESS;
+}*/
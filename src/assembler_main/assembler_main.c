@@ -3,8 +3,10 @@
  *
  * @file assembler_main.c
  * @brief This file contains the implementation of the main assembler functions.
- * This is is the entry point of the assembler.
+ * The entry point of the assembler is in main.c.
  *********************************************************************/
+#define _POSIX_C_SOURCE 200809L /* for fmemopen and open_memstream */
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -16,18 +18,93 @@
 #include "../pre_processor/preprocessor_consts.h"
 #include "../logger/logger.h"
 #include "../general_const/general_const.h"
+#include "../stats/stats.h"
 #include "../obj_file_builder/obj_file_builder.h"
 #include "../ext_ent_file_builder/ext_ent_file_builder.h"
+#include "../assembler_options/assembler_options.h"
+#include "../tracer/tracer.h"
+#include "../build_cache/build_cache.h"
+#include "../macro_library/macro_library.h"
+#include "../assembler_pipeline/assembler_pipeline.h"
+#include "../output_file/output_file.h"
 #define FILE_EXTENSION_SIZE (4)
+#define MAX_OPTIONS_KEY_SIZE (256)
 /*========================internal function declaration ========================*/
 
 /* print massages of type warning/error to the user */
-int _print_massages(StringVector *msg_vec, enum msg_type msg_type);
-int _print_errors_and_warnings(StringVector *errors_found, StringVector *warnings_found, const char*input_file);
+int _print_massages(FILE *msg_stream, StringVector *msg_vec, enum msg_type msg_type);
+int _print_errors_and_warnings(FILE *msg_stream, StringVector *errors_found, StringVector *warnings_found, const char*input_file);
+/* print the peak memory of the file, when it has a memory budget */
+void _print_memory_report(FILE *msg_stream, assembler_data_t *assembler_data, const char *input_file);
+/* give a context a memory budget, MEMORY_BUDGET_UNLIMITED for none */
+void _set_memory_budget(assembler_context_t *context, size_t limit);
+
+/* the state of a run of assembler_inputs_with_options that is shared by its input files */
+typedef struct assembler_run
+{
+	assembler_context_t *context; /* the context of the next input file */
+	build_cache_t *build_cache; /* NULL when caching is disabled */
+	const char *options_key; /* the options part of the build cache keys */
+	int is_pipelined; /* see assembler_options_t */
+	pipeline_writer_t *writer; /* writes the output files in a pipelined run of several input files, NULL otherwise */
+} assembler_run_t;
+
+/* write the output files of an input file that was assembled in a context, and clear the context */
+void _finish_input(assembler_context_t *context, const char *input_file_name, int written_outputs);
+/* assemble an input file the way the run does, in the context of the run */
+int _assembler_input_of_run(assembler_run_t *run, const char *input_file_name, FILE *msg_stream, int *written_outputs);
+/* assemble an input file, or restore its outputs from the build cache when it did not change */
+int _assembler_input_cached(const char *input_file_name, assembler_run_t *run);
+
+/* an output of _assembler_stdin that is kept in memory, see open_memstream */
+typedef struct memory_output
+{
+	char *content;
+	size_t size;
+} memory_output_t;
+
+/* assemble the source of stdin into the output files of output_name, or into a result on stdout when it is NULL */
+int _assembler_stdin(general_data_pre_process_t *pre_process_data, assembler_data_t *assembler_data, const char *output_name);
+int _assembler_stdin_passes(general_data_pre_process_t *pre_process_data, assembler_data_t *assembler_data, FILE *msg_stream, memory_output_t *outputs, int *written_outputs);
+int _write_memory_output(const char *output_name, const char *extension, const memory_output_t *output);
+int _write_result_of_stdin(memory_output_t *messages, int assembler_ret_val, memory_output_t *outputs, int written_outputs);
+
+/* mark the beginning/end of a stage for the stats and the tracer */
+void _stage_begin(stats_timer_t stage);
+void _stage_end(stats_timer_t stage);
+/* keep the statistics of the symbol and macro tables of the file, before they are cleared */
+void _stats_set_hash_tables(general_data_pre_process_t *pre_process_data, assembler_data_t *assembler_data);
+
+void _stage_begin(stats_timer_t stage)
+{
+	stats_timer_start(stage);
+	TRACE_BEGIN(stats_timer_name(stage), TRACE_CATEGORY_STAGE);
+}
+
+void _stage_end(stats_timer_t stage)
+{
+	TRACE_END(stats_timer_name(stage), TRACE_CATEGORY_STAGE);
+	stats_timer_stop(stage);
+}
+
+void _stats_set_hash_tables(general_data_pre_process_t *pre_process_data, assembler_data_t *assembler_data)
+{
+	HashTableStats table_stats;
+
+	if (stats_get_mode() == STATS_MODE__OFF)
+	{
+		return;
+	}
+	hash_table_get_stats(assembler_data->symbol_table, &table_stats);
+	stats_set_hash_table(STATS_HASH_TABLE__SYMBOLS, &table_stats);
+	hash_table_get_stats(pre_process_data->macro_table, &table_stats);
+	stats_set_hash_table(STATS_HASH_TABLE__MACROS, &table_stats);
+}
 
 /*========================data initialization and freeing========================*/
 
-int _assembler_input(const char *input_file_name, general_data_pre_process_t *pre_process_data, assembler_data_t *assembler_data)
+int _assembler_input(const char *input_file_name, general_data_pre_process_t *pre_process_data, assembler_data_t *assembler_data,
+					 FILE *msg_stream, int *written_outputs, int is_pipelined)
 {
 	int ret = SUCCESS;
 	int file_name_size = strlen(input_file_name);
@@ -37,8 +114,10 @@ int _assembler_input(const char *input_file_name, general_data_pre_process_t *pr
 	FILE *pre_process_output_file = NULL;
 	FILE *pre_process_input_file = NULL;
 	int should_create_output_files = TRUE;
-	
-	pre_process_input_file_name = (char *)malloc(file_name_size + FILE_EXTENSION_SIZE + 1);
+	int first_pass_ret = SUCCESS;
+
+	*written_outputs = 0;
+	pre_process_input_file_name = (char *)stats_malloc(file_name_size + FILE_EXTENSION_SIZE + 1);
 	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(pre_process_input_file_name, "Memory allocation failed in _assembler_input for pre_process_input_file_name", FUNC_ERR);
 
 	get_output_file_name(input_file_name, pre_process_input_file_name, SRC_FILE_EXTENSION);
@@ -46,13 +125,13 @@ int _assembler_input(const char *input_file_name, general_data_pre_process_t *pr
 
 	if (pre_process_input_file == NULL)
 	{
-		free(pre_process_input_file_name);
 		LOG(ERROR, PARAMS, "Error opening file %s", pre_process_input_file_name);
-		printf("failed on opening file %s, will not continue to the assembler process \n", pre_process_input_file_name);
+		fprintf(msg_stream, "failed on opening file %s, will not continue to the assembler process \n", pre_process_input_file_name);
+		free(pre_process_input_file_name);
 		return USER_ERR;
 	}
 
-	pre_process_output_file_name = (char *)malloc(file_name_size + FILE_EXTENSION_SIZE + 1);
+	pre_process_output_file_name = (char *)stats_malloc(file_name_size + FILE_EXTENSION_SIZE + 1);
 	if (pre_process_output_file_name == NULL)
 	{
 		free(pre_process_input_file_name);
@@ -60,26 +139,38 @@ int _assembler_input(const char *input_file_name, general_data_pre_process_t *pr
 		LOG(ERROR, PARAMS, "Memory allocation failed in _assembler_input for pre_process_output_file_name");
 		return FUNC_ERR;
 	}
-	ret = pre_process_input(pre_process_data, pre_process_input_file, input_file_name, pre_process_output_file_name);
+	if (is_pipelined)
+	{
+		/* the first pass runs together with the pre processor, it is done when the pre processor is */
+		ret = pipeline_pre_process_and_first_pass(pre_process_data, assembler_data, pre_process_input_file, input_file_name,
+												  pre_process_output_file_name, &first_pass_ret);
+	}
+	else
+	{
+		_stage_begin(STATS_TIMER__PRE_PROCESS);
+		ret = pre_process_input(pre_process_data, pre_process_input_file, input_file_name, pre_process_output_file_name);
+		_stage_end(STATS_TIMER__PRE_PROCESS);
+	}
 	if (ret != SUCCESS)
 	{
 		free(pre_process_input_file_name);
 		free(pre_process_output_file_name);
 		LOG(ERROR, PARAMS, "Error pre processing file %s", input_file_name);
-		ret = _print_errors_and_warnings(pre_process_data->error_founds, pre_process_data->warning_founds, input_file_name);
+		ret = _print_errors_and_warnings(msg_stream, pre_process_data->error_founds, pre_process_data->warning_founds, input_file_name);
 		if (ret == FUNC_ERR)
 		{
 			return ret;
 		}
 		else if (ret == USER_ERR)
 		{
-			printf("failed on pre processing file %s, will not continue for first pass\n", input_file_name);
+			fprintf(msg_stream, "failed on pre processing file %s, will not continue for first pass\n", input_file_name);
 			return USER_ERR;
 		}
 			return ret;
 	}
 
 	free(pre_process_input_file_name);
+	*written_outputs |= BUILD_CACHE_OUTPUT__AM;
 
 	pre_process_output_file = fopen(pre_process_output_file_name, "r");
 	if (pre_process_output_file == NULL)
@@ -88,8 +179,17 @@ int _assembler_input(const char *input_file_name, general_data_pre_process_t *pr
 		return FUNC_ERR;
 	}
 
-	LOG(INFO, PARAMS, "starting assembler first pass on %s.", pre_process_output_file_name);
-	ret = assembler_first_pass(assembler_data, pre_process_output_file, pre_process_data->macro_table);
+	if (is_pipelined)
+	{
+		ret = first_pass_ret;
+	}
+	else
+	{
+		LOG(INFO, PARAMS, "starting assembler first pass on %s.", pre_process_output_file_name);
+		_stage_begin(STATS_TIMER__FIRST_PASS);
+		ret = assembler_first_pass(assembler_data, pre_process_output_file, pre_process_data->macro_table, pre_process_data->macro_calls);
+		_stage_end(STATS_TIMER__FIRST_PASS);
+	}
 	if (ret == FUNC_ERR)
 	{
 		LOG(ERROR, PARAMS, "Error in first pass processing file %s", input_file_name);
@@ -100,13 +200,16 @@ int _assembler_input(const char *input_file_name, general_data_pre_process_t *pr
 		should_create_output_files = FALSE;
 	}
 
+	_stage_begin(STATS_TIMER__SECOND_PASS);
 	ret = assembler_second_pass(assembler_data, pre_process_output_file);
+	_stage_end(STATS_TIMER__SECOND_PASS);
 	if (ret == FUNC_ERR)
 	{
 		LOG(ERROR, PARAMS, "Error in second pass processing file %s", input_file_name);
 		return ret;
 	}
-	ret = _print_errors_and_warnings(assembler_data->error_founds, assembler_data->warning_founds, input_file_name);
+	ret = _print_errors_and_warnings(msg_stream, assembler_data->error_founds, assembler_data->warning_founds, input_file_name);
+	_print_memory_report(msg_stream, assembler_data, input_file_name);
 	if (ret == FUNC_ERR)
 	{
 		return ret;
@@ -118,9 +221,16 @@ int _assembler_input(const char *input_file_name, general_data_pre_process_t *pr
 
 	if (should_create_output_files)
 	{
-		build_obj_file(input_file_name, assembler_data);
-		build_entry_file(input_file_name, assembler_data);
-		build_extern_file(input_file_name, assembler_data);
+		/* the files are written by _finish_input, the entry and extern files only when there is something to write to them */
+		*written_outputs |= BUILD_CACHE_OUTPUT__OB;
+		if (assembler_data->has_entry)
+		{
+			*written_outputs |= BUILD_CACHE_OUTPUT__ENT;
+		}
+		if (assembler_data->extern_uses.num_uses > 0)
+		{
+			*written_outputs |= BUILD_CACHE_OUTPUT__EXT;
+		}
 	}
 
 	free(pre_process_output_file_name);
@@ -133,78 +243,424 @@ int _assembler_input(const char *input_file_name, general_data_pre_process_t *pr
 	return ret;
 }
 
-void _free_pre_process_data(general_data_pre_process_t *pre_process_data)
+void _finish_input(assembler_context_t *context, const char *input_file_name, int written_outputs)
+{
+	assembler_data_t *assembler_data = context->assembler_data;
+
+	if (written_outputs & BUILD_CACHE_OUTPUT__OB)
+	{
+		_stage_begin(STATS_TIMER__OBJ_FILE);
+		build_obj_file(input_file_name, assembler_data);
+		_stage_end(STATS_TIMER__OBJ_FILE);
+
+		_stage_begin(STATS_TIMER__ENT_FILE);
+		build_entry_file(input_file_name, assembler_data);
+		_stage_end(STATS_TIMER__ENT_FILE);
+
+		_stage_begin(STATS_TIMER__EXT_FILE);
+		build_extern_file(input_file_name, assembler_data);
+		_stage_end(STATS_TIMER__EXT_FILE);
+	}
+
+	/* the context is ready for the next input file */
+	_stats_set_hash_tables(context->pre_process_data, assembler_data);
+	clear_pre_process_data(context->pre_process_data);
+	clear_assembler_data(assembler_data);
+}
+
+int _assembler_input_of_run(assembler_run_t *run, const char *input_file_name, FILE *msg_stream, int *written_outputs)
+{
+	int ret = SUCCESS;
+
+	if (!run->is_pipelined)
+	{
+		return assembler_input_with_context(run->context, input_file_name, msg_stream, written_outputs);
+	}
+	ret = _assembler_input(input_file_name, run->context->pre_process_data, run->context->assembler_data, msg_stream, written_outputs, TRUE);
+	if (run->writer == NULL)
+	{
+		_finish_input(run->context, input_file_name, *written_outputs);
+	}
+	else
+	{
+		/* the output files are written while the next input file is assembled in another context */
+		run->context = pipeline_writer_submit(run->writer, run->context, input_file_name, *written_outputs);
+	}
+	return ret;
+}
+
+int _assembler_stdin_passes(general_data_pre_process_t *pre_process_data, assembler_data_t *assembler_data, FILE *msg_stream, memory_output_t *outputs, int *written_outputs)
+{
+	FILE *output_stream = NULL;
+	FILE *pre_processed_stream = NULL;
+	int should_create_output_files = TRUE;
+	int ret = SUCCESS;
+
+	/* the .am content never touches the disk, the passes read it back from memory */
+	output_stream = open_memstream(&outputs[0].content, &outputs[0].size);
+	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(output_stream, "open_memstream failed in _assembler_stdin_passes", FUNC_ERR);
+	_stage_begin(STATS_TIMER__PRE_PROCESS);
+	ret = pre_process_stream(pre_process_data, stdin, output_stream);
+	_stage_end(STATS_TIMER__PRE_PROCESS);
+	fclose(output_stream);
+	if (ret != SUCCESS)
+	{
+		ret = _print_errors_and_warnings(msg_stream, pre_process_data->error_founds, pre_process_data->warning_founds, STDIN_INPUT_NAME);
+		if (ret == USER_ERR)
+		{
+			fprintf(msg_stream, "failed on pre processing file %s, will not continue for first pass\n", STDIN_INPUT_NAME);
+		}
+		return ret == SUCCESS ? FUNC_ERR : ret;
+	}
+	*written_outputs |= BUILD_CACHE_OUTPUT__AM;
+
+	pre_processed_stream = fmemopen(outputs[0].content, outputs[0].size, "r");
+	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(pre_processed_stream, "fmemopen failed in _assembler_stdin_passes", FUNC_ERR);
+	_stage_begin(STATS_TIMER__FIRST_PASS);
+	ret = assembler_first_pass(assembler_data, pre_processed_stream, pre_process_data->macro_table, pre_process_data->macro_calls);
+	_stage_end(STATS_TIMER__FIRST_PASS);
+	should_create_output_files = ret == SUCCESS;
+	if (ret != FUNC_ERR)
+	{
+		_stage_begin(STATS_TIMER__SECOND_PASS);
+		ret = assembler_second_pass(assembler_data, pre_processed_stream);
+		_stage_end(STATS_TIMER__SECOND_PASS);
+	}
+	fclose(pre_processed_stream);
+	if (ret == FUNC_ERR)
+	{
+		LOG(ERROR, PARAMS, "Error in the passes of %s", STDIN_INPUT_NAME);
+		return ret;
+	}
+	ret = _print_errors_and_warnings(msg_stream, assembler_data->error_founds, assembler_data->warning_founds, STDIN_INPUT_NAME);
+	_print_memory_report(msg_stream, assembler_data, STDIN_INPUT_NAME);
+	if (ret != SUCCESS || !should_create_output_files)
+	{
+		return ret == FUNC_ERR ? FUNC_ERR : USER_ERR;
+	}
+
+	/* the entry and extern files are created only when there is something to write to them */
+	*written_outputs |= BUILD_CACHE_OUTPUT__OB;
+	*written_outputs |= assembler_data->has_entry ? BUILD_CACHE_OUTPUT__ENT : 0;
+	*written_outputs |= assembler_data->extern_uses.num_uses > 0 ? BUILD_CACHE_OUTPUT__EXT : 0;
+
+	output_stream = open_memstream(&outputs[1].content, &outputs[1].size);
+	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(output_stream, "open_memstream failed in _assembler_stdin_passes", FUNC_ERR);
+	_stage_begin(STATS_TIMER__OBJ_FILE);
+	write_obj_file(output_stream, assembler_data);
+	_stage_end(STATS_TIMER__OBJ_FILE);
+	fclose(output_stream);
+
+	output_stream = open_memstream(&outputs[2].content, &outputs[2].size);
+	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(output_stream, "open_memstream failed in _assembler_stdin_passes", FUNC_ERR);
+	_stage_begin(STATS_TIMER__ENT_FILE);
+	ret = write_entry_file(output_stream, assembler_data);
+	_stage_end(STATS_TIMER__ENT_FILE);
+	fclose(output_stream);
+	if (ret != SUCCESS)
+	{
+		return ret;
+	}
+
+	output_stream = open_memstream(&outputs[3].content, &outputs[3].size);
+	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(output_stream, "open_memstream failed in _assembler_stdin_passes", FUNC_ERR);
+	_stage_begin(STATS_TIMER__EXT_FILE);
+	ret = write_extern_file(output_stream, assembler_data);
+	_stage_end(STATS_TIMER__EXT_FILE);
+	fclose(output_stream);
+	return ret;
+}
+
+int _write_memory_output(const char *output_name, const char *extension, const memory_output_t *output)
+{
+	char *output_file_name = (char *)stats_malloc(strlen(output_name) + FILE_EXTENSION_SIZE + 1);
+	int ret = SUCCESS;
+
+	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(output_file_name, "Memory allocation failed in _write_memory_output", FUNC_ERR);
+	get_output_file_name(output_name, output_file_name, extension);
+	ret = output_file_write(output_file_name, output->content, output->size);
+	free(output_file_name);
+	return ret;
+}
+
+int _write_result_of_stdin(memory_output_t *messages, int assembler_ret_val, memory_output_t *outputs, int written_outputs)
+{
+	char *contents[BUILD_CACHE_NUM_OUTPUTS];
+	size_t sizes[BUILD_CACHE_NUM_OUTPUTS];
+	int i = 0;
+
+	for (i = 0; i < BUILD_CACHE_NUM_OUTPUTS; ++i)
+	{
+		contents[i] = (written_outputs & (1 << i)) ? outputs[i].content : NULL;
+		sizes[i] = outputs[i].size;
+	}
+	return build_cache_write_result_contents(stdout, messages->content, messages->size, assembler_ret_val, contents, sizes);
+}
+
+int _assembler_stdin(general_data_pre_process_t *pre_process_data, assembler_data_t *assembler_data, const char *output_name)
 {
-	if (pre_process_data != NULL)
+	static const char *const extensions[BUILD_CACHE_NUM_OUTPUTS] = {PRE_PROCESSOR_FILE_EXTENSION, OBJ_FILE_EXTENSION, ENT_FILE_EXTENSION, EXT_FILE_EXTENSION};
+	memory_output_t outputs[BUILD_CACHE_NUM_OUTPUTS];
+	memory_output_t messages;
+	FILE *msg_stream = stdout;
+	int written_outputs = 0;
+	int ret = SUCCESS;
+	int write_ret = SUCCESS;
+	int i = 0;
+
+	memset(outputs, 0, sizeof(outputs));
+	memset(&messages, 0, sizeof(messages));
+	/* without output files, the messages are a part of the result on stdout */
+	if (output_name == NULL)
+	{
+		msg_stream = open_memstream(&messages.content, &messages.size);
+		CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(msg_stream, "open_memstream failed in _assembler_stdin", FUNC_ERR);
+	}
+
+	ret = _assembler_stdin_passes(pre_process_data, assembler_data, msg_stream, outputs, &written_outputs);
+
+	if (output_name == NULL)
+	{
+		fclose(msg_stream);
+		if (ret != FUNC_ERR)
+		{
+			write_ret = _write_result_of_stdin(&messages, ret, outputs, written_outputs);
+		}
+	}
+	for (i = 0; i < BUILD_CACHE_NUM_OUTPUTS && output_name != NULL && ret != FUNC_ERR && write_ret == SUCCESS; ++i)
 	{
-		free_pre_process_data(pre_process_data);
+		if (written_outputs & (1 << i))
+		{
+			write_ret = _write_memory_output(output_name, extensions[i], &outputs[i]);
+		}
 	}
+
+	for (i = 0; i < BUILD_CACHE_NUM_OUTPUTS; ++i)
+	{
+		free(outputs[i].content);
+	}
+	free(messages.content);
+	return write_ret != SUCCESS ? FUNC_ERR : ret;
 }
-void _free_assembler_data(assembler_data_t *assembler_data)
+
+int _assembler_input_cached(const char *input_file_name, assembler_run_t *run)
 {
-	if (assembler_data != NULL)
+	char key[BUILD_CACHE_KEY_SIZE];
+	FILE *msg_stream = NULL;
+	char *messages = NULL;
+	size_t messages_size = 0;
+	int written_outputs = 0;
+	int ret = SUCCESS;
+
+	if (run->build_cache == NULL || build_cache_compute_key(input_file_name, run->options_key, key) != SUCCESS)
+	{
+		/* without a key (for example, the input file does not exist) the input is assembled as usual */
+		return _assembler_input_of_run(run, input_file_name, stdout, &written_outputs);
+	}
+
+	if (build_cache_restore(run->build_cache, key, input_file_name, stdout, &ret) == BUILD_CACHE_HIT)
+	{
+		return ret;
+	}
+
+	/* the errors and warnings are captured, so they can be stored with the output files */
+	msg_stream = tmpfile();
+	if (msg_stream == NULL)
 	{
-		free_assembler_data(assembler_data);
+		LOG(ERROR, PARAMS, "failed to create a temporary file for the messages of %s", input_file_name);
+		return _assembler_input_of_run(run, input_file_name, stdout, &written_outputs);
 	}
+	ret = _assembler_input_of_run(run, input_file_name, msg_stream, &written_outputs);
+
+	if (read_stream_to_buffer(msg_stream, &messages, &messages_size) != SUCCESS)
+	{
+		LOG(ERROR, PARAMS, "failed to read back the messages of %s", input_file_name);
+		fclose(msg_stream);
+		return FUNC_ERR;
+	}
+	fclose(msg_stream);
+	fwrite(messages, 1, messages_size, stdout);
+
+	/* internal failures are not a result of the input, so they are never cached */
+	if (ret == SUCCESS || ret == USER_ERR)
+	{
+		/* the entry is made of the output files, so they must be written first */
+		pipeline_writer_wait(run->writer);
+		if (build_cache_store(run->build_cache, key, input_file_name, messages, messages_size, ret, written_outputs) != SUCCESS)
+		{
+			LOG(WARNING, PARAMS, "failed to store %s in the build cache", input_file_name);
+		}
+	}
+	free(messages);
+	return ret;
 }
-int _destruct_assembler_all_data(general_data_pre_process_t *pre_process_data, assembler_data_t *assembler_data)
+
+assembler_context_t *init_assembler_context()
 {
-	if (pre_process_data != NULL)
+	assembler_context_t *context = (assembler_context_t *)stats_calloc(1, sizeof(assembler_context_t));
+	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(context, "Memory allocation failed in init_assembler_context", NULL);
+
+	/* initialize pre processor general data*/
+	context->pre_process_data = init_pre_process_general_data();
+	if (context->pre_process_data == NULL)
 	{
-		_free_pre_process_data(pre_process_data);
+		LOG(ERROR, PARAMS, "Error initializing pre process data");
+		free_assembler_context(context);
+		return NULL;
 	}
-	if (assembler_data != NULL)
+
+	context->assembler_data = init_assembler_data();
+	if (context->assembler_data == NULL)
 	{
-		_free_assembler_data(assembler_data);
+		LOG(ERROR, PARAMS, "Error initializing assembler_data data");
+		free_assembler_context(context);
+		return NULL;
 	}
-	return SUCCESS;
+	return context;
 }
 
-void _clear_assembler_all_data(general_data_pre_process_t *pre_process_data, assembler_data_t *assembler_data)
+void free_assembler_context(assembler_context_t *context)
 {
-	if (pre_process_data != NULL)
+	if (context == NULL)
+	{
+		return;
+	}
+	if (context->pre_process_data != NULL)
 	{
-		clear_pre_process_data(pre_process_data);
+		free_pre_process_data(context->pre_process_data);
 	}
-	if (assembler_data != NULL)
+	if (context->assembler_data != NULL)
 	{
-		clear_assembler_data(assembler_data);
+		free_assembler_data(context->assembler_data);
 	}
+	free(context);
+}
+
+int assembler_input_with_context(assembler_context_t *context, const char *input_file_name, FILE *msg_stream, int *written_outputs)
+{
+	int ret = _assembler_input(input_file_name, context->pre_process_data, context->assembler_data, msg_stream, written_outputs, FALSE);
+
+	_finish_input(context, input_file_name, *written_outputs);
+	return ret;
 }
 
 int assembler_inputs(const char *input_file_names[], int num_input_files)
+{
+	assembler_options_t options;
+
+	memset(&options, 0, sizeof(assembler_options_t));
+	options.input_file_names = input_file_names;
+	options.num_input_files = num_input_files;
+	options.stats_mode = STATS_MODE__OFF;
+	options.cache_size = BUILD_CACHE_DEFAULT_MAX_SIZE;
+	return assembler_inputs_with_options(&options);
+}
+
+int assembler_inputs_with_options(const assembler_options_t *options)
 {
 	int i = 0;
 	int ret_val = SUCCESS;
-	general_data_pre_process_t *pre_process_data = NULL;
-	assembler_data_t *assembler_data = NULL;
+	assembler_run_t run;
+	assembler_context_t *spare_context = NULL;
+	macro_library_t *macro_library = NULL;
+	char options_key[MAX_OPTIONS_KEY_SIZE];
+	const char **input_file_names = options->input_file_names;
 
-	/* initialize pre processor general data*/
-	pre_process_data = init_pre_process_general_data();
-	if (pre_process_data == NULL)
+	/* the library is parsed once, and all the input files look up its macros and constants */
+	if (options->macro_library_file_name != NULL)
 	{
-		LOG(ERROR, PARAMS, "Error initializing pre process data");
-		return ERROR;
+		macro_library = macro_library_load(options->macro_library_file_name, stdout);
+		if (macro_library == NULL)
+		{
+			return ERR;
+		}
 	}
 
-	assembler_data = init_assembler_data();
-	if (assembler_data == NULL)
+	memset(&run, 0, sizeof(assembler_run_t));
+	run.options_key = options_key;
+	run.is_pipelined = options->is_pipelined;
+	run.context = init_assembler_context();
+	if (run.context == NULL)
 	{
-		LOG(ERROR, PARAMS, "Error initializing assembler_data data");
+		macro_library_free(macro_library);
 		return ERROR;
 	}
+	macro_library_attach(macro_library, run.context);
+	_set_memory_budget(run.context, options->memory_budget);
+	run.context->assembler_data->entry_order = options->entry_order;
+	run.context->assembler_data->is_ext_grouped = options->is_ext_grouped;
+
+	if (run.is_pipelined && options->num_input_files > 1)
+	{
+		/* the outputs of an input file are written in one context while the next input file is assembled in the other */
+		spare_context = init_assembler_context();
+		if (spare_context != NULL)
+		{
+			macro_library_attach(macro_library, spare_context);
+			_set_memory_budget(spare_context, options->memory_budget);
+			spare_context->assembler_data->entry_order = options->entry_order;
+			spare_context->assembler_data->is_ext_grouped = options->is_ext_grouped;
+			run.writer = pipeline_writer_start(spare_context, _finish_input);
+			if (run.writer == NULL)
+			{
+				free_assembler_context(spare_context);
+			}
+		}
+	}
 
-	for (i = 0; i < num_input_files; ++i)
+	if (options->cache_dir != NULL)
 	{
-		ret_val += _assembler_input(input_file_names[i], pre_process_data, assembler_data);
-		_clear_assembler_all_data(pre_process_data, assembler_data);
+		/* a cache that can't be opened only makes the process slower, so the inputs are still assembled */
+		run.build_cache = build_cache_open(options->cache_dir, options->cache_size);
+		if (run.build_cache == NULL)
+		{
+			printf("failed on opening cache directory %s, will continue without it\n", options->cache_dir);
+		}
+		if (get_assembler_options_cache_key(options, macro_library == NULL ? 0 : macro_library_get_hash(macro_library), options_key, sizeof(options_key)) != SUCCESS)
+		{
+			pipeline_writer_stop(run.writer);
+			free_assembler_context(run.context);
+			macro_library_free(macro_library);
+			build_cache_close(run.build_cache);
+			return ERR;
+		}
 	}
-	_destruct_assembler_all_data(pre_process_data, assembler_data);
-	
+
+	for (i = 0; i < options->num_input_files; ++i)
+	{
+		if (stats_begin_file(input_file_names[i]) != SUCCESS)
+		{
+			pipeline_writer_stop(run.writer);
+			free_assembler_context(run.context);
+			macro_library_free(macro_library);
+			build_cache_close(run.build_cache);
+			return ERR;
+		}
+		TRACE_BEGIN(input_file_names[i], TRACE_CATEGORY_FILE);
+		if (strcmp(input_file_names[i], STDIN_INPUT_NAME) == 0)
+		{
+			/* a source read from a pipe can't be hashed before it is read, so it is never cached */
+			ret_val += _assembler_stdin(run.context->pre_process_data, run.context->assembler_data, options->output_name);
+			_stats_set_hash_tables(run.context->pre_process_data, run.context->assembler_data);
+			clear_pre_process_data(run.context->pre_process_data);
+			clear_assembler_data(run.context->assembler_data);
+		}
+		else
+		{
+			ret_val += _assembler_input_cached(input_file_names[i], &run);
+		}
+		TRACE_END(input_file_names[i], TRACE_CATEGORY_FILE);
+		stats_end_file();
+	}
+	pipeline_writer_stop(run.writer);
+	free_assembler_context(run.context);
+	macro_library_free(macro_library);
+	build_cache_close(run.build_cache);
+
 	return ret_val == SUCCESS ? SUCCESS : ERR;
 }
 
-int _print_massages(StringVector *msg_vec, enum msg_type msg_type)
+int _print_massages(FILE *msg_stream, StringVector *msg_vec, enum msg_type msg_type)
 {
 	int i;
 	int msg_num = string_vector_get_size(msg_vec);
@@ -213,7 +669,7 @@ int _print_massages(StringVector *msg_vec, enum msg_type msg_type)
 	int ret_val = SUCCESS;
 	if (msg_num != 0)
 	{
-		printf("%s\n", msg_type_content);
+		fprintf(msg_stream, "%s\n", msg_type_content);
 		for (i = 0; i < msg_num; i++)
 		{
 			msg = string_vector_at(msg_vec, i);
@@ -223,51 +679,65 @@ int _print_massages(StringVector *msg_vec, enum msg_type msg_type)
 				return FUNC_ERR;
 			}
 			ret_val = USER_ERR;
-			printf("%s\n", msg);
+			fprintf(msg_stream, "%s\n", msg);
 		}
 	}
+	if (string_vector_get_num_dropped(msg_vec) > 0)
+	{
+		fprintf(msg_stream, "%d more %s not kept, they are over the memory budget\n", string_vector_get_num_dropped(msg_vec),
+				msg_type == MSG_TYPE__ERROR ? "errors were" : "warnings were");
+	}
 	return ret_val;
 }
 
+void _print_memory_report(FILE *msg_stream, assembler_data_t *assembler_data, const char *input_file)
+{
+	const memory_budget_t *memory_budget = &assembler_data->memory_budget;
 
-int _print_errors_and_warnings(StringVector *errors_found, StringVector *warnings_found, const char *input_file)
+	if (!memory_budget_is_limited(memory_budget))
+	{
+		return;
+	}
+	fprintf(msg_stream, "memory of %s: peak of %lu bytes, budget of %lu bytes", input_file,
+			(unsigned long)memory_budget->peak, (unsigned long)memory_budget->limit);
+	if (assembler_data->num_spilled_lines > 0)
+	{
+		fprintf(msg_stream, ", %d parsed lines were spilled to a temporary file", assembler_data->num_spilled_lines);
+	}
+	fprintf(msg_stream, "\n");
+}
+
+void _set_memory_budget(assembler_context_t *context, size_t limit)
+{
+	size_t diagnostics_size = 0;
+
+	memory_budget_init(&context->assembler_data->memory_budget, limit);
+	diagnostics_size = memory_budget_share(&context->assembler_data->memory_budget, MEMORY_BUDGET_DIAGNOSTICS_SHARE);
+	string_vector_set_max_bytes(context->assembler_data->error_founds, diagnostics_size);
+	string_vector_set_max_bytes(context->assembler_data->warning_founds, diagnostics_size);
+	string_vector_set_max_bytes(context->pre_process_data->error_founds, diagnostics_size);
+	string_vector_set_max_bytes(context->pre_process_data->warning_founds, diagnostics_size);
+}
+
+
+int _print_errors_and_warnings(FILE *msg_stream, StringVector *errors_found, StringVector *warnings_found, const char *input_file)
 {
 	int ret = SUCCESS;
 
 	if (string_vector_get_size(errors_found) > 0)
 	{
 		LOG(INFO, PARAMS, "failed on first pass. Errors:  %s.", input_file);
-		ret = _print_massages(errors_found, MSG_TYPE__ERROR);
+		ret = _print_massages(msg_stream, errors_found, MSG_TYPE__ERROR);
 		if (ret == FUNC_ERR)
 		{
 			LOG(ERROR, PARAMS, "_print_massages function failed");
 			return FUNC_ERR;
 		}
 	}
-	if (_print_massages(warnings_found, MSG_TYPE__WARNING) != SUCCESS)
+	if (_print_massages(msg_stream, warnings_found, MSG_TYPE__WARNING) != SUCCESS)
 	{
 		LOG(ERROR, PARAMS, "_print_massages function failed");
 		return FUNC_ERR;
 	}
 	return ret;
 }
-
-
-/**
- * @brief The entry point of the program.
- *
- * This function is the starting point of the program execution. It takes command line arguments
- * and returns an integer value indicating the exit status of the program.
- *
- * @param argc The number of command line arguments.
- * @param argv An array of strings containing the command line arguments.
- * @return An integer value indicating the exit status of the program.
- */
-int main(int argc, char *argv[]) {
-    if (argc < 2) {
-        return 1;
-    }
-
-	return assembler_inputs((const char **)argv + 1, argc - 1);
-}
-
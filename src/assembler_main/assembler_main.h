@@ -18,6 +18,17 @@
 #include "../utils/utils.h"
 #include "../hash_table/hash_table.h"
 #include "../string_vector/string_vector.h"
+#include "../assembler_options/assembler_options.h"
+#include "../pre_processor/preprocessor.h"
+#include "../assembler/assembler.h"
+
+/* This structure holds everything needed to assemble one input file. It is cleared after every
+ * file and reused for the next one, so the tables are allocated only once. */
+typedef struct assembler_context
+{
+	general_data_pre_process_t *pre_process_data; /* data of the pre processor */
+	assembler_data_t *assembler_data; /* data of the first and second pass */
+} assembler_context_t;
 
 /**
  * @brief Assembles the input files.
@@ -31,4 +42,42 @@
  */
 int assembler_inputs(const char *input_file_names[], int num_input_files);
 
+/**
+ * @brief Assembles the input files with the given options.
+ *
+ * Like assembler_inputs, but the input files and the behavior of the process (stats, build cache)
+ * are taken from the parsed command line options.
+ *
+ * @param options The options of the assembler.
+ * @return SUCCESS if all the input files were assembled successfully, ERR otherwise.
+ */
+int assembler_inputs_with_options(const assembler_options_t *options);
+
+/**
+ * Creates a context for assembling input files.
+ *
+ * @return A pointer to the new context, or NULL on memory allocation failure.
+ */
+assembler_context_t *init_assembler_context();
+
+/**
+ * Frees a context and all of its data.
+ *
+ * @param context The context to free.
+ */
+void free_assembler_context(assembler_context_t *context);
+
+/**
+ * Assembles a single input file with a context, and clears the context for the next file.
+ *
+ * A context must not be used by two threads at the same time, but different contexts can.
+ *
+ * @param context The context to assemble with.
+ * @param input_file_name The name of the input file, without the .as extension.
+ * @param msg_stream The stream to print the errors and warnings of the input file to.
+ * @param written_outputs Set to the BUILD_CACHE_OUTPUT__* flags of the output files that were written.
+ * @return SUCCESS, USER_ERR if the input file has errors, or FUNC_ERR on internal failure.
+ */
+int assembler_input_with_context(assembler_context_t *context, const char *input_file_name, FILE *msg_stream, int *written_outputs);
+
 #endif /* ASSEMBLER_MAIN_H */
@@ -0,0 +1,99 @@
+/* *******************************************************************
+ * Authors: Daniel Oren, Elisheva Cirota
+ *
+ * @file main.c
+ * @brief This file contains the entry point of the assembler.
+ *
+ * It is kept apart from assembler_main.c, so the static library can be linked without it.
+ *********************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "assembler_main.h"
+#include "../general_const/general_const.h"
+#include "../stats/stats.h"
+#include "../assembler_options/assembler_options.h"
+#include "../tracer/tracer.h"
+#include "../assembler_server/assembler_server.h"
+#include "../memory_budget/memory_budget.h"
+#include "../output_file/output_file.h"
+
+/**
+ * @brief The entry point of the program.
+ *
+ * This function is the starting point of the program execution. It takes command line arguments
+ * and returns an integer value indicating the exit status of the program.
+ *
+ * @param argc The number of command line arguments.
+ * @param argv An array of strings containing the command line arguments.
+ * @return An integer value indicating the exit status of the program.
+ */
+int main(int argc, char *argv[]) {
+	assembler_options_t options;
+	int ret_val = SUCCESS;
+
+    if (argc < 2) {
+        return 1;
+    }
+
+	ret_val = parse_assembler_options(argc, argv, &options);
+	if (ret_val != SUCCESS)
+	{
+		free_assembler_options(&options);
+		return 1;
+	}
+	if (options.server_socket_path != NULL && options.stats_mode != STATS_MODE__OFF)
+	{
+		/* the stats are collected per input file of a single thread */
+		printf("--stats is not supported with --server, ignoring it\n");
+		options.stats_mode = STATS_MODE__OFF;
+	}
+	if (options.is_pipelined && options.stats_mode != STATS_MODE__OFF)
+	{
+		/* the stages of an input file run on several threads */
+		printf("--stats is not supported with --pipeline, ignoring it\n");
+		options.stats_mode = STATS_MODE__OFF;
+	}
+	if ((options.server_socket_path != NULL || options.client_socket_path != NULL) && options.memory_budget != MEMORY_BUDGET_UNLIMITED)
+	{
+		/* the workers of a server share their contexts between all the clients */
+		printf("--memory-budget is not supported with --server or --client, ignoring it\n");
+		options.memory_budget = MEMORY_BUDGET_UNLIMITED;
+	}
+	if (options.client_socket_path != NULL && (options.entry_order != ENTRY_ORDER__DEFINITION || options.is_ext_grouped))
+	{
+		/* the .ent and .ext files are written by the server, in the layout it was started with */
+		printf("--ent-sort and --ext-grouped are taken from the server with --client, ignoring them\n");
+		options.entry_order = ENTRY_ORDER__DEFINITION;
+		options.is_ext_grouped = FALSE;
+	}
+	stats_set_mode(options.stats_mode);
+	output_file_set_write_if_changed(options.is_write_if_changed);
+	if (options.trace_file_name != NULL && tracer_enable(options.trace_file_name) != SUCCESS)
+	{
+		free_assembler_options(&options);
+		return 1;
+	}
+
+	if (options.server_socket_path != NULL)
+	{
+		ret_val = assembler_server_run(&options);
+	}
+	else if (options.client_socket_path != NULL)
+	{
+		ret_val = assembler_client_run(&options);
+	}
+	else
+	{
+		ret_val = assembler_inputs_with_options(&options);
+	}
+
+	/* stats are printed to stderr so they are never mixed with the errors and warnings of the input files */
+	stats_print(stderr);
+	stats_free();
+	tracer_write();
+	tracer_free();
+	free_assembler_options(&options);
+	return ret_val;
+}
+
@@ -5,15 +5,75 @@
  * @brief This file contains the implementation of the tests for the assembler main functions.
  *
  *********************************************************************/
+#define _POSIX_C_SOURCE 200809L /* for dup and dup2 */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <ctype.h>
+#include <unistd.h>
 
 #include "../hash_table/hash_table.h"
 #include "../assembler/assembler.h"
 #include "assembler_main.h"
 
+#define TEST_MAX_PATH_SIZE (256)
+
+/* assembles one input file, its errors and warnings are written to output_file_name instead of stdout */
+int _test_assemble_to_file(const char *input_file_name, const char *output_file_name)
+{
+	int saved_stdout = 0;
+	int ret = SUCCESS;
+
+	fflush(stdout);
+	saved_stdout = dup(STDOUT_FILENO);
+	if (saved_stdout < 0)
+	{
+		return FUNC_ERR;
+	}
+	if (freopen(output_file_name, "w", stdout) != NULL)
+	{
+		ret = assembler_inputs(&input_file_name, 1);
+		fflush(stdout);
+	}
+	else
+	{
+		ret = FUNC_ERR;
+	}
+	dup2(saved_stdout, STDOUT_FILENO);
+	close(saved_stdout);
+	return ret;
+}
+
+/* an invalid input fails with the messages of expected_output/<name>/<name>OUT.txt, and has no .ob, .ent or .ext file */
+int _test_invalid_input_messages(const char *name)
+{
+	char input_file_name[TEST_MAX_PATH_SIZE];
+	char messages_file_name[TEST_MAX_PATH_SIZE];
+	char expected_file_name[TEST_MAX_PATH_SIZE];
+	char output_file_name[TEST_MAX_PATH_SIZE];
+	const char *extensions[] = {".ob", ".ent", ".ext"};
+	FILE *output_file = NULL;
+	int i = 0;
+
+	sprintf(input_file_name, "invalid_input/%s/%s", name, name);
+	sprintf(messages_file_name, "invalid_input/%s/%sOUT.txt", name, name);
+	sprintf(expected_file_name, "expected_output/%s/%sOUT.txt", name, name);
+	if (SUCCESS == _test_assemble_to_file(input_file_name, messages_file_name))
+	{
+		return ERR;
+	}
+	for (i = 0; i < sizeof(extensions) / sizeof(extensions[0]); ++i)
+	{
+		sprintf(output_file_name, "%s%s", input_file_name, extensions[i]);
+		if ((output_file = fopen(output_file_name, "r")) != NULL)
+		{
+			fclose(output_file);
+			return ERR;
+		}
+	}
+	return compare_files(fopen(messages_file_name, "r"), fopen(expected_file_name, "r"), TRUE) == SUCCESS ? SUCCESS : ERR;
+}
+
 
 void test_invalid_input_2()
 {
@@ -302,6 +362,110 @@ void test_invalid_input_4()
     return;
 }
 
+/* the second file reuses the memory of the symbols of the first, its extern uses must not see their symbol ids */
+void test_valid_inputs_in_one_run()
+{
+    const char *input_file_names[] = {"valid_input/test8/test8", "valid_input/test9/test9"};
+    int res = 0;
+
+    if (SUCCESS != assembler_inputs(input_file_names, 2))
+    {
+        printf("FAILURE, assembler_inputs test_valid_inputs_in_one_run\n");
+        return;
+    }
+
+    res += compare_files(fopen("valid_input/test8/test8.ob", "r"), fopen("expected_output/test8/test8.ob", "r"), TRUE);
+    res += compare_files(fopen("valid_input/test8/test8.ext", "r"), fopen("expected_output/test8/test8.ext", "r"), TRUE);
+    res += compare_files(fopen("valid_input/test9/test9.ob", "r"), fopen("expected_output/test9/test9.ob", "r"), TRUE);
+    res += compare_files(fopen("valid_input/test9/test9.ext", "r"), fopen("expected_output/test9/test9.ext", "r"), TRUE);
+
+    if (res == SUCCESS)
+    {
+        printf("SUCCESS, test_valid_inputs_in_one_run\n");
+    }
+    else
+    {
+        printf("FAILURE, test_valid_inputs_in_one_run\n");
+    }
+    return;
+}
+
+/* macro parameters, nested macro calls and calls that are copied from a stored expansion */
+void test_valid_input_macro_params()
+{
+    const char *input_file_name = "valid_input/test11/test11";
+    int res = 0;
+
+    if (SUCCESS != assembler_inputs(&input_file_name, 1))
+    {
+        printf("FAILURE, assembler_inputs test_valid_input_macro_params\n");
+        return;
+    }
+
+    res += compare_files(fopen("valid_input/test11/test11.am", "r"), fopen("expected_output/test11/test11.am", "r"), TRUE);
+    res += compare_files(fopen("valid_input/test11/test11.ob", "r"), fopen("expected_output/test11/test11.ob", "r"), TRUE);
+
+    if (res == SUCCESS)
+    {
+        printf("SUCCESS, test_valid_input_macro_params\n");
+    }
+    else
+    {
+        printf("FAILURE, test_valid_input_macro_params\n");
+    }
+    return;
+}
+
+/* a macro that calls itself stops at the nesting limit */
+void test_invalid_input_recursive_macro()
+{
+    printf("%s test_invalid_input_recursive_macro\n", _test_invalid_input_messages("test12") == SUCCESS ? "SUCCESS" : "FAILURE");
+}
+
+/* a call must give an argument for every parameter */
+void test_invalid_input_macro_arguments()
+{
+    printf("%s test_invalid_input_macro_arguments\n", _test_invalid_input_messages("test13") == SUCCESS ? "SUCCESS" : "FAILURE");
+}
+
+/* macros that call each other many times stop at the limit of the expanded lines */
+void test_invalid_input_macro_too_large()
+{
+    printf("%s test_invalid_input_macro_too_large\n", _test_invalid_input_messages("test14") == SUCCESS ? "SUCCESS" : "FAILURE");
+}
+
+/* constant expressions: precedence, unary minus, truncating / and %, shifts and constants of constants */
+void test_valid_input_expressions()
+{
+    const char *input_file_name = "valid_input/test15/test15";
+    int res = 0;
+
+    if (SUCCESS != assembler_inputs(&input_file_name, 1))
+    {
+        printf("FAILURE, assembler_inputs test_valid_input_expressions\n");
+        return;
+    }
+
+    res += compare_files(fopen("valid_input/test15/test15.am", "r"), fopen("expected_output/test15/test15.am", "r"), TRUE);
+    res += compare_files(fopen("valid_input/test15/test15.ob", "r"), fopen("expected_output/test15/test15.ob", "r"), TRUE);
+
+    if (res == SUCCESS)
+    {
+        printf("SUCCESS, test_valid_input_expressions\n");
+    }
+    else
+    {
+        printf("FAILURE, test_valid_input_expressions\n");
+    }
+    return;
+}
+
+/* overflow, division by zero, a missing ')', a value out of range, a bad shift count and a missing operand */
+void test_invalid_input_expressions()
+{
+    printf("%s test_invalid_input_expressions\n", _test_invalid_input_messages("test16") == SUCCESS ? "SUCCESS" : "FAILURE");
+}
+
 
 void test_valid_inputs()
 {
@@ -310,6 +474,9 @@ void test_valid_inputs()
     test_valid_input_4();
     test_valid_input_6();
     test_valid_input_5();
+    test_valid_inputs_in_one_run();
+    test_valid_input_macro_params();
+    test_valid_input_expressions();
 }
 
 void test_invalid_inputs()
@@ -318,6 +485,10 @@ void test_invalid_inputs()
     test_invalid_input_2();
     test_invalid_input_3();
     test_invalid_input_4();
+    test_invalid_input_recursive_macro();
+    test_invalid_input_macro_arguments();
+    test_invalid_input_macro_too_large();
+    test_invalid_input_expressions();
 }
 
 
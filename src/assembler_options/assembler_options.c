@@ -0,0 +1,182 @@
+/* *******************************************************************
+ * Authors: Daniel Oren, Elisheva Cirota
+ *
+ * @file assembler_options.c
+ * @brief This file contains the implementation of the command line options parsing.
+ *
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "assembler_options.h"
+#include "../logger/logger.h"
+#include "../general_const/general_const.h"
+#include "../build_cache/build_cache.h"
+#include "../assembler_server/assembler_server.h"
+#include "../utils/utils.h"
+#include "../memory_budget/memory_budget.h"
+
+#define MAX_SIZE_DIGITS (20) /* the digits of the largest size_t */
+
+int parse_assembler_options(int argc, char *argv[], assembler_options_t *options)
+{
+	int i = 0;
+	char *end = NULL;
+
+	memset(options, 0, sizeof(assembler_options_t));
+	options->stats_mode = STATS_MODE__OFF;
+	options->trace_file_name = NULL;
+	options->cache_dir = NULL;
+	options->cache_size = BUILD_CACHE_DEFAULT_MAX_SIZE;
+	options->server_socket_path = NULL;
+	options->client_socket_path = NULL;
+	options->num_workers = DEFAULT_NUM_OF_WORKERS;
+	options->macro_library_file_name = NULL;
+	options->output_name = NULL;
+	options->is_pipelined = FALSE;
+	options->memory_budget = MEMORY_BUDGET_UNLIMITED;
+	options->is_write_if_changed = FALSE;
+	options->entry_order = ENTRY_ORDER__DEFINITION;
+	options->is_ext_grouped = FALSE;
+
+	options->input_file_names = (const char **)malloc(argc * sizeof(const char *));
+	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(options->input_file_names, "Memory allocation failed in parse_assembler_options", FUNC_ERR);
+
+	for (i = 1; i < argc; ++i)
+	{
+		if (strncmp(argv[i], OPTION_PREFIX, strlen(OPTION_PREFIX)) != 0)
+		{
+			options->input_file_names[options->num_input_files++] = argv[i];
+		}
+		else if (strcmp(argv[i], OPTION_STATS) == 0)
+		{
+			options->stats_mode = STATS_MODE__TABLE;
+		}
+		else if (strcmp(argv[i], OPTION_STATS_JSON) == 0)
+		{
+			options->stats_mode = STATS_MODE__JSON;
+		}
+		else if (strcmp(argv[i], OPTION_STATS_VERBOSE) == 0)
+		{
+			options->stats_mode = STATS_MODE__VERBOSE;
+		}
+		else if (strncmp(argv[i], OPTION_TRACE, strlen(OPTION_TRACE)) == 0 && argv[i][strlen(OPTION_TRACE)] != NULL_TERMINATOR)
+		{
+			options->trace_file_name = argv[i] + strlen(OPTION_TRACE);
+		}
+		else if (strncmp(argv[i], OPTION_CACHE_DIR, strlen(OPTION_CACHE_DIR)) == 0 && argv[i][strlen(OPTION_CACHE_DIR)] != NULL_TERMINATOR)
+		{
+			options->cache_dir = argv[i] + strlen(OPTION_CACHE_DIR);
+		}
+		else if (strncmp(argv[i], OPTION_CACHE_SIZE, strlen(OPTION_CACHE_SIZE)) == 0)
+		{
+			options->cache_size = strtoul(argv[i] + strlen(OPTION_CACHE_SIZE), &end, 10);
+			if (end == argv[i] + strlen(OPTION_CACHE_SIZE) || *end != NULL_TERMINATOR)
+			{
+				printf("invalid cache size %s\n", argv[i] + strlen(OPTION_CACHE_SIZE));
+				LOG(ERROR, PARAMS, "invalid cache size %s", argv[i]);
+				return USER_ERR;
+			}
+		}
+		else if (strncmp(argv[i], OPTION_SERVER, strlen(OPTION_SERVER)) == 0 && argv[i][strlen(OPTION_SERVER)] != NULL_TERMINATOR)
+		{
+			options->server_socket_path = argv[i] + strlen(OPTION_SERVER);
+		}
+		else if (strncmp(argv[i], OPTION_CLIENT, strlen(OPTION_CLIENT)) == 0 && argv[i][strlen(OPTION_CLIENT)] != NULL_TERMINATOR)
+		{
+			options->client_socket_path = argv[i] + strlen(OPTION_CLIENT);
+		}
+		else if (strncmp(argv[i], OPTION_WORKERS, strlen(OPTION_WORKERS)) == 0)
+		{
+			options->num_workers = (int)strtol(argv[i] + strlen(OPTION_WORKERS), &end, 10);
+			if (end == argv[i] + strlen(OPTION_WORKERS) || *end != NULL_TERMINATOR || options->num_workers <= 0)
+			{
+				printf("invalid number of workers %s\n", argv[i] + strlen(OPTION_WORKERS));
+				LOG(ERROR, PARAMS, "invalid number of workers %s", argv[i]);
+				return USER_ERR;
+			}
+		}
+		else if (strncmp(argv[i], OPTION_LIB, strlen(OPTION_LIB)) == 0 && argv[i][strlen(OPTION_LIB)] != NULL_TERMINATOR)
+		{
+			options->macro_library_file_name = argv[i] + strlen(OPTION_LIB);
+		}
+		else if (strncmp(argv[i], OPTION_OUTPUT, strlen(OPTION_OUTPUT)) == 0 && argv[i][strlen(OPTION_OUTPUT)] != NULL_TERMINATOR)
+		{
+			options->output_name = argv[i] + strlen(OPTION_OUTPUT);
+		}
+		else if (strcmp(argv[i], OPTION_PIPELINE) == 0)
+		{
+			options->is_pipelined = TRUE;
+		}
+		else if (strcmp(argv[i], OPTION_WRITE_IF_CHANGED) == 0)
+		{
+			options->is_write_if_changed = TRUE;
+		}
+		else if (strcmp(argv[i], OPTION_ENT_SORT_DEFINITION) == 0)
+		{
+			options->entry_order = ENTRY_ORDER__DEFINITION;
+		}
+		else if (strcmp(argv[i], OPTION_ENT_SORT_ADDRESS) == 0)
+		{
+			options->entry_order = ENTRY_ORDER__ADDRESS;
+		}
+		else if (strcmp(argv[i], OPTION_EXT_GROUPED) == 0)
+		{
+			options->is_ext_grouped = TRUE;
+		}
+		else if (strncmp(argv[i], OPTION_MEMORY_BUDGET, strlen(OPTION_MEMORY_BUDGET)) == 0)
+		{
+			if (memory_budget_parse_size(argv[i] + strlen(OPTION_MEMORY_BUDGET), &options->memory_budget) != SUCCESS)
+			{
+				printf("invalid memory budget %s\n", argv[i] + strlen(OPTION_MEMORY_BUDGET));
+				LOG(ERROR, PARAMS, "invalid memory budget %s", argv[i]);
+				return USER_ERR;
+			}
+		}
+		else
+		{
+			printf("unknown option %s\n", argv[i]);
+			LOG(ERROR, PARAMS, "unknown option %s", argv[i]);
+			return USER_ERR;
+		}
+	}
+	return SUCCESS;
+}
+
+int get_assembler_options_cache_key(const assembler_options_t *options, unsigned long library_hash, char *key, size_t key_size)
+{
+	if (key_size < sizeof("lib=00000000"))
+	{
+		LOG(ERROR, PARAMS, "the buffer of the options key is too small");
+		return ERR;
+	}
+	key[0] = NULL_TERMINATOR;
+	/* the macros and the constants of the library change the outputs, so its content is a part of the key */
+	if (options->macro_library_file_name != NULL)
+	{
+		sprintf(key, "lib=%08lx", library_hash);
+	}
+	/* the messages of a file with a budget have its memory report */
+	if (options->memory_budget != MEMORY_BUDGET_UNLIMITED && strlen(key) + sizeof(";budget=") + MAX_SIZE_DIGITS <= key_size)
+	{
+		sprintf(key + strlen(key), ";budget=%lu", (unsigned long)options->memory_budget);
+	}
+	if (options->entry_order == ENTRY_ORDER__ADDRESS && strlen(key) + sizeof(";ent=address") <= key_size)
+	{
+		strcat(key, ";ent=address");
+	}
+	if (options->is_ext_grouped && strlen(key) + sizeof(";ext=grouped") <= key_size)
+	{
+		strcat(key, ";ext=grouped");
+	}
+	return SUCCESS;
+}
+
+void free_assembler_options(assembler_options_t *options)
+{
+	free(options->input_file_names);
+	options->input_file_names = NULL;
+	options->num_input_files = 0;
+}
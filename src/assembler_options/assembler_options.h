@@ -0,0 +1,90 @@
+/* *******************************************************************
+ * Authors: Daniel Oren, Elisheva Cirota
+ *
+ * @file assembler_options.h
+ * @brief This file contains the declarations of the command line options of the assembler.
+ *
+ *********************************************************************/
+
+#ifndef ASSEMBLER_OPTIONS_H
+#define ASSEMBLER_OPTIONS_H
+
+#include <stdlib.h>
+
+#include "../stats/stats.h"
+#include "../assembler_helper/assembler_helper.h"
+
+#define OPTION_PREFIX ("--")
+#define OPTION_STATS ("--stats")
+#define OPTION_STATS_JSON ("--stats=json")
+#define OPTION_STATS_VERBOSE ("--stats=verbose")
+#define OPTION_TRACE ("--trace=")
+#define OPTION_CACHE_DIR ("--cache-dir=")
+#define OPTION_CACHE_SIZE ("--cache-size=")
+#define OPTION_SERVER ("--server=")
+#define OPTION_CLIENT ("--client=")
+#define OPTION_WORKERS ("--workers=")
+#define OPTION_LIB ("--lib=")
+#define OPTION_OUTPUT ("--output=")
+#define OPTION_PIPELINE ("--pipeline")
+#define OPTION_MEMORY_BUDGET ("--memory-budget=")
+#define OPTION_WRITE_IF_CHANGED ("--write-if-changed")
+#define OPTION_ENT_SORT_DEFINITION ("--ent-sort=definition")
+#define OPTION_ENT_SORT_ADDRESS ("--ent-sort=address")
+#define OPTION_EXT_GROUPED ("--ext-grouped")
+
+#define STDIN_INPUT_NAME ("-") /* an input file name that means the source is read from stdin */
+
+/* This structure holds the options the assembler was invoked with. */
+typedef struct assembler_options
+{
+	const char **input_file_names; /* the input files (without the .as extension), in the given order */
+	int num_input_files; /* number of input files */
+	stats_mode_t stats_mode; /* if and how to print the stats of the process */
+	const char *trace_file_name; /* where to write the Chrome trace of the process, NULL when tracing is disabled */
+	const char *cache_dir; /* directory of the build cache, NULL when caching is disabled */
+	unsigned long cache_size; /* maximal size of the build cache in bytes */
+	const char *server_socket_path; /* run as a server listening on this socket, NULL otherwise */
+	const char *client_socket_path; /* send the input files to the server listening on this socket, NULL otherwise */
+	int num_workers; /* number of worker threads of the server */
+	const char *macro_library_file_name; /* macro library shared by all the input files, NULL when there is none */
+	const char *output_name; /* output files name (without extension) of the source of stdin, NULL to write them to stdout */
+	int is_pipelined; /* TRUE to run the stages of the assembler on threads of their own, see assembler_pipeline.h */
+	size_t memory_budget; /* memory budget of every input file in bytes, MEMORY_BUDGET_UNLIMITED when there is none */
+	int is_write_if_changed; /* TRUE to leave output files that did not change untouched, see output_file.h */
+	enum entry_order entry_order; /* the order of the lines of the .ent files */
+	int is_ext_grouped; /* TRUE to write every extern symbol once in the .ext files, followed by the addresses of its uses */
+} assembler_options_t;
+
+/**
+ * Parses the command line arguments of the assembler.
+ *
+ * Every argument that starts with "--" is an option, all the other arguments are input file names.
+ *
+ * @param argc The number of command line arguments.
+ * @param argv The command line arguments.
+ * @param options The options structure to fill.
+ * @return SUCCESS, USER_ERR if an unknown option was given, or FUNC_ERR if memory allocation failed.
+ */
+int parse_assembler_options(int argc, char *argv[], assembler_options_t *options);
+
+/**
+ * Writes the options that change the content of the output files or the messages, for the build cache key.
+ * An option that changes the output files must be added here, or the cache would restore stale outputs.
+ *
+ * @param options The options of the assembler.
+ * @param library_hash The hash of the loaded macro library (see macro_library_get_hash), ignored without --lib.
+ * @param key Buffer for the options key.
+ * @param key_size The size of the buffer.
+ * @return SUCCESS, or ERR if the key doesn't fit in the buffer.
+ */
+int get_assembler_options_cache_key(const assembler_options_t *options, unsigned long library_hash, char *key, size_t key_size);
+
+/**
+ * Frees the memory allocated by parse_assembler_options.
+ *
+ * @param options The options structure to free.
+ */
+void free_assembler_options(assembler_options_t *options);
+
+#endif /* ASSEMBLER_OPTIONS_H */
@@ -0,0 +1,424 @@
+/* *******************************************************************
+ * Authors: Daniel Oren, Elisheva Cirota
+ *
+ * @file assembler_pipeline.c
+ * @brief This file contains the implementation of the pipelined mode of the assembler.
+ *
+ * The batches of pre processed text go around two rings: the pre processor fills a batch and
+ * pushes it to the full ring, the first pass reads it and pushes it back to the empty ring. A
+ * NULL batch ends the text. The first pass reads the text like fgets reads the .am file, so its
+ * lines are split exactly like in the sequential mode.
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "assembler_pipeline.h"
+#include "../spsc_ring/spsc_ring.h"
+#include "../logger/logger.h"
+#include "../general_const/general_const.h"
+#include "../stats/stats.h"
+#include "../tracer/tracer.h"
+
+#define PIPELINE_BATCH_SIZE (16384)
+#define PIPELINE_NAMES_SIZE (1024)
+#define PIPELINE_NUM_BATCHES (8)
+#define PIPELINE_WRITER_RING_SIZE (2)
+#define PIPELINE_WRITE_STAGE ("write")
+
+/* a part of the pre processed text, with the macros that were defined until its end */
+typedef struct pipeline_batch
+{
+	size_t size; /* the size of the text */
+	size_t names_size; /* the size of the names */
+	char text[PIPELINE_BATCH_SIZE];
+	char names[PIPELINE_NAMES_SIZE]; /* the names of the macros, each one ends with NULL_TERMINATOR */
+} pipeline_batch_t;
+
+/* the pre processed text of one input file, between the pre processor thread and the first pass */
+typedef struct pipeline_lines
+{
+	spsc_ring_t *full_batches; /* batches to read, from the pre processor */
+	spsc_ring_t *empty_batches; /* batches to fill, from the first pass */
+	pipeline_batch_t *batches;
+
+	/* used by the pre processor thread */
+	general_data_pre_process_t *pre_process_data;
+	FILE *input_file;
+	const char *file_name;
+	char *output_file_name;
+	int pre_process_ret;
+	pipeline_batch_t *filling; /* the batch that is filled now */
+
+	/* used by the first pass */
+	pipeline_batch_t *reading; /* the batch that is read now, NULL before the first one */
+	size_t read_offset;
+	int is_end; /* TRUE once the NULL batch was read */
+	HashTable *macro_names; /* the macros that were defined so far, the macro table of the first pass */
+	HashTable *labels; /* the labels that were parsed so far */
+	int is_macro_after_label; /* TRUE when a macro was defined after a label with its name was parsed */
+} pipeline_lines_t;
+
+/* an input file whose outputs are written by the writer thread */
+typedef struct pipeline_job
+{
+	assembler_context_t *context;
+	const char *input_file_name;
+	int written_outputs;
+} pipeline_job_t;
+
+struct pipeline_writer
+{
+	pthread_t thread;
+	pipeline_finish_func finish;
+	spsc_ring_t *jobs; /* jobs to write, a NULL job stops the thread */
+	spsc_ring_t *done_jobs; /* written jobs, their contexts are cleared */
+	pipeline_job_t job; /* there is one job, so one input file is written while the next one is assembled */
+	pipeline_job_t *ready_job; /* the job when it is back from the writer thread, NULL while it is away */
+};
+
+/* =========================== internal functions declarations ================== */
+void _pipeline_push_batch(pipeline_lines_t *lines);
+void _pipeline_on_output(const char *text, void *user_data);
+void _pipeline_on_macro_defined(const char *macro_name, void *user_data);
+void *_pipeline_pre_process_main(void *arg);
+int _pipeline_next_batch(pipeline_lines_t *lines);
+void _pipeline_remember_label(pipeline_lines_t *lines, const char *line);
+char *_pipeline_read_line(char *line, int size, void *source);
+int _pipeline_lines_init(pipeline_lines_t *lines, general_data_pre_process_t *pre_process_data);
+void _pipeline_lines_free(pipeline_lines_t *lines);
+int _pipeline_first_pass_again(general_data_pre_process_t *pre_process_data, assembler_data_t *assembler_data, const char *output_file_name);
+void *_pipeline_writer_main(void *arg);
+
+/* =========================== internal functions implementations ================= */
+
+/* called on the pre processor thread */
+void _pipeline_push_batch(pipeline_lines_t *lines)
+{
+	spsc_ring_push(lines->full_batches, lines->filling);
+	lines->filling = (pipeline_batch_t *)spsc_ring_pop(lines->empty_batches);
+	lines->filling->size = 0;
+	lines->filling->names_size = 0;
+}
+
+void _pipeline_on_output(const char *text, void *user_data)
+{
+	pipeline_lines_t *lines = (pipeline_lines_t *)user_data;
+	size_t size = strlen(text);
+	size_t chunk = 0;
+
+	while (size > 0)
+	{
+		if (lines->filling->size == PIPELINE_BATCH_SIZE)
+		{
+			_pipeline_push_batch(lines);
+		}
+		chunk = PIPELINE_BATCH_SIZE - lines->filling->size;
+		chunk = chunk < size ? chunk : size;
+		memcpy(lines->filling->text + lines->filling->size, text, chunk);
+		lines->filling->size += chunk;
+		text += chunk;
+		size -= chunk;
+	}
+}
+
+void _pipeline_on_macro_defined(const char *macro_name, void *user_data)
+{
+	pipeline_lines_t *lines = (pipeline_lines_t *)user_data;
+	size_t size = strlen(macro_name) + 1;
+
+	/* a macro name is shorter than a line, so it always fits in an empty batch */
+	if (lines->filling->names_size + size > PIPELINE_NAMES_SIZE)
+	{
+		_pipeline_push_batch(lines);
+	}
+	memcpy(lines->filling->names + lines->filling->names_size, macro_name, size);
+	lines->filling->names_size += size;
+}
+
+void *_pipeline_pre_process_main(void *arg)
+{
+	pipeline_lines_t *lines = (pipeline_lines_t *)arg;
+
+	TRACE_BEGIN(stats_timer_name(STATS_TIMER__PRE_PROCESS), TRACE_CATEGORY_STAGE);
+	lines->filling = (pipeline_batch_t *)spsc_ring_pop(lines->empty_batches);
+	lines->filling->size = 0;
+	lines->filling->names_size = 0;
+	pre_process_set_listener(lines->pre_process_data, _pipeline_on_output, _pipeline_on_macro_defined, lines);
+	lines->pre_process_ret = pre_process_input(lines->pre_process_data, lines->input_file, lines->file_name, lines->output_file_name);
+	pre_process_set_listener(lines->pre_process_data, NULL, NULL, NULL);
+
+	/* the last batch, and the end of the text */
+	spsc_ring_push(lines->full_batches, lines->filling);
+	spsc_ring_push(lines->full_batches, NULL);
+	TRACE_END(stats_timer_name(STATS_TIMER__PRE_PROCESS), TRACE_CATEGORY_STAGE);
+	return NULL;
+}
+
+/* gives the read batch back and takes the next one, returns FALSE at the end of the text */
+int _pipeline_next_batch(pipeline_lines_t *lines)
+{
+	const char *name = NULL;
+
+	if (lines->is_end)
+	{
+		return FALSE;
+	}
+	if (lines->reading != NULL)
+	{
+		spsc_ring_push(lines->empty_batches, lines->reading);
+	}
+	lines->reading = (pipeline_batch_t *)spsc_ring_pop(lines->full_batches);
+	lines->read_offset = 0;
+	if (lines->reading == NULL)
+	{
+		lines->is_end = TRUE;
+		return FALSE;
+	}
+
+	/* the sequential first pass sees every macro of the file, so the macros of the batch are known before its lines are parsed */
+	for (name = lines->reading->names; name < lines->reading->names + lines->reading->names_size; name += strlen(name) + 1)
+	{
+		if (hash_table_lookup(lines->labels, name) != NULL)
+		{
+			lines->is_macro_after_label = TRUE;
+		}
+		if (hash_table_lookup(lines->macro_names, name) == NULL && hash_table_insert(lines->macro_names, name, lines) != SUCCESS)
+		{
+			/* the first pass will be run again, like after a conflict */
+			lines->is_macro_after_label = TRUE;
+		}
+	}
+	return TRUE;
+}
+
+/* keeps the label of a line, the first pass checks that a label is not the name of a macro */
+void _pipeline_remember_label(pipeline_lines_t *lines, const char *line)
+{
+	char label_name[MAX_LABEL_SIZE];
+	size_t size = 0;
+
+	if (!is_symbol(line))
+	{
+		return;
+	}
+	size = strchr(line, LABEL_POSTFIX) - line;
+	memcpy(label_name, line, size);
+	label_name[size] = NULL_TERMINATOR;
+	if (hash_table_lookup(lines->labels, label_name) == NULL && hash_table_insert(lines->labels, label_name, lines) != SUCCESS)
+	{
+		lines->is_macro_after_label = TRUE;
+	}
+}
+
+/* reads a line like fgets */
+char *_pipeline_read_line(char *line, int size, void *source)
+{
+	pipeline_lines_t *lines = (pipeline_lines_t *)source;
+	const char *text = NULL;
+	const char *newline = NULL;
+	size_t length = 0;
+	size_t chunk = 0;
+
+	while (length + 1 < (size_t)size && newline == NULL)
+	{
+		if (lines->reading == NULL || lines->read_offset == lines->reading->size)
+		{
+			if (!_pipeline_next_batch(lines))
+			{
+				break;
+			}
+			continue;
+		}
+		text = lines->reading->text + lines->read_offset;
+		chunk = lines->reading->size - lines->read_offset;
+		chunk = chunk < size - 1 - length ? chunk : size - 1 - length;
+		newline = (const char *)memchr(text, NEWLINE_CHARACTER, chunk);
+		chunk = newline != NULL ? (size_t)(newline - text) + 1 : chunk;
+		memcpy(line + length, text, chunk);
+		length += chunk;
+		lines->read_offset += chunk;
+	}
+	if (length == 0)
+	{
+		return NULL;
+	}
+	line[length] = NULL_TERMINATOR;
+	_pipeline_remember_label(lines, line);
+	return line;
+}
+
+int _pipeline_lines_init(pipeline_lines_t *lines, general_data_pre_process_t *pre_process_data)
+{
+	int i = 0;
+
+	memset(lines, 0, sizeof(pipeline_lines_t));
+	lines->pre_process_data = pre_process_data;
+	lines->full_batches = spsc_ring_create(PIPELINE_NUM_BATCHES + 1);
+	lines->empty_batches = spsc_ring_create(PIPELINE_NUM_BATCHES);
+	lines->batches = (pipeline_batch_t *)stats_malloc(PIPELINE_NUM_BATCHES * sizeof(pipeline_batch_t));
+	lines->macro_names = hash_table_init();
+	lines->labels = hash_table_init();
+	if (lines->full_batches == NULL || lines->empty_batches == NULL || lines->batches == NULL || lines->macro_names == NULL || lines->labels == NULL)
+	{
+		LOG(ERROR, PARAMS, "Memory allocation failed in _pipeline_lines_init");
+		_pipeline_lines_free(lines);
+		return FUNC_ERR;
+	}
+	/* the macros of the library are known from the start */
+	hash_table_set_fallback(lines->macro_names, pre_process_data->macro_table->fallback);
+	for (i = 0; i < PIPELINE_NUM_BATCHES; ++i)
+	{
+		spsc_ring_try_push(lines->empty_batches, &lines->batches[i]);
+	}
+	return SUCCESS;
+}
+
+void _pipeline_lines_free(pipeline_lines_t *lines)
+{
+	spsc_ring_free(lines->full_batches);
+	spsc_ring_free(lines->empty_batches);
+	free(lines->batches);
+	if (lines->macro_names != NULL)
+	{
+		hash_table_free(lines->macro_names, NULL);
+	}
+	if (lines->labels != NULL)
+	{
+		hash_table_free(lines->labels, NULL);
+	}
+}
+
+int _pipeline_first_pass_again(general_data_pre_process_t *pre_process_data, assembler_data_t *assembler_data, const char *output_file_name)
+{
+	FILE *pre_processed_file = fopen(output_file_name, "r");
+	int ret = SUCCESS;
+
+	if (pre_processed_file == NULL)
+	{
+		LOG(ERROR, PARAMS, "Error opening file %s", output_file_name);
+		return FUNC_ERR;
+	}
+	clear_assembler_data(assembler_data);
+	ret = assembler_first_pass(assembler_data, pre_processed_file, pre_process_data->macro_table, pre_process_data->macro_calls);
+	fclose(pre_processed_file);
+	return ret;
+}
+
+void *_pipeline_writer_main(void *arg)
+{
+	pipeline_writer_t *writer = (pipeline_writer_t *)arg;
+	pipeline_job_t *job = NULL;
+
+	while ((job = (pipeline_job_t *)spsc_ring_pop(writer->jobs)) != NULL)
+	{
+		TRACE_BEGIN(PIPELINE_WRITE_STAGE, TRACE_CATEGORY_STAGE);
+		writer->finish(job->context, job->input_file_name, job->written_outputs);
+		TRACE_END(PIPELINE_WRITE_STAGE, TRACE_CATEGORY_STAGE);
+		spsc_ring_push(writer->done_jobs, job);
+	}
+	return NULL;
+}
+
+/*=============================================================================== */
+
+int pipeline_pre_process_and_first_pass(general_data_pre_process_t *pre_process_data, assembler_data_t *assembler_data,
+										FILE *input_file, const char *file_name, char *output_file_name, int *first_pass_ret)
+{
+	pipeline_lines_t lines;
+	pthread_t pre_process_thread;
+
+	if (_pipeline_lines_init(&lines, pre_process_data) != SUCCESS)
+	{
+		fclose(input_file);
+		return ERR;
+	}
+	lines.input_file = input_file;
+	lines.file_name = file_name;
+	lines.output_file_name = output_file_name;
+	if (pthread_create(&pre_process_thread, NULL, _pipeline_pre_process_main, &lines) != SUCCESS)
+	{
+		LOG(ERROR, PARAMS, "failed to create the pre processor thread of %s", file_name);
+		_pipeline_lines_free(&lines);
+		fclose(input_file);
+		return ERR;
+	}
+
+	TRACE_BEGIN(stats_timer_name(STATS_TIMER__FIRST_PASS), TRACE_CATEGORY_STAGE);
+	*first_pass_ret = assembler_first_pass_lines(assembler_data, _pipeline_read_line, &lines, lines.macro_names, NULL);
+	TRACE_END(stats_timer_name(STATS_TIMER__FIRST_PASS), TRACE_CATEGORY_STAGE);
+	/* the first pass may stop early, the pre processor still needs empty batches to finish */
+	while (_pipeline_next_batch(&lines))
+	{
+	}
+	pthread_join(pre_process_thread, NULL);
+
+	if (lines.pre_process_ret == SUCCESS && *first_pass_ret != FUNC_ERR && lines.is_macro_after_label)
+	{
+		LOG(INFO, PARAMS, "a macro of %s was defined after a label with its name, running the first pass again", file_name);
+		*first_pass_ret = _pipeline_first_pass_again(pre_process_data, assembler_data, output_file_name);
+	}
+	_pipeline_lines_free(&lines);
+	return lines.pre_process_ret;
+}
+
+pipeline_writer_t *pipeline_writer_start(assembler_context_t *spare_context, pipeline_finish_func finish)
+{
+	pipeline_writer_t *writer = (pipeline_writer_t *)stats_calloc(1, sizeof(pipeline_writer_t));
+
+	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(writer, "Memory allocation failed in pipeline_writer_start", NULL);
+	writer->finish = finish;
+	writer->jobs = spsc_ring_create(PIPELINE_WRITER_RING_SIZE);
+	writer->done_jobs = spsc_ring_create(PIPELINE_WRITER_RING_SIZE);
+	if (writer->jobs == NULL || writer->done_jobs == NULL ||
+		pthread_create(&writer->thread, NULL, _pipeline_writer_main, writer) != SUCCESS)
+	{
+		LOG(ERROR, PARAMS, "failed to start the writer thread");
+		spsc_ring_free(writer->jobs);
+		spsc_ring_free(writer->done_jobs);
+		free(writer);
+		return NULL;
+	}
+	writer->job.context = spare_context;
+	writer->ready_job = &writer->job;
+	return writer;
+}
+
+assembler_context_t *pipeline_writer_submit(pipeline_writer_t *writer, assembler_context_t *context, const char *input_file_name, int written_outputs)
+{
+	assembler_context_t *cleared_context = NULL;
+
+	pipeline_writer_wait(writer);
+	cleared_context = writer->ready_job->context;
+	writer->ready_job->context = context;
+	writer->ready_job->input_file_name = input_file_name;
+	writer->ready_job->written_outputs = written_outputs;
+	spsc_ring_push(writer->jobs, writer->ready_job);
+	writer->ready_job = NULL;
+	return cleared_context;
+}
+
+void pipeline_writer_wait(pipeline_writer_t *writer)
+{
+	if (writer != NULL && writer->ready_job == NULL)
+	{
+		writer->ready_job = (pipeline_job_t *)spsc_ring_pop(writer->done_jobs);
+	}
+}
+
+void pipeline_writer_stop(pipeline_writer_t *writer)
+{
+	if (writer == NULL)
+	{
+		return;
+	}
+	pipeline_writer_wait(writer);
+	spsc_ring_push(writer->jobs, NULL);
+	pthread_join(writer->thread, NULL);
+	free_assembler_context(writer->job.context);
+	spsc_ring_free(writer->jobs);
+	spsc_ring_free(writer->done_jobs);
+	free(writer);
+}
@@ -0,0 +1,87 @@
+/* *******************************************************************
+ * Authors: Daniel Oren, Elisheva Cirota
+ *
+ * @file assembler_pipeline.h
+ * @brief This file contains the declarations of the pipelined mode of the assembler (--pipeline).
+ *
+ * In the pipelined mode the stages of the assembler run on threads of their own, connected by
+ * single-producer/single-consumer rings, so reading and writing files overlaps with parsing:
+ *
+ * - The pre processor runs on a thread of its own. The text it writes to the .am file is also
+ *   pushed, in batches, to the first pass, which parses it while the rest of the input file is
+ *   pre processed. The .am file is still written, the second pass reads it.
+ * - In runs of several input files, the output files of an input file are written by a writer
+ *   thread while the next input file is assembled.
+ *
+ * The outputs and the messages are the same as in the sequential mode. The stats must be off,
+ * since the stats counters are not synchronized between threads.
+ *
+ *********************************************************************/
+
+#ifndef ASSEMBLER_PIPELINE_H
+#define ASSEMBLER_PIPELINE_H
+
+#include <stdio.h>
+
+#include "../assembler_main/assembler_main.h"
+
+typedef struct pipeline_writer pipeline_writer_t;
+
+/* Writes the output files of an input file that was assembled in a context, and clears the context for the next input file */
+typedef void (*pipeline_finish_func)(assembler_context_t *context, const char *input_file_name, int written_outputs);
+
+/**
+ * Pre processes an input file on a thread of its own, while the first pass parses the pre
+ * processed lines on the calling thread.
+ *
+ * The first pass sees the macros of the whole input file, like in the sequential mode: when a
+ * macro is defined after a label with its name was parsed, the first pass is run again on the
+ * complete .am file.
+ *
+ * @param pre_process_data The data of the pre processor.
+ * @param assembler_data The data of the first pass.
+ * @param input_file The input file, it is closed.
+ * @param file_name The name of the input file, without its extension.
+ * @param output_file_name Set to the name of the .am file, see pre_process_input.
+ * @param first_pass_ret Set to the return value of the first pass, when the pre processing succeeded.
+ * @return The return value of the pre processor, see pre_process_input.
+ */
+int pipeline_pre_process_and_first_pass(general_data_pre_process_t *pre_process_data, assembler_data_t *assembler_data,
+										FILE *input_file, const char *file_name, char *output_file_name, int *first_pass_ret);
+
+/**
+ * Starts a writer thread.
+ *
+ * @param spare_context A context that is given back for the next input file while the outputs of the previous one are
+ *                      written. It is owned by the writer from now on.
+ * @param finish Writes the outputs of an input file and clears its context, called on the writer thread.
+ * @return The writer, or NULL if it could not be started, then spare_context is not taken.
+ */
+pipeline_writer_t *pipeline_writer_start(assembler_context_t *spare_context, pipeline_finish_func finish);
+
+/**
+ * Hands an assembled input file to the writer.
+ *
+ * @param writer The writer.
+ * @param context The context the input file was assembled in, it is owned by the writer from now on.
+ * @param input_file_name The name of the input file, it must stay valid until the writer is stopped.
+ * @param written_outputs The outputs to write, BUILD_CACHE_OUTPUT__* flags.
+ * @return A cleared context for the next input file, it waits while the writer still writes the previous input file.
+ */
+assembler_context_t *pipeline_writer_submit(pipeline_writer_t *writer, assembler_context_t *context, const char *input_file_name, int written_outputs);
+
+/**
+ * Waits until the output files of all the submitted input files are written.
+ *
+ * @param writer The writer, or NULL.
+ */
+void pipeline_writer_wait(pipeline_writer_t *writer);
+
+/**
+ * Waits for the submitted input files, stops the writer thread and frees the writer and the context it owns.
+ *
+ * @param writer The writer, or NULL.
+ */
+void pipeline_writer_stop(pipeline_writer_t *writer);
+
+#endif /* ASSEMBLER_PIPELINE_H */
@@ -0,0 +1,584 @@
+/* *******************************************************************
+ * Authors: Daniel Oren, Elisheva Cirota
+ *
+ * @file assembler_server.c
+ * @brief This file contains the implementation of the assembler server and client.
+ *
+ *********************************************************************/
+#define _POSIX_C_SOURCE 200809L /* for sockets, sigwait and mkdtemp */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <signal.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "assembler_server.h"
+#include "../assembler_main/assembler_main.h"
+#include "../build_cache/build_cache.h"
+#include "../macro_library/macro_library.h"
+#include "../tracer/tracer.h"
+#include "../utils/utils.h"
+#include "../logger/logger.h"
+#include "../general_const/general_const.h"
+#include "../stats/stats.h"
+
+#define REQUEST_MAGIC ("ASMREQ 1")
+#define REQUEST_FILE ("file ")
+#define REQUEST_SOURCE ("source ")
+#define REQUEST_IMAGES ("images")
+#define REQUEST_END ("end")
+#define MAX_REQUEST_LINE_SIZE (4096)
+#define MAX_SOURCE_NAME_SIZE (64)
+#define MAX_SOURCE_SIZE (16UL * 1024 * 1024)
+#define SOURCE_DIR_TEMPLATE "/tmp/assembler_XXXXXX" /* not parenthesized, it initializes a char array */
+#define SERVER_BACKLOG (16)
+#define REPLY_CHUNK_SIZE (4096)
+#define NUM_OF_OUTPUT_EXTENSIONS (5)
+#define MAX_EXTENSION_SIZE (4)
+
+/* one parsed request */
+typedef struct server_request
+{
+	char file_name[MAX_REQUEST_LINE_SIZE]; /* input file name of a file request, or the name of a source request */
+	char *source; /* content of a source request, NULL for a file request */
+	size_t source_size;
+	int with_images; /* TRUE if the output files should be included in the reply */
+} server_request_t;
+
+/* the state shared by all the workers */
+typedef struct server
+{
+	int listen_fd;
+	volatile int is_stopping; /* set by the main thread before the listening socket is shut down */
+} server_t;
+
+/* a worker thread and the context it assembles with */
+typedef struct server_worker
+{
+	pthread_t thread;
+	int is_started;
+	server_t *server;
+	assembler_context_t *context;
+} server_worker_t;
+
+static const char *SOURCE_FILES_EXTENSIONS[NUM_OF_OUTPUT_EXTENSIONS] = {
+	SRC_FILE_EXTENSION, PRE_PROCESSOR_FILE_EXTENSION, OBJ_FILE_EXTENSION, ENT_FILE_EXTENSION, EXT_FILE_EXTENSION};
+
+/* =========================== internal functions declarations ================== */
+int _server_read_line(FILE *input, char *line);
+int _server_is_valid_source_name(const char *name);
+int _server_read_request(FILE *input, server_request_t *request);
+int _server_write_source(const server_request_t *request, char *source_dir, char **input_file_name);
+void _server_remove_source(const char *source_dir, const char *input_file_name);
+int _server_assemble(server_worker_t *worker, const char *input_file_name, int with_images, FILE *reply);
+void _server_handle_connection(server_worker_t *worker, int connection_fd);
+void *_server_worker_main(void *arg);
+int _server_listen(const char *socket_path);
+int _client_connect(const char *socket_path);
+int _client_read_reply(int connection_fd, char **reply, size_t *reply_size);
+int _client_assemble(const char *socket_path, const char *input_file_name);
+
+/* =========================== internal functions implementations ================= */
+
+int _server_read_line(FILE *input, char *line)
+{
+	size_t length = 0;
+
+	if (fgets(line, MAX_REQUEST_LINE_SIZE, input) == NULL)
+	{
+		return ERR;
+	}
+	length = strlen(line);
+	if (length == 0 || line[length - 1] != NEWLINE_CHARACTER)
+	{
+		/* the line is too long, or the connection was closed in the middle of it */
+		return ERR;
+	}
+	line[length - 1] = NULL_TERMINATOR;
+	return SUCCESS;
+}
+
+int _server_is_valid_source_name(const char *name)
+{
+	/* the name becomes a file name in the temporary directory, so it can't have a path or an extension */
+	if (*name == NULL_TERMINATOR)
+	{
+		return FALSE;
+	}
+	for (; *name != NULL_TERMINATOR; ++name)
+	{
+		if (!isalnum((unsigned char)*name) && *name != '_' && *name != '-')
+		{
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+int _server_read_request(FILE *input, server_request_t *request)
+{
+	char line[MAX_REQUEST_LINE_SIZE];
+	char name[MAX_SOURCE_NAME_SIZE];
+	unsigned long source_size = 0;
+
+	memset(request, 0, sizeof(server_request_t));
+	if (_server_read_line(input, line) != SUCCESS || strcmp(line, REQUEST_MAGIC) != 0)
+	{
+		return USER_ERR;
+	}
+
+	while (_server_read_line(input, line) == SUCCESS)
+	{
+		if (strcmp(line, REQUEST_END) == 0)
+		{
+			return request->file_name[0] != NULL_TERMINATOR ? SUCCESS : USER_ERR;
+		}
+		if (strcmp(line, REQUEST_IMAGES) == 0)
+		{
+			request->with_images = TRUE;
+		}
+		else if (strncmp(line, REQUEST_FILE, strlen(REQUEST_FILE)) == 0 && request->file_name[0] == NULL_TERMINATOR)
+		{
+			strcpy(request->file_name, line + strlen(REQUEST_FILE));
+		}
+		else if (strncmp(line, REQUEST_SOURCE, strlen(REQUEST_SOURCE)) == 0 && request->file_name[0] == NULL_TERMINATOR)
+		{
+			/* the name is limited to MAX_SOURCE_NAME_SIZE - 1 characters */
+			if (sscanf(line + strlen(REQUEST_SOURCE), "%63s %lu", name, &source_size) != 2 ||
+				!_server_is_valid_source_name(name) || source_size > MAX_SOURCE_SIZE)
+			{
+				return USER_ERR;
+			}
+			request->source = (char *)stats_malloc(source_size + 1);
+			CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(request->source, "Memory allocation failed in _server_read_request", FUNC_ERR);
+			request->source_size = fread(request->source, 1, source_size, input);
+			if (request->source_size != source_size)
+			{
+				return USER_ERR;
+			}
+			strcpy(request->file_name, name);
+			request->with_images = TRUE;
+		}
+		else
+		{
+			return USER_ERR;
+		}
+	}
+	return USER_ERR;
+}
+
+int _server_write_source(const server_request_t *request, char *source_dir, char **input_file_name)
+{
+	char *src_file_name = NULL;
+	FILE *src_file = NULL;
+	size_t written = 0;
+
+	if (mkdtemp(source_dir) == NULL)
+	{
+		LOG(ERROR, PARAMS, "failed to create a temporary directory for a source request");
+		return FUNC_ERR;
+	}
+
+	*input_file_name = (char *)stats_malloc(strlen(source_dir) + strlen(request->file_name) + 2);
+	src_file_name = (char *)stats_malloc(strlen(source_dir) + strlen(request->file_name) + strlen(SRC_FILE_EXTENSION) + 2);
+	if (*input_file_name == NULL || src_file_name == NULL)
+	{
+		LOG(ERROR, PARAMS, "Memory allocation failed in _server_write_source");
+		free(src_file_name);
+		return FUNC_ERR;
+	}
+	sprintf(*input_file_name, "%s/%s", source_dir, request->file_name);
+	sprintf(src_file_name, "%s%s", *input_file_name, SRC_FILE_EXTENSION);
+
+	src_file = fopen(src_file_name, "wb");
+	if (src_file != NULL)
+	{
+		written = fwrite(request->source, 1, request->source_size, src_file);
+		fclose(src_file);
+	}
+	free(src_file_name);
+	if (src_file == NULL || written != request->source_size)
+	{
+		LOG(ERROR, PARAMS, "failed to write the source of request %s", request->file_name);
+		return FUNC_ERR;
+	}
+	return SUCCESS;
+}
+
+void _server_remove_source(const char *source_dir, const char *input_file_name)
+{
+	char *file_name = NULL;
+	int i = 0;
+
+	if (input_file_name != NULL)
+	{
+		file_name = (char *)stats_malloc(strlen(input_file_name) + MAX_EXTENSION_SIZE + 1);
+		for (i = 0; i < NUM_OF_OUTPUT_EXTENSIONS && file_name != NULL; ++i)
+		{
+			sprintf(file_name, "%s%s", input_file_name, SOURCE_FILES_EXTENSIONS[i]);
+			remove(file_name);
+		}
+		free(file_name);
+	}
+	rmdir(source_dir);
+}
+
+int _server_assemble(server_worker_t *worker, const char *input_file_name, int with_images, FILE *reply)
+{
+	FILE *msg_stream = NULL;
+	char *messages = NULL;
+	size_t messages_size = 0;
+	int written_outputs = 0;
+	int ret = SUCCESS;
+
+	msg_stream = tmpfile();
+	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(msg_stream, "failed to create a temporary file for the messages", FUNC_ERR);
+
+	TRACE_BEGIN(input_file_name, TRACE_CATEGORY_FILE);
+	ret = assembler_input_with_context(worker->context, input_file_name, msg_stream, &written_outputs);
+	TRACE_END(input_file_name, TRACE_CATEGORY_FILE);
+
+	if (read_stream_to_buffer(msg_stream, &messages, &messages_size) != SUCCESS)
+	{
+		fclose(msg_stream);
+		return FUNC_ERR;
+	}
+	fclose(msg_stream);
+
+	build_cache_write_result(reply, input_file_name, messages, messages_size, ret, with_images ? written_outputs : 0);
+	free(messages);
+	return SUCCESS;
+}
+
+void _server_handle_connection(server_worker_t *worker, int connection_fd)
+{
+	FILE *input = NULL;
+	FILE *reply = NULL;
+	server_request_t request;
+	char source_dir[] = SOURCE_DIR_TEMPLATE;
+	char *input_file_name = NULL;
+	int ret = SUCCESS;
+
+	input = fdopen(connection_fd, "rb");
+	reply = fdopen(dup(connection_fd), "wb");
+	if (input == NULL || reply == NULL)
+	{
+		LOG(ERROR, PARAMS, "failed to open the streams of a connection");
+		if (input != NULL)
+		{
+			fclose(input);
+		}
+		else
+		{
+			close(connection_fd);
+		}
+		return;
+	}
+
+	ret = _server_read_request(input, &request);
+	if (ret == SUCCESS && request.source != NULL)
+	{
+		ret = _server_write_source(&request, source_dir, &input_file_name);
+	}
+
+	if (ret == SUCCESS)
+	{
+		ret = _server_assemble(worker, request.source != NULL ? input_file_name : request.file_name, request.with_images, reply);
+	}
+	if (ret != SUCCESS)
+	{
+		/* the client gets a reply it can parse in any case */
+		LOG(ERROR, PARAMS, "failed to handle a request");
+		build_cache_write_result(reply, request.file_name, "", 0, ret == USER_ERR ? USER_ERR : FUNC_ERR, 0);
+	}
+
+	/* mkdtemp replaces the X characters of the template when it creates the directory */
+	if (strcmp(source_dir, SOURCE_DIR_TEMPLATE) != 0)
+	{
+		_server_remove_source(source_dir, input_file_name);
+	}
+	free(input_file_name);
+	free(request.source);
+	fclose(reply);
+	fclose(input);
+}
+
+void *_server_worker_main(void *arg)
+{
+	server_worker_t *worker = (server_worker_t *)arg;
+	int connection_fd = 0;
+
+	while (!worker->server->is_stopping)
+	{
+		connection_fd = accept(worker->server->listen_fd, NULL, NULL);
+		if (connection_fd < 0)
+		{
+			if (!worker->server->is_stopping && errno != EINTR && errno != ECONNABORTED)
+			{
+				LOG(ERROR, PARAMS, "accept failed with errno %d", errno);
+			}
+			continue;
+		}
+		_server_handle_connection(worker, connection_fd);
+	}
+	return NULL;
+}
+
+int _server_listen(const char *socket_path)
+{
+	struct sockaddr_un address;
+	struct stat socket_stat;
+	int listen_fd = 0;
+
+	if (strlen(socket_path) >= sizeof(address.sun_path))
+	{
+		printf("socket path %s is too long\n", socket_path);
+		return ERR;
+	}
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strcpy(address.sun_path, socket_path);
+
+	/* a socket left by a server that was killed is removed, any other file is kept */
+	if (stat(socket_path, &socket_stat) == SUCCESS && S_ISSOCK(socket_stat.st_mode))
+	{
+		unlink(socket_path);
+	}
+
+	listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listen_fd < 0)
+	{
+		LOG(ERROR, PARAMS, "failed to create the server socket");
+		return ERR;
+	}
+	if (bind(listen_fd, (struct sockaddr *)&address, sizeof(address)) != SUCCESS || listen(listen_fd, SERVER_BACKLOG) != SUCCESS)
+	{
+		printf("failed on listening on %s\n", socket_path);
+		LOG(ERROR, PARAMS, "failed to listen on %s, errno %d", socket_path, errno);
+		close(listen_fd);
+		return ERR;
+	}
+	return listen_fd;
+}
+
+int _client_connect(const char *socket_path)
+{
+	struct sockaddr_un address;
+	int connection_fd = 0;
+
+	if (strlen(socket_path) >= sizeof(address.sun_path))
+	{
+		return ERR;
+	}
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strcpy(address.sun_path, socket_path);
+
+	connection_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (connection_fd < 0)
+	{
+		return ERR;
+	}
+	if (connect(connection_fd, (struct sockaddr *)&address, sizeof(address)) != SUCCESS)
+	{
+		close(connection_fd);
+		return ERR;
+	}
+	return connection_fd;
+}
+
+int _client_read_reply(int connection_fd, char **reply, size_t *reply_size)
+{
+	char *new_reply = NULL;
+	size_t capacity = REPLY_CHUNK_SIZE;
+	ssize_t read_size = 0;
+
+	*reply_size = 0;
+	*reply = (char *)stats_malloc(capacity + 1);
+	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(*reply, "Memory allocation failed in _client_read_reply", FUNC_ERR);
+
+	/* the server closes the connection after the reply */
+	while ((read_size = read(connection_fd, *reply + *reply_size, capacity - *reply_size)) != 0)
+	{
+		if (read_size < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			return FUNC_ERR;
+		}
+		*reply_size += read_size;
+		if (*reply_size == capacity)
+		{
+			capacity *= 2;
+			new_reply = (char *)stats_realloc(*reply, capacity + 1);
+			CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(new_reply, "Memory allocation failed in _client_read_reply", FUNC_ERR);
+			*reply = new_reply;
+		}
+	}
+	(*reply)[*reply_size] = NULL_TERMINATOR;
+	return SUCCESS;
+}
+
+int _client_assemble(const char *socket_path, const char *input_file_name)
+{
+	char current_dir[MAX_REQUEST_LINE_SIZE];
+	FILE *request = NULL;
+	char *reply = NULL;
+	size_t reply_size = 0;
+	int connection_fd = 0;
+	int assembler_ret_val = SUCCESS;
+	int ret = SUCCESS;
+
+	/* the server may run in another directory, so relative names are sent as absolute ones */
+	current_dir[0] = NULL_TERMINATOR;
+	if (input_file_name[0] != '/' && getcwd(current_dir, sizeof(current_dir)) == NULL)
+	{
+		LOG(ERROR, PARAMS, "getcwd failed in _client_assemble");
+		return FUNC_ERR;
+	}
+
+	connection_fd = _client_connect(socket_path);
+	if (connection_fd < 0)
+	{
+		printf("failed on connecting to assembler server %s\n", socket_path);
+		return FUNC_ERR;
+	}
+	request = fdopen(dup(connection_fd), "wb");
+	if (request == NULL)
+	{
+		close(connection_fd);
+		return FUNC_ERR;
+	}
+	fprintf(request, "%s\n%s%s%s%s\n%s\n", REQUEST_MAGIC, REQUEST_FILE, current_dir,
+			current_dir[0] != NULL_TERMINATOR ? "/" : "", input_file_name, REQUEST_END);
+	fclose(request);
+
+	ret = _client_read_reply(connection_fd, &reply, &reply_size);
+	close(connection_fd);
+	if (ret == SUCCESS)
+	{
+		/* the server wrote the output files itself, only the messages are printed */
+		ret = build_cache_apply_result(reply, reply_size, input_file_name, stdout, FALSE, &assembler_ret_val);
+	}
+	free(reply);
+	if (ret != SUCCESS)
+	{
+		printf("failed on getting a reply for %s from assembler server %s\n", input_file_name, socket_path);
+		return FUNC_ERR;
+	}
+	return assembler_ret_val;
+}
+
+/*=============================================================================== */
+
+int assembler_server_run(const assembler_options_t *options)
+{
+	server_t server;
+	server_worker_t *workers = NULL;
+	macro_library_t *macro_library = NULL;
+	sigset_t signals;
+	int signal_number = 0;
+	int ret = SUCCESS;
+	int i = 0;
+
+	/* the library is loaded once, and the workers only look it up, so they share it without locking */
+	if (options->macro_library_file_name != NULL)
+	{
+		macro_library = macro_library_load(options->macro_library_file_name, stdout);
+		if (macro_library == NULL)
+		{
+			return ERR;
+		}
+	}
+
+	server.is_stopping = FALSE;
+	server.listen_fd = _server_listen(options->server_socket_path);
+	if (server.listen_fd < 0)
+	{
+		macro_library_free(macro_library);
+		return ERR;
+	}
+
+	/* the workers inherit the mask: SIGINT and SIGTERM are waited for below, and a client
+	 * that disconnects early fails the write instead of killing the server with SIGPIPE */
+	sigemptyset(&signals);
+	sigaddset(&signals, SIGINT);
+	sigaddset(&signals, SIGTERM);
+	sigaddset(&signals, SIGPIPE);
+	pthread_sigmask(SIG_BLOCK, &signals, NULL);
+
+	workers = (server_worker_t *)stats_calloc(options->num_workers, sizeof(server_worker_t));
+	if (workers == NULL)
+	{
+		LOG(ERROR, PARAMS, "Memory allocation failed in assembler_server_run");
+		close(server.listen_fd);
+		macro_library_free(macro_library);
+		return ERR;
+	}
+	for (i = 0; i < options->num_workers && ret == SUCCESS; ++i)
+	{
+		workers[i].server = &server;
+		workers[i].context = init_assembler_context();
+		if (workers[i].context != NULL)
+		{
+			macro_library_attach(macro_library, workers[i].context);
+			workers[i].context->assembler_data->entry_order = options->entry_order;
+			workers[i].context->assembler_data->is_ext_grouped = options->is_ext_grouped;
+		}
+		if (workers[i].context == NULL || pthread_create(&workers[i].thread, NULL, _server_worker_main, &workers[i]) != SUCCESS)
+		{
+			LOG(ERROR, PARAMS, "failed to start worker %d", i);
+			ret = ERR;
+			break;
+		}
+		workers[i].is_started = TRUE;
+	}
+
+	if (ret == SUCCESS)
+	{
+		printf("assembler server is listening on %s with %d workers\n", options->server_socket_path, options->num_workers);
+		fflush(stdout);
+		sigdelset(&signals, SIGPIPE);
+		sigwait(&signals, &signal_number);
+		LOG(INFO, PARAMS, "assembler server got signal %d, stopping", signal_number);
+	}
+
+	/* wakes the workers that wait in accept, a worker in the middle of a request finishes it first */
+	server.is_stopping = TRUE;
+	shutdown(server.listen_fd, SHUT_RDWR);
+	for (i = 0; i < options->num_workers; ++i)
+	{
+		if (workers[i].is_started)
+		{
+			pthread_join(workers[i].thread, NULL);
+		}
+		free_assembler_context(workers[i].context);
+	}
+	free(workers);
+	macro_library_free(macro_library);
+	close(server.listen_fd);
+	unlink(options->server_socket_path);
+	return ret;
+}
+
+int assembler_client_run(const assembler_options_t *options)
+{
+	int ret_val = SUCCESS;
+	int i = 0;
+
+	for (i = 0; i < options->num_input_files; ++i)
+	{
+		ret_val += _client_assemble(options->client_socket_path, options->input_file_names[i]);
+	}
+	return ret_val == SUCCESS ? SUCCESS : ERR;
+}
@@ -0,0 +1,55 @@
+/* *******************************************************************
+ * Authors: Daniel Oren, Elisheva Cirota
+ *
+ * @file assembler_server.h
+ * @brief This file contains the declarations of the assembler server and client.
+ *
+ * The server keeps a pool of worker threads, each with its own assembler context that was
+ * initialized once, and listens on a Unix domain socket. Every connection carries one request:
+ *
+ *     ASMREQ 1
+ *     file <input file name, without the .as extension>
+ *     images                  (optional, include the output files in the reply)
+ *     end
+ *
+ * or, to assemble source text that is not saved to a file:
+ *
+ *     ASMREQ 1
+ *     source <name> <size>
+ *     <size bytes of .as content>
+ *     end
+ *
+ * The reply has the format of a build cache entry (see build_cache_write_result): the return
+ * value, the errors and warnings, and the output files when they were requested. A source request
+ * is assembled in a temporary directory, so its output files are always included in the reply.
+ *
+ * The client mode sends a file request for every input file and prints the reply, so scripts
+ * that run the assembler keep working when the files are assembled by a server.
+ * The macro library (--lib) is the one the server was started with, a client doesn't send its own.
+ *
+ *********************************************************************/
+
+#ifndef ASSEMBLER_SERVER_H
+#define ASSEMBLER_SERVER_H
+
+#include "../assembler_options/assembler_options.h"
+
+#define DEFAULT_NUM_OF_WORKERS (4)
+
+/**
+ * Runs the assembler server until it gets SIGINT or SIGTERM.
+ *
+ * @param options The options of the assembler, with the socket path and the number of workers.
+ * @return SUCCESS, or ERR if the server could not be started.
+ */
+int assembler_server_run(const assembler_options_t *options);
+
+/**
+ * Assembles the input files with a running assembler server.
+ *
+ * @param options The options of the assembler, with the socket path and the input files.
+ * @return SUCCESS if all the input files were assembled successfully, ERR otherwise.
+ */
+int assembler_client_run(const assembler_options_t *options);
+
+#endif /* ASSEMBLER_SERVER_H */
@@ -0,0 +1,129 @@
+/* *******************************************************************
+ * Authors: Daniel Oren, Elisheva Cirota
+ *
+ * @file  test_assembler_server.c
+ * @brief This file contains the tests of the assembler server and client.
+ *
+ *********************************************************************/
+#define _POSIX_C_SOURCE 200809L /* for kill, nanosleep and chdir */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/stat.h>
+
+#include "assembler_server.h"
+#include "../general_const/general_const.h"
+#include "../utils/utils.h"
+
+#define TEST_SERVER_SOCKET_PATH "test_assembler_server.sock"
+#define TEST_SERVER_NUM_WAITS (100)
+#define TEST_SERVER_WAIT_NSEC (10000000)
+
+/* runs the server in a child process, returns its pid or -1 */
+pid_t _test_server_start()
+{
+	char *argv[] = {"assembler", "--server=" TEST_SERVER_SOCKET_PATH, "--workers=2"};
+	struct timespec wait_time = {0, TEST_SERVER_WAIT_NSEC};
+	struct stat socket_stat;
+	assembler_options_t options;
+	pid_t server_pid = 0;
+	int i = 0;
+
+	unlink(TEST_SERVER_SOCKET_PATH);
+	fflush(stdout); /* or the child prints it again */
+	server_pid = fork();
+	if (server_pid == 0)
+	{
+		if (parse_assembler_options(sizeof(argv) / sizeof(argv[0]), argv, &options) != SUCCESS)
+		{
+			_exit(EXIT_FAILURE);
+		}
+		_exit(assembler_server_run(&options) == SUCCESS ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+	/* the client fails when the server doesn't listen yet */
+	for (i = 0; i < TEST_SERVER_NUM_WAITS && server_pid > 0; ++i)
+	{
+		if (stat(TEST_SERVER_SOCKET_PATH, &socket_stat) == SUCCESS)
+		{
+			return server_pid;
+		}
+		nanosleep(&wait_time, NULL);
+	}
+	if (server_pid > 0)
+	{
+		kill(server_pid, SIGTERM);
+		waitpid(server_pid, NULL, 0);
+	}
+	return -1;
+}
+
+/* the client sends the absolute name of the input file, the dot of its directory is not an extension */
+void test_client_in_dotted_directory()
+{
+	char current_dir[MAX_LINE_SIZE];
+	char client_option[MAX_LINE_SIZE * 2];
+	char *argv[] = {"assembler", NULL, "test10"};
+	assembler_options_t options;
+	pid_t server_pid = _test_server_start();
+	int client_ret = ERR;
+	int res = 0;
+
+	if (server_pid < 0)
+	{
+		printf("FAILURE, test_client_in_dotted_directory could not start the server\n");
+		return;
+	}
+	/* the socket is found from the input directory too */
+	if (getcwd(current_dir, sizeof(current_dir)) != NULL)
+	{
+		sprintf(client_option, "--client=%s/%s", current_dir, TEST_SERVER_SOCKET_PATH);
+		argv[1] = client_option;
+	}
+
+	if (argv[1] != NULL && chdir("valid_input/test10.dir") == SUCCESS)
+	{
+		if (parse_assembler_options(sizeof(argv) / sizeof(argv[0]), argv, &options) == SUCCESS)
+		{
+			client_ret = assembler_client_run(&options);
+			free_assembler_options(&options);
+		}
+		if (chdir("../..") != SUCCESS)
+		{
+			client_ret = ERR;
+		}
+	}
+	kill(server_pid, SIGTERM);
+	waitpid(server_pid, NULL, 0);
+	unlink(TEST_SERVER_SOCKET_PATH);
+
+	if (client_ret != SUCCESS)
+	{
+		printf("FAILURE, test_client_in_dotted_directory assembler_client_run\n");
+		return;
+	}
+	res += compare_files(fopen("valid_input/test10.dir/test10.am", "r"), fopen("expected_output/test10/test10.am", "r"), TRUE);
+	res += compare_files(fopen("valid_input/test10.dir/test10.ob", "r"), fopen("expected_output/test10/test10.ob", "r"), TRUE);
+	res += compare_files(fopen("valid_input/test10.dir/test10.ent", "r"), fopen("expected_output/test10/test10.ent", "r"), TRUE);
+	res += compare_files(fopen("valid_input/test10.dir/test10.ext", "r"), fopen("expected_output/test10/test10.ext", "r"), TRUE);
+	if (res == SUCCESS)
+	{
+		printf("SUCCESS, test_client_in_dotted_directory\n");
+	}
+	else
+	{
+		printf("FAILURE, test_client_in_dotted_directory\n");
+	}
+}
+
+/* uncomment this line to run test_assembler_server */
+/*int main()
+{
+	test_client_in_dotted_directory();
+	return SUCCESS;
+}*/
@@ -0,0 +1,617 @@
+/* *******************************************************************
+ * Authors: Daniel Oren, Elisheva Cirota
+ *
+ * @file build_cache.c
+ * @brief This file contains the implementation of the incremental build cache.
+ *
+ * An entry file has a short text header followed by length prefixed sections:
+ *
+ *     ASMCACHE 1
+ *     rc <assembler return value>
+ *     section <name> <size>
+ *     <size bytes of content>
+ *     ...
+ *     end
+ *
+ *********************************************************************/
+#define _POSIX_C_SOURCE 200112L /* for mkdir, stat, opendir, getpid and utime */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <utime.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "build_cache.h"
+#include "../utils/utils.h"
+#include "../logger/logger.h"
+#include "../general_const/general_const.h"
+#include "../stats/stats.h"
+#include "../output_file/output_file.h"
+
+#define BUILD_CACHE_MAGIC ("ASMCACHE 1\n")
+#define BUILD_CACHE_END ("end\n")
+#define BUILD_CACHE_ENTRY_SUFFIX (".entry")
+#define BUILD_CACHE_TMP_INFIX (".tmp.")
+#define BUILD_CACHE_MESSAGES_SECTION ("out")
+#define MAX_SECTION_NAME_SIZE (16)
+#define MAX_TMP_SUFFIX_SIZE (32)
+#define NUM_OF_OUTPUT_SECTIONS (BUILD_CACHE_NUM_OUTPUTS)
+#define CACHE_DIR_MODE (0777)
+
+#define XXH_PRIME32_1 (2654435761UL)
+#define XXH_PRIME32_2 (2246822519UL)
+#define XXH_PRIME32_3 (3266489917UL)
+#define XXH_PRIME32_4 (668265263UL)
+#define XXH_PRIME32_5 (374761393UL)
+#define XXH_MASK32 (0xFFFFFFFFUL)
+#define XXH_ROTL32(x, r) ((((x) << (r)) | ((x) >> (32 - (r)))) & XXH_MASK32)
+#define XXH_SECOND_SEED (0x9E3779B9UL) /* seed of the second half of the key */
+
+/* an output file of the assembler that is kept in the cache entry */
+typedef struct build_cache_section
+{
+	const char *name;
+	const char *extension;
+	int output_flag;
+} build_cache_section_t;
+
+static const build_cache_section_t BUILD_CACHE_SECTIONS[NUM_OF_OUTPUT_SECTIONS] = {
+	{"am", PRE_PROCESSOR_FILE_EXTENSION, BUILD_CACHE_OUTPUT__AM},
+	{"ob", OBJ_FILE_EXTENSION, BUILD_CACHE_OUTPUT__OB},
+	{"ent", ENT_FILE_EXTENSION, BUILD_CACHE_OUTPUT__ENT},
+	{"ext", EXT_FILE_EXTENSION, BUILD_CACHE_OUTPUT__EXT}};
+
+/* an entry file found in the cache directory while scanning it */
+typedef struct build_cache_file
+{
+	char *path;
+	time_t last_used;
+	unsigned long size;
+} build_cache_file_t;
+
+/* =========================== internal functions declarations ================== */
+unsigned long _xxh32_read_lane(const unsigned char *p);
+unsigned long _xxh32_round(unsigned long acc, unsigned long input);
+char *_build_cache_path(const build_cache_t *build_cache, const char *name, const char *suffix);
+char *_build_cache_output_file_name(const char *input_file_name, const char *extension);
+int _build_cache_write_section(FILE *entry_file, const char *name, const char *content, size_t size);
+int _build_cache_parse_entry(char *entry, size_t entry_size, int *assembler_ret_val, char **contents, size_t *sizes, char **messages, size_t *messages_size);
+int _build_cache_compare_last_used(const void *first, const void *second);
+void _build_cache_scan(build_cache_t *build_cache);
+
+/* =========================== internal functions implementations ================= */
+
+unsigned long _xxh32_read_lane(const unsigned char *p)
+{
+	/* lanes are read as little endian regardless of the host, so keys are the same on every machine */
+	return (unsigned long)p[0] | ((unsigned long)p[1] << 8) | ((unsigned long)p[2] << 16) | ((unsigned long)p[3] << 24);
+}
+
+unsigned long _xxh32_round(unsigned long acc, unsigned long input)
+{
+	acc = (acc + input * XXH_PRIME32_2) & XXH_MASK32;
+	acc = XXH_ROTL32(acc, 13);
+	return (acc * XXH_PRIME32_1) & XXH_MASK32;
+}
+
+char *_build_cache_path(const build_cache_t *build_cache, const char *name, const char *suffix)
+{
+	char *path = (char *)stats_malloc(strlen(build_cache->cache_dir) + strlen(name) + strlen(suffix) + 2);
+	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(path, "Memory allocation failed in _build_cache_path", NULL);
+
+	sprintf(path, "%s/%s%s", build_cache->cache_dir, name, suffix);
+	return path;
+}
+
+char *_build_cache_output_file_name(const char *input_file_name, const char *extension)
+{
+	char *output_file_name = (char *)stats_malloc(strlen(input_file_name) + strlen(extension) + 1);
+	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(output_file_name, "Memory allocation failed in _build_cache_output_file_name", NULL);
+
+	get_output_file_name(input_file_name, output_file_name, extension);
+	return output_file_name;
+}
+
+int _build_cache_write_section(FILE *entry_file, const char *name, const char *content, size_t size)
+{
+	if (fprintf(entry_file, "section %s %lu\n", name, (unsigned long)size) < 0 ||
+		fwrite(content, 1, size, entry_file) != size)
+	{
+		LOG(ERROR, PARAMS, "failed to write section %s to the cache entry", name);
+		return FUNC_ERR;
+	}
+	return SUCCESS;
+}
+
+
+int _build_cache_parse_entry(char *entry, size_t entry_size, int *assembler_ret_val, char **contents, size_t *sizes, char **messages, size_t *messages_size)
+{
+	char *cursor = entry;
+	char *entry_end = entry + entry_size;
+	char section_name[MAX_SECTION_NAME_SIZE];
+	unsigned long section_size = 0;
+	int header_size = 0;
+	int i = 0;
+
+	if (strncmp(cursor, BUILD_CACHE_MAGIC, strlen(BUILD_CACHE_MAGIC)) != 0)
+	{
+		return ERR;
+	}
+	cursor += strlen(BUILD_CACHE_MAGIC);
+	if (sscanf(cursor, "rc %d\n%n", assembler_ret_val, &header_size) != 1 || header_size == 0)
+	{
+		return ERR;
+	}
+	cursor += header_size;
+
+	while (strncmp(cursor, BUILD_CACHE_END, strlen(BUILD_CACHE_END)) != 0)
+	{
+		header_size = 0;
+		/* the name is limited to MAX_SECTION_NAME_SIZE - 1 characters */
+		if (sscanf(cursor, "section %15s %lu%n", section_name, &section_size, &header_size) != 2 ||
+			cursor[header_size] != NEWLINE_CHARACTER)
+		{
+			return ERR;
+		}
+		cursor += header_size + 1;
+		if (section_size > (unsigned long)(entry_end - cursor))
+		{
+			return ERR;
+		}
+
+		if (strcmp(section_name, BUILD_CACHE_MESSAGES_SECTION) == 0)
+		{
+			*messages = cursor;
+			*messages_size = section_size;
+		}
+		for (i = 0; i < NUM_OF_OUTPUT_SECTIONS; ++i)
+		{
+			if (strcmp(section_name, BUILD_CACHE_SECTIONS[i].name) == 0)
+			{
+				contents[i] = cursor;
+				sizes[i] = section_size;
+			}
+		}
+		cursor += section_size;
+	}
+	return SUCCESS;
+}
+
+int _build_cache_compare_last_used(const void *first, const void *second)
+{
+	const build_cache_file_t *first_file = (const build_cache_file_t *)first;
+	const build_cache_file_t *second_file = (const build_cache_file_t *)second;
+
+	if (first_file->last_used < second_file->last_used)
+	{
+		return -1;
+	}
+	return first_file->last_used > second_file->last_used ? 1 : 0;
+}
+
+void _build_cache_scan(build_cache_t *build_cache)
+{
+	DIR *dir = NULL;
+	struct dirent *dir_entry = NULL;
+	struct stat file_stat;
+	build_cache_file_t *files = NULL;
+	build_cache_file_t *new_files = NULL;
+	int num_files = 0;
+	int capacity = 0;
+	unsigned long total_size = 0;
+	size_t name_length = 0;
+	size_t suffix_length = strlen(BUILD_CACHE_ENTRY_SUFFIX);
+	char *path = NULL;
+	int is_tmp = FALSE;
+	time_t now = time(NULL);
+	int i = 0;
+
+	dir = opendir(build_cache->cache_dir);
+	if (dir == NULL)
+	{
+		LOG(ERROR, PARAMS, "Error opening cache directory %s", build_cache->cache_dir);
+		return;
+	}
+
+	while ((dir_entry = readdir(dir)) != NULL)
+	{
+		name_length = strlen(dir_entry->d_name);
+		is_tmp = strstr(dir_entry->d_name, BUILD_CACHE_TMP_INFIX) != NULL;
+		if (!is_tmp && (name_length <= suffix_length || strcmp(dir_entry->d_name + name_length - suffix_length, BUILD_CACHE_ENTRY_SUFFIX) != 0))
+		{
+			continue;
+		}
+		path = _build_cache_path(build_cache, dir_entry->d_name, "");
+		if (path == NULL)
+		{
+			break;
+		}
+		/* another process may have evicted the entry in the meantime */
+		if (stat(path, &file_stat) != SUCCESS)
+		{
+			free(path);
+			continue;
+		}
+		/* a temporary file is renamed within moments, an old one was left by a process that crashed */
+		if (is_tmp)
+		{
+			if (now - file_stat.st_mtime > BUILD_CACHE_STALE_TMP_AGE)
+			{
+				LOG(DEBUG, PARAMS, "removing stale temporary file %s", path);
+				remove(path);
+			}
+			free(path);
+			continue;
+		}
+		if (num_files == capacity)
+		{
+			capacity = capacity == 0 ? 16 : capacity * 2;
+			new_files = (build_cache_file_t *)stats_realloc(files, capacity * sizeof(build_cache_file_t));
+			if (new_files == NULL)
+			{
+				LOG(ERROR, PARAMS, "Memory allocation failed in _build_cache_evict");
+				free(path);
+				break;
+			}
+			files = new_files;
+		}
+		files[num_files].path = path;
+		files[num_files].last_used = file_stat.st_mtime;
+		files[num_files].size = (unsigned long)file_stat.st_size;
+		total_size += files[num_files].size;
+		++num_files;
+	}
+	closedir(dir);
+
+	if (total_size > build_cache->max_size)
+	{
+		qsort(files, num_files, sizeof(build_cache_file_t), _build_cache_compare_last_used);
+		for (i = 0; i < num_files && total_size > build_cache->max_size; ++i)
+		{
+			LOG(DEBUG, PARAMS, "evicting cache entry %s", files[i].path);
+			remove(files[i].path);
+			total_size -= files[i].size;
+		}
+	}
+	build_cache->total_size = total_size;
+	build_cache->num_stores_since_scan = 0;
+
+	for (i = 0; i < num_files; ++i)
+	{
+		free(files[i].path);
+	}
+	free(files);
+}
+
+/*=============================================================================== */
+
+unsigned long build_cache_xxh32(const void *data, size_t size, unsigned long seed)
+{
+	const unsigned char *p = (const unsigned char *)data;
+	const unsigned char *end = p + size;
+	unsigned long v1, v2, v3, v4;
+	unsigned long hash = 0;
+
+	seed &= XXH_MASK32;
+	if (size >= 16)
+	{
+		v1 = (seed + XXH_PRIME32_1 + XXH_PRIME32_2) & XXH_MASK32;
+		v2 = (seed + XXH_PRIME32_2) & XXH_MASK32;
+		v3 = seed;
+		v4 = (seed - XXH_PRIME32_1) & XXH_MASK32;
+		while (end - p >= 16)
+		{
+			v1 = _xxh32_round(v1, _xxh32_read_lane(p));
+			v2 = _xxh32_round(v2, _xxh32_read_lane(p + 4));
+			v3 = _xxh32_round(v3, _xxh32_read_lane(p + 8));
+			v4 = _xxh32_round(v4, _xxh32_read_lane(p + 12));
+			p += 16;
+		}
+		hash = (XXH_ROTL32(v1, 1) + XXH_ROTL32(v2, 7) + XXH_ROTL32(v3, 12) + XXH_ROTL32(v4, 18)) & XXH_MASK32;
+	}
+	else
+	{
+		hash = (seed + XXH_PRIME32_5) & XXH_MASK32;
+	}
+	hash = (hash + (unsigned long)size) & XXH_MASK32;
+
+	while (end - p >= 4)
+	{
+		hash = (hash + _xxh32_read_lane(p) * XXH_PRIME32_3) & XXH_MASK32;
+		hash = (XXH_ROTL32(hash, 17) * XXH_PRIME32_4) & XXH_MASK32;
+		p += 4;
+	}
+	while (p < end)
+	{
+		hash = (hash + (unsigned long)*p * XXH_PRIME32_5) & XXH_MASK32;
+		hash = (XXH_ROTL32(hash, 11) * XXH_PRIME32_1) & XXH_MASK32;
+		++p;
+	}
+
+	hash ^= hash >> 15;
+	hash = (hash * XXH_PRIME32_2) & XXH_MASK32;
+	hash ^= hash >> 13;
+	hash = (hash * XXH_PRIME32_3) & XXH_MASK32;
+	hash ^= hash >> 16;
+	return hash;
+}
+
+build_cache_t *build_cache_open(const char *cache_dir, unsigned long max_size)
+{
+	build_cache_t *build_cache = NULL;
+
+	if (mkdir(cache_dir, CACHE_DIR_MODE) != SUCCESS && errno != EEXIST)
+	{
+		LOG(ERROR, PARAMS, "failed to create cache directory %s", cache_dir);
+		return NULL;
+	}
+
+	build_cache = (build_cache_t *)stats_malloc(sizeof(build_cache_t));
+	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(build_cache, "Memory allocation failed in build_cache_open", NULL);
+
+	build_cache->cache_dir = str_dup(cache_dir);
+	if (build_cache->cache_dir == NULL)
+	{
+		LOG(ERROR, PARAMS, "Memory allocation failed in build_cache_open for cache_dir");
+		free(build_cache);
+		return NULL;
+	}
+	build_cache->max_size = max_size;
+	build_cache->total_size = 0;
+	build_cache->num_stores_since_scan = -1;
+	return build_cache;
+}
+
+void build_cache_close(build_cache_t *build_cache)
+{
+	if (build_cache != NULL)
+	{
+		free(build_cache->cache_dir);
+		free(build_cache);
+	}
+}
+
+int build_cache_compute_key(const char *input_file_name, const char *options_key, char *key)
+{
+	char *src_file_name = NULL;
+	char *content = NULL;
+	char *header = NULL;
+	size_t content_size = 0;
+	size_t header_size = 0;
+	unsigned long header_hash = 0;
+	int ret = SUCCESS;
+
+	src_file_name = _build_cache_output_file_name(input_file_name, SRC_FILE_EXTENSION);
+	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(src_file_name, "failed to get the source file name in build_cache_compute_key", FUNC_ERR);
+	ret = read_file_to_buffer(src_file_name, &content, &content_size);
+	free(src_file_name);
+	CHECK_RET_VAL_AND_RETURN(ret);
+
+	/* the header holds everything besides the content that changes the output files */
+	header_size = strlen(ASSEMBLER_VERSION) + strlen(options_key) + strlen(input_file_name) + 3;
+	header = (char *)stats_malloc(header_size);
+	if (header == NULL)
+	{
+		LOG(ERROR, PARAMS, "Memory allocation failed in build_cache_compute_key");
+		free(content);
+		return FUNC_ERR;
+	}
+	sprintf(header, "%s%c%s%c%s", ASSEMBLER_VERSION, NULL_TERMINATOR, options_key, NULL_TERMINATOR, input_file_name);
+	header_hash = build_cache_xxh32(header, header_size, 0);
+
+	sprintf(key, "%08lx%08lx", build_cache_xxh32(content, content_size, header_hash),
+			build_cache_xxh32(content, content_size, header_hash ^ XXH_SECOND_SEED));
+
+	free(header);
+	free(content);
+	return SUCCESS;
+}
+
+int build_cache_apply_result(char *result, size_t result_size, const char *input_file_name, FILE *msg_stream, int restore_outputs, int *assembler_ret_val)
+{
+	char *contents[NUM_OF_OUTPUT_SECTIONS] = {NULL, NULL, NULL, NULL};
+	size_t sizes[NUM_OF_OUTPUT_SECTIONS] = {0, 0, 0, 0};
+	char *messages = NULL;
+	size_t messages_size = 0;
+	char *output_file_name = NULL;
+	int ret = SUCCESS;
+	int i = 0;
+
+	if (_build_cache_parse_entry(result, result_size, assembler_ret_val, contents, sizes, &messages, &messages_size) != SUCCESS)
+	{
+		return ERR;
+	}
+
+	for (i = 0; i < NUM_OF_OUTPUT_SECTIONS && restore_outputs; ++i)
+	{
+		if (contents[i] == NULL && BUILD_CACHE_SECTIONS[i].output_flag != BUILD_CACHE_OUTPUT__AM)
+		{
+			continue;
+		}
+		output_file_name = _build_cache_output_file_name(input_file_name, BUILD_CACHE_SECTIONS[i].extension);
+		CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(output_file_name, "failed to get an output file name in build_cache_apply_result", FUNC_ERR);
+		if (contents[i] != NULL)
+		{
+			ret = output_file_write(output_file_name, contents[i], sizes[i]);
+		}
+		else
+		{
+			remove(output_file_name);
+		}
+		free(output_file_name);
+		CHECK_RET_VAL_AND_RETURN(ret);
+	}
+
+	if (messages_size > 0)
+	{
+		fwrite(messages, 1, messages_size, msg_stream);
+	}
+	return SUCCESS;
+}
+
+int build_cache_restore(build_cache_t *build_cache, const char *key, const char *input_file_name, FILE *msg_stream, int *assembler_ret_val)
+{
+	char *entry_path = NULL;
+	char *entry = NULL;
+	size_t entry_size = 0;
+	int ret = SUCCESS;
+
+	entry_path = _build_cache_path(build_cache, key, BUILD_CACHE_ENTRY_SUFFIX);
+	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(entry_path, "failed to get the entry path in build_cache_restore", FUNC_ERR);
+
+	ret = read_file_to_buffer(entry_path, &entry, &entry_size);
+	if (ret != SUCCESS)
+	{
+		free(entry_path);
+		return ret == USER_ERR ? BUILD_CACHE_MISS : ret;
+	}
+
+	ret = build_cache_apply_result(entry, entry_size, input_file_name, msg_stream, TRUE, assembler_ret_val);
+	if (ret == ERR)
+	{
+		LOG(WARNING, PARAMS, "cache entry %s is corrupted, ignoring it", entry_path);
+		ret = BUILD_CACHE_MISS;
+	}
+	else if (ret == SUCCESS)
+	{
+		/* the modification time of an entry is its last use, for the LRU eviction */
+		utime(entry_path, NULL);
+		LOG(INFO, PARAMS, "restored %s from cache entry %s", input_file_name, entry_path);
+		ret = BUILD_CACHE_HIT;
+	}
+
+	free(entry);
+	free(entry_path);
+	return ret;
+}
+
+int build_cache_write_result(FILE *stream, const char *input_file_name, const char *messages, size_t messages_size, int assembler_ret_val, int written_outputs)
+{
+	char *output_file_name = NULL;
+	char *contents[NUM_OF_OUTPUT_SECTIONS];
+	size_t sizes[NUM_OF_OUTPUT_SECTIONS];
+	int ret = SUCCESS;
+	int i = 0;
+
+	for (i = 0; i < NUM_OF_OUTPUT_SECTIONS; ++i)
+	{
+		contents[i] = NULL;
+		sizes[i] = 0;
+		if (!(written_outputs & BUILD_CACHE_SECTIONS[i].output_flag) || ret != SUCCESS)
+		{
+			continue;
+		}
+		output_file_name = _build_cache_output_file_name(input_file_name, BUILD_CACHE_SECTIONS[i].extension);
+		ret = output_file_name != NULL && read_file_to_buffer(output_file_name, &contents[i], &sizes[i]) == SUCCESS ? SUCCESS : FUNC_ERR;
+		free(output_file_name);
+	}
+
+	if (ret == SUCCESS)
+	{
+		ret = build_cache_write_result_contents(stream, messages, messages_size, assembler_ret_val, contents, sizes);
+	}
+	for (i = 0; i < NUM_OF_OUTPUT_SECTIONS; ++i)
+	{
+		free(contents[i]);
+	}
+	return ret;
+}
+
+int build_cache_write_result_contents(FILE *stream, const char *messages, size_t messages_size, int assembler_ret_val, char *contents[], const size_t sizes[])
+{
+	int ret = SUCCESS;
+	int i = 0;
+
+	fprintf(stream, "%src %d\n", BUILD_CACHE_MAGIC, assembler_ret_val);
+	ret = _build_cache_write_section(stream, BUILD_CACHE_MESSAGES_SECTION, messages, messages_size);
+	for (i = 0; i < NUM_OF_OUTPUT_SECTIONS && ret == SUCCESS; ++i)
+	{
+		if (contents[i] != NULL)
+		{
+			ret = _build_cache_write_section(stream, BUILD_CACHE_SECTIONS[i].name, contents[i], sizes[i]);
+		}
+	}
+	CHECK_RET_VAL_AND_RETURN(ret);
+
+	if (fprintf(stream, "%s", BUILD_CACHE_END) < 0)
+	{
+		return FUNC_ERR;
+	}
+	return SUCCESS;
+}
+
+int build_cache_store(build_cache_t *build_cache, const char *key, const char *input_file_name, const char *messages, size_t messages_size, int assembler_ret_val, int written_outputs)
+{
+	char tmp_suffix[MAX_TMP_SUFFIX_SIZE];
+	char *entry_path = NULL;
+	char *tmp_path = NULL;
+	FILE *entry_file = NULL;
+	struct stat entry_stat;
+	unsigned long replaced_size = 0;
+	int ret = SUCCESS;
+
+	/* the entry is written to a file of its own and renamed, so readers never see half an entry */
+	sprintf(tmp_suffix, "%s%ld", BUILD_CACHE_TMP_INFIX, (long)getpid());
+	entry_path = _build_cache_path(build_cache, key, BUILD_CACHE_ENTRY_SUFFIX);
+	tmp_path = _build_cache_path(build_cache, key, tmp_suffix);
+	if (entry_path == NULL || tmp_path == NULL)
+	{
+		free(entry_path);
+		free(tmp_path);
+		return FUNC_ERR;
+	}
+
+	entry_file = fopen(tmp_path, "wb");
+	if (entry_file == NULL)
+	{
+		LOG(ERROR, PARAMS, "Error opening file %s", tmp_path);
+		free(entry_path);
+		free(tmp_path);
+		return FUNC_ERR;
+	}
+
+	ret = build_cache_write_result(entry_file, input_file_name, messages, messages_size, assembler_ret_val, written_outputs);
+	if (fclose(entry_file) != SUCCESS)
+	{
+		ret = FUNC_ERR;
+	}
+	/* the entry may replace one of another process, its size is not counted twice */
+	if (ret == SUCCESS && stat(entry_path, &entry_stat) == SUCCESS)
+	{
+		replaced_size = (unsigned long)entry_stat.st_size;
+	}
+	if (ret == SUCCESS && rename(tmp_path, entry_path) != SUCCESS)
+	{
+		LOG(ERROR, PARAMS, "failed to rename %s to %s", tmp_path, entry_path);
+		ret = FUNC_ERR;
+	}
+	if (ret == SUCCESS && build_cache->num_stores_since_scan >= 0 && stat(entry_path, &entry_stat) == SUCCESS)
+	{
+		if (replaced_size > build_cache->total_size)
+		{
+			replaced_size = build_cache->total_size;
+		}
+		build_cache->total_size = build_cache->total_size - replaced_size + (unsigned long)entry_stat.st_size;
+		++build_cache->num_stores_since_scan;
+	}
+	if (ret != SUCCESS)
+	{
+		remove(tmp_path);
+	}
+	free(entry_path);
+	free(tmp_path);
+
+	/* the directory is scanned only when it may be over its limit, not on every store */
+	if (ret == SUCCESS && (build_cache->num_stores_since_scan < 0 || build_cache->total_size > build_cache->max_size ||
+						   build_cache->num_stores_since_scan >= BUILD_CACHE_RESCAN_STORES))
+	{
+		_build_cache_scan(build_cache);
+	}
+	return ret;
+}
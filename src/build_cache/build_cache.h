@@ -0,0 +1,158 @@
+/* *******************************************************************
+ * Authors: Daniel Oren, Elisheva Cirota
+ *
+ * @file build_cache.h
+ * @brief This file contains the declarations of the incremental build cache.
+ *
+ * The build cache keeps the results of assembling an input file in a cache directory.
+ * An entry is keyed by a hash of the .as content, the input file name, the assembler
+ * version and the options that affect the output, and holds the .am/.ob/.ent/.ext files
+ * and the errors and warnings that were printed. When the same input is assembled again
+ * the entry is restored instead of running the assembler.
+ *
+ * Entries are written to a temporary file and renamed into place, so several assembler
+ * processes can share the same cache directory. When the directory grows over its size
+ * limit the least recently used entries are removed.
+ *
+ * The directory is scanned once, and then only when the entries stored since then may have taken
+ * it over its size limit, or after BUILD_CACHE_RESCAN_STORES stores, for the entries of the other
+ * processes. A scan also removes the temporary files that a crashed process left behind.
+ *
+ *********************************************************************/
+
+#ifndef BUILD_CACHE_H
+#define BUILD_CACHE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BUILD_CACHE_KEY_SIZE (17) /* 16 hex digits plus null terminator */
+#define BUILD_CACHE_DEFAULT_MAX_SIZE (64UL * 1024 * 1024)
+#define BUILD_CACHE_RESCAN_STORES (64) /* stores between two scans of the cache directory */
+#define BUILD_CACHE_STALE_TMP_AGE (60 * 60) /* seconds after which a temporary file is left over from a crash */
+
+#define BUILD_CACHE_HIT (1)
+#define BUILD_CACHE_MISS (0)
+
+/* flags of the output files an assembler run has written */
+#define BUILD_CACHE_OUTPUT__AM (1 << 0)
+#define BUILD_CACHE_OUTPUT__OB (1 << 1)
+#define BUILD_CACHE_OUTPUT__ENT (1 << 2)
+#define BUILD_CACHE_OUTPUT__EXT (1 << 3)
+#define BUILD_CACHE_NUM_OUTPUTS (4) /* the output of flag (1 << i) is the i-th output */
+
+/* This structure represents an opened cache directory. */
+typedef struct build_cache
+{
+	char *cache_dir; /* the directory of the cache entries */
+	unsigned long max_size; /* maximal total size of the entries in bytes */
+	unsigned long total_size; /* total size of the entries at the last scan, and of the entries stored since */
+	int num_stores_since_scan; /* number of entries stored since the last scan, -1 before the first scan */
+} build_cache_t;
+
+/**
+ * Opens a cache directory, and creates it if it doesn't exist.
+ *
+ * @param cache_dir The cache directory.
+ * @param max_size Maximal total size of the cache entries in bytes.
+ * @return A pointer to the opened cache, or NULL on failure.
+ */
+build_cache_t *build_cache_open(const char *cache_dir, unsigned long max_size);
+
+/**
+ * Closes a cache directory and frees its memory.
+ *
+ * @param build_cache The cache to close.
+ */
+void build_cache_close(build_cache_t *build_cache);
+
+/**
+ * Computes the cache key of an input file.
+ *
+ * @param input_file_name The name of the input file, without the .as extension.
+ * @param options_key A string describing the options that affect the output files.
+ * @param key Buffer of BUILD_CACHE_KEY_SIZE characters for the key.
+ * @return SUCCESS, USER_ERR if the .as file could not be read, or FUNC_ERR on memory allocation failure.
+ */
+int build_cache_compute_key(const char *input_file_name, const char *options_key, char *key);
+
+/**
+ * Restores the output files of an input file from the cache, and prints the stored errors and warnings.
+ * Output files that the stored run did not write are left untouched, except the .am file which the
+ * pre processor removes when it fails, so it is removed here as well.
+ *
+ * @param build_cache The cache.
+ * @param key The key of the input file.
+ * @param input_file_name The name of the input file, without the .as extension.
+ * @param msg_stream The stream to print the stored errors and warnings to.
+ * @param assembler_ret_val Set to the value the assembler returned for this input.
+ * @return BUILD_CACHE_HIT if the entry was restored, BUILD_CACHE_MISS if there is no valid entry, or FUNC_ERR on failure.
+ */
+int build_cache_restore(build_cache_t *build_cache, const char *key, const char *input_file_name, FILE *msg_stream, int *assembler_ret_val);
+
+/**
+ * Stores the output files of an input file in the cache, and evicts old entries if needed.
+ *
+ * @param build_cache The cache.
+ * @param key The key of the input file.
+ * @param input_file_name The name of the input file, without the .as extension.
+ * @param messages The errors and warnings that were printed for this input.
+ * @param messages_size The size of messages in bytes.
+ * @param assembler_ret_val The value the assembler returned for this input.
+ * @param written_outputs BUILD_CACHE_OUTPUT__* flags of the output files the assembler has written.
+ * @return SUCCESS, or FUNC_ERR on failure.
+ */
+int build_cache_store(build_cache_t *build_cache, const char *key, const char *input_file_name, const char *messages, size_t messages_size, int assembler_ret_val, int written_outputs);
+
+/**
+ * Writes the result of assembling an input file in the format of a cache entry.
+ * The assembler server uses the same format for its replies.
+ *
+ * @param stream The stream to write to.
+ * @param input_file_name The name of the input file, without the .as extension.
+ * @param messages The errors and warnings that were printed for this input.
+ * @param messages_size The size of messages in bytes.
+ * @param assembler_ret_val The value the assembler returned for this input.
+ * @param written_outputs BUILD_CACHE_OUTPUT__* flags of the output files to include.
+ * @return SUCCESS, or FUNC_ERR on failure.
+ */
+int build_cache_write_result(FILE *stream, const char *input_file_name, const char *messages, size_t messages_size, int assembler_ret_val, int written_outputs);
+
+/**
+ * Writes a result in the format of build_cache_write_result, with the output files given in memory.
+ *
+ * @param stream The stream to write to.
+ * @param messages The errors and warnings that were printed for this input.
+ * @param messages_size The size of messages in bytes.
+ * @param assembler_ret_val The value the assembler returned for this input.
+ * @param contents BUILD_CACHE_NUM_OUTPUTS contents of output files, by the index of their flag. NULL for an output that was not written.
+ * @param sizes The sizes of the contents in bytes.
+ * @return SUCCESS, or FUNC_ERR on failure.
+ */
+int build_cache_write_result_contents(FILE *stream, const char *messages, size_t messages_size, int assembler_ret_val, char *contents[], const size_t sizes[]);
+
+/**
+ * Applies a result that was written by build_cache_write_result: prints the stored errors and warnings
+ * and, if requested, writes the stored output files like build_cache_restore does.
+ *
+ * @param result The result. It must be null terminated, like the buffers of read_file_to_buffer.
+ * @param result_size The size of the result in bytes.
+ * @param input_file_name The name of the input file, without the .as extension.
+ * @param msg_stream The stream to print the stored errors and warnings to.
+ * @param restore_outputs TRUE to write the stored output files.
+ * @param assembler_ret_val Set to the value the assembler returned for this input.
+ * @return SUCCESS, ERR if the result is malformed, or FUNC_ERR on failure.
+ */
+int build_cache_apply_result(char *result, size_t result_size, const char *input_file_name, FILE *msg_stream, int restore_outputs, int *assembler_ret_val);
+
+/**
+ * Computes the 32 bits xxHash (XXH32) of a buffer. Only the low 32 bits of the seed and the result are used.
+ *
+ * @param data The buffer to hash.
+ * @param size The size of the buffer in bytes.
+ * @param seed The seed of the hash.
+ * @return The hash value.
+ */
+unsigned long build_cache_xxh32(const void *data, size_t size, unsigned long seed);
+
+#endif /* BUILD_CACHE_H */
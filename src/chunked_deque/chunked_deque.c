@@ -0,0 +1,342 @@
+/* *******************************************************************
+ * Authors: Daniel Oren, Elisheva Cirota
+ *
+ * @file  chunked_deque.c
+ * @brief This file contains the implementation of the chunked deque data structure.
+ *
+ * There is always at least one block. When the first and the last blocks differ, the first one
+ * has an element at its front index and the last one an element before its back index, so a
+ * block is released as soon as its last element is removed.
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../logger/logger.h"
+#include "../general_const/general_const.h"
+#include "../stats/stats.h"
+#include "chunked_deque.h"
+
+#define DEQUE_BLOCK_SIZE (64)
+
+typedef struct deque_block
+{
+    struct deque_block *prev;
+    struct deque_block *next;
+    void *items[DEQUE_BLOCK_SIZE];
+} deque_block_t;
+
+/* =========================== internal functions declarations ================== */
+deque_block_t *_deque_get_block(ChunkedDeque *deque);
+void _deque_release_block(ChunkedDeque *deque, deque_block_t *block);
+int _deque_reserve_blocks(ChunkedDeque *deque, size_t num_blocks);
+void _deque_free_blocks(deque_block_t *block);
+
+/* =========================== internal functions implementations ================= */
+
+deque_block_t *_deque_get_block(ChunkedDeque *deque)
+{
+    deque_block_t *block = deque->spare;
+
+    if (block != NULL)
+    {
+        deque->spare = block->next;
+        return block;
+    }
+    block = (deque_block_t *)stats_malloc(sizeof(deque_block_t));
+    CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(block, "Memory allocation failed in _deque_get_block", NULL);
+    stats_add(STATS_COUNTER__DEQUE_BLOCKS, 1);
+    return block;
+}
+
+void _deque_release_block(ChunkedDeque *deque, deque_block_t *block)
+{
+    block->next = deque->spare;
+    deque->spare = block;
+}
+
+/* makes sure the spare list has num_blocks blocks, so a bulk operation can't fail in the middle */
+int _deque_reserve_blocks(ChunkedDeque *deque, size_t num_blocks)
+{
+    deque_block_t *block = deque->spare;
+    deque_block_t *new_block = NULL;
+
+    for (; block != NULL && num_blocks > 0; block = block->next)
+    {
+        --num_blocks;
+    }
+    for (; num_blocks > 0; --num_blocks)
+    {
+        new_block = (deque_block_t *)stats_malloc(sizeof(deque_block_t));
+        CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(new_block, "Memory allocation failed in _deque_reserve_blocks", ERR);
+        stats_add(STATS_COUNTER__DEQUE_BLOCKS, 1);
+        _deque_release_block(deque, new_block);
+    }
+    return SUCCESS;
+}
+
+void _deque_free_blocks(deque_block_t *block)
+{
+    deque_block_t *next = NULL;
+
+    for (; block != NULL; block = next)
+    {
+        next = block->next;
+        free(block);
+    }
+}
+
+/*=============================================================================== */
+
+ChunkedDeque *deque_create()
+{
+    ChunkedDeque *deque = (ChunkedDeque *)stats_calloc(1, sizeof(ChunkedDeque));
+
+    CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(deque, "Memory allocation failed for deque_create deque struct", NULL);
+    deque->first = _deque_get_block(deque);
+    if (deque->first == NULL)
+    {
+        free(deque);
+        return NULL;
+    }
+    deque->first->prev = NULL;
+    deque->first->next = NULL;
+    deque->last = deque->first;
+    return deque;
+}
+
+int deque_is_empty(const ChunkedDeque *deque)
+{
+    return deque->size == 0;
+}
+
+size_t deque_get_size(const ChunkedDeque *deque)
+{
+    return deque->size;
+}
+
+int deque_push_back(ChunkedDeque *deque, void *item)
+{
+    deque_block_t *block = NULL;
+
+    if (deque->size == 0)
+    {
+        deque->front = deque->back = 0;
+    }
+    if (deque->back == DEQUE_BLOCK_SIZE)
+    {
+        block = _deque_get_block(deque);
+        if (block == NULL)
+        {
+            return ERR;
+        }
+        block->prev = deque->last;
+        block->next = NULL;
+        deque->last->next = block;
+        deque->last = block;
+        deque->back = 0;
+    }
+    deque->last->items[deque->back++] = item;
+    ++deque->size;
+    return SUCCESS;
+}
+
+int deque_push_front(ChunkedDeque *deque, void *item)
+{
+    deque_block_t *block = NULL;
+
+    if (deque->size == 0)
+    {
+        deque->front = deque->back = DEQUE_BLOCK_SIZE;
+    }
+    if (deque->front == 0)
+    {
+        block = _deque_get_block(deque);
+        if (block == NULL)
+        {
+            return ERR;
+        }
+        block->prev = NULL;
+        block->next = deque->first;
+        deque->first->prev = block;
+        deque->first = block;
+        deque->front = DEQUE_BLOCK_SIZE;
+    }
+    deque->first->items[--deque->front] = item;
+    ++deque->size;
+    return SUCCESS;
+}
+
+void *deque_pop_front(ChunkedDeque *deque)
+{
+    deque_block_t *block = deque->first;
+    void *item = NULL;
+
+    if (deque_is_empty(deque))
+    {
+        LOG(ERROR, PARAMS, "Trying to pop from an empty deque.");
+        return NULL;
+    }
+    item = block->items[deque->front++];
+    --deque->size;
+    if (deque->front == DEQUE_BLOCK_SIZE && block != deque->last)
+    {
+        deque->first = block->next;
+        deque->first->prev = NULL;
+        deque->front = 0;
+        _deque_release_block(deque, block);
+    }
+    return item;
+}
+
+void *deque_pop_back(ChunkedDeque *deque)
+{
+    deque_block_t *block = deque->last;
+    void *item = NULL;
+
+    if (deque_is_empty(deque))
+    {
+        LOG(ERROR, PARAMS, "Trying to pop from an empty deque.");
+        return NULL;
+    }
+    item = block->items[--deque->back];
+    --deque->size;
+    if (deque->back == 0 && block != deque->first)
+    {
+        deque->last = block->prev;
+        deque->last->next = NULL;
+        deque->back = DEQUE_BLOCK_SIZE;
+        _deque_release_block(deque, block);
+    }
+    return item;
+}
+
+int deque_push_back_bulk(ChunkedDeque *deque, void *const *items, size_t num_items)
+{
+    deque_block_t *block = NULL;
+    size_t room = 0;
+    size_t chunk = 0;
+
+    if (deque->size == 0)
+    {
+        deque->front = deque->back = 0;
+    }
+    room = DEQUE_BLOCK_SIZE - deque->back;
+    if (num_items > room && _deque_reserve_blocks(deque, (num_items - room + DEQUE_BLOCK_SIZE - 1) / DEQUE_BLOCK_SIZE) != SUCCESS)
+    {
+        return ERR;
+    }
+
+    while (num_items > 0)
+    {
+        if (deque->back == DEQUE_BLOCK_SIZE)
+        {
+            /* reserved above, can't fail */
+            block = _deque_get_block(deque);
+            block->prev = deque->last;
+            block->next = NULL;
+            deque->last->next = block;
+            deque->last = block;
+            deque->back = 0;
+        }
+        chunk = DEQUE_BLOCK_SIZE - deque->back;
+        chunk = chunk < num_items ? chunk : num_items;
+        memcpy(deque->last->items + deque->back, items, chunk * sizeof(void *));
+        deque->back += chunk;
+        deque->size += chunk;
+        items += chunk;
+        num_items -= chunk;
+    }
+    return SUCCESS;
+}
+
+size_t deque_pop_front_bulk(ChunkedDeque *deque, void **items, size_t max_items)
+{
+    deque_block_t *block = NULL;
+    size_t num_popped = 0;
+    size_t chunk = 0;
+
+    while (num_popped < max_items && deque->size > 0)
+    {
+        block = deque->first;
+        chunk = (block == deque->last ? deque->back : DEQUE_BLOCK_SIZE) - deque->front;
+        chunk = chunk < max_items - num_popped ? chunk : max_items - num_popped;
+        memcpy(items + num_popped, block->items + deque->front, chunk * sizeof(void *));
+        deque->front += chunk;
+        deque->size -= chunk;
+        num_popped += chunk;
+        if (deque->front == DEQUE_BLOCK_SIZE && block != deque->last)
+        {
+            deque->first = block->next;
+            deque->first->prev = NULL;
+            deque->front = 0;
+            _deque_release_block(deque, block);
+        }
+    }
+    return num_popped;
+}
+
+void deque_iterator_init(const ChunkedDeque *deque, DequeIterator *iterator)
+{
+    iterator->block = deque->first;
+    iterator->index = deque->front;
+    iterator->remaining = deque->size;
+}
+
+int deque_iterator_next(DequeIterator *iterator, void **item)
+{
+    if (iterator->remaining == 0)
+    {
+        return FALSE;
+    }
+    if (iterator->index == DEQUE_BLOCK_SIZE)
+    {
+        iterator->block = iterator->block->next;
+        iterator->index = 0;
+    }
+    *item = iterator->block->items[iterator->index++];
+    --iterator->remaining;
+    return TRUE;
+}
+
+void deque_clear(ChunkedDeque *deque, DequeFreeFunc freeFunc)
+{
+    DequeIterator iterator;
+    void *item = NULL;
+
+    if (deque == NULL)
+    {
+        return;
+    }
+    if (freeFunc != NULL)
+    {
+        deque_iterator_init(deque, &iterator);
+        while (deque_iterator_next(&iterator, &item))
+        {
+            freeFunc(item);
+        }
+    }
+    /* all the blocks but the first move to the spare list at once */
+    if (deque->first != deque->last)
+    {
+        deque->last->next = deque->spare;
+        deque->spare = deque->first->next;
+        deque->first->next = NULL;
+        deque->last = deque->first;
+    }
+    deque->front = deque->back = 0;
+    deque->size = 0;
+}
+
+void deque_destroy(ChunkedDeque *deque, DequeFreeFunc freeFunc)
+{
+    if (deque == NULL)
+    {
+        return;
+    }
+    deque_clear(deque, freeFunc);
+    _deque_free_blocks(deque->first);
+    _deque_free_blocks(deque->spare);
+    free(deque);
+}
@@ -0,0 +1,156 @@
+/* *******************************************************************
+ * Authors: Daniel Oren, Elisheva Cirota
+ *
+ * @file chunked_deque.h
+ * @brief Header file for a double-ended queue built from fixed-size blocks.
+ *
+ * The elements are kept in a list of blocks of DEQUE_BLOCK_SIZE pointers. Growing links a new
+ * block instead of copying the elements, so a pointer to an element slot is never moved, and
+ * the blocks of removed elements are kept for reuse until the deque is freed.
+ *
+ *********************************************************************/
+
+#ifndef CHUNKED_DEQUE_H
+#define CHUNKED_DEQUE_H
+
+#include <stdlib.h>
+
+struct deque_block;
+
+/* @brief Structure representing a chunked deque. */
+typedef struct
+{
+    struct deque_block *first; /**< Block of the front element */
+    struct deque_block *last; /**< Block of the rear element */
+    struct deque_block *spare; /**< Unused blocks, linked by their next pointer */
+    size_t front; /**< Index of the front element in the first block */
+    size_t back; /**< Index after the rear element in the last block */
+    size_t size; /**< Number of elements */
+} ChunkedDeque;
+
+/* @brief Position of an iteration over a deque, from front to rear. */
+typedef struct
+{
+    const struct deque_block *block; /**< Block of the next element */
+    size_t index; /**< Index of the next element in the block */
+    size_t remaining; /**< Number of elements that were not visited yet */
+} DequeIterator;
+
+/**
+ * @brief Function pointer type for freeing an element.
+ */
+typedef void (*DequeFreeFunc)(void *);
+
+/**
+ * @brief Creates a new empty deque.
+ * @return A pointer to the newly created deque, or NULL on memory allocation failure.
+ * @remark Complexity: O(1).
+ */
+ChunkedDeque *deque_create();
+
+/**
+ * @brief Checks if the deque is empty.
+ * @param deque A pointer to the deque.
+ * @return 1 if the deque is empty, 0 otherwise.
+ * @remark Complexity: O(1).
+ */
+int deque_is_empty(const ChunkedDeque *deque);
+
+/**
+ * @brief Returns the number of elements in the deque.
+ * @param deque A pointer to the deque.
+ * @return The number of elements.
+ * @remark Complexity: O(1).
+ */
+size_t deque_get_size(const ChunkedDeque *deque);
+
+/**
+ * @brief Adds an element to the rear of the deque.
+ * @param deque A pointer to the deque.
+ * @param item A pointer to the item to be added.
+ * @return SUCCESS if the element was added, ERR on memory allocation failure.
+ * @remark Complexity: O(1), the elements are never copied.
+ */
+int deque_push_back(ChunkedDeque *deque, void *item);
+
+/**
+ * @brief Adds an element to the front of the deque.
+ * @param deque A pointer to the deque.
+ * @param item A pointer to the item to be added.
+ * @return SUCCESS if the element was added, ERR on memory allocation failure.
+ * @remark Complexity: O(1), the elements are never copied.
+ */
+int deque_push_front(ChunkedDeque *deque, void *item);
+
+/**
+ * @brief Removes and returns the element at the front of the deque.
+ * @param deque A pointer to the deque.
+ * @return The element at the front, or NULL if the deque is empty.
+ * @remark Complexity: O(1).
+ */
+void *deque_pop_front(ChunkedDeque *deque);
+
+/**
+ * @brief Removes and returns the element at the rear of the deque.
+ * @param deque A pointer to the deque.
+ * @return The element at the rear, or NULL if the deque is empty.
+ * @remark Complexity: O(1).
+ */
+void *deque_pop_back(ChunkedDeque *deque);
+
+/**
+ * @brief Adds elements to the rear of the deque, in their order.
+ * @param deque A pointer to the deque.
+ * @param items The items to be added.
+ * @param num_items The number of items.
+ * @return SUCCESS if all the elements were added, ERR on memory allocation failure, then none was added.
+ * @remark Complexity: O(num_items), copied a block at a time.
+ */
+int deque_push_back_bulk(ChunkedDeque *deque, void *const *items, size_t num_items);
+
+/**
+ * @brief Removes elements from the front of the deque.
+ * @param deque A pointer to the deque.
+ * @param items Receives the removed elements, from the front.
+ * @param max_items The maximal number of elements to remove.
+ * @return The number of elements that were removed, less than max_items only if the deque got empty.
+ * @remark Complexity: O(number of removed elements), copied a block at a time.
+ */
+size_t deque_pop_front_bulk(ChunkedDeque *deque, void **items, size_t max_items);
+
+/**
+ * @brief Starts an iteration over the elements of the deque, from front to rear.
+ *
+ * The deque must not be changed while it is iterated.
+ * @param deque A pointer to the deque.
+ * @param iterator The iterator to start.
+ * @remark Complexity: O(1).
+ */
+void deque_iterator_init(const ChunkedDeque *deque, DequeIterator *iterator);
+
+/**
+ * @brief Advances an iteration.
+ * @param iterator The iterator.
+ * @param item Receives the next element.
+ * @return 1 if an element was returned, 0 if all the elements were visited.
+ * @remark Complexity: O(1).
+ */
+int deque_iterator_next(DequeIterator *iterator, void **item);
+
+/**
+ * @brief Removes all the elements of the deque, its blocks are kept for reuse.
+ * @param deque A pointer to the deque.
+ * @param freeFunc Called for every element, from front to rear, or NULL to keep the elements.
+ * @remark Complexity: O(1) when freeFunc is NULL, O(n) otherwise.
+ */
+void deque_clear(ChunkedDeque *deque, DequeFreeFunc freeFunc);
+
+/**
+ * @brief Destroys the deque and frees its blocks.
+ * @param deque A pointer to the deque.
+ * @param freeFunc Called for every element, or NULL to keep the elements.
+ * @remark Complexity: O(number of blocks) when freeFunc is NULL, O(n) otherwise.
+ */
+void deque_destroy(ChunkedDeque *deque, DequeFreeFunc freeFunc);
+
+#endif /* CHUNKED_DEQUE_H */
@@ -0,0 +1,259 @@
+/* *******************************************************************
+ * Authors: Daniel Oren, Elisheva Cirota
+ *
+ * @file  test_chunked_deque.c
+ * @brief This file contains the tests of the chunked deque and a micro-benchmark against the dynamic queue.
+ *
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "chunked_deque.h"
+#include "../dynamic_queue/dynamic_queue.h"
+#include "../general_const/general_const.h"
+#include "../stats/stats.h"
+#include "../utils/utils.h"
+
+#define TEST_DEQUE_NUM_ITEMS (1000)
+#define TEST_DEQUE_BULK_SIZE (100)
+#define TEST_DEQUE_BENCHMARK_ITEMS (100000)
+#define TEST_DEQUE_BENCHMARK_ROUNDS (50)
+
+/* the items are the numbers 1...n, kept in the pointers */
+#define TEST_DEQUE_ITEM(i) ((void *)(size_t)(i))
+
+void _test_deque_do_nothing(void *item)
+{
+	UNUSED(item);
+}
+
+void _test_deque_queue_do_nothing(void *item, void *user_data)
+{
+	UNUSED(item);
+	UNUSED(user_data);
+}
+
+/* checks that the deque holds first...last in order, with the iterator */
+int _test_deque_check_range(const ChunkedDeque *deque, size_t first, size_t last)
+{
+	DequeIterator iterator;
+	void *item = NULL;
+	size_t expected = first;
+
+	deque_iterator_init(deque, &iterator);
+	while (deque_iterator_next(&iterator, &item))
+	{
+		if (item != TEST_DEQUE_ITEM(expected++))
+		{
+			return FALSE;
+		}
+	}
+	return expected == last + 1 && deque_get_size(deque) == last + 1 - first;
+}
+
+void test_chunked_deque()
+{
+	ChunkedDeque *deque = deque_create();
+	void *items[TEST_DEQUE_NUM_ITEMS];
+	stats_mode_t mode = stats_get_mode();
+	unsigned long num_blocks = 0;
+	int is_ok = TRUE;
+	size_t i = 0;
+
+	if (deque == NULL)
+	{
+		printf("FAILURE, deque_create\n");
+		return;
+	}
+
+	/* a queue: pushed at the rear, popped at the front */
+	for (i = 1; i <= TEST_DEQUE_NUM_ITEMS; ++i)
+	{
+		is_ok &= deque_push_back(deque, TEST_DEQUE_ITEM(i)) == SUCCESS;
+	}
+	is_ok &= _test_deque_check_range(deque, 1, TEST_DEQUE_NUM_ITEMS);
+	for (i = 1; i <= TEST_DEQUE_NUM_ITEMS / 2; ++i)
+	{
+		is_ok &= deque_pop_front(deque) == TEST_DEQUE_ITEM(i);
+	}
+	is_ok &= _test_deque_check_range(deque, TEST_DEQUE_NUM_ITEMS / 2 + 1, TEST_DEQUE_NUM_ITEMS);
+
+	/* the other end: pushed back at the front, popped at the rear */
+	for (i = TEST_DEQUE_NUM_ITEMS / 2; i >= 1; --i)
+	{
+		is_ok &= deque_push_front(deque, TEST_DEQUE_ITEM(i)) == SUCCESS;
+	}
+	is_ok &= _test_deque_check_range(deque, 1, TEST_DEQUE_NUM_ITEMS);
+	for (i = TEST_DEQUE_NUM_ITEMS; i >= 1; --i)
+	{
+		is_ok &= deque_pop_back(deque) == TEST_DEQUE_ITEM(i);
+	}
+	is_ok &= deque_is_empty(deque) && deque_pop_front(deque) == NULL && deque_pop_back(deque) == NULL;
+	if (!is_ok)
+	{
+		printf("FAILURE, test_chunked_deque push and pop\n");
+		deque_destroy(deque, NULL);
+		return;
+	}
+
+	/* bulk operations, in parts that don't match the blocks */
+	for (i = 0; i < TEST_DEQUE_NUM_ITEMS; ++i)
+	{
+		items[i] = TEST_DEQUE_ITEM(i + 1);
+	}
+	for (i = 0; i < TEST_DEQUE_NUM_ITEMS; i += TEST_DEQUE_BULK_SIZE)
+	{
+		is_ok &= deque_push_back_bulk(deque, items + i, TEST_DEQUE_BULK_SIZE) == SUCCESS;
+	}
+	is_ok &= _test_deque_check_range(deque, 1, TEST_DEQUE_NUM_ITEMS);
+	is_ok &= deque_pop_front_bulk(deque, items, TEST_DEQUE_BULK_SIZE + 1) == TEST_DEQUE_BULK_SIZE + 1;
+	is_ok &= items[0] == TEST_DEQUE_ITEM(1) && items[TEST_DEQUE_BULK_SIZE] == TEST_DEQUE_ITEM(TEST_DEQUE_BULK_SIZE + 1);
+	is_ok &= _test_deque_check_range(deque, TEST_DEQUE_BULK_SIZE + 2, TEST_DEQUE_NUM_ITEMS);
+	is_ok &= deque_pop_front_bulk(deque, items, TEST_DEQUE_NUM_ITEMS) == TEST_DEQUE_NUM_ITEMS - TEST_DEQUE_BULK_SIZE - 1;
+	is_ok &= items[0] == TEST_DEQUE_ITEM(TEST_DEQUE_BULK_SIZE + 2) && deque_is_empty(deque);
+	if (!is_ok)
+	{
+		printf("FAILURE, test_chunked_deque bulk\n");
+		deque_destroy(deque, NULL);
+		return;
+	}
+
+	/* the blocks are kept by clear, so filling the deque again allocates nothing */
+	stats_set_mode(STATS_MODE__TABLE);
+	for (i = 1; i <= TEST_DEQUE_NUM_ITEMS; ++i)
+	{
+		deque_push_back(deque, TEST_DEQUE_ITEM(i));
+	}
+	deque_clear(deque, _test_deque_do_nothing);
+	is_ok &= deque_is_empty(deque);
+	num_blocks = stats_get_counter(STATS_COUNTER__DEQUE_BLOCKS);
+	for (i = 1; i <= TEST_DEQUE_NUM_ITEMS; ++i)
+	{
+		deque_push_back(deque, TEST_DEQUE_ITEM(i));
+	}
+	is_ok &= stats_get_counter(STATS_COUNTER__DEQUE_BLOCKS) == num_blocks;
+	is_ok &= _test_deque_check_range(deque, 1, TEST_DEQUE_NUM_ITEMS);
+	stats_set_mode(mode);
+
+	deque_destroy(deque, NULL);
+	printf("%s, test_chunked_deque\n", is_ok ? "SUCCESS" : "FAILURE");
+}
+
+void test_chunked_deque_benchmark()
+{
+	static void *items[TEST_DEQUE_BENCHMARK_ITEMS];
+	DequeIterator iterator;
+	void *item = NULL;
+	ChunkedDeque *deque = deque_create();
+	Queue *queue = queue_create();
+	size_t checksum = 0;
+	double start = 0;
+	double queue_usec = 0;
+	double deque_usec = 0;
+	double bulk_usec = 0;
+	int round = 0;
+	size_t i = 0;
+
+	if (deque == NULL || queue == NULL)
+	{
+		printf("FAILURE, memory allocation failed\n");
+		deque_destroy(deque, NULL);
+		queue_destroy(queue, _test_deque_do_nothing);
+		return;
+	}
+	for (i = 0; i < TEST_DEQUE_BENCHMARK_ITEMS; ++i)
+	{
+		items[i] = TEST_DEQUE_ITEM(i + 1);
+	}
+
+	/* like a file: every line is added, then they are all visited and removed, then the next file starts.
+	 * The queue is created for every round, since it keeps its largest array after a clear as well */
+	printf("%-28s %12s %12s\n", "workload", "structure", "ns/item");
+	start = get_monotonic_time_usec();
+	for (round = 0; round < TEST_DEQUE_BENCHMARK_ROUNDS; ++round)
+	{
+		queue_destroy(queue, _test_deque_do_nothing);
+		queue = queue_create();
+		for (i = 0; i < TEST_DEQUE_BENCHMARK_ITEMS; ++i)
+		{
+			queue_enqueue(queue, items[i]);
+		}
+		queue_for_each(queue, _test_deque_queue_do_nothing, NULL);
+		while (!queue_is_empty(queue))
+		{
+			checksum += (size_t)queue_dequeue(queue);
+		}
+	}
+	queue_usec = get_monotonic_time_usec() - start;
+
+	start = get_monotonic_time_usec();
+	for (round = 0; round < TEST_DEQUE_BENCHMARK_ROUNDS; ++round)
+	{
+		deque_destroy(deque, NULL);
+		deque = deque_create();
+		for (i = 0; i < TEST_DEQUE_BENCHMARK_ITEMS; ++i)
+		{
+			deque_push_back(deque, items[i]);
+		}
+		deque_iterator_init(deque, &iterator);
+		while (deque_iterator_next(&iterator, &item))
+		{
+			_test_deque_queue_do_nothing(item, NULL);
+		}
+		while (!deque_is_empty(deque))
+		{
+			checksum += (size_t)deque_pop_front(deque);
+		}
+	}
+	deque_usec = get_monotonic_time_usec() - start;
+	printf("%-28s %12s %12.2f\n", "fill and drain, new", "queue", queue_usec * 1000.0 / ((double)TEST_DEQUE_BENCHMARK_ROUNDS * TEST_DEQUE_BENCHMARK_ITEMS));
+	printf("%-28s %12s %12.2f\n", "fill and drain, new", "deque", deque_usec * 1000.0 / ((double)TEST_DEQUE_BENCHMARK_ROUNDS * TEST_DEQUE_BENCHMARK_ITEMS));
+
+	/* the same, with one structure that is reused for every round */
+	start = get_monotonic_time_usec();
+	for (round = 0; round < TEST_DEQUE_BENCHMARK_ROUNDS; ++round)
+	{
+		for (i = 0; i < TEST_DEQUE_BENCHMARK_ITEMS; ++i)
+		{
+			queue_enqueue(queue, items[i]);
+		}
+		queue_clear(queue, _test_deque_do_nothing);
+	}
+	queue_usec = get_monotonic_time_usec() - start;
+
+	start = get_monotonic_time_usec();
+	for (round = 0; round < TEST_DEQUE_BENCHMARK_ROUNDS; ++round)
+	{
+		for (i = 0; i < TEST_DEQUE_BENCHMARK_ITEMS; ++i)
+		{
+			deque_push_back(deque, items[i]);
+		}
+		deque_clear(deque, NULL);
+	}
+	deque_usec = get_monotonic_time_usec() - start;
+
+	start = get_monotonic_time_usec();
+	for (round = 0; round < TEST_DEQUE_BENCHMARK_ROUNDS; ++round)
+	{
+		deque_push_back_bulk(deque, items, TEST_DEQUE_BENCHMARK_ITEMS);
+		checksum += deque_pop_front_bulk(deque, items, TEST_DEQUE_BENCHMARK_ITEMS);
+	}
+	bulk_usec = get_monotonic_time_usec() - start;
+	printf("%-28s %12s %12.2f\n", "fill and clear, reused", "queue", queue_usec * 1000.0 / ((double)TEST_DEQUE_BENCHMARK_ROUNDS * TEST_DEQUE_BENCHMARK_ITEMS));
+	printf("%-28s %12s %12.2f\n", "fill and clear, reused", "deque", deque_usec * 1000.0 / ((double)TEST_DEQUE_BENCHMARK_ROUNDS * TEST_DEQUE_BENCHMARK_ITEMS));
+	printf("%-28s %12s %12.2f\n", "bulk fill and drain, reused", "deque", bulk_usec * 1000.0 / ((double)TEST_DEQUE_BENCHMARK_ROUNDS * TEST_DEQUE_BENCHMARK_ITEMS));
+
+	/* printed so the loops are not optimized away */
+	printf("checksum %lu\n", (unsigned long)checksum);
+	deque_destroy(deque, NULL);
+	queue_destroy(queue, _test_deque_do_nothing);
+}
+
+/* uncomment this line to run test_chunked_deque */
+/*int main()
+{
+	test_chunked_deque();
+	test_chunked_deque_benchmark();
+	return SUCCESS;
+}*/
@@ -0,0 +1,507 @@
+/* *******************************************************************
+ * Authors: Daniel Oren, Elisheva Cirota
+ *
+ * @file concurrent_symbol_table.c
+ * @brief This file contains the implementation of the concurrent symbol table.
+ *
+ * A shard keeps an entry for every symbol: the definition and the location of the symbol, each
+ * with its order, and no symbol_t until the table is exported. A definition or a location that
+ * loses to one with a lower order is kept as a conflict of the shard.
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "concurrent_symbol_table.h"
+#include "../hash_table/hash_table.h"
+#include "../dynamic_queue/dynamic_queue.h"
+#include "../logger/logger.h"
+#include "../general_const/general_const.h"
+#include "../stats/stats.h"
+#include "../utils/utils.h"
+
+#define NO_ORDER (-1L)
+
+/* what a conflict reports */
+enum symbol_conflict_type
+{
+	SYMBOL_CONFLICT__DEFINED_TWICE,
+	SYMBOL_CONFLICT__LOCATION_TWICE,
+	SYMBOL_CONFLICT__EXTERN_DEFINED
+};
+
+/* everything that was given for one symbol */
+typedef struct symbol_entry
+{
+	char name[MAX_LABEL_SIZE];
+	long define_order; /* NO_ORDER when the symbol was not defined */
+	short memory_type;
+	short symbol_value;
+	short num_elements;
+	long location_order; /* NO_ORDER when the symbol has no .entry/.extern */
+	short symbol_location;
+} symbol_entry_t;
+
+/* a definition or a location that lost to one with a lower order */
+typedef struct symbol_conflict
+{
+	char name[MAX_LABEL_SIZE];
+	long order;
+	enum symbol_conflict_type type;
+} symbol_conflict_t;
+
+typedef struct symbol_shard
+{
+	pthread_mutex_t lock;
+	HashTable *entries; /* symbol name to symbol_entry_t */
+	Queue *conflicts; /* of symbol_conflict_t */
+	int num_conflicts;
+} symbol_shard_t;
+
+struct concurrent_symbol_table
+{
+	int num_shards;
+	symbol_shard_t *shards;
+};
+
+/* the entries of all the shards, collected for the export */
+typedef struct symbol_entries
+{
+	symbol_entry_t **entries;
+	int num_entries;
+} symbol_entries_t;
+
+/* =========================== internal functions declarations ================== */
+symbol_shard_t *_get_shard(concurrent_symbol_table_t *table, const char *name);
+symbol_entry_t *_get_or_add_entry(symbol_shard_t *shard, const char *name);
+int _add_conflict(symbol_shard_t *shard, const char *name, long order, enum symbol_conflict_type type);
+void _entry_to_symbol(const symbol_entry_t *entry, symbol_t *symbol);
+long _entry_first_order(const symbol_entry_t *entry);
+void _collect_entry(const char *key, void *data, void *entries);
+int _compare_entries(const void *first, const void *second);
+int _compare_conflicts(const void *first, const void *second);
+int _compare_locations(const void *first, const void *second);
+int _export_entry_symbols(symbol_entries_t *entries, assembler_data_t *assembler_data);
+int _export_conflicts(concurrent_symbol_table_t *table, const symbol_entries_t *entries, StringVector *error_founds);
+
+/* =========================== internal functions implementations ================= */
+
+symbol_shard_t *_get_shard(concurrent_symbol_table_t *table, const char *name)
+{
+	/* FNV-1a, so the shard of a name doesn't depend on the hash that picks its bucket inside the shard */
+	return &table->shards[fnv1a_hash(name) % table->num_shards];
+}
+
+symbol_entry_t *_get_or_add_entry(symbol_shard_t *shard, const char *name)
+{
+	symbol_entry_t *entry = (symbol_entry_t *)hash_table_lookup_local(shard->entries, name);
+
+	if (entry != NULL)
+	{
+		return entry;
+	}
+	entry = (symbol_entry_t *)stats_calloc(1, sizeof(symbol_entry_t));
+	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(entry, "Memory allocation failed in _get_or_add_entry", NULL);
+	strncpy(entry->name, name, MAX_LABEL_SIZE - 1);
+	entry->define_order = NO_ORDER;
+	entry->location_order = NO_ORDER;
+	entry->symbol_location = -1;
+	if (hash_table_insert(shard->entries, name, entry) != SUCCESS)
+	{
+		LOG(ERROR, PARAMS, "failed to insert symbol %s to a shard", name);
+		free(entry);
+		return NULL;
+	}
+	return entry;
+}
+
+int _add_conflict(symbol_shard_t *shard, const char *name, long order, enum symbol_conflict_type type)
+{
+	symbol_conflict_t *conflict = (symbol_conflict_t *)stats_calloc(1, sizeof(symbol_conflict_t));
+
+	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(conflict, "Memory allocation failed in _add_conflict", FUNC_ERR);
+	strncpy(conflict->name, name, MAX_LABEL_SIZE - 1);
+	conflict->order = order;
+	conflict->type = type;
+	if (queue_enqueue(shard->conflicts, conflict) != SUCCESS)
+	{
+		free(conflict);
+		return FUNC_ERR;
+	}
+	++shard->num_conflicts;
+	return SUCCESS;
+}
+
+void _entry_to_symbol(const symbol_entry_t *entry, symbol_t *symbol)
+{
+	memset(symbol, 0, sizeof(symbol_t));
+	symbol->symbol_name = entry->name;
+	symbol->symbol_location = entry->symbol_location;
+	if (entry->define_order != NO_ORDER)
+	{
+		symbol->memory_type = entry->memory_type;
+		symbol->symbol_value = entry->symbol_value;
+		symbol->num_elements = entry->num_elements;
+	}
+	else
+	{
+		/* like init_symbol_location_data, a symbol that was only declared */
+		symbol->symbol_value = (entry->symbol_location == SYMBOL__EXTERN) ? 0 : -1;
+	}
+}
+
+long _entry_first_order(const symbol_entry_t *entry)
+{
+	if (entry->define_order == NO_ORDER)
+	{
+		return entry->location_order;
+	}
+	if (entry->location_order == NO_ORDER || entry->define_order < entry->location_order)
+	{
+		return entry->define_order;
+	}
+	return entry->location_order;
+}
+
+void _collect_entry(const char *key, void *data, void *entries)
+{
+	symbol_entries_t *collected = (symbol_entries_t *)entries;
+
+	UNUSED(key);
+	collected->entries[collected->num_entries++] = (symbol_entry_t *)data;
+}
+
+int _compare_entries(const void *first, const void *second)
+{
+	const symbol_entry_t *first_entry = *(const symbol_entry_t *const *)first;
+	const symbol_entry_t *second_entry = *(const symbol_entry_t *const *)second;
+	long first_order = _entry_first_order(first_entry);
+	long second_order = _entry_first_order(second_entry);
+
+	if (first_order != second_order)
+	{
+		return first_order < second_order ? -1 : 1;
+	}
+	return strcmp(first_entry->name, second_entry->name);
+}
+
+int _compare_conflicts(const void *first, const void *second)
+{
+	const symbol_conflict_t *first_conflict = *(const symbol_conflict_t *const *)first;
+	const symbol_conflict_t *second_conflict = *(const symbol_conflict_t *const *)second;
+	int name_compare = 0;
+
+	if (first_conflict->order != second_conflict->order)
+	{
+		return first_conflict->order < second_conflict->order ? -1 : 1;
+	}
+	name_compare = strcmp(first_conflict->name, second_conflict->name);
+	return name_compare != 0 ? name_compare : (int)first_conflict->type - (int)second_conflict->type;
+}
+
+int _compare_locations(const void *first, const void *second)
+{
+	const symbol_entry_t *first_entry = *(const symbol_entry_t *const *)first;
+	const symbol_entry_t *second_entry = *(const symbol_entry_t *const *)second;
+
+	if (first_entry->location_order != second_entry->location_order)
+	{
+		return first_entry->location_order < second_entry->location_order ? -1 : 1;
+	}
+	return strcmp(first_entry->name, second_entry->name);
+}
+
+int _export_entry_symbols(symbol_entries_t *entries, assembler_data_t *assembler_data)
+{
+	symbol_t *symbol = NULL;
+	int num_entry_symbols = 0;
+	int i = 0;
+
+	/* the .entry symbols are moved to the front, and put in the order of their .entry lines like a single thread adds them */
+	for (i = 0; i < entries->num_entries; ++i)
+	{
+		if (entries->entries[i]->location_order != NO_ORDER && entries->entries[i]->symbol_location == SYMBOL__ENTRY)
+		{
+			entries->entries[num_entry_symbols++] = entries->entries[i];
+		}
+	}
+	qsort(entries->entries, num_entry_symbols, sizeof(symbol_entry_t *), _compare_locations);
+	for (i = 0; i < num_entry_symbols; ++i)
+	{
+		symbol = (symbol_t *)hash_table_lookup(assembler_data->symbol_table, entries->entries[i]->name);
+		if (symbol == NULL || deque_push_back(assembler_data->entry_symbols, symbol) != SUCCESS)
+		{
+			LOG(ERROR, PARAMS, "failed to export entry symbol %s", entries->entries[i]->name);
+			return FUNC_ERR;
+		}
+	}
+	return SUCCESS;
+}
+
+int _export_conflicts(concurrent_symbol_table_t *table, const symbol_entries_t *entries, StringVector *error_founds)
+{
+	symbol_conflict_t **sorted = NULL;
+	symbol_conflict_t *conflict = NULL;
+	char log_error[MAX_LINE_SIZE + MAX_LINE_SIZE];
+	int max_conflicts = entries->num_entries; /* at most one .extern conflict per symbol */
+	int num_conflicts = 0;
+	int ret = SUCCESS;
+	int i = 0;
+
+	for (i = 0; i < table->num_shards; ++i)
+	{
+		max_conflicts += table->shards[i].num_conflicts;
+	}
+	sorted = (symbol_conflict_t **)stats_malloc((max_conflicts + 1) * sizeof(symbol_conflict_t *));
+	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(sorted, "Memory allocation failed in _export_conflicts", FUNC_ERR);
+	for (i = 0; i < table->num_shards; ++i)
+	{
+		while (!queue_is_empty(table->shards[i].conflicts))
+		{
+			sorted[num_conflicts++] = (symbol_conflict_t *)queue_dequeue(table->shards[i].conflicts);
+		}
+		table->shards[i].num_conflicts = 0;
+	}
+
+	/* an .extern before the definition is known only when both were given, whatever their order of arrival */
+	for (i = 0; i < entries->num_entries; ++i)
+	{
+		if (entries->entries[i]->define_order == NO_ORDER || entries->entries[i]->symbol_location != SYMBOL__EXTERN ||
+			entries->entries[i]->location_order > entries->entries[i]->define_order)
+		{
+			continue;
+		}
+		conflict = (symbol_conflict_t *)stats_calloc(1, sizeof(symbol_conflict_t));
+		if (conflict == NULL)
+		{
+			LOG(ERROR, PARAMS, "Memory allocation failed in _export_conflicts");
+			ret = FUNC_ERR;
+			break;
+		}
+		strcpy(conflict->name, entries->entries[i]->name);
+		conflict->order = entries->entries[i]->define_order;
+		conflict->type = SYMBOL_CONFLICT__EXTERN_DEFINED;
+		sorted[num_conflicts++] = conflict;
+	}
+
+	qsort(sorted, num_conflicts, sizeof(symbol_conflict_t *), _compare_conflicts);
+	for (i = 0; i < num_conflicts && ret == SUCCESS; ++i)
+	{
+		if (sorted[i]->type == SYMBOL_CONFLICT__EXTERN_DEFINED)
+		{
+			sprintf(log_error, "line number: %ld symbol %s defined as extern but definition is given in this file.", sorted[i]->order, sorted[i]->name);
+		}
+		else
+		{
+			sprintf(log_error, "line number: %ld symbol %s already exists", sorted[i]->order, sorted[i]->name);
+		}
+		LOG(INFO, PARAMS, "%s", log_error);
+		if (string_vector_push_back(error_founds, log_error) != SUCCESS)
+		{
+			ret = FUNC_ERR;
+		}
+	}
+	for (i = 0; i < num_conflicts; ++i)
+	{
+		free(sorted[i]);
+	}
+	free(sorted);
+	return ret;
+}
+
+/*=============================================================================== */
+
+concurrent_symbol_table_t *concurrent_symbol_table_create(int num_shards)
+{
+	concurrent_symbol_table_t *table = (concurrent_symbol_table_t *)stats_calloc(1, sizeof(concurrent_symbol_table_t));
+	int i = 0;
+
+	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(table, "Memory allocation failed in concurrent_symbol_table_create", NULL);
+	table->shards = (symbol_shard_t *)stats_calloc(num_shards, sizeof(symbol_shard_t));
+	if (table->shards == NULL)
+	{
+		LOG(ERROR, PARAMS, "Memory allocation failed in concurrent_symbol_table_create");
+		free(table);
+		return NULL;
+	}
+
+	for (i = 0; i < num_shards; ++i)
+	{
+		table->shards[i].entries = hash_table_init();
+		table->shards[i].conflicts = queue_create();
+		if (table->shards[i].entries == NULL || table->shards[i].conflicts == NULL || pthread_mutex_init(&table->shards[i].lock, NULL) != SUCCESS)
+		{
+			LOG(ERROR, PARAMS, "failed to create shard %d of a concurrent symbol table", i);
+			if (table->shards[i].entries != NULL)
+			{
+				hash_table_free(table->shards[i].entries, NULL);
+			}
+			if (table->shards[i].conflicts != NULL)
+			{
+				queue_destroy(table->shards[i].conflicts, free);
+			}
+			table->num_shards = i;
+			concurrent_symbol_table_free(table);
+			return NULL;
+		}
+	}
+	table->num_shards = num_shards;
+	return table;
+}
+
+void concurrent_symbol_table_free(concurrent_symbol_table_t *table)
+{
+	int i = 0;
+
+	if (table == NULL)
+	{
+		return;
+	}
+	for (i = 0; i < table->num_shards; ++i)
+	{
+		/* hash_table_free frees only the nodes */
+		hash_table_clear(table->shards[i].entries, free);
+		hash_table_free(table->shards[i].entries, NULL);
+		queue_destroy(table->shards[i].conflicts, free);
+		pthread_mutex_destroy(&table->shards[i].lock);
+	}
+	free(table->shards);
+	free(table);
+}
+
+int concurrent_symbol_table_define(concurrent_symbol_table_t *table, const char *name, enum memory_type memory_type, short symbol_value, short num_elements, long order)
+{
+	symbol_shard_t *shard = _get_shard(table, name);
+	symbol_entry_t *entry = NULL;
+	long losing_order = NO_ORDER;
+	int ret = SUCCESS;
+
+	pthread_mutex_lock(&shard->lock);
+	entry = _get_or_add_entry(shard, name);
+	if (entry == NULL)
+	{
+		ret = FUNC_ERR;
+	}
+	else if (entry->define_order != NO_ORDER && entry->define_order < order)
+	{
+		losing_order = order;
+	}
+	else
+	{
+		/* the definition with the lower order wins, the one it replaces is the duplicate */
+		losing_order = entry->define_order;
+		entry->define_order = order;
+		entry->memory_type = memory_type;
+		entry->symbol_value = symbol_value;
+		entry->num_elements = num_elements;
+	}
+	if (losing_order != NO_ORDER)
+	{
+		ret = _add_conflict(shard, name, losing_order, SYMBOL_CONFLICT__DEFINED_TWICE);
+	}
+	pthread_mutex_unlock(&shard->lock);
+	return ret;
+}
+
+int concurrent_symbol_table_set_location(concurrent_symbol_table_t *table, const char *name, enum symbol_location symbol_location, long order)
+{
+	symbol_shard_t *shard = _get_shard(table, name);
+	symbol_entry_t *entry = NULL;
+	long losing_order = NO_ORDER;
+	int ret = SUCCESS;
+
+	pthread_mutex_lock(&shard->lock);
+	entry = _get_or_add_entry(shard, name);
+	if (entry == NULL)
+	{
+		ret = FUNC_ERR;
+	}
+	else if (entry->location_order != NO_ORDER && entry->location_order < order)
+	{
+		losing_order = order;
+	}
+	else
+	{
+		losing_order = entry->location_order;
+		entry->location_order = order;
+		entry->symbol_location = symbol_location;
+	}
+	if (losing_order != NO_ORDER)
+	{
+		ret = _add_conflict(shard, name, losing_order, SYMBOL_CONFLICT__LOCATION_TWICE);
+	}
+	pthread_mutex_unlock(&shard->lock);
+	return ret;
+}
+
+int concurrent_symbol_table_lookup(concurrent_symbol_table_t *table, const char *name, symbol_t *symbol)
+{
+	symbol_shard_t *shard = _get_shard(table, name);
+	symbol_entry_t *entry = NULL;
+
+	pthread_mutex_lock(&shard->lock);
+	entry = (symbol_entry_t *)hash_table_lookup_local(shard->entries, name);
+	if (entry != NULL)
+	{
+		_entry_to_symbol(entry, symbol);
+	}
+	pthread_mutex_unlock(&shard->lock);
+	return entry != NULL;
+}
+
+int concurrent_symbol_table_export(concurrent_symbol_table_t *table, assembler_data_t *assembler_data)
+{
+	symbol_entries_t collected;
+	symbol_t *symbol = NULL;
+	const char *interned_name = NULL;
+	size_t num_entries = 0;
+	int ret = SUCCESS;
+	int i = 0;
+
+	for (i = 0; i < table->num_shards; ++i)
+	{
+		num_entries += table->shards[i].entries->size;
+	}
+	collected.num_entries = 0;
+	collected.entries = (symbol_entry_t **)stats_malloc((num_entries + 1) * sizeof(symbol_entry_t *));
+	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(collected.entries, "Memory allocation failed in concurrent_symbol_table_export", FUNC_ERR);
+	for (i = 0; i < table->num_shards; ++i)
+	{
+		hash_table_for_each(table->shards[i].entries, _collect_entry, &collected);
+	}
+
+	/* the symbols are inserted in the order a single thread would have inserted them */
+	qsort(collected.entries, collected.num_entries, sizeof(symbol_entry_t *), _compare_entries);
+	ret = _export_conflicts(table, &collected, assembler_data->error_founds);
+	for (i = 0; i < collected.num_entries && ret == SUCCESS; ++i)
+	{
+		interned_name = intern_pool_intern(assembler_data->labels, collected.entries[i]->name);
+		symbol = (symbol_t *)stats_malloc(sizeof(symbol_t));
+		if (interned_name == NULL || symbol == NULL || hash_table_insert_borrowed(assembler_data->symbol_table, interned_name, symbol) != SUCCESS)
+		{
+			LOG(ERROR, PARAMS, "failed to export symbol %s", collected.entries[i]->name);
+			free(symbol);
+			ret = FUNC_ERR;
+			break;
+		}
+		_entry_to_symbol(collected.entries[i], symbol);
+		symbol->symbol_name = interned_name;
+		if (symbol->symbol_location == SYMBOL__ENTRY)
+		{
+			assembler_data->has_entry = TRUE;
+		}
+	}
+	if (ret == SUCCESS)
+	{
+		ret = _export_entry_symbols(&collected, assembler_data);
+	}
+	free(collected.entries);
+
+	for (i = 0; i < table->num_shards; ++i)
+	{
+		hash_table_clear(table->shards[i].entries, free);
+	}
+	return ret;
+}
@@ -0,0 +1,92 @@
+/* *******************************************************************
+ * Authors: Daniel Oren, Elisheva Cirota
+ *
+ * @file concurrent_symbol_table.h
+ * @brief This file contains the declarations of the concurrent symbol table.
+ *
+ * A symbol table that several threads can define symbols in, look symbols up in and set the
+ * .entry/.extern location of symbols in, at the same time, for passes that work on chunks of
+ * one input file in parallel. The table is split into shards by a hash of the symbol name, and
+ * every shard has a lock of its own, so threads that work on different symbols rarely wait.
+ *
+ * Every definition and location is given with its order in the input file (its line number).
+ * When a symbol is defined twice, the definition with the lower order is kept and the other one
+ * is reported, whichever thread came first, so the diagnostics are the same on every run and
+ * for every number of threads. They are reported, sorted by their order, when the table is
+ * exported to the symbol table of the second pass.
+ *
+ * The stats must be off while threads use the table, like in the server, because the stats
+ * counters are not synchronized.
+ *
+ *********************************************************************/
+
+#ifndef CONCURRENT_SYMBOL_TABLE_H
+#define CONCURRENT_SYMBOL_TABLE_H
+
+#include "../assembler_helper/assembler_helper.h"
+
+#define CONCURRENT_SYMBOL_TABLE_DEFAULT_SHARDS (16)
+
+typedef struct concurrent_symbol_table concurrent_symbol_table_t;
+
+/**
+ * Creates an empty concurrent symbol table.
+ *
+ * @param num_shards The number of shards, each with a lock and a hash table of its own.
+ * @return A pointer to the new table, or NULL on memory allocation failure.
+ */
+concurrent_symbol_table_t *concurrent_symbol_table_create(int num_shards);
+
+/**
+ * Frees a concurrent symbol table and all of its symbols. No thread may use the table anymore.
+ *
+ * @param table The table to free.
+ */
+void concurrent_symbol_table_free(concurrent_symbol_table_t *table);
+
+/**
+ * Defines a symbol, a label or a .define constant. Safe to call from several threads.
+ *
+ * @param table The table.
+ * @param name The name of the symbol.
+ * @param memory_type The memory type of the symbol (MEM_TYPE__*).
+ * @param symbol_value The address of the label or the value of the constant.
+ * @param num_elements The number of elements of a data label.
+ * @param order The order of the definition in the input file, its line number.
+ * @return SUCCESS, or FUNC_ERR on memory allocation failure. A duplicate definition is not a failure of the call.
+ */
+int concurrent_symbol_table_define(concurrent_symbol_table_t *table, const char *name, enum memory_type memory_type, short symbol_value, short num_elements, long order);
+
+/**
+ * Sets the location of a symbol, for .entry and .extern. Safe to call from several threads.
+ *
+ * @param table The table.
+ * @param name The name of the symbol.
+ * @param symbol_location SYMBOL__ENTRY or SYMBOL__EXTERN.
+ * @param order The order of the .entry/.extern line in the input file, its line number.
+ * @return SUCCESS, or FUNC_ERR on memory allocation failure. A duplicate location is not a failure of the call.
+ */
+int concurrent_symbol_table_set_location(concurrent_symbol_table_t *table, const char *name, enum symbol_location symbol_location, long order);
+
+/**
+ * Looks a symbol up. Safe to call from several threads, also while others define symbols.
+ *
+ * @param table The table.
+ * @param name The name of the symbol.
+ * @param symbol Set to a copy of the symbol as it is at the moment of the call, its name is valid until the table is exported or freed.
+ * @return TRUE if the symbol was found, FALSE otherwise.
+ */
+int concurrent_symbol_table_lookup(concurrent_symbol_table_t *table, const char *name, symbol_t *symbol);
+
+/**
+ * Moves the symbols to the symbol table of the assembler data, in the order they first appeared in
+ * the input file, and pushes the diagnostics of the duplicate definitions and locations to its errors,
+ * sorted by their order. Must be called after all the threads are done with the table.
+ *
+ * @param table The table, it is left empty.
+ * @param assembler_data The assembler data to move the symbols to.
+ * @return SUCCESS, or FUNC_ERR on memory allocation failure.
+ */
+int concurrent_symbol_table_export(concurrent_symbol_table_t *table, assembler_data_t *assembler_data);
+
+#endif /* CONCURRENT_SYMBOL_TABLE_H */
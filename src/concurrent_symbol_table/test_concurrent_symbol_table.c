@@ -0,0 +1,294 @@
+/* *******************************************************************
+ * Authors: Daniel Oren, Elisheva Cirota
+ *
+ * @file  test_concurrent_symbol_table.c
+ * @brief This file contains a stress test and a scaling benchmark of the concurrent symbol table.
+ *
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "concurrent_symbol_table.h"
+#include "../assembler/assembler.h"
+#include "../utils/utils.h"
+
+#define TEST_CST_NUM_SYMBOLS (20000)
+#define TEST_CST_MAX_THREADS (8)
+#define TEST_CST_BENCHMARK_SYMBOLS (200000)
+#define TEST_CST_RESULT_SIZE (4 * 1024 * 1024)
+
+enum test_cst_operation_type
+{
+	TEST_CST__DEFINE,
+	TEST_CST__ENTRY,
+	TEST_CST__EXTERN,
+	TEST_CST__LOOKUP
+};
+
+/* one line of a generated input file */
+typedef struct test_cst_operation
+{
+	enum test_cst_operation_type type;
+	int symbol_index;
+	long order;
+	short value;
+} test_cst_operation_t;
+
+/* the operations thread_index, thread_index + num_threads, ... of the array */
+typedef struct test_cst_thread_args
+{
+	concurrent_symbol_table_t *table;
+	const test_cst_operation_t *operations;
+	int num_operations;
+	int thread_index;
+	int num_threads;
+	int num_failures;
+} test_cst_thread_args_t;
+
+/* a serialized result of an export, to compare runs with different numbers of threads */
+typedef struct test_cst_result
+{
+	char *text;
+	size_t size;
+} test_cst_result_t;
+
+void *_test_cst_thread(void *args)
+{
+	test_cst_thread_args_t *thread_args = (test_cst_thread_args_t *)args;
+	const test_cst_operation_t *operation = NULL;
+	char name[MAX_LABEL_SIZE];
+	symbol_t symbol;
+	int i = 0;
+
+	for (i = thread_args->thread_index; i < thread_args->num_operations; i += thread_args->num_threads)
+	{
+		operation = &thread_args->operations[i];
+		sprintf(name, "L%d", operation->symbol_index);
+		switch (operation->type)
+		{
+		case TEST_CST__DEFINE:
+			thread_args->num_failures += concurrent_symbol_table_define(thread_args->table, name, MEM_TYPE__INSTRUCTION, operation->value, 0, operation->order) != SUCCESS;
+			break;
+		case TEST_CST__ENTRY:
+			thread_args->num_failures += concurrent_symbol_table_set_location(thread_args->table, name, SYMBOL__ENTRY, operation->order) != SUCCESS;
+			break;
+		case TEST_CST__EXTERN:
+			thread_args->num_failures += concurrent_symbol_table_set_location(thread_args->table, name, SYMBOL__EXTERN, operation->order) != SUCCESS;
+			break;
+		case TEST_CST__LOOKUP:
+			/* the symbol may not be defined yet, but when it is found it must be whole */
+			if (concurrent_symbol_table_lookup(thread_args->table, name, &symbol) && strcmp(symbol.symbol_name, name) != 0)
+			{
+				++thread_args->num_failures;
+			}
+			break;
+		}
+	}
+	return NULL;
+}
+
+void _test_cst_serialize_symbol(const char *key, void *data, void *result)
+{
+	symbol_t *symbol = (symbol_t *)data;
+	test_cst_result_t *serialized = (test_cst_result_t *)result;
+
+	if (serialized->size + MAX_LINE_SIZE < TEST_CST_RESULT_SIZE)
+	{
+		serialized->size += sprintf(serialized->text + serialized->size, "%s %d %d %d\n", key, symbol->symbol_value, symbol->symbol_location, symbol->memory_type);
+	}
+}
+
+void _test_cst_add(test_cst_operation_t *operations, int *num_operations, enum test_cst_operation_type type, int symbol_index, long order)
+{
+	operations[*num_operations].type = type;
+	operations[*num_operations].symbol_index = symbol_index;
+	operations[*num_operations].order = order;
+	operations[*num_operations].value = (short)(order % 4096);
+	++(*num_operations);
+}
+
+/* generates the lines of an input file: every symbol is defined, some twice, some are .entry and some are .extern */
+test_cst_operation_t *_test_cst_generate(int num_symbols, int *num_operations)
+{
+	test_cst_operation_t *operations = (test_cst_operation_t *)malloc(5 * num_symbols * sizeof(test_cst_operation_t));
+	test_cst_operation_t temp;
+	int i = 0;
+	int j = 0;
+
+	*num_operations = 0;
+	if (operations == NULL)
+	{
+		return NULL;
+	}
+	for (i = 0; i < num_symbols; ++i)
+	{
+		if (i % 11 == 0)
+		{
+			_test_cst_add(operations, num_operations, TEST_CST__EXTERN, i, 4L * i + 1);
+		}
+		_test_cst_add(operations, num_operations, TEST_CST__DEFINE, i, 4L * i + 2);
+		if (i % 7 == 0)
+		{
+			_test_cst_add(operations, num_operations, TEST_CST__DEFINE, i, 4L * i + 3);
+		}
+		if (i % 5 == 0)
+		{
+			_test_cst_add(operations, num_operations, TEST_CST__ENTRY, i, 4L * i + 4);
+		}
+		_test_cst_add(operations, num_operations, TEST_CST__LOOKUP, i, 0);
+	}
+
+	/* the lines arrive in a scrambled order, like chunks that are done at different times */
+	srand(1);
+	for (i = *num_operations - 1; i > 0; --i)
+	{
+		j = rand() % (i + 1);
+		temp = operations[i];
+		operations[i] = operations[j];
+		operations[j] = temp;
+	}
+	return operations;
+}
+
+int _test_cst_run(const test_cst_operation_t *operations, int num_operations, int num_threads, test_cst_result_t *result, double *elapsed_usec)
+{
+	pthread_t threads[TEST_CST_MAX_THREADS];
+	test_cst_thread_args_t args[TEST_CST_MAX_THREADS];
+	concurrent_symbol_table_t *table = concurrent_symbol_table_create(CONCURRENT_SYMBOL_TABLE_DEFAULT_SHARDS);
+	assembler_data_t *assembler_data = init_assembler_data();
+	DequeIterator iterator;
+	void *entry_symbol = NULL;
+	double start = 0;
+	int num_failures = 0;
+	int i = 0;
+
+	if (table == NULL || assembler_data == NULL)
+	{
+		printf("FAILURE, couldn't create the tables\n");
+		return ERR;
+	}
+
+	start = get_monotonic_time_usec();
+	for (i = 0; i < num_threads; ++i)
+	{
+		args[i].table = table;
+		args[i].operations = operations;
+		args[i].num_operations = num_operations;
+		args[i].thread_index = i;
+		args[i].num_threads = num_threads;
+		args[i].num_failures = 0;
+		pthread_create(&threads[i], NULL, _test_cst_thread, &args[i]);
+	}
+	for (i = 0; i < num_threads; ++i)
+	{
+		pthread_join(threads[i], NULL);
+		num_failures += args[i].num_failures;
+	}
+	*elapsed_usec = get_monotonic_time_usec() - start;
+
+	num_failures += concurrent_symbol_table_export(table, assembler_data) != SUCCESS;
+	if (result != NULL)
+	{
+		result->size = 0;
+		for (i = 0; i < string_vector_get_size(assembler_data->error_founds) && result->size + MAX_LINE_SIZE + MAX_LINE_SIZE < TEST_CST_RESULT_SIZE; ++i)
+		{
+			result->size += sprintf(result->text + result->size, "%s\n", string_vector_at(assembler_data->error_founds, i));
+		}
+		hash_table_for_each(assembler_data->symbol_table, _test_cst_serialize_symbol, result);
+		/* the .ent order comes from the entry symbols, it must be the order of the .entry lines with any number of threads */
+		deque_iterator_init(assembler_data->entry_symbols, &iterator);
+		while (deque_iterator_next(&iterator, &entry_symbol) && result->size + MAX_LINE_SIZE < TEST_CST_RESULT_SIZE)
+		{
+			result->size += sprintf(result->text + result->size, "entry %s\n", ((symbol_t *)entry_symbol)->symbol_name);
+		}
+	}
+
+	concurrent_symbol_table_free(table);
+	free_assembler_data(assembler_data);
+	return num_failures == 0 ? SUCCESS : ERR;
+}
+
+void test_concurrent_symbol_table_stress()
+{
+	test_cst_result_t expected;
+	test_cst_result_t result;
+	test_cst_operation_t *operations = NULL;
+	int num_operations = 0;
+	int num_threads = 0;
+	double elapsed_usec = 0;
+
+	expected.text = (char *)malloc(TEST_CST_RESULT_SIZE);
+	result.text = (char *)malloc(TEST_CST_RESULT_SIZE);
+	operations = _test_cst_generate(TEST_CST_NUM_SYMBOLS, &num_operations);
+	if (expected.text == NULL || result.text == NULL || operations == NULL)
+	{
+		printf("FAILURE, memory allocation failed\n");
+		free(expected.text);
+		free(result.text);
+		free(operations);
+		return;
+	}
+
+	/* the result of one thread is the reference, every number of threads must give exactly the same diagnostics and symbols */
+	if (_test_cst_run(operations, num_operations, 1, &expected, &elapsed_usec) != SUCCESS)
+	{
+		printf("FAILURE, test_concurrent_symbol_table_stress with 1 thread\n");
+	}
+	for (num_threads = 2; num_threads <= TEST_CST_MAX_THREADS; num_threads *= 2)
+	{
+		if (_test_cst_run(operations, num_operations, num_threads, &result, &elapsed_usec) != SUCCESS ||
+			result.size != expected.size || memcmp(result.text, expected.text, result.size) != 0)
+		{
+			printf("FAILURE, test_concurrent_symbol_table_stress with %d threads\n", num_threads);
+			break;
+		}
+	}
+	if (num_threads > TEST_CST_MAX_THREADS)
+	{
+		printf("SUCCESS, test_concurrent_symbol_table_stress\n");
+	}
+
+	free(expected.text);
+	free(result.text);
+	free(operations);
+}
+
+void test_concurrent_symbol_table_benchmark()
+{
+	test_cst_operation_t *operations = NULL;
+	int num_operations = 0;
+	int num_threads = 0;
+	double elapsed_usec = 0;
+	double single_thread_usec = 0;
+
+	operations = _test_cst_generate(TEST_CST_BENCHMARK_SYMBOLS, &num_operations);
+	if (operations == NULL)
+	{
+		printf("FAILURE, memory allocation failed\n");
+		return;
+	}
+
+	printf("%-8s %12s %14s %8s\n", "threads", "usec", "ops/sec", "speedup");
+	for (num_threads = 1; num_threads <= TEST_CST_MAX_THREADS; num_threads *= 2)
+	{
+		if (_test_cst_run(operations, num_operations, num_threads, NULL, &elapsed_usec) != SUCCESS)
+		{
+			printf("FAILURE, test_concurrent_symbol_table_benchmark with %d threads\n", num_threads);
+			break;
+		}
+		single_thread_usec = num_threads == 1 ? elapsed_usec : single_thread_usec;
+		printf("%-8d %12.0f %14.0f %8.2f\n", num_threads, elapsed_usec, num_operations / (elapsed_usec / 1000000.0), single_thread_usec / elapsed_usec);
+	}
+	free(operations);
+}
+
+/* uncomment this line to run test_concurrent_symbol_table */
+/*int main()
+{
+	test_concurrent_symbol_table_stress();
+	test_concurrent_symbol_table_benchmark();
+	return SUCCESS;
+}*/
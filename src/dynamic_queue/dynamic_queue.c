@@ -11,6 +11,7 @@
 
 #include "../logger/logger.h"
 #include "../general_const/general_const.h"
+#include "../stats/stats.h"
 #include "../utils/utils.h"
 #include "dynamic_queue.h"
 
@@ -18,13 +19,13 @@
 
 Queue* queue_create()
 {
-    Queue *queue = (Queue*)malloc(sizeof(Queue));
+    Queue *queue = (Queue*)stats_malloc(sizeof(Queue));
     if (queue == NULL)
     {
         LOG(ERROR, PARAMS, "Memory allocation failed for queue_create queue struct");
         return NULL;
     }
-    queue->array = (void**)malloc(INITIAL_CAPACITY * sizeof(void *));
+    queue->array = (void**)stats_malloc(INITIAL_CAPACITY * sizeof(void *));
     if (queue->array == NULL)
     {
         LOG(ERROR, PARAMS, "Memory allocation failed for queue_create queue array");
@@ -50,7 +51,7 @@ int queue_enqueue(Queue *queue, void *item)
 	{
         /* Queue is full, need to resize*/
         int newCapacity = queue->capacity * 2;
-        void **newArray = (void**)malloc(newCapacity * sizeof(void *));
+        void **newArray = (void**)stats_malloc(newCapacity * sizeof(void *));
         if (newArray == NULL) {
             LOG(ERROR, PARAMS, "Memory allocation failed");
             return ERR;
@@ -66,6 +67,7 @@ int queue_enqueue(Queue *queue, void *item)
         queue->front = 0;
         queue->rear = i;
         queue->capacity = newCapacity;
+        stats_add(STATS_COUNTER__QUEUE_RESIZES, 1);
     }
     if (queue_is_empty(queue))
         queue->front = 0;
@@ -77,12 +79,13 @@ int queue_enqueue(Queue *queue, void *item)
 
 void* queue_dequeue(Queue *queue)
 {
-	void *item = queue->array[queue->front];
+	void *item = NULL;
     if (queue_is_empty(queue)) {
         LOG(ERROR, PARAMS, "Trying to dequeue from an empty queue.");
         return NULL;
     }
-   
+    item = queue->array[queue->front];
+
     if (queue->front == queue->rear)
         queue->front = queue->rear = -1;
     else
@@ -105,6 +108,18 @@ void queue_display(Queue *queue)
     printf("\n");
 }
 
+void queue_for_each(Queue *queue, QueueForEachFunc callback, void *user_data)
+{
+	int i = queue->front;
+    if (queue_is_empty(queue)) {
+        return;
+    }
+    do {
+        callback(queue->array[i], user_data);
+        i = (i + 1) % queue->capacity;
+    } while (i != (queue->rear + 1) % queue->capacity);
+}
+
 void queue_clear(Queue *queue, FreeFunc freeFunc)
 {
     if (queue == NULL) {
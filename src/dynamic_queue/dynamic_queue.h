@@ -22,6 +22,11 @@ typedef struct {
  */
 typedef void (*FreeFunc)(void *);
 
+/**
+ * @brief Function pointer type for visiting an element without removing it.
+ */
+typedef void (*QueueForEachFunc)(void *item, void *user_data);
+
 /**
  * @brief Creates a new dynamic-size queue.
  * @return A pointer to the newly created queue.
@@ -61,6 +66,15 @@ void* queue_dequeue(Queue *queue);
  */
 void queue_display(Queue *queue);
 
+/**
+ * @brief Calls a function for every element of the queue, from front to rear, without removing them.
+ * @param queue A pointer to the queue.
+ * @param callback The function to call for every element.
+ * @param user_data Passed to every call of callback.
+ * @remark Complexity: O(n).
+ */
+void queue_for_each(Queue *queue, QueueForEachFunc callback, void *user_data);
+
 /**
  * @brief Clears the queue.
  * @param queue A pointer to the queue.
@@ -8,72 +8,181 @@
  *********************************************************************/
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "ext_ent_file_builder.h"
 #include "../hash_table/hash_table.h"
 #include "../assembler/assembler.h"
 #include "../utils/utils.h"
 #include "../logger/logger.h"
+#include "../output_file/output_file.h"
+#include "../stats/stats.h"
+
+#define OUTPUT_LINE_SIZE (MAX_LABEL_SIZE + 8) /* the name, a tab, a value of up to 6 characters and a new line */
+#define OUTPUT_ADDRESS_SIZE (8) /* a separator and a value of up to 6 characters */
 
 /* -------------------------------- internal function declarations -------------*/
-void _write_to_file_if_symbol_entry(const char *key, void *data, void *file);
+int _compare_entry_addresses(const void *first, const void *second);
+int _format_address(char *buffer, short address);
+size_t _format_extern_uses(const extern_uses_t *extern_uses, char *buffer);
+size_t _format_grouped_extern_uses(const extern_uses_t *extern_uses, short *addresses, size_t *starts, char *buffer);
+int _write_buffer(FILE *file, const char *buffer, size_t size);
 
 /*--------------------------------- internal function definitions -------------*/
-void _write_to_file_if_symbol_entry(const char *key, void *data, void *file)
+int _compare_entry_addresses(const void *first, const void *second)
+{
+    const symbol_t *first_symbol = *(const symbol_t *const *)first;
+    const symbol_t *second_symbol = *(const symbol_t *const *)second;
+
+    if (first_symbol->symbol_value != second_symbol->symbol_value)
+    {
+        return first_symbol->symbol_value < second_symbol->symbol_value ? -1 : 1;
+    }
+    /* the names are unique, so symbols at the same address have a fixed order too */
+    return strcmp(first_symbol->symbol_name, second_symbol->symbol_name);
+}
+
+int _format_address(char *buffer, short address)
+{
+    /* an address has at least 4 digits */
+    return sprintf(buffer, count_digit(address) < 4 ? "0%d" : "%d", address);
+}
+
+size_t _format_extern_uses(const extern_uses_t *extern_uses, char *buffer)
+{
+    size_t size = 0;
+    size_t i = 0;
+
+    for (i = 0; i < extern_uses->num_uses; ++i)
+    {
+        size += sprintf(buffer + size, "%s\t", extern_uses->names[extern_uses->uses[i].symbol_id]);
+        size += _format_address(buffer + size, extern_uses->uses[i].address);
+        buffer[size++] = '\n';
+    }
+    return size;
+}
+
+size_t _format_grouped_extern_uses(const extern_uses_t *extern_uses, short *addresses, size_t *starts, char *buffer)
 {
-    symbol_t *symbol = (symbol_t *)data;
-    if (symbol->symbol_location == SYMBOL__ENTRY)
+    size_t size = 0;
+    size_t i = 0;
+    int symbol_id = 0;
+
+    /* a counting sort by symbol id. The uses are added in the order of the code, so the
+     * addresses of every symbol stay sorted, and the symbols are in the order of their first use */
+    memset(starts, 0, (extern_uses->num_names + 1) * sizeof(size_t));
+    for (i = 0; i < extern_uses->num_uses; ++i)
+    {
+        ++starts[extern_uses->uses[i].symbol_id + 1];
+    }
+    for (symbol_id = 0; symbol_id < extern_uses->num_names; ++symbol_id)
+    {
+        starts[symbol_id + 1] += starts[symbol_id];
+    }
+    for (i = 0; i < extern_uses->num_uses; ++i)
+    {
+        addresses[starts[extern_uses->uses[i].symbol_id]++] = extern_uses->uses[i].address;
+    }
+
+    /* starts[symbol_id] is now the end of the addresses of symbol_id */
+    i = 0;
+    for (symbol_id = 0; symbol_id < extern_uses->num_names; ++symbol_id)
     {
-        fprintf(file, "%s\t", symbol->symbol_name);
-		if (count_digit(symbol->symbol_value) < 4)
+        size += sprintf(buffer + size, "%s", extern_uses->names[symbol_id]);
+        buffer[size++] = '\t';
+        for (; i < starts[symbol_id]; ++i)
         {
-            fprintf(file, "0");
+            size += _format_address(buffer + size, addresses[i]);
+            buffer[size++] = ' ';
         }
-		fprintf(file, "%d\n", symbol->symbol_value);
+        buffer[size - 1] = '\n';
     }
+    return size;
+}
+
+int _write_buffer(FILE *file, const char *buffer, size_t size)
+{
+    if (fwrite(buffer, 1, size, file) != size)
+    {
+        LOG(ERROR, PARAMS, "failed to write an output file");
+        return FUNC_ERR;
+    }
+    return SUCCESS;
 }
 
 int build_extern_file(const char *filename, assembler_data_t *assembler)
 {
     char output_filename[MAX_LINE_SIZE];
+    output_file_t output_file;
     FILE *file;
-    extern_user_t *extern_user;
+    int ret = SUCCESS;
 
-    if (queue_is_empty(assembler->extern_symbols))
+    if (assembler->extern_uses.num_uses == 0)
     {
         /* no externs were defined in the file, no need to create the file */
         return SUCCESS;
     }
     get_output_file_name(filename, output_filename, EXT_FILE_EXTENSION);
-    file = fopen(output_filename, "w");
+    file = output_file_open(&output_file, output_filename);
+    if (file == NULL)
+    {
+        return FUNC_ERR;
+    }
 
-    while (!queue_is_empty(assembler->extern_symbols))
+    ret = write_extern_file(file, assembler);
+    if (ret != SUCCESS)
     {
-        extern_user  = (extern_user_t *)queue_dequeue(assembler->extern_symbols);
-		if (extern_user == NULL)
+        output_file_discard(&output_file);
+        return ret;
+    }
+    return output_file_commit(&output_file);
+}
+
+int write_extern_file(FILE *file, assembler_data_t *assembler)
+{
+    const extern_uses_t *extern_uses = &assembler->extern_uses;
+    char *buffer = NULL;
+    short *addresses = NULL;
+    size_t *starts = NULL;
+    size_t size = 0;
+    int ret = SUCCESS;
+
+    if (!assembler->is_ext_grouped)
+    {
+        buffer = (char *)stats_malloc(extern_uses->num_uses * OUTPUT_LINE_SIZE + 1);
+        CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(buffer, "Memory allocation failed in write_extern_file", FUNC_ERR);
+        size = _format_extern_uses(extern_uses, buffer);
+    }
+    else
+    {
+        buffer = (char *)stats_malloc(extern_uses->num_names * OUTPUT_LINE_SIZE + extern_uses->num_uses * OUTPUT_ADDRESS_SIZE + 1);
+        addresses = (short *)stats_malloc((extern_uses->num_uses + 1) * sizeof(short));
+        starts = (size_t *)stats_malloc((extern_uses->num_names + 1) * sizeof(size_t));
+        if (buffer == NULL || addresses == NULL || starts == NULL)
         {
-            LOG(ERROR, PARAMS, "queue_dequeue failed");
-            fclose(file);
+            LOG(ERROR, PARAMS, "Memory allocation failed in write_extern_file");
+            free(buffer);
+            free(addresses);
+            free(starts);
             return FUNC_ERR;
         }
-		fprintf(file, "%s\t", extern_user->label_name);
-		if (count_digit(extern_user->address) < 4)
-        {
-            fprintf(file, "0");
-        }
-		fprintf(file, "%d\n", extern_user->address);
-
-        free(extern_user);
+        size = _format_grouped_extern_uses(extern_uses, addresses, starts, buffer);
+        free(addresses);
+        free(starts);
     }
 
-    fclose(file);
-    return SUCCESS;
+    ret = _write_buffer(file, buffer, size);
+    free(buffer);
+    return ret;
 }
 
 int build_entry_file(const char *filename, assembler_data_t *assembler_data)
 {
     char output_filename[MAX_LINE_SIZE];
-    FILE *output_file = NULL;
+    output_file_t output_file;
+    FILE *output_stream = NULL;
+    int ret = SUCCESS;
 
     if (assembler_data->has_entry == FALSE)
     {
@@ -82,13 +191,72 @@ int build_entry_file(const char *filename, assembler_data_t *assembler_data)
     }
 
     get_output_file_name(filename, output_filename, ENT_FILE_EXTENSION);
-    output_file = fopen(output_filename, "w");
-    hash_table_for_each(assembler_data->symbol_table, _write_to_file_if_symbol_entry, output_file);
-
-    fclose(output_file);
-    return 0;
+    output_stream = output_file_open(&output_file, output_filename);
+    if (output_stream == NULL)
+    {
+        return FUNC_ERR;
+    }
+    ret = write_entry_file(output_stream, assembler_data);
+    if (ret != SUCCESS)
+    {
+        output_file_discard(&output_file);
+        return ret;
+    }
+    return output_file_commit(&output_file);
 }
 
+int write_entry_file(FILE *output_file, assembler_data_t *assembler_data)
+{
+    symbol_t **symbols = NULL;
+    char *buffer = NULL;
+    size_t size = 0;
+    int num_symbols = 0;
+    int ret = SUCCESS;
+    int i = 0;
 
+    symbols = get_ordered_entry_symbols(assembler_data, &num_symbols);
+    CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(symbols, "Memory allocation failed in write_entry_file", FUNC_ERR);
+    buffer = (char *)stats_malloc((size_t)num_symbols * OUTPUT_LINE_SIZE + 1);
+    if (buffer == NULL)
+    {
+        LOG(ERROR, PARAMS, "Memory allocation failed in write_entry_file");
+        free(symbols);
+        return FUNC_ERR;
+    }
 
+    /* the lines are formatted into one buffer and written at once */
+    for (i = 0; i < num_symbols; ++i)
+    {
+        size += sprintf(buffer + size, "%s\t", symbols[i]->symbol_name);
+        size += _format_address(buffer + size, symbols[i]->symbol_value);
+        buffer[size++] = '\n';
+    }
+    ret = _write_buffer(output_file, buffer, size);
+    free(buffer);
+    free(symbols);
+    return ret;
+}
 
+symbol_t **get_ordered_entry_symbols(assembler_data_t *assembler_data, int *num_symbols)
+{
+    symbol_t **symbols = NULL;
+    DequeIterator iterator;
+    void *item = NULL;
+    int i = 0;
+
+    *num_symbols = (int)deque_get_size(assembler_data->entry_symbols);
+    symbols = (symbol_t **)stats_malloc(((size_t)*num_symbols + 1) * sizeof(symbol_t *));
+    CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(symbols, "Memory allocation failed in get_ordered_entry_symbols", NULL);
+
+    /* entry_symbols is already in the order of the .entry lines */
+    deque_iterator_init(assembler_data->entry_symbols, &iterator);
+    while (deque_iterator_next(&iterator, &item))
+    {
+        symbols[i++] = (symbol_t *)item;
+    }
+    if (assembler_data->entry_order == ENTRY_ORDER__ADDRESS)
+    {
+        qsort(symbols, *num_symbols, sizeof(symbol_t *), _compare_entry_addresses);
+    }
+    return symbols;
+}
@@ -38,6 +38,38 @@ int build_extern_file(const char *filename, assembler_data_t *assembler);
  */
 int build_entry_file(const char *filename, assembler_data_t *assembler);
 
+/**
+ * Writes the content of an extern file to a stream, like build_extern_file.
+ * Nothing is written when no externs were used. A line is written for every use, or with
+ * --ext-grouped a line for every extern symbol with the addresses of all of its uses.
+ *
+ * @param file The stream to write to, it is not closed.
+ * @param assembler A pointer to the assembler data structure.
+ * @return Returns 0 on success, otherwise returns -1.
+ */
+int write_extern_file(FILE *file, assembler_data_t *assembler);
+
+/**
+ * Writes the content of an entry file to a stream, like build_entry_file.
+ * Nothing is written when no entries were defined.
+ *
+ * @param output_file The stream to write to, it is not closed.
+ * @param assembler A pointer to the assembler data.
+ * @return An integer indicating the success or failure of the operation.
+ */
+int write_entry_file(FILE *output_file, assembler_data_t *assembler);
+
+/**
+ * Returns the entry symbols in the order of the .ent file: the order of the .entry lines, or the
+ * order of their addresses with --ent-sort=address. Only the entry symbols are sorted, the symbol
+ * table is not walked, so the order does not depend on the hash table.
+ *
+ * @param assembler A pointer to the assembler data.
+ * @param num_symbols Set to the number of entry symbols.
+ * @return An array of the entry symbols that the caller frees, or NULL on memory allocation failure.
+ */
+symbol_t **get_ordered_entry_symbols(assembler_data_t *assembler, int *num_symbols);
+
 
 #endif /* EXT_ENT_FILE_BUILDER_H */
 
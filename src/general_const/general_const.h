@@ -10,6 +10,7 @@
 
 /* This file contains all common consts for all the projects*/
 #define LOG_SEPARATOR ("========================================")
+#define ASSEMBLER_VERSION ("1.0") /* change it whenever the output of the assembler changes, it invalidates the build cache */
 
 #define FALSE (0)
 #define TRUE (1)
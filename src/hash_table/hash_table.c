@@ -12,16 +12,182 @@
 
 #include "../logger/logger.h"
 #include "../general_const/general_const.h"
+#include "../stats/stats.h"
 #include "../utils/utils.h"
 #include "hash_table.h"
 
 #define INITIAL_TABLE_SIZE 10
 #define LOAD_FACTOR_THRESHOLD 0.75
+#define MIGRATION_STEP 4 /* old buckets moved by every insert while a resize is in progress, at least 2 so a resize ends before the next one */
+
+/* =========================== internal functions declarations ================== */
+unsigned int _hash_key(const char *key);
+void _free_nodes(HashNode **buckets, size_t capacity, CustomFreeFunction free_function_data);
+void _migrate_bucket(HashTable *ht, size_t old_index);
+void _migrate_step(HashTable *ht, size_t num_buckets);
+void _finish_resize(HashTable *ht);
+HashNode *_find_node(HashNode *current, const char *key, unsigned int hash);
+void _add_chains_stats(HashNode **buckets, size_t capacity, HashTableStats *stats, size_t *total_probes);
+int _insert_node(HashTable *ht, HashNode *new_node);
+
+/* =========================== internal functions implementations ================= */
+
+/* Function to compute the hash value of a key, before it is reduced to a bucket */
+unsigned int _hash_key(const char *key)
+{
+    unsigned int hashValue = 0;
+    while (*key)
+    {
+        hashValue = (hashValue << 5) + *key++;
+    }
+    return hashValue;
+}
+
+/* Function to free all the nodes of an array of buckets */
+void _free_nodes(HashNode **buckets, size_t capacity, CustomFreeFunction free_function_data)
+{
+    size_t i = 0;
+    HashNode *current = NULL;
+    HashNode *temp = NULL;
+
+    for (i = 0; i < capacity; i++)
+    {
+        current = buckets[i];
+        while (current != NULL)
+        {
+            temp = current;
+            current = current->next;
+            if (free_function_data != NULL)
+            {
+                free_function_data(temp->data);
+            }
+            if (temp->owns_key)
+            {
+                free(temp->key);
+            }
+            free(temp);
+        }
+        buckets[i] = NULL;
+    }
+}
+
+/* Function to move the nodes of one old bucket to the new buckets, in the order a full rehash would give them */
+void _migrate_bucket(HashTable *ht, size_t old_index)
+{
+    HashNode *current = ht->old_buckets[old_index];
+    HashNode *next = NULL;
+    size_t new_index = 0;
+
+    while (current != NULL)
+    {
+        next = current->next;
+        new_index = current->hash % ht->capacity;
+        current->next = ht->buckets[new_index];
+        ht->buckets[new_index] = current;
+        current = next;
+    }
+    ht->old_buckets[old_index] = NULL;
+}
+
+/* Function to move the next old buckets, and to end the resize when all of them were moved */
+void _migrate_step(HashTable *ht, size_t num_buckets)
+{
+    for (; num_buckets > 0 && ht->migrate_index < ht->old_capacity; ht->migrate_index++)
+    {
+        if (ht->old_buckets[ht->migrate_index] != NULL)
+        {
+            _migrate_bucket(ht, ht->migrate_index);
+            num_buckets--;
+        }
+    }
+    if (ht->migrate_index == ht->old_capacity)
+    {
+        free(ht->old_buckets);
+        ht->old_buckets = NULL;
+        ht->old_capacity = 0;
+        ht->migrate_index = 0;
+    }
+}
+
+/* Function to move all the old buckets that were not moved yet */
+void _finish_resize(HashTable *ht)
+{
+    if (ht->old_buckets != NULL)
+    {
+        _migrate_step(ht, ht->old_capacity);
+    }
+}
+
+/* Function to find the node of a key in a bucket */
+HashNode *_find_node(HashNode *current, const char *key, unsigned int hash)
+{
+    while (current != NULL)
+    {
+        stats_add(STATS_COUNTER__HASH_PROBES, 1);
+        if (current->key == key || (current->hash == hash && strcmp(current->key, key) == 0))
+        {
+            return current;
+        }
+        current = current->next;
+    }
+    return NULL;
+}
+
+/* Function to add the chains of an array of buckets to the statistics */
+void _add_chains_stats(HashNode **buckets, size_t capacity, HashTableStats *stats, size_t *total_probes)
+{
+    size_t i = 0;
+    size_t chain_length = 0;
+    HashNode *current = NULL;
+
+    for (i = 0; i < capacity; i++)
+    {
+        chain_length = 0;
+        for (current = buckets[i]; current != NULL; current = current->next)
+        {
+            /* the key of the n-th node of a chain is found after n probes */
+            *total_probes += ++chain_length;
+        }
+        stats->used_buckets += chain_length > 0;
+        stats->longest_chain = chain_length > stats->longest_chain ? chain_length : stats->longest_chain;
+    }
+}
+
+/* Function to add a new node to the hash table, and to resize the hash table if needed */
+int _insert_node(HashTable *ht, HashNode *new_node)
+{
+    unsigned int index = 0;
+
+    if (ht->old_buckets != NULL)
+    {
+        /* the nodes of the old bucket go first, so the new node is before them like after a full rehash */
+        _migrate_bucket(ht, new_node->hash % ht->old_capacity);
+        _migrate_step(ht, MIGRATION_STEP);
+    }
+    index = new_node->hash % ht->capacity;
+    new_node->next = ht->buckets[index];
+    ht->buckets[index] = new_node;
+    ht->size++;
+    stats_add(STATS_COUNTER__HASH_INSERTS, 1);
+
+    /* Check if resizing is needed */
+    if ((double)ht->size / ht->capacity >= LOAD_FACTOR_THRESHOLD)
+    {
+        if (hash_table_resize(ht) != SUCCESS)
+        {
+            return ERR;
+        }
+    }
+
+    return SUCCESS; /* Indicate success*/
+}
+
+/*=============================================================================== */
 
 /* Function to initialize the hash table */
 HashTable *hash_table_init()
 {
-    HashTable *ht = (HashTable *)malloc(sizeof(HashTable));
+    HashTable *ht = (HashTable *)stats_malloc(sizeof(HashTable));
     if (ht == NULL)
     {
         LOG(ERROR, PARAMS, "inside hash_table_init: Memory allocation for the hashtable failed!");
@@ -29,7 +195,14 @@ HashTable *hash_table_init()
     }
     ht->size = 0;
     ht->capacity = INITIAL_TABLE_SIZE;
-    ht->buckets = (HashNode **)calloc(INITIAL_TABLE_SIZE, sizeof(HashNode *));
+    ht->fallback = NULL;
+    ht->old_buckets = NULL;
+    ht->old_capacity = 0;
+    ht->migrate_index = 0;
+    ht->num_resizes = 0;
+    ht->lookup_hits = 0;
+    ht->lookup_misses = 0;
+    ht->buckets = (HashNode **)stats_calloc(INITIAL_TABLE_SIZE, sizeof(HashNode *));
     if (ht->buckets == NULL)
     {
         LOG(ERROR, PARAMS, "inside hash_table_init: Memory allocation for the nodes failed!");
@@ -43,33 +216,30 @@ HashTable *hash_table_init()
 /* Function to free the memory allocated for the hash table */
 void hash_table_free(HashTable *ht, CustomFreeFunction free_function_data)
 {
-    int i = 0;
-    for (i = 0; i < ht->capacity; i++)
+    UNUSED(free_function_data);
+    _free_nodes(ht->buckets, ht->capacity, NULL);
+    if (ht->old_buckets != NULL)
     {
-        HashNode *current = ht->buckets[i];
-        while (current != NULL)
-        {
-            HashNode *temp = current;
-            current = current->next;
-            free(temp->key);
-            free(temp);
-        }
+        _free_nodes(ht->old_buckets, ht->old_capacity, NULL);
+        free(ht->old_buckets);
     }
     free(ht->buckets);
     free(ht);
 }
 
 /* Function to create a new hash node */
-HashNode *hash_table_create_hash_node(const char *key, void *data)
+HashNode *hash_table_create_hash_node(const char *key, void *data, unsigned int hash)
 {
-    HashNode *new_node = (HashNode *)malloc(sizeof(HashNode));
+    HashNode *new_node = (HashNode *)stats_malloc(sizeof(HashNode));
     if (new_node == NULL)
     {
         LOG(ERROR, PARAMS, "inside create_hash_node: Memory allocation for the new node failed!");
         return NULL;
     }
     new_node->key = str_dup(key);
+    new_node->owns_key = TRUE;
     new_node->data = data;
+    new_node->hash = hash;
     new_node->next = NULL;
     return new_node;
 }
@@ -77,89 +247,132 @@ HashNode *hash_table_create_hash_node(const char *key, void *data)
 /* Function to compute the hash value for a given key */
 unsigned int hash_table_hash(const char *key, size_t capacity)
 {
-    unsigned int hashValue = 0;
-    while (*key)
-    {
-        hashValue = (hashValue << 5) + *key++;
-    }
-    return hashValue % capacity;
+    return _hash_key(key) % capacity;
 }
 
 /* Function to insert a key-value pair into the hash table */
 int hash_table_insert(HashTable *ht, const char *key, void *data)
 {
-    unsigned int index = hash_table_hash(key, ht->capacity);
+    HashNode *new_node = hash_table_create_hash_node(key, data, _hash_key(key));
 
-    HashNode *new_node = hash_table_create_hash_node(key, data);
     if (new_node == NULL)
     { /* Check for node creation failure*/
         return ERR;
     }
+    return _insert_node(ht, new_node);
+}
 
-    new_node->next = ht->buckets[index];
-    ht->buckets[index] = new_node;
-    ht->size++;
+/* Function to insert a key-value pair into the hash table without copying the key */
+int hash_table_insert_borrowed(HashTable *ht, const char *key, void *data)
+{
+    HashNode *new_node = (HashNode *)stats_malloc(sizeof(HashNode));
 
-    /* Check if resizing is needed */
-    if ((double)ht->size / ht->capacity >= LOAD_FACTOR_THRESHOLD)
+    if (new_node == NULL)
     {
-        if (hash_table_resize(ht) != SUCCESS)
-        {
-            return ERR;
-        }
+        LOG(ERROR, PARAMS, "inside hash_table_insert_borrowed: Memory allocation for the new node failed!");
+        return ERR;
     }
-
-    return SUCCESS; /* Indicate success*/
+    new_node->key = (char *)key;
+    new_node->owns_key = FALSE;
+    new_node->data = data;
+    new_node->hash = _hash_key(key);
+    new_node->next = NULL;
+    return _insert_node(ht, new_node);
 }
-/* Function to resize the hash table */
+
+/* Function to resize the hash table, the nodes are moved by the following inserts */
 int hash_table_resize(HashTable *ht)
 {
-    int i = 0;
-    unsigned int new_index = 0;
     size_t new_capacity = ht->capacity * 2;
-    HashNode **new_buckets = (HashNode **)calloc(new_capacity, sizeof(HashNode *));
-    HashNode *next = NULL;
+    HashNode **new_buckets = (HashNode **)stats_calloc(new_capacity, sizeof(HashNode *));
+
     if (new_buckets == NULL)
     {
         LOG(ERROR, PARAMS, "inside hash_table_resize: Memory allocation for the new node failed!");
         return ERR;
     }
 
-    /* Rehash all existing elements */
-    for (i = 0; i < ht->capacity; i++)
+    /* a resize that is still in progress ends before the next one starts */
+    _finish_resize(ht);
+    ht->old_buckets = ht->buckets;
+    ht->old_capacity = ht->capacity;
+    ht->migrate_index = 0;
+    ht->buckets = new_buckets;
+    ht->capacity = new_capacity;
+    ht->num_resizes++;
+    return SUCCESS;
+}
+
+/* Function to make room for a number of elements */
+int hash_table_reserve(HashTable *ht, size_t expected_size)
+{
+    size_t new_capacity = ht->capacity;
+
+    /* doubling keeps every new bucket fed by a single old bucket, like a regular resize */
+    while ((double)expected_size / new_capacity >= LOAD_FACTOR_THRESHOLD)
     {
-        HashNode *current = ht->buckets[i];
-        while (current != NULL)
+        new_capacity *= 2;
+    }
+    if (new_capacity == ht->capacity)
+    {
+        return SUCCESS;
+    }
+    if (hash_table_resize(ht) != SUCCESS)
+    {
+        return ERR;
+    }
+    _finish_resize(ht);
+    while (ht->capacity < new_capacity)
+    {
+        if (hash_table_resize(ht) != SUCCESS)
         {
-            next = current->next;
-            new_index = hash_table_hash(current->key, new_capacity);
-            current->next = new_buckets[new_index];
-            new_buckets[new_index] = current;
-            current = next;
+            return ERR;
         }
+        _finish_resize(ht);
     }
-
-    /* Update hash table properties */
-    free(ht->buckets);
-    ht->buckets = new_buckets;
-    ht->capacity = new_capacity;
     return SUCCESS;
 }
 
-/* Function to retrieve the value associated with a key from the hash table */
+/* Function to retrieve the value associated with a key from the hash table, or from its fallback */
 void *hash_table_lookup(HashTable *ht, const char *key)
 {
-    unsigned int index = hash_table_hash(key, ht->capacity);
-    HashNode *current = ht->buckets[index];
-    while (current != NULL)
+    void *data = hash_table_lookup_local(ht, key);
+
+    if (data == NULL && ht->fallback != NULL)
     {
-        if (strcmp(current->key, key) == 0)
-        {
-            return current->data;
-        }
-        current = current->next;
+        return hash_table_lookup(ht->fallback, key);
+    }
+    return data;
+}
+
+/* Function to retrieve the value associated with a key from the hash table itself */
+void *hash_table_lookup_local(HashTable *ht, const char *key)
+{
+    /* a lookup doesn't move buckets: a fallback table is read by several threads at once */
+    unsigned int hash = _hash_key(key);
+    HashNode *node = _find_node(ht->buckets[hash % ht->capacity], key, hash);
+
+    stats_add(STATS_COUNTER__HASH_LOOKUPS, 1);
+    if (node == NULL && ht->old_buckets != NULL)
+    {
+        node = _find_node(ht->old_buckets[hash % ht->old_capacity], key, hash);
     }
-    return NULL; /* Key not found */
+    /* counted only with the stats on, like the other counters, since the server shares fallback tables between threads */
+    if (stats_get_mode() != STATS_MODE__OFF && node != NULL)
+    {
+        ht->lookup_hits++;
+    }
+    else if (stats_get_mode() != STATS_MODE__OFF)
+    {
+        ht->lookup_misses++;
+    }
+    return node != NULL ? node->data : NULL; /* NULL if the key was not found */
+}
+
+/* Function to set the table that missing keys are looked up in */
+void hash_table_set_fallback(HashTable *ht, HashTable *fallback)
+{
+    ht->fallback = fallback;
 }
 
 /* Function to traverse all elements in the hash table and call the callback function for each element */
@@ -173,6 +386,8 @@ void hash_table_for_each(HashTable *ht, HashTableForEachCallback callback, void
         return;
     }
 
+    /* the elements are visited in the order of the buckets, as if the table was rehashed at once */
+    _finish_resize(ht);
     for (i = 0; i < ht->capacity; i++)
     {
         HashNode *current = ht->buckets[i];
@@ -187,19 +402,39 @@ void hash_table_for_each(HashTable *ht, HashTableForEachCallback callback, void
 /* Function to clear the hash table */
 void hash_table_clear(HashTable *ht, CustomFreeFunction free_function_data)
 {
-    int i = 0;
-    for (i = 0; i < ht->capacity; i++)
+    /* Free the data using the provided custom free function */
+    _free_nodes(ht->buckets, ht->capacity, free_function_data);
+    if (ht->old_buckets != NULL)
     {
-        HashNode *current = ht->buckets[i];
-        while (current != NULL)
-        {
-            HashNode *temp = current;
-            current = current->next;
-            free_function_data(temp->data); /* Free the data using the provided custom free function */
-            free(temp->key);
-            free(temp);
-        }
-        ht->buckets[i] = NULL; /* Set the bucket to NULL after clearing the linked list */
+        _free_nodes(ht->old_buckets, ht->old_capacity, free_function_data);
+        free(ht->old_buckets);
+        ht->old_buckets = NULL;
+        ht->old_capacity = 0;
+        ht->migrate_index = 0;
     }
     ht->size = 0; 
+    ht->num_resizes = 0;
+    ht->lookup_hits = 0;
+    ht->lookup_misses = 0;
+}
+
+/* Function to get the statistics of the hash table */
+void hash_table_get_stats(HashTable *ht, HashTableStats *stats)
+{
+    size_t total_probes = 0;
+
+    memset(stats, 0, sizeof(HashTableStats));
+    stats->size = ht->size;
+    stats->capacity = ht->capacity;
+    stats->num_resizes = ht->num_resizes;
+    stats->lookup_hits = ht->lookup_hits;
+    stats->lookup_misses = ht->lookup_misses;
+
+    /* a resize in progress is not finished, the statistics don't change the table */
+    _add_chains_stats(ht->buckets, ht->capacity, stats, &total_probes);
+    if (ht->old_buckets != NULL)
+    {
+        _add_chains_stats(ht->old_buckets, ht->old_capacity, stats, &total_probes);
+    }
+    stats->average_probe_length = ht->size == 0 ? 0 : (double)total_probes / ht->size;
 }
@@ -13,17 +13,39 @@ typedef struct HashNode
 {
     char *key;
     void *data;
+    unsigned int hash; /* hash of the key before it is reduced to a bucket, so resizing doesn't hash the key again */
+    int owns_key; /* FALSE when the key is borrowed from the caller, see hash_table_insert_borrowed */
     struct HashNode *next;
 } HashNode;
 
 /* Define a structure for the hash table */
-typedef struct
+typedef struct HashTable
 {
     size_t size;        /* Current size of the hash table */
     size_t capacity;    /* Capacity of the hash table */
     HashNode **buckets; /* Array of buckets */
+    HashNode **old_buckets; /* Buckets of the array before a resize, that are not moved yet. NULL when no resize is in progress */
+    size_t old_capacity; /* Capacity of old_buckets */
+    size_t migrate_index; /* The old buckets before this index were moved */
+    size_t num_resizes; /* Number of resizes since the hash table was created or cleared */
+    unsigned long lookup_hits; /* Number of lookups that found their key, counted only when the stats are on */
+    unsigned long lookup_misses; /* Number of lookups that didn't find their key, counted only when the stats are on */
+    struct HashTable *fallback; /* Table to look up the keys that are not in this table, not owned. NULL if there is none */
 } HashTable;
 
+/* Define a structure for the statistics of a hash table */
+typedef struct HashTableStats
+{
+    size_t size;                 /* Number of elements */
+    size_t capacity;             /* Number of buckets */
+    size_t used_buckets;         /* Number of buckets with at least one element */
+    size_t longest_chain;        /* Number of elements in the longest bucket, the most probes of a lookup */
+    double average_probe_length; /* Average number of probes of a lookup that finds its key */
+    size_t num_resizes;          /* Number of resizes since the hash table was created or cleared */
+    unsigned long lookup_hits;   /* Number of lookups that found their key */
+    unsigned long lookup_misses; /* Number of lookups that didn't find their key */
+} HashTableStats;
+
 /* Function prototype for the callback function  for free unction*/
 typedef void (*CustomFreeFunction)(void *);
 
@@ -69,14 +91,41 @@ unsigned int hash_table_hash(const char *key, size_t capacity);
  */
 int hash_table_insert(HashTable *ht, const char *key, void *data);
 
+/*
+ * Function to insert a key-value pair into the hash table without copying the key.
+ * The key must stay valid and unchanged as long as it is in the hash table, like a string of an intern pool.
+ * A lookup with the same pointer finds the key without comparing the strings.
+ *
+ * Parameters:
+ *   ht: Pointer to the hash table
+ *   key: The key associated with the data, it is not copied
+ *   data: Pointer to the data
+ */
+int hash_table_insert_borrowed(HashTable *ht, const char *key, void *data);
+
 /*
  * Function to resize the hash table when the load factor exceeds a threshold.
+ * The capacity is doubled at once, but the nodes are moved to the new buckets a few buckets at a time,
+ * by the following inserts, so no single insert rehashes the whole table.
  *
  * Parameters:
  *   ht: Pointer to the hash table
  */
 int hash_table_resize(HashTable *ht);
 
+/*
+ * Function to make room for a number of elements, so inserting them doesn't resize the hash table.
+ * The capacity is never reduced.
+ *
+ * Parameters:
+ *   ht: Pointer to the hash table
+ *   expected_size: The number of elements the hash table is expected to hold
+ *
+ * Returns:
+ *   SUCCESS, or ERR if the memory allocation failed
+ */
+int hash_table_reserve(HashTable *ht, size_t expected_size);
+
 /*
  * Function to retrieve the data associated with a given key from the hash table.
  *
@@ -89,17 +138,41 @@ int hash_table_resize(HashTable *ht);
  */
 void *hash_table_lookup(HashTable *ht, const char *key);
 
+/*
+ * Function to retrieve the data associated with a given key from the hash table itself, without its fallback.
+ *
+ * Parameters:
+ *   ht: Pointer to the hash table
+ *   key: The key for which the data needs to be retrieved
+ *
+ * Returns:
+ *   Pointer to the data associated with the key, or NULL if the key is not in the hash table
+ */
+void *hash_table_lookup_local(HashTable *ht, const char *key);
+
+/*
+ * Function to set the table that keys not found in the hash table are looked up in.
+ * The fallback is only read, so one table can be the fallback of many tables.
+ * Clearing, freeing and traversing the hash table don't touch its fallback.
+ *
+ * Parameters:
+ *   ht: Pointer to the hash table
+ *   fallback: Pointer to the fallback hash table, or NULL to remove the fallback
+ */
+void hash_table_set_fallback(HashTable *ht, HashTable *fallback);
+
 /*
  * Function to create a new hash node.
  *
  * Parameters:
  *   key: The key associated with the data
  *   data: Pointer to the data
+ *   hash: The hash of the key, before it is reduced to a bucket
  *
  * Returns:
  *   Pointer to the newly created hash node
  */
-HashNode *hash_table_create_hash_node(const char *key, void *data);
+HashNode *hash_table_create_hash_node(const char *key, void *data, unsigned int hash);
 
 /*
  * Function to clear the hash from all its content.
@@ -120,5 +193,14 @@ void hash_table_clear(HashTable *ht, CustomFreeFunction free_function_data);
 void hash_table_for_each(HashTable *ht, HashTableForEachCallback callback, void *data);
 
 
+/*
+ * Function to get the statistics of the hash table, to see how well the hash function spreads its keys.
+ * The lookup hits and misses of the fallback are not included.
+ *
+ * Parameters:
+ *   ht: Pointer to the hash table
+ *   stats: Pointer to the statistics to fill
+ */
+void hash_table_get_stats(HashTable *ht, HashTableStats *stats);
 
 #endif /* HASH_TABLE_H */
@@ -0,0 +1,233 @@
+/* *******************************************************************
+ * Authors: Daniel Oren, Elisheva Cirota
+ *
+ * @file  test_hash_table.c
+ * @brief This file contains the tests of the hash table statistics and a micro-benchmark of hash functions over label corpora.
+ *
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hash_table.h"
+#include "../general_const/general_const.h"
+#include "../stats/stats.h"
+#include "../utils/utils.h"
+
+#define TEST_HT_NUM_KEYS (5000)
+#define TEST_HT_KEY_SIZE (32)
+#define TEST_HT_CORPUS_SIZE (9999)
+#define TEST_HT_NUM_CORPORA (3)
+#define TEST_HT_NUM_HASHES (4)
+#define TEST_HT_INITIAL_CAPACITY (10)
+#define TEST_HT_LOAD_FACTOR (0.75)
+#define TEST_HT_BENCHMARK_ROUNDS (200)
+
+typedef unsigned int (*test_ht_hash_function)(const char *key);
+
+/* the hash of hash_table.c, before it is reduced to a bucket */
+unsigned int _test_ht_shift_add(const char *key)
+{
+	unsigned int hash = 0;
+
+	while (*key)
+	{
+		hash = (hash << 5) + *key++;
+	}
+	return hash;
+}
+
+unsigned int _test_ht_djb2(const char *key)
+{
+	unsigned int hash = 5381;
+
+	while (*key)
+	{
+		hash = hash * 33 + (unsigned char)*key++;
+	}
+	return hash;
+}
+
+unsigned int _test_ht_fnv1a(const char *key)
+{
+	return (unsigned int)fnv1a_hash(key);
+}
+
+unsigned int _test_ht_sdbm(const char *key)
+{
+	unsigned int hash = 0;
+
+	while (*key)
+	{
+		hash = (unsigned char)*key++ + (hash << 6) + (hash << 16) - hash;
+	}
+	return hash;
+}
+
+/* fills a corpus of labels: L0001...L9999, names with a common prefix and a counter, or random names */
+void _test_ht_fill_corpus(int corpus, char keys[][TEST_HT_KEY_SIZE])
+{
+	static const char *const prefixes[] = {"LOOP", "END", "STR", "LIST", "K", "MAIN", "NEXT", "ARR"};
+	static const char *const label_chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789";
+	int length = 0;
+	int i = 0;
+	int j = 0;
+
+	srand(1);
+	for (i = 0; i < TEST_HT_CORPUS_SIZE; ++i)
+	{
+		if (corpus == 0)
+		{
+			sprintf(keys[i], "L%04d", i + 1);
+		}
+		else if (corpus == 1)
+		{
+			sprintf(keys[i], "%s%d", prefixes[i % 8], i / 8);
+		}
+		else
+		{
+			length = 1 + rand() % (TEST_HT_KEY_SIZE - 2);
+			keys[i][0] = label_chars[rand() % 52];
+			for (j = 1; j < length; ++j)
+			{
+				keys[i][j] = label_chars[rand() % 62];
+			}
+			keys[i][length] = NULL_TERMINATOR;
+		}
+	}
+}
+
+void test_hash_table_stats()
+{
+	HashTable *ht = hash_table_init();
+	HashTableStats table_stats;
+	stats_mode_t mode = stats_get_mode();
+	char key[TEST_HT_KEY_SIZE];
+	int num_found = 0;
+	int i = 0;
+
+	if (ht == NULL)
+	{
+		printf("FAILURE, hash_table_init\n");
+		return;
+	}
+
+	/* lookups are counted only with the stats on */
+	stats_set_mode(STATS_MODE__TABLE);
+	for (i = 0; i < TEST_HT_NUM_KEYS; ++i)
+	{
+		sprintf(key, "L%04d", i);
+		hash_table_insert(ht, key, ht);
+		/* keys of buckets that were not moved yet must still be found while a resize is in progress */
+		sprintf(key, "L%04d", i / 2);
+		num_found += hash_table_lookup(ht, key) != NULL;
+	}
+	num_found += hash_table_lookup(ht, "missing") != NULL;
+	hash_table_get_stats(ht, &table_stats);
+	stats_set_mode(mode);
+
+	if (num_found != TEST_HT_NUM_KEYS || table_stats.size != TEST_HT_NUM_KEYS || table_stats.lookup_hits != TEST_HT_NUM_KEYS ||
+		table_stats.lookup_misses != 1 || table_stats.num_resizes == 0 || table_stats.longest_chain == 0 ||
+		table_stats.used_buckets == 0 || table_stats.used_buckets > table_stats.capacity ||
+		table_stats.average_probe_length < 1 || table_stats.average_probe_length > table_stats.longest_chain)
+	{
+		printf("FAILURE, test_hash_table_stats\n");
+		hash_table_free(ht, NULL);
+		return;
+	}
+
+	hash_table_clear(ht, NULL);
+	hash_table_get_stats(ht, &table_stats);
+	if (table_stats.size != 0 || table_stats.used_buckets != 0 || table_stats.lookup_hits != 0 || table_stats.num_resizes != 0)
+	{
+		printf("FAILURE, test_hash_table_stats after clear\n");
+		hash_table_free(ht, NULL);
+		return;
+	}
+	hash_table_free(ht, NULL);
+	printf("SUCCESS, test_hash_table_stats\n");
+}
+
+void test_hash_table_benchmark()
+{
+	static const char *const corpora_names[TEST_HT_NUM_CORPORA] = {"L0001..L9999", "prefix+counter", "random"};
+	static const char *const hashes_names[TEST_HT_NUM_HASHES] = {"shift_add", "djb2", "fnv1a", "sdbm"};
+	static const test_ht_hash_function hashes[TEST_HT_NUM_HASHES] = {_test_ht_shift_add, _test_ht_djb2, _test_ht_fnv1a, _test_ht_sdbm};
+	char(*keys)[TEST_HT_KEY_SIZE] = (char(*)[TEST_HT_KEY_SIZE])malloc(TEST_HT_CORPUS_SIZE * TEST_HT_KEY_SIZE);
+	size_t *chains = NULL;
+	size_t capacity = TEST_HT_INITIAL_CAPACITY;
+	size_t used_buckets = 0;
+	size_t longest_chain = 0;
+	size_t total_probes = 0;
+	unsigned int checksum = 0;
+	double start = 0;
+	double elapsed_usec = 0;
+	int corpus = 0;
+	int hash = 0;
+	int round = 0;
+	int i = 0;
+
+	/* the capacity the hash table has for the whole corpus */
+	while ((double)TEST_HT_CORPUS_SIZE / capacity >= TEST_HT_LOAD_FACTOR)
+	{
+		capacity *= 2;
+	}
+	chains = (size_t *)malloc(capacity * sizeof(size_t));
+	if (keys == NULL || chains == NULL)
+	{
+		printf("FAILURE, memory allocation failed\n");
+		free(keys);
+		free(chains);
+		return;
+	}
+
+	printf("%-16s %-10s %8s %8s %8s %8s %10s\n", "corpus", "hash", "buckets", "used", "longest", "avg", "ns/key");
+	for (corpus = 0; corpus < TEST_HT_NUM_CORPORA; ++corpus)
+	{
+		_test_ht_fill_corpus(corpus, keys);
+		for (hash = 0; hash < TEST_HT_NUM_HASHES; ++hash)
+		{
+			memset(chains, 0, capacity * sizeof(size_t));
+			used_buckets = 0;
+			longest_chain = 0;
+			total_probes = 0;
+			for (i = 0; i < TEST_HT_CORPUS_SIZE; ++i)
+			{
+				/* a key is found after as many probes as the keys of its bucket up to it */
+				total_probes += ++chains[hashes[hash](keys[i]) % capacity];
+			}
+			for (i = 0; i < capacity; ++i)
+			{
+				used_buckets += chains[i] > 0;
+				longest_chain = chains[i] > longest_chain ? chains[i] : longest_chain;
+			}
+
+			start = get_monotonic_time_usec();
+			for (round = 0; round < TEST_HT_BENCHMARK_ROUNDS; ++round)
+			{
+				for (i = 0; i < TEST_HT_CORPUS_SIZE; ++i)
+				{
+					checksum += hashes[hash](keys[i]);
+				}
+			}
+			elapsed_usec = get_monotonic_time_usec() - start;
+
+			printf("%-16s %-10s %8lu %8lu %8lu %8.2f %10.2f\n", corpora_names[corpus], hashes_names[hash], (unsigned long)capacity,
+				   (unsigned long)used_buckets, (unsigned long)longest_chain, (double)total_probes / TEST_HT_CORPUS_SIZE,
+				   elapsed_usec * 1000.0 / ((double)TEST_HT_BENCHMARK_ROUNDS * TEST_HT_CORPUS_SIZE));
+		}
+	}
+	/* printed so the hashing is not optimized away */
+	printf("checksum %u\n", checksum);
+	free(keys);
+	free(chains);
+}
+
+/* uncomment this line to run test_hash_table */
+/*int main()
+{
+	test_hash_table_stats();
+	test_hash_table_benchmark();
+	return SUCCESS;
+}*/
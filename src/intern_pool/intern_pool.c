@@ -0,0 +1,235 @@
+/* *******************************************************************
+ * Authors: Daniel Oren, Elisheva Cirota
+ *
+ * @file intern_pool.c
+ * @brief This file contains the implementation of the intern pool.
+ *
+ * The strings are copied one after the other into blocks that are never moved, and found by
+ * an open addressing index of the strings and their hashes. Clearing keeps the first block and
+ * the index, so a pool that is reused for every input file allocates almost nothing.
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "intern_pool.h"
+#include "../logger/logger.h"
+#include "../general_const/general_const.h"
+#include "../stats/stats.h"
+#include "../utils/utils.h"
+
+#define INTERN_POOL_BLOCK_SIZE (4096)
+#define INTERN_POOL_INITIAL_SLOTS (64) /* a power of two */
+
+/* a block of interned strings, its text follows the header */
+typedef struct intern_block
+{
+	struct intern_block *next;
+	size_t used;
+	size_t capacity;
+} intern_block_t;
+
+/* a slot of the index, str is NULL when the slot is free */
+typedef struct intern_slot
+{
+	const char *str;
+	unsigned long hash;
+} intern_slot_t;
+
+struct intern_pool
+{
+	intern_block_t *blocks; /* the block that is filled now, it points to the older ones */
+	intern_slot_t *slots;
+	size_t num_slots; /* a power of two */
+	size_t size; /* number of interned strings */
+	size_t num_bytes; /* bytes of the blocks and the index */
+};
+
+/* =========================== internal functions declarations ================== */
+intern_block_t *_intern_new_block(size_t capacity, intern_block_t *next);
+const intern_slot_t *_intern_find_slot(const intern_pool_t *pool, const char *str, unsigned long hash);
+int _intern_grow_slots(intern_pool_t *pool);
+char *_intern_copy(intern_pool_t *pool, const char *str, size_t size);
+
+/* =========================== internal functions implementations ================= */
+
+intern_block_t *_intern_new_block(size_t capacity, intern_block_t *next)
+{
+	intern_block_t *block = (intern_block_t *)stats_malloc(sizeof(intern_block_t) + capacity);
+
+	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(block, "Memory allocation failed in _intern_new_block", NULL);
+	block->next = next;
+	block->used = 0;
+	block->capacity = capacity;
+	return block;
+}
+
+const intern_slot_t *_intern_find_slot(const intern_pool_t *pool, const char *str, unsigned long hash)
+{
+	size_t mask = pool->num_slots - 1;
+	size_t i = hash & mask;
+
+	/* the index is never full, so a free slot ends every probe sequence */
+	while (pool->slots[i].str != NULL && (pool->slots[i].hash != hash || strcmp(pool->slots[i].str, str) != 0))
+	{
+		i = (i + 1) & mask;
+	}
+	return &pool->slots[i];
+}
+
+int _intern_grow_slots(intern_pool_t *pool)
+{
+	intern_slot_t *old_slots = pool->slots;
+	size_t old_num_slots = pool->num_slots;
+	size_t mask = old_num_slots * 2 - 1;
+	size_t i = 0;
+	size_t j = 0;
+
+	pool->slots = (intern_slot_t *)stats_calloc(old_num_slots * 2, sizeof(intern_slot_t));
+	if (pool->slots == NULL)
+	{
+		LOG(ERROR, PARAMS, "Memory allocation failed in _intern_grow_slots");
+		pool->slots = old_slots;
+		return FUNC_ERR;
+	}
+	pool->num_slots = old_num_slots * 2;
+	pool->num_bytes += old_num_slots * sizeof(intern_slot_t);
+	for (i = 0; i < old_num_slots; ++i)
+	{
+		if (old_slots[i].str == NULL)
+		{
+			continue;
+		}
+		j = old_slots[i].hash & mask;
+		while (pool->slots[j].str != NULL)
+		{
+			j = (j + 1) & mask;
+		}
+		pool->slots[j] = old_slots[i];
+	}
+	free(old_slots);
+	return SUCCESS;
+}
+
+char *_intern_copy(intern_pool_t *pool, const char *str, size_t size)
+{
+	intern_block_t *block = pool->blocks;
+	char *copy = NULL;
+
+	if (block->capacity - block->used < size)
+	{
+		/* a string longer than a block gets a block of its own */
+		block = _intern_new_block(size > INTERN_POOL_BLOCK_SIZE ? size : INTERN_POOL_BLOCK_SIZE, pool->blocks);
+		if (block == NULL)
+		{
+			return NULL;
+		}
+		pool->blocks = block;
+		pool->num_bytes += sizeof(intern_block_t) + block->capacity;
+	}
+	copy = (char *)(block + 1) + block->used;
+	memcpy(copy, str, size);
+	block->used += size;
+	return copy;
+}
+
+/*=============================================================================== */
+
+intern_pool_t *intern_pool_create()
+{
+	intern_pool_t *pool = (intern_pool_t *)stats_calloc(1, sizeof(intern_pool_t));
+
+	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(pool, "Memory allocation failed in intern_pool_create", NULL);
+	pool->blocks = _intern_new_block(INTERN_POOL_BLOCK_SIZE, NULL);
+	pool->slots = (intern_slot_t *)stats_calloc(INTERN_POOL_INITIAL_SLOTS, sizeof(intern_slot_t));
+	if (pool->blocks == NULL || pool->slots == NULL)
+	{
+		LOG(ERROR, PARAMS, "Memory allocation failed in intern_pool_create");
+		free(pool->blocks);
+		free(pool->slots);
+		free(pool);
+		return NULL;
+	}
+	pool->num_slots = INTERN_POOL_INITIAL_SLOTS;
+	pool->num_bytes = sizeof(intern_block_t) + INTERN_POOL_BLOCK_SIZE + INTERN_POOL_INITIAL_SLOTS * sizeof(intern_slot_t);
+	return pool;
+}
+
+void intern_pool_free(intern_pool_t *pool)
+{
+	intern_block_t *next = NULL;
+
+	if (pool == NULL)
+	{
+		return;
+	}
+	for (; pool->blocks != NULL; pool->blocks = next)
+	{
+		next = pool->blocks->next;
+		free(pool->blocks);
+	}
+	free(pool->slots);
+	free(pool);
+}
+
+void intern_pool_clear(intern_pool_t *pool)
+{
+	intern_block_t *next = NULL;
+
+	/* the oldest block is a regular one, it is kept */
+	while (pool->blocks->next != NULL)
+	{
+		next = pool->blocks->next;
+		pool->num_bytes -= sizeof(intern_block_t) + pool->blocks->capacity;
+		free(pool->blocks);
+		pool->blocks = next;
+	}
+	pool->blocks->used = 0;
+	memset(pool->slots, 0, pool->num_slots * sizeof(intern_slot_t));
+	pool->size = 0;
+}
+
+const char *intern_pool_intern(intern_pool_t *pool, const char *str)
+{
+	unsigned long hash = fnv1a_hash(str);
+	intern_slot_t *slot = (intern_slot_t *)_intern_find_slot(pool, str, hash);
+
+	if (slot->str != NULL)
+	{
+		return slot->str;
+	}
+
+	/* at most half of the slots are used, so probe sequences stay short */
+	if ((pool->size + 1) * 2 > pool->num_slots)
+	{
+		if (_intern_grow_slots(pool) != SUCCESS)
+		{
+			return NULL;
+		}
+		slot = (intern_slot_t *)_intern_find_slot(pool, str, hash);
+	}
+	slot->str = _intern_copy(pool, str, strlen(str) + 1);
+	if (slot->str == NULL)
+	{
+		return NULL;
+	}
+	slot->hash = hash;
+	++pool->size;
+	return slot->str;
+}
+
+const char *intern_pool_find(const intern_pool_t *pool, const char *str)
+{
+	return _intern_find_slot(pool, str, fnv1a_hash(str))->str;
+}
+
+size_t intern_pool_size(const intern_pool_t *pool)
+{
+	return pool->size;
+}
+
+size_t intern_pool_memory_size(const intern_pool_t *pool)
+{
+	return pool->num_bytes;
+}
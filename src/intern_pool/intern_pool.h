@@ -0,0 +1,81 @@
+/* *******************************************************************
+ * Authors: Daniel Oren, Elisheva Cirota
+ *
+ * @file intern_pool.h
+ * @brief This file contains the declarations of the intern pool.
+ *
+ * An intern pool keeps one copy of every distinct string that was interned in it, in large
+ * blocks of memory. Interning the same text again returns the same pointer, so the pointer is
+ * a handle of the text: two interned strings of one pool are equal exactly when their pointers
+ * are equal, and structures can keep the pointer instead of a copy of the text.
+ *
+ * The pointers stay valid until the pool is cleared or freed, so the assembler keeps a pool for
+ * the labels of the file it assembles and clears it together with the rest of the file data.
+ *
+ *********************************************************************/
+
+#ifndef INTERN_POOL_H
+#define INTERN_POOL_H
+
+#include <stdlib.h>
+
+typedef struct intern_pool intern_pool_t;
+
+/**
+ * Creates an empty intern pool.
+ *
+ * @return A pointer to the new pool, or NULL on memory allocation failure.
+ */
+intern_pool_t *intern_pool_create();
+
+/**
+ * Frees an intern pool, all the strings interned in it are freed too.
+ *
+ * @param pool The pool to free.
+ */
+void intern_pool_free(intern_pool_t *pool);
+
+/**
+ * Removes all the strings of the pool. The memory of the pool is kept for the next strings,
+ * the pointers that were returned before are not valid anymore.
+ *
+ * @param pool The pool to clear.
+ */
+void intern_pool_clear(intern_pool_t *pool);
+
+/**
+ * Interns a string.
+ *
+ * @param pool The pool.
+ * @param str The string to intern.
+ * @return The copy of the string in the pool, the same pointer for every call with the same text,
+ *         or NULL on memory allocation failure.
+ */
+const char *intern_pool_intern(intern_pool_t *pool, const char *str);
+
+/**
+ * Finds the interned copy of a string, without interning it.
+ *
+ * @param pool The pool.
+ * @param str The string to find.
+ * @return The copy of the string in the pool, or NULL if it was not interned.
+ */
+const char *intern_pool_find(const intern_pool_t *pool, const char *str);
+
+/**
+ * Returns the number of distinct strings in the pool.
+ *
+ * @param pool The pool.
+ * @return The number of strings.
+ */
+size_t intern_pool_size(const intern_pool_t *pool);
+
+/**
+ * Returns the memory the pool takes, its blocks of strings and its index.
+ *
+ * @param pool The pool.
+ * @return The number of bytes.
+ */
+size_t intern_pool_memory_size(const intern_pool_t *pool);
+
+#endif /* INTERN_POOL_H */
@@ -6,21 +6,38 @@
  * 
  *********************************************************************/
 
+#include <pthread.h>
+
 #include "logger.h"
 
 #define LOG_FILE "logfile.txt"
 
+/* the server assembles in several threads, messages are written one at a time */
+static pthread_mutex_t g_log_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int g_log_enabled = 1;
+
+void logger_set_enabled(int is_enabled)
+{
+    g_log_enabled = is_enabled;
+}
+
 void LOG(LogLevel level, const char *filename, int line_number, const char *format, ...) {
     time_t rawtime;
     struct tm *timeinfo;
     char timestamp[20];
     const char *level_str;
-    FILE *file = fopen(LOG_FILE, "w");
-	/*FILE *file = fopen(LOG_FILE, "a");*/
+    FILE *file = NULL;
     va_list args;
 
+    if (!g_log_enabled) {
+        return;
+    }
+    pthread_mutex_lock(&g_log_mutex);
+    file = fopen(LOG_FILE, "w");
+	/*FILE *file = fopen(LOG_FILE, "a");*/
     if (file == NULL) {
         perror("Error opening log file");
+        pthread_mutex_unlock(&g_log_mutex);
         return;
     }
 
@@ -60,4 +77,5 @@ void LOG(LogLevel level, const char *filename, int line_number, const char *form
     va_end(args);
 
     fclose(file);
+    pthread_mutex_unlock(&g_log_mutex);
 }
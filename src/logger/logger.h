@@ -42,6 +42,16 @@ typedef enum {
  */
 void LOG(LogLevel level, const char *filename, int line_number, const char *format, ...);
 
+/**
+ * @brief Enables or disables the log file. It is enabled by default.
+ *
+ * When the assembler is embedded as a library, every message would open and truncate the log
+ * file in the working directory of the host, so the library disables it.
+ *
+ * @param is_enabled TRUE to write messages to the log file, FALSE to drop them.
+ */
+void logger_set_enabled(int is_enabled);
+
 #define PARAMS  __FILE__, __LINE__
 
 #endif /* LOGGER_H */
@@ -0,0 +1,195 @@
+/* *******************************************************************
+ * Authors: Daniel Oren, Elisheva Cirota
+ *
+ * @file macro_library.c
+ * @brief This file contains the implementation of the macro library.
+ *
+ * The library file goes through the pre processor and the first pass like an input file, into a
+ * context of its own. The macro table and the symbol table of that context are the fallbacks of
+ * the tables of the input files.
+ *********************************************************************/
+#define _POSIX_C_SOURCE 200809L /* for fmemopen */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "macro_library.h"
+#include "../logger/logger.h"
+#include "../general_const/general_const.h"
+#include "../stats/stats.h"
+#include "../hash_table/hash_table.h"
+#include "../utils/utils.h"
+#include "../build_cache/build_cache.h"
+#include "../string_vector/string_vector.h"
+
+struct macro_library
+{
+	assembler_context_t *context; /* holds the macros and the constants of the library */
+	unsigned long content_hash; /* hash of the content the library was parsed from, for the build cache key */
+};
+
+/* =========================== internal functions declarations ================== */
+void _macro_library_validate_symbol(const char *key, void *data, void *assembler_data);
+int _macro_library_parse(macro_library_t *library, FILE *input_file);
+int _macro_library_print_messages(FILE *msg_stream, StringVector *messages, const char *msg_type);
+
+/* =========================== internal functions implementations ================= */
+
+void _macro_library_validate_symbol(const char *key, void *data, void *assembler_data)
+{
+	symbol_t *symbol = (symbol_t *)data;
+	assembler_data_t *assembler_data_casted = (assembler_data_t *)assembler_data;
+	char log_error[MAX_LINE_SIZE];
+
+	if (symbol->memory_type != MEM_TYPE__DEFINE || symbol->symbol_location != -1)
+	{
+		sprintf(log_error, "symbol %s of a macro library must be a .define constant", key);
+		LOG(ERROR, PARAMS, "%s", log_error);
+		if (string_vector_push_back(assembler_data_casted->error_founds, log_error) == ERR)
+		{
+			LOG(ERROR, PARAMS, "string_vector_push_back failed");
+		}
+	}
+}
+
+int _macro_library_parse(macro_library_t *library, FILE *input_file)
+{
+	general_data_pre_process_t *pre_process_data = library->context->pre_process_data;
+	assembler_data_t *assembler_data = library->context->assembler_data;
+	FILE *pre_processed_file = NULL;
+	char log_error[MAX_LINE_SIZE];
+	int ret = SUCCESS;
+
+	pre_processed_file = tmpfile();
+	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(pre_processed_file, "tmpfile failed in _macro_library_parse", FUNC_ERR);
+
+	ret = pre_process_stream(pre_process_data, input_file, pre_processed_file);
+	if (ret == SUCCESS)
+	{
+		rewind(pre_processed_file);
+		ret = assembler_first_pass(assembler_data, pre_processed_file, pre_process_data->macro_table, NULL);
+	}
+	fclose(pre_processed_file);
+	if (ret == FUNC_ERR || ret == ERR)
+	{
+		return FUNC_ERR;
+	}
+
+	/* the library is only looked up, so everything that would be assembled into an input file is an error */
+	if (assembler_data->IC != IC_INITIAL_VALUE || assembler_data->DC != 0 || !deque_is_empty(assembler_data->parsed_instruction_lines))
+	{
+		sprintf(log_error, "a macro library can contain only macros and .define constants");
+		PUSH_ERROR_AND_LOG(log_error, assembler_data->error_founds);
+	}
+	hash_table_for_each(assembler_data->symbol_table, _macro_library_validate_symbol, assembler_data);
+	return SUCCESS;
+}
+
+int _macro_library_print_messages(FILE *msg_stream, StringVector *messages, const char *msg_type)
+{
+	int num_messages = string_vector_get_size(messages);
+	int i = 0;
+
+	if (num_messages > 0)
+	{
+		fprintf(msg_stream, "%s\n", msg_type);
+	}
+	for (i = 0; i < num_messages; ++i)
+	{
+		fprintf(msg_stream, "%s\n", string_vector_at(messages, i));
+	}
+	return num_messages;
+}
+
+/*=============================================================================== */
+
+macro_library_t *macro_library_load(const char *file_name, FILE *msg_stream)
+{
+	macro_library_t *library = NULL;
+	FILE *input_file = NULL;
+	char *content = NULL;
+	size_t content_size = 0;
+	int num_errors = 0;
+	int ret = SUCCESS;
+
+	/* the library is parsed from the same buffer it is hashed from, so the cache key describes what was loaded */
+	ret = read_file_to_buffer(file_name, &content, &content_size);
+	if (ret != SUCCESS)
+	{
+		LOG(ERROR, PARAMS, "Error opening macro library %s", file_name);
+		fprintf(msg_stream, "failed on opening macro library %s\n", file_name);
+		return NULL;
+	}
+	input_file = fmemopen(content, content_size, "r");
+	if (input_file == NULL)
+	{
+		LOG(ERROR, PARAMS, "fmemopen failed in macro_library_load");
+		free(content);
+		return NULL;
+	}
+
+	library = (macro_library_t *)stats_malloc(sizeof(macro_library_t));
+	if (library == NULL)
+	{
+		LOG(ERROR, PARAMS, "Memory allocation failed in macro_library_load");
+		fclose(input_file);
+		free(content);
+		return NULL;
+	}
+	library->content_hash = build_cache_xxh32(content, content_size, 0);
+	library->context = init_assembler_context();
+	if (library->context == NULL)
+	{
+		free(library);
+		fclose(input_file);
+		free(content);
+		return NULL;
+	}
+
+	ret = _macro_library_parse(library, input_file);
+	fclose(input_file);
+	free(content);
+	if (ret != SUCCESS)
+	{
+		LOG(ERROR, PARAMS, "Error in parsing macro library %s", file_name);
+		macro_library_free(library);
+		return NULL;
+	}
+
+	num_errors += _macro_library_print_messages(msg_stream, library->context->pre_process_data->error_founds, "Errors:");
+	num_errors += _macro_library_print_messages(msg_stream, library->context->assembler_data->error_founds, "Errors:");
+	_macro_library_print_messages(msg_stream, library->context->pre_process_data->warning_founds, "Warnings:");
+	_macro_library_print_messages(msg_stream, library->context->assembler_data->warning_founds, "Warnings:");
+	if (num_errors > 0)
+	{
+		fprintf(msg_stream, "failed on loading macro library %s\n", file_name);
+		macro_library_free(library);
+		return NULL;
+	}
+
+	LOG(INFO, PARAMS, "macro library %s was loaded", file_name);
+	return library;
+}
+
+void macro_library_attach(const macro_library_t *library, assembler_context_t *context)
+{
+	hash_table_set_fallback(context->pre_process_data->macro_table,
+							library == NULL ? NULL : library->context->pre_process_data->macro_table);
+	hash_table_set_fallback(context->assembler_data->symbol_table,
+							library == NULL ? NULL : library->context->assembler_data->symbol_table);
+}
+
+unsigned long macro_library_get_hash(const macro_library_t *library)
+{
+	return library->content_hash;
+}
+
+void macro_library_free(macro_library_t *library)
+{
+	if (library != NULL)
+	{
+		free_assembler_context(library->context);
+		free(library);
+	}
+}
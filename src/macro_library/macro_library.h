@@ -0,0 +1,56 @@
+/* *******************************************************************
+ * Authors: Daniel Oren, Elisheva Cirota
+ *
+ * @file macro_library.h
+ * @brief This file contains the declarations of the macro library.
+ *
+ * A macro library is a source file with only macros and .define constants, that many input files
+ * share. It is parsed once per process, and attached to the context of every input file: a macro
+ * or a constant that the input file doesn't define is looked up in the library. The library is
+ * never changed after it was loaded, so the workers of the server share it.
+ *
+ *********************************************************************/
+
+#ifndef MACRO_LIBRARY_H
+#define MACRO_LIBRARY_H
+
+#include <stdio.h>
+
+#include "../assembler_main/assembler_main.h"
+
+typedef struct macro_library macro_library_t;
+
+/**
+ * Loads a macro library.
+ *
+ * @param file_name The name of the library file, with its extension.
+ * @param msg_stream The stream to print the errors and warnings of the library to.
+ * @return A pointer to the loaded library, or NULL if the file could not be read or has errors.
+ */
+macro_library_t *macro_library_load(const char *file_name, FILE *msg_stream);
+
+/**
+ * Attaches a macro library to a context, so the input files assembled with the context can use
+ * its macros and constants. The library must not be freed before the context.
+ *
+ * @param library The library to attach, or NULL to detach the current library.
+ * @param context The context to attach the library to.
+ */
+void macro_library_attach(const macro_library_t *library, assembler_context_t *context);
+
+/**
+ * Returns the hash of the content a library was parsed from, for the build cache key.
+ *
+ * @param library The library.
+ * @return The xxh32 hash of the library file, as it was read when the library was loaded.
+ */
+unsigned long macro_library_get_hash(const macro_library_t *library);
+
+/**
+ * Frees a macro library.
+ *
+ * @param library The library to free, may be NULL.
+ */
+void macro_library_free(macro_library_t *library);
+
+#endif /* MACRO_LIBRARY_H */
@@ -0,0 +1,90 @@
+/* *******************************************************************
+ * Authors: Daniel Oren, Elisheva Cirota
+ *
+ * @file memory_budget.c
+ * @brief This file contains the implementation of the memory budget of an input file.
+ *
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+
+#include "memory_budget.h"
+#include "../general_const/general_const.h"
+
+#define KILOBYTE (1024UL)
+
+void memory_budget_init(memory_budget_t *budget, size_t limit)
+{
+	budget->limit = limit;
+	memory_budget_begin_file(budget);
+}
+
+void memory_budget_begin_file(memory_budget_t *budget)
+{
+	budget->peak = 0;
+	budget->is_exceeded = FALSE;
+}
+
+int memory_budget_update(memory_budget_t *budget, size_t in_use)
+{
+	if (in_use > budget->peak)
+	{
+		budget->peak = in_use;
+	}
+	if (budget->limit != MEMORY_BUDGET_UNLIMITED && in_use > budget->limit)
+	{
+		budget->is_exceeded = TRUE;
+		return FALSE;
+	}
+	return TRUE;
+}
+
+int memory_budget_is_limited(const memory_budget_t *budget)
+{
+	return budget->limit != MEMORY_BUDGET_UNLIMITED;
+}
+
+size_t memory_budget_share(const memory_budget_t *budget, size_t share)
+{
+	return budget->limit / share;
+}
+
+int memory_budget_parse_size(const char *text, size_t *size)
+{
+	char *end = NULL;
+	unsigned long value = 0;
+	unsigned long multiplier = 1;
+
+	/* strtoul would take a sign or spaces */
+	if (!isdigit((unsigned char)*text))
+	{
+		return USER_ERR;
+	}
+	errno = 0;
+	value = strtoul(text, &end, 10);
+	if (value == 0 || errno == ERANGE)
+	{
+		return USER_ERR;
+	}
+	if (*end == 'K' || *end == 'k')
+	{
+		multiplier = KILOBYTE;
+		++end;
+	}
+	else if (*end == 'M' || *end == 'm')
+	{
+		multiplier = KILOBYTE * KILOBYTE;
+		++end;
+	}
+	/* a size that wraps around would be a small or a zero limit */
+	if (*end != NULL_TERMINATOR || value > ULONG_MAX / multiplier)
+	{
+		return USER_ERR;
+	}
+	*size = value * multiplier;
+	return SUCCESS;
+}
@@ -0,0 +1,82 @@
+/* *******************************************************************
+ * Authors: Daniel Oren, Elisheva Cirota
+ *
+ * @file memory_budget.h
+ * @brief This file contains the declarations of the memory budget of an input file (--memory-budget).
+ *
+ * The budget limits the memory the structures of an input file grow to: the symbols, the parsed
+ * instruction lines, the extern uses and the errors and warnings. The assembler samples the memory
+ * in use after every line, keeps its high-water mark and stops the file with an error once it is
+ * over the budget, before the allocations start to fail. Parts of the budget are given to the
+ * parsed lines, which are spilled to a temporary file beyond their share, and to the diagnostics,
+ * which are dropped beyond their share.
+ *
+ *********************************************************************/
+
+#ifndef MEMORY_BUDGET_H
+#define MEMORY_BUDGET_H
+
+#include <stdlib.h>
+
+#define MEMORY_BUDGET_UNLIMITED (0)
+#define MEMORY_BUDGET_LINES_SHARE (4) /* the parsed lines kept in memory may take a quarter of the budget */
+#define MEMORY_BUDGET_DIAGNOSTICS_SHARE (8) /* the errors, or the warnings, may take an eighth of the budget */
+
+typedef struct memory_budget
+{
+	size_t limit; /* in bytes, MEMORY_BUDGET_UNLIMITED when there is no budget */
+	size_t peak; /* the most memory in use of the current file */
+	int is_exceeded; /* TRUE once the memory in use of the current file was over the limit */
+} memory_budget_t;
+
+/**
+ * Initializes a budget.
+ *
+ * @param budget The budget.
+ * @param limit The limit in bytes, or MEMORY_BUDGET_UNLIMITED.
+ */
+void memory_budget_init(memory_budget_t *budget, size_t limit);
+
+/**
+ * Starts the budget of a new input file, its high-water mark starts from zero.
+ *
+ * @param budget The budget.
+ */
+void memory_budget_begin_file(memory_budget_t *budget);
+
+/**
+ * Records the memory the current file uses now.
+ *
+ * @param budget The budget.
+ * @param in_use The bytes in use.
+ * @return TRUE if in_use is within the limit, FALSE otherwise.
+ */
+int memory_budget_update(memory_budget_t *budget, size_t in_use);
+
+/**
+ * Returns whether the budget has a limit.
+ *
+ * @param budget The budget.
+ * @return TRUE if there is a limit, FALSE otherwise.
+ */
+int memory_budget_is_limited(const memory_budget_t *budget);
+
+/**
+ * Returns a part of the limit.
+ *
+ * @param budget The budget.
+ * @param share The part, MEMORY_BUDGET_LINES_SHARE or MEMORY_BUDGET_DIAGNOSTICS_SHARE.
+ * @return The limit divided by share, or 0 when there is no limit.
+ */
+size_t memory_budget_share(const memory_budget_t *budget, size_t share);
+
+/**
+ * Parses a size given in bytes, or in kilobytes or megabytes with a K or an M suffix (for example 512K).
+ *
+ * @param text The text to parse.
+ * @param size Set to the size in bytes.
+ * @return SUCCESS, or USER_ERR if the text is not a positive size or the size is too large.
+ */
+int memory_budget_parse_size(const char *text, size_t *size);
+
+#endif /* MEMORY_BUDGET_H */
@@ -10,6 +10,7 @@
 
 #include "../utils/utils.h"
 #include "../general_const/general_const.h"
+#include "../output_file/output_file.h"
 
 #define OBJ_FILE_BASE (4)
 #define WORD_CONTENT_SIZE (7)
@@ -33,21 +34,29 @@ void _convert_to_base4_encrypted(short num, char *encrypted_word, short size)
 
 int build_obj_file(const char *filename, assembler_data_t *assembler_data)
 {
-    /* first line include IC and DC */
-    short curr_address = 0;
-    short curr_content = 0;
-    char encrypted_word[WORD_CONTENT_SIZE];
     char output_file_name[MAX_LINE_SIZE];
-    FILE *output_file = NULL;
-    int i, j , k= 0;
-	
+    output_file_t output_file;
+    FILE *output_stream = NULL;
+
     get_output_file_name(filename, output_file_name, OBJ_FILE_EXTENSION);
 
-    output_file = fopen(output_file_name, "w");
-    if (output_file == NULL)
+    output_stream = output_file_open(&output_file, output_file_name);
+    if (output_stream == NULL)
     {
         return FUNC_ERR;
     }
+    write_obj_file(output_stream, assembler_data);
+    return output_file_commit(&output_file);
+}
+
+int write_obj_file(FILE *output_file, assembler_data_t *assembler_data)
+{
+    /* first line include IC and DC */
+    short curr_address = 0;
+    short curr_content = 0;
+    char encrypted_word[WORD_CONTENT_SIZE];
+    int i, j , k= 0;
+
     fprintf(output_file, "  %d %d\n", assembler_data->IC - IC_INITIAL_VALUE, assembler_data->DC);
 
     /* each line include the address of a word and the content of the word.
@@ -93,6 +102,5 @@ int build_obj_file(const char *filename, assembler_data_t *assembler_data)
         }
 		++i;
     }
-    fclose(output_file);
     return SUCCESS;
 }
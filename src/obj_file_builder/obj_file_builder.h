@@ -24,6 +24,15 @@
  */
 int build_obj_file(const char *filename, assembler_data_t *assembler);
 
+/**
+ * Writes the content of an obj file to a stream, like build_obj_file.
+ *
+ * @param output_file The stream to write to, it is not closed.
+ * @param assembler A pointer to the assembler data.
+ * @return Returns 0 if the obj file is successfully written, otherwise returns an error code.
+ */
+int write_obj_file(FILE *output_file, assembler_data_t *assembler);
+
 
 #endif /*  OBJ_FILE_BUILDER_H */
 
@@ -0,0 +1,256 @@
+/* *******************************************************************
+ * Authors: Daniel Oren, Elisheva Cirota
+ *
+ * @file output_file.c
+ * @brief This file contains the implementation of the writing of the output files.
+ *
+ *********************************************************************/
+#define _POSIX_C_SOURCE 200809L /* for open_memstream, mkstemp, fdopen, fstat and mmap */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <pthread.h>
+
+#include "output_file.h"
+#include "../general_const/general_const.h"
+#include "../logger/logger.h"
+#include "../stats/stats.h"
+#include "../utils/utils.h"
+
+#define TMP_FILE_SUFFIX ".XXXXXX"
+#define NEW_FILE_MODE (S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH) /* like fopen, before the umask */
+
+static int g_is_write_if_changed = FALSE;
+static pthread_once_t g_umask_once = PTHREAD_ONCE_INIT;
+static mode_t g_umask = 0;
+
+/* =========================== internal functions declarations ================== */
+void _output_file_read_umask();
+int _output_file_is_unchanged(const char *file_name, const char *content, size_t size);
+int _output_file_open_tmp(output_file_t *output_file);
+int _output_file_rename_tmp(output_file_t *output_file);
+void _output_file_free(output_file_t *output_file);
+
+/* =========================== internal functions implementations ================= */
+
+void _output_file_read_umask()
+{
+	/* the umask can only be read by setting it, so it is read once and not around every file */
+	g_umask = umask(0);
+	umask(g_umask);
+}
+
+int _output_file_is_unchanged(const char *file_name, const char *content, size_t size)
+{
+	struct stat file_stat;
+	void *existing = NULL;
+	int is_unchanged = FALSE;
+	int fd = open(file_name, O_RDONLY);
+
+	if (fd < 0)
+	{
+		/* there is no existing file, or it can't be read, either way it is written */
+		return FALSE;
+	}
+	if (fstat(fd, &file_stat) == SUCCESS && S_ISREG(file_stat.st_mode) && (size_t)file_stat.st_size == size)
+	{
+		if (size == 0)
+		{
+			is_unchanged = TRUE;
+		}
+		else
+		{
+			existing = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (existing != MAP_FAILED)
+			{
+				is_unchanged = memcmp(existing, content, size) == 0;
+				munmap(existing, size);
+			}
+		}
+	}
+	close(fd);
+	return is_unchanged;
+}
+
+int _output_file_open_tmp(output_file_t *output_file)
+{
+	struct stat file_stat;
+	mode_t mode = 0;
+	int fd = -1;
+
+	/* next to the output file, so the rename stays on the same file system.
+	 * the name is unique per call, the server threads share the pid */
+	output_file->tmp_file_name = (char *)stats_malloc(strlen(output_file->file_name) + strlen(TMP_FILE_SUFFIX) + 1);
+	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(output_file->tmp_file_name, "Memory allocation failed in _output_file_open_tmp", FUNC_ERR);
+	strcpy(output_file->tmp_file_name, output_file->file_name);
+	strcat(output_file->tmp_file_name, TMP_FILE_SUFFIX);
+
+	fd = mkstemp(output_file->tmp_file_name);
+	if (fd < 0)
+	{
+		/* the name is not ours, so it must not be removed by output_file_discard */
+		LOG(ERROR, PARAMS, "Error creating a temporary file for %s", output_file->file_name);
+		free(output_file->tmp_file_name);
+		output_file->tmp_file_name = NULL;
+		return FUNC_ERR;
+	}
+	/* mkstemp creates the file as 0600, a replaced file keeps its own permissions
+	 * and a new one gets the permissions fopen would have given it */
+	if (stat(output_file->file_name, &file_stat) == SUCCESS)
+	{
+		mode = file_stat.st_mode & (S_IRWXU | S_IRWXG | S_IRWXO);
+	}
+	else
+	{
+		pthread_once(&g_umask_once, _output_file_read_umask);
+		mode = NEW_FILE_MODE & ~g_umask;
+	}
+	fchmod(fd, mode);
+
+	output_file->stream = fdopen(fd, "w");
+	if (output_file->stream == NULL)
+	{
+		LOG(ERROR, PARAMS, "Error opening file %s", output_file->tmp_file_name);
+		close(fd);
+		remove(output_file->tmp_file_name);
+		free(output_file->tmp_file_name);
+		output_file->tmp_file_name = NULL;
+		return FUNC_ERR;
+	}
+	return SUCCESS;
+}
+
+int _output_file_rename_tmp(output_file_t *output_file)
+{
+	int ret = SUCCESS;
+
+	if (fclose(output_file->stream) != SUCCESS)
+	{
+		LOG(ERROR, PARAMS, "failed to write %s", output_file->tmp_file_name);
+		ret = FUNC_ERR;
+	}
+	output_file->stream = NULL;
+	if (ret == SUCCESS && rename(output_file->tmp_file_name, output_file->file_name) != SUCCESS)
+	{
+		LOG(ERROR, PARAMS, "failed to rename %s to %s", output_file->tmp_file_name, output_file->file_name);
+		ret = FUNC_ERR;
+	}
+	if (ret != SUCCESS)
+	{
+		remove(output_file->tmp_file_name);
+	}
+	return ret;
+}
+
+void _output_file_free(output_file_t *output_file)
+{
+	free(output_file->file_name);
+	free(output_file->tmp_file_name);
+	free(output_file->content);
+	memset(output_file, 0, sizeof(output_file_t));
+}
+
+/*=============================================================================== */
+
+void output_file_set_write_if_changed(int is_write_if_changed)
+{
+	g_is_write_if_changed = is_write_if_changed;
+}
+
+FILE *output_file_open(output_file_t *output_file, const char *file_name)
+{
+	memset(output_file, 0, sizeof(output_file_t));
+	output_file->file_name = str_dup(file_name);
+	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(output_file->file_name, "Memory allocation failed in output_file_open", NULL);
+
+	if (g_is_write_if_changed)
+	{
+		output_file->stream = open_memstream(&output_file->content, &output_file->size);
+		if (output_file->stream == NULL)
+		{
+			LOG(ERROR, PARAMS, "open_memstream failed for %s", file_name);
+			_output_file_free(output_file);
+		}
+		return output_file->stream;
+	}
+	if (_output_file_open_tmp(output_file) != SUCCESS)
+	{
+		_output_file_free(output_file);
+	}
+	return output_file->stream;
+}
+
+int output_file_commit(output_file_t *output_file)
+{
+	int ret = SUCCESS;
+
+	if (output_file->tmp_file_name == NULL)
+	{
+		/* the content is in memory, the stream has to be closed before content and size are set */
+		if (fclose(output_file->stream) != SUCCESS)
+		{
+			LOG(ERROR, PARAMS, "failed to write %s to memory", output_file->file_name);
+			output_file->stream = NULL;
+			_output_file_free(output_file);
+			return FUNC_ERR;
+		}
+		output_file->stream = NULL;
+		if (_output_file_is_unchanged(output_file->file_name, output_file->content, output_file->size))
+		{
+			LOG(DEBUG, PARAMS, "%s did not change, it is not written", output_file->file_name);
+			_output_file_free(output_file);
+			return SUCCESS;
+		}
+		ret = _output_file_open_tmp(output_file);
+		if (ret == SUCCESS && fwrite(output_file->content, 1, output_file->size, output_file->stream) != output_file->size)
+		{
+			LOG(ERROR, PARAMS, "failed to write %s", output_file->tmp_file_name);
+			ret = FUNC_ERR;
+		}
+		if (ret != SUCCESS)
+		{
+			output_file_discard(output_file);
+			return ret;
+		}
+	}
+	ret = _output_file_rename_tmp(output_file);
+	_output_file_free(output_file);
+	return ret;
+}
+
+void output_file_discard(output_file_t *output_file)
+{
+	if (output_file->stream != NULL)
+	{
+		fclose(output_file->stream);
+	}
+	if (output_file->tmp_file_name != NULL)
+	{
+		remove(output_file->tmp_file_name);
+	}
+	_output_file_free(output_file);
+}
+
+int output_file_write(const char *file_name, const char *content, size_t size)
+{
+	output_file_t output_file;
+	FILE *stream = output_file_open(&output_file, file_name);
+
+	if (stream == NULL)
+	{
+		return FUNC_ERR;
+	}
+	if (fwrite(content, 1, size, stream) != size)
+	{
+		LOG(ERROR, PARAMS, "failed to write %s", file_name);
+		output_file_discard(&output_file);
+		return FUNC_ERR;
+	}
+	return output_file_commit(&output_file);
+}
@@ -0,0 +1,73 @@
+/* *******************************************************************
+ * Authors: Daniel Oren, Elisheva Cirota
+ *
+ * @file output_file.h
+ * @brief This file contains the declarations of the writing of the output files.
+ *
+ * An output file (.am, .ob, .ent or .ext) is written to a temporary file next to it and renamed
+ * into place when it is complete, so a crash never leaves a truncated output behind. With
+ * --write-if-changed the content is kept in memory and compared with the existing file first,
+ * and an identical file is not written at all, so its modification time is kept and make does
+ * not rebuild what depends on it.
+ *
+ *********************************************************************/
+
+#ifndef OUTPUT_FILE_H
+#define OUTPUT_FILE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct output_file
+{
+	FILE *stream; /* the stream the content is written to */
+	char *file_name; /* the name of the output file */
+	char *tmp_file_name; /* the temporary file, NULL while the content is in memory */
+	char *content; /* the content in memory, with --write-if-changed */
+	size_t size;
+} output_file_t;
+
+/**
+ * Sets whether the output files are compared with the existing files before they are written.
+ * It is set once, before any output file is opened.
+ *
+ * @param is_write_if_changed TRUE to skip writing outputs that did not change.
+ */
+void output_file_set_write_if_changed(int is_write_if_changed);
+
+/**
+ * Opens an output file for writing. Nothing is visible under file_name until output_file_commit.
+ *
+ * @param output_file The output file to open.
+ * @param file_name The name of the output file.
+ * @return The stream to write the content to, or NULL on failure.
+ */
+FILE *output_file_open(output_file_t *output_file, const char *file_name);
+
+/**
+ * Closes an output file and puts its content in place, unless it is the same as the existing file
+ * with --write-if-changed.
+ *
+ * @param output_file The output file.
+ * @return SUCCESS, or FUNC_ERR if the content could not be written, the existing file is then untouched.
+ */
+int output_file_commit(output_file_t *output_file);
+
+/**
+ * Closes an output file and drops its content, the existing file is untouched.
+ *
+ * @param output_file The output file.
+ */
+void output_file_discard(output_file_t *output_file);
+
+/**
+ * Writes a whole output file from memory, like output_file_open, fwrite and output_file_commit.
+ *
+ * @param file_name The name of the output file.
+ * @param content The content.
+ * @param size The size of the content.
+ * @return SUCCESS or FUNC_ERR.
+ */
+int output_file_write(const char *file_name, const char *content, size_t size);
+
+#endif /* OUTPUT_FILE_H */
@@ -15,34 +15,144 @@
 #include "preprocessor.h"
 
 #include "../general_const/general_const.h"
+#include "../stats/stats.h"
 #include "../utils/utils.h"
 #include "../logger/logger.h"
+#include "../output_file/output_file.h"
 #include "../hash_table/hash_table.h"
 #include "../string_vector/string_vector.h"
 #include "../assembler_helper/assembler_helper.h"
 
 /* =========================== internal functions declarations ================== */
-int _pre_process_input(general_data_pre_process_t *general_data_pre_process, FILE *input_file, const char *output_file_name);
+int _pre_process_input(general_data_pre_process_t *general_data_pre_process, FILE *input_file, FILE *output_file);
+long _estimate_num_lines(FILE *input_file);
+void _write_output(general_data_pre_process_t *general_data_pre_process, const char *text, FILE *output_file);
 
 int _validate_macro_name(char *macro_name, int line_count, general_data_pre_process_t *data);
 
 int _has_non_whitespace_characters_after_endmcr(const char *line, general_data_pre_process_t *general_data_pre_process);
-void _get_end_line_index(int *end_line_index, const char *line);
-void _get_first_word_from_line(const char *line, char *first_word, int *first_word_size, int *space_counter);
+const char *_get_first_token(const char *line, int *token_size);
+int _is_token(const char *token, int token_size, const char *word);
+macro_data_t *_lookup_macro(general_data_pre_process_t *general_data_pre_process, const char *token, int token_size, int *is_failed);
 int _get_macro_name(char *macro_name, const char *line, int first_word_size, int space_counter, int *macro_name_size, StringVector *warning_founds);
 void _remove_white_space_from_end_of_macro_name(int i, char *macro_name);
+macro_data_t *_create_macro(const char *macro_name);
+macro_data_t *_create_library_macro_call(general_data_pre_process_t *general_data_pre_process, const char *macro_name, macro_data_t *library_macro);
+int _set_macro_line_templates(macro_data_t *macro_data);
+int _add_macro_call(general_data_pre_process_t *general_data_pre_process, macro_data_t *macro_data, int first_line);
+int _get_macro_params(general_data_pre_process_t *general_data_pre_process, macro_data_t *macro_data, const char *params_text, int line_count);
+int _get_macro_args(general_data_pre_process_t *general_data_pre_process, const macro_data_t *macro_data, const char *args_text, char args[][MAX_LINE_SIZE], int line_count);
+void _get_trimmed_item(const char *item, int item_size, char *dest);
+int _substitute_macro_params(const macro_data_t *macro_data, char args[][MAX_LINE_SIZE], const char *line, char *expanded_line);
+void _get_expansion_key(const macro_data_t *macro_data, char args[][MAX_LINE_SIZE], char *key);
+int _add_expanded_line(general_data_pre_process_t *general_data_pre_process, macro_data_t *expansion, const char *line, int line_count);
+int _expand_macro(general_data_pre_process_t *general_data_pre_process, macro_data_t *macro_data, char args[][MAX_LINE_SIZE], int depth, int line_count, macro_data_t **expansion);
+int _store_expansion(general_data_pre_process_t *general_data_pre_process, macro_data_t *macro_data, const char *key, macro_data_t *expansion, int is_changed);
 
 /*================================================================================ */
 /* =========================== internal functions implementations ================= */
 
 void _free_macro(void *ptr)
 {
-	string_vector_free(((StringVector *)ptr));
+	macro_data_t *macro_data = (macro_data_t *)ptr;
+
+	if (macro_data->owns_content)
+	{
+		string_vector_free(macro_data->macro_content);
+	}
+	free(macro_data->line_templates);
+	free(macro_data);
+}
+
+void _free_macro_call(void *ptr)
+{
+	free(ptr);
+}
+
+void _forget_expansion(void *ptr)
+{
+	/* the expansions are owned by the macro_expansions queue */
+}
+
+macro_data_t *_create_macro(const char *macro_name)
+{
+	macro_data_t *macro_data = (macro_data_t *)stats_malloc(sizeof(macro_data_t));
+	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(macro_data, "Memory allocation failed in _create_macro", NULL);
+
+	strncpy(macro_data->macro_name, macro_name, MAX_LABEL_SIZE - 1);
+	macro_data->macro_name[MAX_LABEL_SIZE - 1] = NULL_TERMINATOR;
+	macro_data->line_templates = NULL;
+	macro_data->owns_content = TRUE;
+	macro_data->num_params = 0;
+	macro_data->macro_content = string_vector_create();
+	if (macro_data->macro_content == NULL)
+	{
+		free(macro_data);
+		return NULL;
+	}
+	return macro_data;
+}
+
+macro_data_t *_create_library_macro_call(general_data_pre_process_t *general_data_pre_process, const char *macro_name, macro_data_t *library_macro)
+{
+	/* the content is shared with the library, but the line templates belong to the input file */
+	macro_data_t *macro_data = (macro_data_t *)stats_malloc(sizeof(macro_data_t));
+	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(macro_data, "Memory allocation failed in _create_library_macro_call", NULL);
+
+	strcpy(macro_data->macro_name, library_macro->macro_name);
+	macro_data->macro_content = library_macro->macro_content;
+	macro_data->owns_content = FALSE;
+	macro_data->line_templates = NULL;
+	macro_data->num_params = library_macro->num_params;
+	memcpy(macro_data->params, library_macro->params, sizeof(macro_data->params));
+	if (_set_macro_line_templates(macro_data) != SUCCESS ||
+		hash_table_insert(general_data_pre_process->macro_table, macro_name, macro_data) != SUCCESS)
+	{
+		_free_macro(macro_data);
+		return NULL;
+	}
+	return macro_data;
+}
+
+int _set_macro_line_templates(macro_data_t *macro_data)
+{
+	int num_lines = string_vector_get_size(macro_data->macro_content);
+
+	if (num_lines == 0)
+	{
+		return SUCCESS;
+	}
+	/* all the templates start as not parsed */
+	macro_data->line_templates = (line_template_t *)stats_calloc(num_lines, sizeof(line_template_t));
+	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(macro_data->line_templates, "Memory allocation failed in _set_macro_line_templates", ERR);
+	return SUCCESS;
+}
+
+int _add_macro_call(general_data_pre_process_t *general_data_pre_process, macro_data_t *macro_data, int first_line)
+{
+	macro_call_t *macro_call = NULL;
+
+	if (macro_data->line_templates == NULL)
+	{
+		/* an empty macro adds no lines */
+		return SUCCESS;
+	}
+	macro_call = (macro_call_t *)stats_malloc(sizeof(macro_call_t));
+	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(macro_call, "Memory allocation failed in _add_macro_call", ERR);
+
+	macro_call->first_line = first_line;
+	macro_call->macro = macro_data;
+	if (SUCCESS != queue_enqueue(general_data_pre_process->macro_calls, macro_call))
+	{
+		free(macro_call);
+		return ERR;
+	}
+	return SUCCESS;
 }
 
 general_data_pre_process_t *init_pre_process_general_data()
 {
-	general_data_pre_process_t *general_data_pre_process = (general_data_pre_process_t *)malloc(sizeof(general_data_pre_process_t));
+	general_data_pre_process_t *general_data_pre_process = (general_data_pre_process_t *)stats_malloc(sizeof(general_data_pre_process_t));
 	LOG(DEBUG, PARAMS, "/================================================================================================================================*/\n");
 	if (NULL == general_data_pre_process)
 	{
@@ -67,47 +177,94 @@ general_data_pre_process_t *init_pre_process_general_data()
 		LOG(ERROR, PARAMS, "Error initializing Hash table general_data_pre_process->macro_table");
 		return NULL;
 	}
+	general_data_pre_process->macro_calls = queue_create();
+	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(general_data_pre_process->macro_calls, "Error initializing general_data_pre_process->macro_calls", NULL);
+	general_data_pre_process->macro_expansions = queue_create();
+	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(general_data_pre_process->macro_expansions, "Error initializing general_data_pre_process->macro_expansions", NULL);
+	general_data_pre_process->expansion_table = hash_table_init();
+	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(general_data_pre_process->expansion_table, "Error initializing general_data_pre_process->expansion_table", NULL);
+	general_data_pre_process->num_expanded_lines = 0;
+	pre_process_set_listener(general_data_pre_process, NULL, NULL, NULL);
 	LOG(DEBUG, PARAMS, "finish initializing general data \n");
 
 	return general_data_pre_process;
 }
+void pre_process_set_listener(general_data_pre_process_t *pre_process_data, pre_process_output_func on_output, pre_process_macro_func on_macro_defined, void *user_data)
+{
+	pre_process_data->on_output = on_output;
+	pre_process_data->on_macro_defined = on_macro_defined;
+	pre_process_data->listener_data = user_data;
+}
+
 void clear_pre_process_data(general_data_pre_process_t *pre_process_data)
 {
 	string_vector_clear(pre_process_data->error_founds);
 	string_vector_clear(pre_process_data->warning_founds);
+	queue_clear(pre_process_data->macro_calls, _free_macro_call);
+	hash_table_clear(pre_process_data->expansion_table, _forget_expansion);
+	queue_clear(pre_process_data->macro_expansions, _free_macro);
+	pre_process_data->num_expanded_lines = 0;
 	hash_table_clear(pre_process_data->macro_table, _free_macro);
 }
 void free_pre_process_data(general_data_pre_process_t *general_data_pre_process)
 {
 	string_vector_free(general_data_pre_process->error_founds);
 	string_vector_free(general_data_pre_process->warning_founds);
+	queue_destroy(general_data_pre_process->macro_calls, _free_macro_call);
+	hash_table_free(general_data_pre_process->expansion_table, _forget_expansion);
+	queue_destroy(general_data_pre_process->macro_expansions, _free_macro);
 	hash_table_free(general_data_pre_process->macro_table, _free_macro);
 
 	free(general_data_pre_process);
 }
 
-void _get_first_word_from_line(const char *line, char *first_word, int *first_word_size, int *space_counter)
+const char *_get_first_token(const char *line, int *token_size)
 {
 	int i = 0;
 
-	(*first_word_size) = 0;
-	/*in case the line starts with space*/
-	while (isspace(line[i]))
+	while (isspace(*line))
 	{
-		line++;
-		space_counter++;
+		++line;
 	}
-
-	while(!isspace(line[i]) && line[i] != NEWLINE_CHARACTER)
+	while (line[i] != NULL_TERMINATOR && !isspace(line[i]))
 	{
-		i++;
+		++i;
 	}
-	
-	(*first_word_size) += i;
-	strncpy(first_word, line, *first_word_size);
-	first_word[*first_word_size] = NULL_TERMINATOR;
+	*token_size = i;
+	return line;
+}
 
-	LOG(DEBUG, PARAMS, "First word: %s\n", first_word);
+int _is_token(const char *token, int token_size, const char *word)
+{
+	return strncmp(token, word, token_size) == 0 && word[token_size] == NULL_TERMINATOR;
+}
+
+macro_data_t *_lookup_macro(general_data_pre_process_t *general_data_pre_process, const char *token, int token_size, int *is_failed)
+{
+	char macro_name[MAX_LINE_SIZE];
+	HashTable *macro_table = general_data_pre_process->macro_table;
+	macro_data_t *macro_data = NULL;
+
+	*is_failed = FALSE;
+	/* a macro name starts with a letter, and most lines are not macro calls */
+	if ((macro_table->size == 0 && macro_table->fallback == NULL) || !isalpha(*token))
+	{
+		return NULL;
+	}
+	memcpy(macro_name, token, token_size);
+	macro_name[token_size] = NULL_TERMINATOR;
+	macro_data = (macro_data_t *)hash_table_lookup_local(macro_table, macro_name);
+	if (macro_data == NULL && macro_table->fallback != NULL)
+	{
+		macro_data = (macro_data_t *)hash_table_lookup_local(macro_table->fallback, macro_name);
+		if (macro_data != NULL)
+		{
+			/* first call of a macro of the macro library in this input file */
+			macro_data = _create_library_macro_call(general_data_pre_process, macro_name, macro_data);
+			*is_failed = macro_data == NULL;
+		}
+	}
+	return macro_data;
 }
 
 int _get_macro_name(char *macro_name, const char *line, int first_word_size, int space_counter, int *macro_name_size, StringVector *warning_founds)
@@ -140,18 +297,6 @@ int _get_macro_name(char *macro_name, const char *line, int first_word_size, int
 	return SUCCESS;
 }
 
-void _get_end_line_index(int *end_line_index, const char *line)
-{
-	int i = 0;
-
-	while (line[i] != '\0')
-	{
-		i++;
-	}
-
-	*end_line_index = i;
-}
-
 void _remove_white_space_from_end_of_macro_name(int i, char *macro_name)
 {
 	i = 0;
@@ -183,11 +328,6 @@ int _validate_macro_name(char *macro_name, int line_count, general_data_pre_proc
 int _has_non_whitespace_characters_after_endmcr(const char *line, general_data_pre_process_t *general_data_pre_process)
 {
 	char log_error[MAX_LINE_SIZE];
-	while (strncmp(line, "endmcr", strlen("endmcr")) != 0)
-		line++;
-
-	/*placing the pointer after endmcr*/
-	line += strlen("endmcr");
 
 	while (*line != '\0')
 	{
@@ -201,17 +341,307 @@ int _has_non_whitespace_characters_after_endmcr(const char *line, general_data_p
 	return SUCCESS;
 }
 
+void _get_trimmed_item(const char *item, int item_size, char *dest)
+{
+	while (item_size > 0 && isspace(*item))
+	{
+		++item;
+		--item_size;
+	}
+	while (item_size > 0 && isspace(item[item_size - 1]))
+	{
+		--item_size;
+	}
+	memcpy(dest, item, item_size);
+	dest[item_size] = NULL_TERMINATOR;
+}
+
+int _get_macro_params(general_data_pre_process_t *general_data_pre_process, macro_data_t *macro_data, const char *params_text, int line_count)
+{
+	char log_error[MAX_LINE_SIZE + MAX_LINE_SIZE];
+	char param[MAX_LINE_SIZE];
+	const char *separator = NULL;
+	int i = 0;
+
+	while (isspace(*params_text))
+	{
+		++params_text;
+	}
+	/* mcr <name> <param>, <param>, ... */
+	while (*params_text != NULL_TERMINATOR)
+	{
+		separator = strchr(params_text, MACRO_PARAMS_SEPARATOR);
+		_get_trimmed_item(params_text, separator == NULL ? (int)strlen(params_text) : (int)(separator - params_text), param);
+		params_text = separator == NULL ? params_text + strlen(params_text) : separator + 1;
+
+		if (macro_data->num_params == MAX_MACRO_PARAMS)
+		{
+			sprintf(log_error, "macro %s has more than %d parameters. found in line: %d", macro_data->macro_name, MAX_MACRO_PARAMS, line_count);
+			PUSH_ERROR_AND_RETURN(log_error, USER_ERR, general_data_pre_process->error_founds);
+		}
+		for (i = 1; isalnum(param[i]) || param[i] == '_'; ++i)
+			;
+		if (!isalpha(param[0]) || param[i] != NULL_TERMINATOR || i >= MAX_LABEL_SIZE)
+		{
+			sprintf(log_error, "invalid macro parameter: %.31s. found in line: %d", param, line_count);
+			PUSH_ERROR_AND_RETURN(log_error, USER_ERR, general_data_pre_process->error_founds);
+		}
+		for (i = 0; i < macro_data->num_params; ++i)
+		{
+			if (strcmp(macro_data->params[i], param) == 0)
+			{
+				sprintf(log_error, "macro parameter %s appears twice. found in line: %d", param, line_count);
+				PUSH_ERROR_AND_RETURN(log_error, USER_ERR, general_data_pre_process->error_founds);
+			}
+		}
+		strcpy(macro_data->params[macro_data->num_params++], param);
+	}
+	return SUCCESS;
+}
+
+int _get_macro_args(general_data_pre_process_t *general_data_pre_process, const macro_data_t *macro_data, const char *args_text, char args[][MAX_LINE_SIZE], int line_count)
+{
+	char log_error[MAX_LINE_SIZE + MAX_LINE_SIZE];
+	const char *separator = NULL;
+	int num_args = 0;
+
+	/* the text after the name of a macro without parameters is ignored */
+	if (macro_data->num_params == 0)
+	{
+		return SUCCESS;
+	}
+	while (isspace(*args_text))
+	{
+		++args_text;
+	}
+	while (*args_text != NULL_TERMINATOR && num_args < MAX_MACRO_PARAMS)
+	{
+		separator = strchr(args_text, MACRO_PARAMS_SEPARATOR);
+		_get_trimmed_item(args_text, separator == NULL ? (int)strlen(args_text) : (int)(separator - args_text), args[num_args]);
+		args_text = separator == NULL ? args_text + strlen(args_text) : separator + 1;
+		if (args[num_args][0] == NULL_TERMINATOR)
+		{
+			sprintf(log_error, "empty argument of macro %s. found in line: %d", macro_data->macro_name, line_count);
+			PUSH_ERROR_AND_RETURN(log_error, USER_ERR, general_data_pre_process->error_founds);
+		}
+		++num_args;
+	}
+	if (num_args != macro_data->num_params || *args_text != NULL_TERMINATOR)
+	{
+		sprintf(log_error, "macro %s expects %d arguments. found in line: %d", macro_data->macro_name, macro_data->num_params, line_count);
+		PUSH_ERROR_AND_RETURN(log_error, USER_ERR, general_data_pre_process->error_founds);
+	}
+	return SUCCESS;
+}
+
+int _substitute_macro_params(const macro_data_t *macro_data, char args[][MAX_LINE_SIZE], const char *line, char *expanded_line)
+{
+	int size = 0;
+	int word_size = 0;
+	int is_in_string = FALSE;
+	int i = 0;
+	const char *replacement = NULL;
+	int replacement_size = 0;
+
+	if (macro_data->num_params == 0 || line[0] == COMMENT_LINE_PREFIX)
+	{
+		strcpy(expanded_line, line);
+		return SUCCESS;
+	}
+	while (*line != NULL_TERMINATOR)
+	{
+		/* a parameter is replaced only when it is a whole word outside of a string */
+		for (word_size = 0; !is_in_string && (isalnum(line[word_size]) || line[word_size] == '_'); ++word_size)
+			;
+		replacement = line;
+		replacement_size = word_size == 0 ? 1 : word_size;
+		for (i = 0; i < macro_data->num_params && word_size > 0; ++i)
+		{
+			if (strncmp(line, macro_data->params[i], word_size) == 0 && macro_data->params[i][word_size] == NULL_TERMINATOR)
+			{
+				replacement = args[i];
+				replacement_size = strlen(args[i]);
+				break;
+			}
+		}
+		if (size + replacement_size > MAX_LINE_SIZE)
+		{
+			return ERR;
+		}
+		memcpy(expanded_line + size, replacement, replacement_size);
+		size += replacement_size;
+		if (*line == '"')
+		{
+			is_in_string = !is_in_string;
+		}
+		line += word_size == 0 ? 1 : word_size;
+	}
+	expanded_line[size] = NULL_TERMINATOR;
+	return SUCCESS;
+}
+
+void _get_expansion_key(const macro_data_t *macro_data, char args[][MAX_LINE_SIZE], char *key)
+{
+	int i = 0;
+
+	/* the arguments can't contain the separator, so the key is unique */
+	strcpy(key, macro_data->macro_name);
+	for (i = 0; i < macro_data->num_params; ++i)
+	{
+		strcat(key, i == 0 ? " " : ",");
+		strcat(key, args[i]);
+	}
+}
+
+int _add_expanded_line(general_data_pre_process_t *general_data_pre_process, macro_data_t *expansion, const char *line, int line_count)
+{
+	char log_error[MAX_LINE_SIZE + MAX_LINE_SIZE];
+
+	if (++general_data_pre_process->num_expanded_lines > MAX_MACRO_EXPANDED_LINES)
+	{
+		sprintf(log_error, "expansion of macro %s is too large. found in line: %d", expansion->macro_name, line_count);
+		PUSH_ERROR_AND_RETURN(log_error, USER_ERR, general_data_pre_process->error_founds);
+	}
+	if (string_vector_push_back(expansion->macro_content, line) == ERR)
+	{
+		LOG(ERROR, PARAMS, "string_vector_push_back failed at _add_expanded_line");
+		return ERR;
+	}
+	return SUCCESS;
+}
+
+int _store_expansion(general_data_pre_process_t *general_data_pre_process, macro_data_t *macro_data, const char *key, macro_data_t *expansion, int is_changed)
+{
+	if (!is_changed)
+	{
+		/* nothing was replaced, the expansion shares the content of the macro */
+		general_data_pre_process->num_expanded_lines -= string_vector_get_size(expansion->macro_content);
+		string_vector_free(expansion->macro_content);
+		expansion->macro_content = macro_data->macro_content;
+		expansion->owns_content = FALSE;
+	}
+	if (_set_macro_line_templates(expansion) != SUCCESS || queue_enqueue(general_data_pre_process->macro_expansions, expansion) != SUCCESS)
+	{
+		_free_macro(expansion);
+		return ERR;
+	}
+	return hash_table_insert(general_data_pre_process->expansion_table, key, expansion) == SUCCESS ? SUCCESS : ERR;
+}
+
+int _expand_macro(general_data_pre_process_t *general_data_pre_process, macro_data_t *macro_data, char args[][MAX_LINE_SIZE], int depth, int line_count, macro_data_t **expansion)
+{
+	char log_error[MAX_LINE_SIZE + MAX_LINE_SIZE];
+	char key[MAX_LABEL_SIZE + MAX_LINE_SIZE];
+	char expanded_line[MAX_LINE_SIZE + 1];
+	char nested_args[MAX_MACRO_PARAMS][MAX_LINE_SIZE];
+	macro_data_t *nested_macro = NULL;
+	macro_data_t *nested_expansion = NULL;
+	const char *line = NULL;
+	const char *token = NULL;
+	int token_size = 0;
+	int num_lines = 0;
+	int is_failed = FALSE;
+	int is_changed = FALSE; /* whether the content of the expansion differs from the content of the macro */
+	int ret = SUCCESS;
+	int i = 0;
+	int j = 0;
+
+	if (depth > MAX_MACRO_NESTING_DEPTH)
+	{
+		sprintf(log_error, "macro %s is nested more than %d times, is it recursive? found in line: %d", macro_data->macro_name, MAX_MACRO_NESTING_DEPTH, line_count);
+		PUSH_ERROR_AND_RETURN(log_error, USER_ERR, general_data_pre_process->error_founds);
+	}
+
+	/* a call with the same arguments is copied from the stored expansion */
+	_get_expansion_key(macro_data, args, key);
+	*expansion = (macro_data_t *)hash_table_lookup_local(general_data_pre_process->expansion_table, key);
+	if (*expansion != NULL)
+	{
+		stats_add(STATS_COUNTER__MACRO_EXPANSIONS_CACHED, 1);
+		return SUCCESS;
+	}
+
+	*expansion = _create_macro(macro_data->macro_name);
+	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(*expansion, "_create_macro failed in _expand_macro", ERR);
+	num_lines = string_vector_get_size(macro_data->macro_content);
+	for (i = 0; i < num_lines && ret == SUCCESS; ++i)
+	{
+		line = string_vector_at(macro_data->macro_content, i);
+		if (_substitute_macro_params(macro_data, args, line, expanded_line) != SUCCESS)
+		{
+			sprintf(log_error, "line of macro %s is too long after replacing its parameters. found in line: %d", macro_data->macro_name, line_count);
+			_free_macro(*expansion);
+			PUSH_ERROR_AND_RETURN(log_error, USER_ERR, general_data_pre_process->error_founds);
+		}
+		is_changed = is_changed || strcmp(line, expanded_line) != 0;
+
+		token = _get_first_token(expanded_line, &token_size);
+		nested_macro = expanded_line[0] == COMMENT_LINE_PREFIX ? NULL : _lookup_macro(general_data_pre_process, token, token_size, &is_failed);
+		if (is_failed)
+		{
+			ret = ERR;
+		}
+		else if (nested_macro != NULL)
+		{
+			is_changed = TRUE;
+			ret = _get_macro_args(general_data_pre_process, nested_macro, token + token_size, nested_args, line_count);
+			if (ret == SUCCESS)
+			{
+				ret = _expand_macro(general_data_pre_process, nested_macro, nested_args, depth + 1, line_count, &nested_expansion);
+			}
+			for (j = 0; ret == SUCCESS && j < string_vector_get_size(nested_expansion->macro_content); ++j)
+			{
+				ret = _add_expanded_line(general_data_pre_process, *expansion, string_vector_at(nested_expansion->macro_content, j), line_count);
+			}
+		}
+		else
+		{
+			ret = _add_expanded_line(general_data_pre_process, *expansion, expanded_line, line_count);
+		}
+	}
+	if (ret != SUCCESS)
+	{
+		general_data_pre_process->num_expanded_lines -= string_vector_get_size((*expansion)->macro_content);
+		_free_macro(*expansion);
+		return ret;
+	}
+	return _store_expansion(general_data_pre_process, macro_data, key, *expansion, is_changed);
+}
+
 /*=============================================================================== */
 
 int pre_process_input(general_data_pre_process_t *pre_process_data, FILE *input_file, const char *file_name, char *output_file_name)
 {
 	int ret = 0;
+	output_file_t output_file;
+	FILE *output_stream = NULL;
 
 	LOG(DEBUG, PARAMS, "pre processing the %s file", file_name);
 
 	get_output_file_name(file_name, output_file_name, PRE_PROCESSOR_FILE_EXTENSION);
 
-	ret = _pre_process_input(pre_process_data, input_file, output_file_name);
+	output_stream = output_file_open(&output_file, output_file_name);
+	if (output_stream == NULL)
+	{
+		LOG(ERROR, PARAMS, "Error opening output file %s", output_file_name);
+		return ERR;
+	}
+	ret = _pre_process_input(pre_process_data, input_file, output_stream);
+	fclose(input_file);
+	if (ret == SUCCESS)
+	{
+		ret = output_file_commit(&output_file) == SUCCESS ? SUCCESS : ERR;
+	}
+	else
+	{
+		/* a failed file leaves no .am behind, not even the one of an earlier run */
+		output_file_discard(&output_file);
+		if (ret == USER_ERR)
+		{
+			remove(output_file_name);
+		}
+	}
+
 	if (ret == ERR)
 	{
 		LOG(ERROR, PARAMS, "Error in pre processing the %s file", file_name);
@@ -222,92 +652,167 @@ int pre_process_input(general_data_pre_process_t *pre_process_data, FILE *input_
 	}
 	return ret;
 }
-int _pre_process_input(general_data_pre_process_t *general_data_pre_process, FILE *input_file, const char *output_file_name)
+int pre_process_stream(general_data_pre_process_t *pre_process_data, FILE *input_file, FILE *output_file)
 {
-	FILE *output_file = NULL;
-	char line[MAX_LINE_SIZE];
-	char first_word[MAX_LINE_SIZE];
+	int ret = _pre_process_input(pre_process_data, input_file, output_file);
+
+	if (ret == ERR)
+	{
+		LOG(ERROR, PARAMS, "Error in pre processing a stream");
+	}
+	return ret;
+}
+
+void _write_output(general_data_pre_process_t *general_data_pre_process, const char *text, FILE *output_file)
+{
+	fputs(text, output_file);
+	if (general_data_pre_process->on_output != NULL)
+	{
+		general_data_pre_process->on_output(text, general_data_pre_process->listener_data);
+	}
+}
+
+long _estimate_num_lines(FILE *input_file)
+{
+	long start = ftell(input_file);
+	long end = 0;
+
+	/* a stream that can't be sought, like a pipe, gives no estimate */
+	if (start < 0 || fseek(input_file, 0, SEEK_END) != SUCCESS)
+	{
+		return 0;
+	}
+	end = ftell(input_file);
+	if (fseek(input_file, start, SEEK_SET) != SUCCESS)
+	{
+		LOG(ERROR, PARAMS, "fseek failed in _estimate_num_lines");
+		return -1;
+	}
+	return end > start ? (end - start) / AVERAGE_LINE_SIZE_ESTIMATE : 0;
+}
+
+int _pre_process_input(general_data_pre_process_t *general_data_pre_process, FILE *input_file, FILE *output_file)
+{
+	char line[MAX_LINE_SIZE + 1]; /* one more char for the newline of a line that is too long */
 	char macro_name[MAX_LINE_SIZE];
+	const char *token = NULL;
+	int token_size = 0;
 	int line_index = 1;
-	int end_line_index = 0;
-	int first_word_size = 0;
+	int output_line_index = 1; /* the number of the next line of the output file */
 	int macro_name_size = 0;
 	int macro_content_size = 0;
-	int found_macro = FALSE;
 	int i = 0;
-	int space_counter = 0;
-	StringVector *macro_data_content = NULL;
-
-
-	output_file = fopen(output_file_name, "w");
-	if (output_file == NULL)
+	macro_data_t *macro_data = NULL; /* the macro that is being defined, NULL outside of a macro definition */
+	macro_data_t *called_macro = NULL;
+	macro_data_t *expansion = NULL;
+	char args[MAX_MACRO_PARAMS][MAX_LINE_SIZE];
+	char *params_text = NULL;
+	long num_lines = _estimate_num_lines(input_file);
+	int is_failed = FALSE;
+	int ret = SUCCESS;
+
+	/* the macro table is sized for the most macros the input file can define, so defining them doesn't resize it */
+	if (num_lines < 0 || hash_table_reserve(general_data_pre_process->macro_table, num_lines / MIN_MACRO_DEFINITION_LINES) != SUCCESS)
 	{
-		LOG(ERROR, PARAMS, "Error opening output file %s", output_file_name);
 		return ERR;
 	}
-	memset(line, NEWLINE_CHARACTER, MAX_LINE_SIZE);
-	while (fgets(line, sizeof(line), input_file) != NULL)
+
+	/* every line is scanned once, its first token decides what to do with it */
+	line[MAX_LINE_SIZE - 1] = NEWLINE_CHARACTER;
+	while (fgets(line, MAX_LINE_SIZE, input_file) != NULL)
 	{
-		line[MAX_LINE_SIZE - 1] = NEWLINE_CHARACTER;
+		if (line[MAX_LINE_SIZE - 1] == NULL_TERMINATOR && line[MAX_LINE_SIZE - 2] != NEWLINE_CHARACTER)
+		{
+			/* the line is too long, its first part is ended with a newline and the rest is the next line */
+			line[MAX_LINE_SIZE - 1] = NEWLINE_CHARACTER;
+			line[MAX_LINE_SIZE] = NULL_TERMINATOR;
+		}
 
 		if (line[0] == COMMENT_LINE_PREFIX)
 		{
-			fprintf(output_file, "%s", line);
+			_write_output(general_data_pre_process, line, output_file);
 			++line_index;
+			++output_line_index;
+			line[MAX_LINE_SIZE - 1] = NEWLINE_CHARACTER;
 			continue;
 		}
-		_get_first_word_from_line(line, first_word, &first_word_size, &space_counter);
-		LOG(DEBUG, PARAMS, "line index : %d ", line_index);
-		_get_end_line_index(&end_line_index, line);
-		if (!found_macro)
+		token = _get_first_token(line, &token_size);
+		called_macro = macro_data == NULL ? _lookup_macro(general_data_pre_process, token, token_size, &is_failed) : NULL;
+		if (is_failed)
 		{
-			macro_data_content = (StringVector *)hash_table_lookup(general_data_pre_process->macro_table, first_word);
+			return ERR;
 		}
+
 		/* first word of the line was found in the macro table, therefore the line should be replaced with the macro content */
-		if (!found_macro && macro_data_content)
+		if (called_macro != NULL)
 		{
-
-			LOG(DEBUG, PARAMS, "Found macro! line index : %d, line: %s, first_word %s\n", line_index, line, first_word);
-			macro_content_size = string_vector_get_size(macro_data_content);
+			LOG(DEBUG, PARAMS, "Found macro! line index : %d, line: %s\n", line_index, line);
+			stats_add(STATS_COUNTER__MACRO_EXPANSIONS, 1);
+			ret = _get_macro_args(general_data_pre_process, called_macro, token + token_size, args, line_index);
+			if (ret == SUCCESS)
+			{
+				ret = _expand_macro(general_data_pre_process, called_macro, args, 0, line_index, &expansion);
+			}
+			if (ret == ERR || (ret == SUCCESS && _add_macro_call(general_data_pre_process, expansion, output_line_index) != SUCCESS))
+			{
+				return ERR;
+			}
+			/* a call with errors is not written, the errors stop the assembling of the file anyway */
+			macro_content_size = ret == SUCCESS ? string_vector_get_size(expansion->macro_content) : 0;
 			for (i = 0; i < macro_content_size; ++i)
 			{
-
-				fprintf(output_file, "%s", string_vector_at(macro_data_content, i));
+				_write_output(general_data_pre_process, string_vector_at(expansion->macro_content, i), output_file);
 			}
+			output_line_index += macro_content_size;
 		}
-		else if (0 == strcmp(first_word, MACRO_PREFIX))
+		else if (_is_token(token, token_size, MACRO_PREFIX))
 		{
-			if (_get_macro_name(macro_name, line, first_word_size, space_counter, &macro_name_size, general_data_pre_process->warning_founds) != SUCCESS)
+			if (_get_macro_name(macro_name, line, token_size, 0, &macro_name_size, general_data_pre_process->warning_founds) != SUCCESS)
 			{
 				return ERR;
 			}
+			/* the parameters follow the name of the macro */
+			params_text = macro_name + strcspn(macro_name, " \t\n\v\f\r");
+			if (params_text[strspn(params_text, " \t\n\v\f\r")] != NULL_TERMINATOR)
+			{
+				*params_text++ = NULL_TERMINATOR;
+			}
 			if (_validate_macro_name(macro_name, line_index, general_data_pre_process) == SUCCESS)
 			{
 				_remove_white_space_from_end_of_macro_name(i, macro_name);
-				LOG(DEBUG, PARAMS, "Found new macro! line index : %d, line: %s, first_word %s\n", line_index, line, first_word);
-				found_macro = TRUE;
-				macro_data_content = string_vector_create();
-				if (macro_data_content == NULL)
+				LOG(DEBUG, PARAMS, "Found new macro! line index : %d, line: %s\n", line_index, line);
+				if (macro_data != NULL)
+				{
+					/* the previous definition never ended */
+					_free_macro(macro_data);
+				}
+				macro_data = _create_macro(macro_name);
+				if (macro_data == NULL || _get_macro_params(general_data_pre_process, macro_data, params_text, line_index) == ERR)
 				{
 					return ERR;
 				}
-				/*macro_data->macro_content = vec;*/
-				/*macro_name[0] = '\0';*/
 			}
 		}
-
-		else if (found_macro && strstr(line, MACRO_POSTFIX) != NULL)
+		else if (macro_data != NULL && _is_token(token, token_size, MACRO_POSTFIX))
 		{
-
-			LOG(INFO, PARAMS, "inserting macro! macro_name : %s, macro_size %d", macro_name, string_vector_get_size(macro_data_content));
-			hash_table_insert(general_data_pre_process->macro_table, macro_name, macro_data_content);
-			found_macro = FALSE;
-			macro_data_content = NULL;
+			_has_non_whitespace_characters_after_endmcr(token + token_size, general_data_pre_process);
+			LOG(INFO, PARAMS, "inserting macro! macro_name : %s, macro_size %d", macro_name, string_vector_get_size(macro_data->macro_content));
+			if (_set_macro_line_templates(macro_data) != SUCCESS)
+			{
+				return ERR;
+			}
+			hash_table_insert(general_data_pre_process->macro_table, macro_name, macro_data);
+			if (general_data_pre_process->on_macro_defined != NULL)
+			{
+				general_data_pre_process->on_macro_defined(macro_name, general_data_pre_process->listener_data);
+			}
+			macro_data = NULL;
+			/* the stored expansions may call the macro that was defined again */
+			hash_table_clear(general_data_pre_process->expansion_table, _forget_expansion);
 		}
-
-		else if (found_macro)
+		else if (macro_data != NULL)
 		{
-			if (string_vector_push_back(macro_data_content, line) == ERR)
+			if (string_vector_push_back(macro_data->macro_content, line) == ERR)
 			{
 				LOG(ERROR, PARAMS, "string_vector_push_back failed at pre_process_input");
 				return ERR;
@@ -315,23 +820,25 @@ int _pre_process_input(general_data_pre_process_t *general_data_pre_process, FIL
 		}
 		else
 		{
-			fprintf(output_file, "%s", line);
+			_write_output(general_data_pre_process, line, output_file);
+			++output_line_index;
 		}
 
 		++line_index;
-		memset(line, NEWLINE_CHARACTER, MAX_LINE_SIZE);
-
+		line[MAX_LINE_SIZE - 1] = NEWLINE_CHARACTER;
 	}
 
-	fclose(input_file);
-	fclose(output_file);
+	if (macro_data != NULL)
+	{
+		/* the last definition never ended */
+		_free_macro(macro_data);
+	}
 
-	LOG(DEBUG, PARAMS, "Finished preprossecor action. file %s is ready.", output_file_name);
+	LOG(DEBUG, PARAMS, "Finished preprossecor action.");
 
 	if (string_vector_get_size(general_data_pre_process->error_founds) > 0)
 	{
 		LOG(ERROR, PARAMS, "Errors found in preprocessor");
-		remove(output_file_name);
 		return USER_ERR;
 	}
 	return SUCCESS;
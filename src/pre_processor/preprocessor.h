@@ -9,10 +9,44 @@
 
 #ifndef PRE_PROCESSOR_H
 #define PRE_PROCESSOR_H
+#include <stdio.h>
+
 #include "../general_const/general_const.h"
+#include "preprocessor_consts.h"
 #include "../hash_table/hash_table.h"
 #include "../string_vector/string_vector.h"
+#include "../dynamic_queue/dynamic_queue.h"
+
+/* defined in assembler_helper.h */
+struct line_template;
+
+/**
+ * @struct macro_data
+ * @brief Represents the data structure for storing macro information.
+ */
+typedef struct macro_data {
+	char macro_name[MAX_LABEL_SIZE]; /* The name of the macro */
+	StringVector *macro_content; /* The content of the macro */
+	int owns_content; /* FALSE when the content is shared with another macro_data_t */
+	struct line_template *line_templates; /* The parsed form of every line of the content, filled by the first pass */
+	int num_params; /* The number of parameters of the macro */
+	char params[MAX_MACRO_PARAMS][MAX_LABEL_SIZE]; /* The names of the parameters, replaced by the arguments of a call */
+} macro_data_t;
+
+/**
+ * @struct macro_call
+ * @brief Represents an expansion of a macro in the pre processed file.
+ */
+typedef struct macro_call {
+	int first_line; /* The line number of the first line of the expansion in the pre processed file */
+	macro_data_t *macro; /* The expansion, its content is the lines that were written to the pre processed file */
+} macro_call_t;
 
+/* Called with the text that is written to the pre processed file, right after it is written */
+typedef void (*pre_process_output_func)(const char *text, void *user_data);
+
+/* Called with the name of every macro that the input file defines, once its definition ends */
+typedef void (*pre_process_macro_func)(const char *macro_name, void *user_data);
 
 /* This structure is used for general data pre-processing operations.
  * It can be used to store and manipulate data before further processing. */
@@ -20,7 +54,14 @@ typedef struct general_data_pre_process
 {
 	StringVector *error_founds; /* A vector to store errors found during pre-processing */
 	StringVector *warning_founds; /* A vector to store warnings found during pre-processing */
-	HashTable *macro_table; /* A hash table to store macros. key: macro name. value: macro content*/
+	HashTable *macro_table; /* A hash table to store macros. key: macro name. value: macro_data_t. Its fallback is the macro library */
+	Queue *macro_calls; /* A queue of macro_call_t, the expansions of the macros in the order of the pre processed file */
+	Queue *macro_expansions; /* A queue of macro_data_t, owns every expansion that was stored */
+	HashTable *expansion_table; /* The stored expansions. key: the macro name and the arguments. value: macro_data_t */
+	long num_expanded_lines; /* The number of lines of the stored expansions that don't share the content of their macro */
+	pre_process_output_func on_output; /* Told about the output while it is written, NULL when nobody listens */
+	pre_process_macro_func on_macro_defined; /* Told about the macros of the input file, NULL when nobody listens */
+	void *listener_data; /* Passed to on_output and on_macro_defined */
 
 } general_data_pre_process_t;
 
@@ -47,6 +88,31 @@ general_data_pre_process_t *init_pre_process_general_data();
  */
 int pre_process_input(general_data_pre_process_t *pre_process_data, FILE *input_file, const char *file_name, char *output_file_name);
 
+/**
+ * Pre-processes an input stream into an output stream.
+ *
+ * Like pre_process_input, but the caller opens and closes the streams, so they can be memory
+ * streams. The output stream is not removed when errors are found.
+ *
+ * @param pre_process_data A pointer to the general_data_pre_process_t struct that holds pre-processing data.
+ * @param input_file The stream to read the source from.
+ * @param output_file The stream to write the pre-processed source to.
+ * @return SUCCESS, USER_ERR if errors were found in the source, or ERR on internal failure.
+ */
+int pre_process_stream(general_data_pre_process_t *pre_process_data, FILE *input_file, FILE *output_file);
+
+/**
+ * Sets the functions that are told about the output of the pre processor while it is written,
+ * so another thread can assemble the pre processed source before the whole file is written.
+ * They stay set until they are set again, clearing the data doesn't remove them.
+ *
+ * @param pre_process_data A pointer to the general_data_pre_process_t struct that holds pre-processing data.
+ * @param on_output Called with every text that is written to the output, or NULL.
+ * @param on_macro_defined Called with the name of every macro the input defines, or NULL.
+ * @param user_data Passed to both functions.
+ */
+void pre_process_set_listener(general_data_pre_process_t *pre_process_data, pre_process_output_func on_output, pre_process_macro_func on_macro_defined, void *user_data);
+
 /**
  * @brief Clears the pre-process data structure.
  *
@@ -65,13 +131,4 @@ void clear_pre_process_data(general_data_pre_process_t *pre_process_data);
 void free_pre_process_data(general_data_pre_process_t *general_data_pre_process);
 
 
-/**
- * @struct macro_data
- * @brief Represents the data structure for storing macro information.
- */
-typedef struct macro_data {
-	char macro_name[MAX_LABEL_SIZE]; /* The name of the macro */
-	StringVector *macro_content; /* The content of the macro */
-} macro_data_t;
-
 #endif /* PRE_PROCESSOR_H */
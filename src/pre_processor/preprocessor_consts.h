@@ -10,5 +10,12 @@
 
 #define MACRO_PREFIX "mcr"
 #define MACRO_POSTFIX "endmcr"
+#define MACRO_PARAMS_SEPARATOR (',')
+
+#define MAX_MACRO_PARAMS (8) /* maximal number of parameters of a macro */
+#define MAX_MACRO_NESTING_DEPTH (16) /* maximal depth of macro calls inside macros, it stops recursive macros */
+#define MAX_MACRO_EXPANDED_LINES (1048576L) /* maximal number of lines of all the stored expansions of an input file */
+#define AVERAGE_LINE_SIZE_ESTIMATE (16L) /* bytes per line, to estimate the number of lines of an input file from its size */
+#define MIN_MACRO_DEFINITION_LINES (2L) /* the mcr and endmcr lines of a macro without content */
 
 #endif /* PRE_PROCESSOR_CONST_H */
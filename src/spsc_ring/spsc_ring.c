@@ -0,0 +1,152 @@
+/* *******************************************************************
+ * Authors: Daniel Oren, Elisheva Cirota
+ *
+ * @file spsc_ring.c
+ * @brief This file contains the implementation of the single-producer/single-consumer ring.
+ *
+ * The head and the tail only grow, an index is reduced to a slot with the mask of the capacity.
+ * Each of them is on a cache line of its own, with the copy of the other index its thread saw
+ * last, so a thread reads the index of the other thread only when the copy says the ring is
+ * full (or empty).
+ *********************************************************************/
+#define _POSIX_C_SOURCE 200809L /* for nanosleep and sched_yield */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sched.h>
+#include <time.h>
+
+#include "spsc_ring.h"
+#include "../logger/logger.h"
+#include "../general_const/general_const.h"
+#include "../stats/stats.h"
+
+#define CACHE_LINE_SIZE (64)
+#define SPSC_RING_SPINS (64) /* waits that only spin */
+#define SPSC_RING_YIELDS (1024) /* waits that yield the processor, then the waits sleep */
+#define SPSC_RING_SLEEP_NSEC (50000L)
+
+struct spsc_ring
+{
+	void **slots;
+	size_t mask; /* the capacity minus one */
+	char pad_producer[CACHE_LINE_SIZE];
+	size_t tail; /* index of the next push, written by the producer */
+	size_t head_seen; /* the head the producer read last */
+	char pad_consumer[CACHE_LINE_SIZE];
+	size_t head; /* index of the next pop, written by the consumer */
+	size_t tail_seen; /* the tail the consumer read last */
+	char pad_end[CACHE_LINE_SIZE];
+};
+
+/* =========================== internal functions declarations ================== */
+void _spsc_ring_wait(unsigned long *num_waits);
+
+/* =========================== internal functions implementations ================= */
+
+void _spsc_ring_wait(unsigned long *num_waits)
+{
+	struct timespec sleep_time;
+
+	if (*num_waits >= SPSC_RING_YIELDS)
+	{
+		sleep_time.tv_sec = 0;
+		sleep_time.tv_nsec = SPSC_RING_SLEEP_NSEC;
+		nanosleep(&sleep_time, NULL);
+	}
+	else if (*num_waits >= SPSC_RING_SPINS)
+	{
+		sched_yield();
+	}
+	++*num_waits;
+}
+
+/*=============================================================================== */
+
+spsc_ring_t *spsc_ring_create(size_t capacity)
+{
+	spsc_ring_t *ring = (spsc_ring_t *)stats_calloc(1, sizeof(spsc_ring_t));
+	size_t num_slots = 1;
+
+	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(ring, "Memory allocation failed in spsc_ring_create", NULL);
+	while (num_slots < capacity)
+	{
+		num_slots *= 2;
+	}
+	ring->slots = (void **)stats_malloc(num_slots * sizeof(void *));
+	if (ring->slots == NULL)
+	{
+		LOG(ERROR, PARAMS, "Memory allocation failed in spsc_ring_create");
+		free(ring);
+		return NULL;
+	}
+	ring->mask = num_slots - 1;
+	return ring;
+}
+
+void spsc_ring_free(spsc_ring_t *ring)
+{
+	if (ring != NULL)
+	{
+		free(ring->slots);
+		free(ring);
+	}
+}
+
+int spsc_ring_try_push(spsc_ring_t *ring, void *item)
+{
+	size_t tail = ring->tail;
+
+	if (tail - ring->head_seen > ring->mask)
+	{
+		/* the slot is released only after the consumer read its item */
+		ring->head_seen = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+		if (tail - ring->head_seen > ring->mask)
+		{
+			return FALSE;
+		}
+	}
+	ring->slots[tail & ring->mask] = item;
+	__atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+	return TRUE;
+}
+
+int spsc_ring_try_pop(spsc_ring_t *ring, void **item)
+{
+	size_t head = ring->head;
+
+	if (head == ring->tail_seen)
+	{
+		/* the item is visible once its tail is */
+		ring->tail_seen = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+		if (head == ring->tail_seen)
+		{
+			return FALSE;
+		}
+	}
+	*item = ring->slots[head & ring->mask];
+	__atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+	return TRUE;
+}
+
+void spsc_ring_push(spsc_ring_t *ring, void *item)
+{
+	unsigned long num_waits = 0;
+
+	while (!spsc_ring_try_push(ring, item))
+	{
+		_spsc_ring_wait(&num_waits);
+	}
+}
+
+void *spsc_ring_pop(spsc_ring_t *ring)
+{
+	unsigned long num_waits = 0;
+	void *item = NULL;
+
+	while (!spsc_ring_try_pop(ring, &item))
+	{
+		_spsc_ring_wait(&num_waits);
+	}
+	return item;
+}
@@ -0,0 +1,73 @@
+/* *******************************************************************
+ * Authors: Daniel Oren, Elisheva Cirota
+ *
+ * @file spsc_ring.h
+ * @brief This file contains the declarations of a lock-free single-producer/single-consumer ring.
+ *
+ * The ring passes pointers from one thread, the producer, to another thread, the consumer, in
+ * the order they were pushed. Only the producer moves the tail and only the consumer moves the
+ * head, so pushing and popping need no lock: an item is published by a release store of the
+ * tail, and a slot is given back by a release store of the head.
+ *
+ * The blocking calls spin for a while, then yield the processor and at last sleep, so a thread
+ * that waits for a slow stage doesn't keep a core busy.
+ *
+ *********************************************************************/
+
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stdlib.h>
+
+typedef struct spsc_ring spsc_ring_t;
+
+/**
+ * Creates an empty ring.
+ *
+ * @param capacity The maximal number of items in the ring, it is rounded up to a power of two.
+ * @return A pointer to the new ring, or NULL on memory allocation failure.
+ */
+spsc_ring_t *spsc_ring_create(size_t capacity);
+
+/**
+ * Frees a ring. The items that are still in it are not freed.
+ *
+ * @param ring The ring to free.
+ */
+void spsc_ring_free(spsc_ring_t *ring);
+
+/**
+ * Adds an item to the ring, if it is not full. Called only by the producer.
+ *
+ * @param ring The ring.
+ * @param item The item to add.
+ * @return TRUE if the item was added, FALSE if the ring is full.
+ */
+int spsc_ring_try_push(spsc_ring_t *ring, void *item);
+
+/**
+ * Removes the oldest item of the ring, if it is not empty. Called only by the consumer.
+ *
+ * @param ring The ring.
+ * @param item Set to the removed item.
+ * @return TRUE if an item was removed, FALSE if the ring is empty.
+ */
+int spsc_ring_try_pop(spsc_ring_t *ring, void **item);
+
+/**
+ * Adds an item to the ring, waits while the ring is full. Called only by the producer.
+ *
+ * @param ring The ring.
+ * @param item The item to add.
+ */
+void spsc_ring_push(spsc_ring_t *ring, void *item);
+
+/**
+ * Removes the oldest item of the ring, waits while the ring is empty. Called only by the consumer.
+ *
+ * @param ring The ring.
+ * @return The removed item.
+ */
+void *spsc_ring_pop(spsc_ring_t *ring);
+
+#endif /* SPSC_RING_H */
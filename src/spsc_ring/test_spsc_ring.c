@@ -0,0 +1,91 @@
+/* *******************************************************************
+ * Authors: Daniel Oren, Elisheva Cirota
+ *
+ * @file  test_spsc_ring.c
+ * @brief This file contains the tests of the single-producer/single-consumer ring.
+ *
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "spsc_ring.h"
+#include "../general_const/general_const.h"
+#include "../utils/utils.h"
+
+#define TEST_SPSC_RING_CAPACITY (6)
+#define TEST_SPSC_RING_SLOTS (8) /* the capacity rounded up to a power of two */
+#define TEST_SPSC_RING_NUM_ITEMS (1000000)
+
+/* the items are the numbers 1...n, kept in the pointers */
+#define TEST_SPSC_RING_ITEM(i) ((void *)(size_t)(i))
+
+void *_test_spsc_ring_producer(void *arg)
+{
+	spsc_ring_t *ring = (spsc_ring_t *)arg;
+	size_t i = 0;
+
+	for (i = 1; i <= TEST_SPSC_RING_NUM_ITEMS; ++i)
+	{
+		spsc_ring_push(ring, TEST_SPSC_RING_ITEM(i));
+	}
+	return NULL;
+}
+
+void test_spsc_ring()
+{
+	spsc_ring_t *ring = spsc_ring_create(TEST_SPSC_RING_CAPACITY);
+	pthread_t producer;
+	void *item = NULL;
+	int is_ok = TRUE;
+	size_t i = 0;
+
+	if (ring == NULL)
+	{
+		printf("FAILURE, spsc_ring_create\n");
+		return;
+	}
+
+	/* one thread: the ring holds exactly its capacity */
+	for (i = 1; i <= TEST_SPSC_RING_SLOTS; ++i)
+	{
+		is_ok &= spsc_ring_try_push(ring, TEST_SPSC_RING_ITEM(i));
+	}
+	is_ok &= !spsc_ring_try_push(ring, TEST_SPSC_RING_ITEM(TEST_SPSC_RING_SLOTS + 1));
+	for (i = 1; i <= TEST_SPSC_RING_SLOTS; ++i)
+	{
+		is_ok &= spsc_ring_try_pop(ring, &item) && item == TEST_SPSC_RING_ITEM(i);
+	}
+	is_ok &= !spsc_ring_try_pop(ring, &item);
+	if (!is_ok)
+	{
+		printf("FAILURE, test_spsc_ring one thread\n");
+		spsc_ring_free(ring);
+		return;
+	}
+
+	/* two threads, through a ring that is full most of the time: every item arrives once, in order */
+	if (pthread_create(&producer, NULL, _test_spsc_ring_producer, ring) != 0)
+	{
+		printf("FAILURE, pthread_create\n");
+		spsc_ring_free(ring);
+		return;
+	}
+	for (i = 1; i <= TEST_SPSC_RING_NUM_ITEMS; ++i)
+	{
+		is_ok &= spsc_ring_pop(ring) == TEST_SPSC_RING_ITEM(i);
+	}
+	pthread_join(producer, NULL);
+	is_ok &= !spsc_ring_try_pop(ring, &item);
+
+	spsc_ring_free(ring);
+	printf("%s, test_spsc_ring\n", is_ok ? "SUCCESS" : "FAILURE");
+}
+
+/* uncomment this line to run test_spsc_ring */
+/*int main()
+{
+	test_spsc_ring();
+	return SUCCESS;
+}*/
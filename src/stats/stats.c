@@ -0,0 +1,348 @@
+/* *******************************************************************
+ * Authors: Daniel Oren, Elisheva Cirota
+ *
+ * @file stats.c
+ * @brief This file contains the implementation of the stats module.
+ *
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "stats.h"
+#include "../utils/utils.h"
+#include "../logger/logger.h"
+#include "../general_const/general_const.h"
+
+#define INITIAL_FILES_CAPACITY (10)
+#define USEC_IN_MSEC (1000.0)
+
+/* all stats collected for one input file */
+typedef struct stats_file
+{
+	char *file_name;
+	double timers[MAX_STATS_TIMER]; /* elapsed time of each stage, in microseconds */
+	double timers_start[MAX_STATS_TIMER]; /* start time of a running stage, in microseconds */
+	unsigned long counters[MAX_STATS_COUNTER];
+	HashTableStats hash_tables[MAX_STATS_HASH_TABLE];
+	int has_hash_tables; /* whether the statistics of the hash tables were set */
+} stats_file_t;
+
+/* the stats of the whole process */
+typedef struct stats_data
+{
+	stats_mode_t mode;
+	stats_file_t *files; /* array of the stats of every input file */
+	int num_files;
+	int capacity;
+	stats_file_t *current_file; /* the file that is being processed now, NULL between files */
+	stats_file_t outside_files; /* counters that were added while no file was processed */
+} stats_data_t;
+
+static stats_data_t g_stats = {STATS_MODE__OFF, NULL, 0, 0, NULL};
+
+static const char *STATS_TIMERS_NAMES[MAX_STATS_TIMER] = {
+	"pre_process", "first_pass", "second_pass", "obj_file", "ent_file", "ext_file"};
+
+static const char *STATS_COUNTERS_NAMES[MAX_STATS_COUNTER] = {
+	"lines_empty", "lines_comment", "lines_directive", "lines_instruction", "lines_const_define", "lines_unknown",
+	"macro_expansions", "macro_lines_reused", "macro_expansions_cached", "hash_inserts", "hash_lookups", "hash_probes", "queue_resizes", "deque_blocks", "malloc_calls", "malloc_bytes"};
+
+static const char *STATS_HASH_TABLES_NAMES[MAX_STATS_HASH_TABLE] = {"symbol_table", "macro_table"};
+
+/* =========================== internal functions declarations ================== */
+void _stats_sum_files(stats_file_t *aggregate);
+void _stats_print_table_file(FILE *output_file, const stats_file_t *stats_file);
+void _stats_print_json_file(FILE *output_file, const stats_file_t *stats_file);
+void _stats_print_json_string(FILE *output_file, const char *str);
+void _stats_print_table_hash_tables(FILE *output_file, const stats_file_t *stats_file);
+void _stats_print_json_hash_tables(FILE *output_file, const stats_file_t *stats_file);
+
+/* =========================== internal functions implementations ================= */
+
+void _stats_sum_files(stats_file_t *aggregate)
+{
+	int i, j;
+
+	memcpy(aggregate, &g_stats.outside_files, sizeof(stats_file_t));
+	aggregate->file_name = "aggregate";
+	for (i = 0; i < g_stats.num_files; ++i)
+	{
+		for (j = 0; j < MAX_STATS_TIMER; ++j)
+		{
+			aggregate->timers[j] += g_stats.files[i].timers[j];
+		}
+		for (j = 0; j < MAX_STATS_COUNTER; ++j)
+		{
+			aggregate->counters[j] += g_stats.files[i].counters[j];
+		}
+	}
+}
+
+void _stats_print_table_file(FILE *output_file, const stats_file_t *stats_file)
+{
+	int i;
+
+	fprintf(output_file, "%s\n", LOG_SEPARATOR);
+	fprintf(output_file, "%-24s %s\n", "file", stats_file->file_name);
+	fprintf(output_file, "%s\n", LOG_SEPARATOR);
+	for (i = 0; i < MAX_STATS_TIMER; ++i)
+	{
+		fprintf(output_file, "%-24s %.3f ms\n", STATS_TIMERS_NAMES[i], stats_file->timers[i] / USEC_IN_MSEC);
+	}
+	for (i = 0; i < MAX_STATS_COUNTER; ++i)
+	{
+		fprintf(output_file, "%-24s %lu\n", STATS_COUNTERS_NAMES[i], stats_file->counters[i]);
+	}
+}
+
+void _stats_print_table_hash_tables(FILE *output_file, const stats_file_t *stats_file)
+{
+	const HashTableStats *table_stats = NULL;
+	int i;
+
+	if (!stats_file->has_hash_tables)
+	{
+		return;
+	}
+	for (i = 0; i < MAX_STATS_HASH_TABLE; ++i)
+	{
+		table_stats = &stats_file->hash_tables[i];
+		fprintf(output_file, "%-24s size %lu, capacity %lu, used_buckets %lu, longest_chain %lu, average_probe %.2f, resizes %lu, hits %lu, misses %lu\n",
+				STATS_HASH_TABLES_NAMES[i], (unsigned long)table_stats->size, (unsigned long)table_stats->capacity,
+				(unsigned long)table_stats->used_buckets, (unsigned long)table_stats->longest_chain, table_stats->average_probe_length,
+				(unsigned long)table_stats->num_resizes, table_stats->lookup_hits, table_stats->lookup_misses);
+	}
+}
+
+void _stats_print_json_hash_tables(FILE *output_file, const stats_file_t *stats_file)
+{
+	const HashTableStats *table_stats = NULL;
+	int i;
+
+	if (!stats_file->has_hash_tables)
+	{
+		return;
+	}
+	fprintf(output_file, ", \"hash_tables\": {");
+	for (i = 0; i < MAX_STATS_HASH_TABLE; ++i)
+	{
+		table_stats = &stats_file->hash_tables[i];
+		fprintf(output_file, "%s\"%s\": {\"size\": %lu, \"capacity\": %lu, \"used_buckets\": %lu, \"longest_chain\": %lu, \"average_probe\": %.3f, \"resizes\": %lu, \"hits\": %lu, \"misses\": %lu}",
+				i == 0 ? "" : ", ", STATS_HASH_TABLES_NAMES[i], (unsigned long)table_stats->size, (unsigned long)table_stats->capacity,
+				(unsigned long)table_stats->used_buckets, (unsigned long)table_stats->longest_chain, table_stats->average_probe_length,
+				(unsigned long)table_stats->num_resizes, table_stats->lookup_hits, table_stats->lookup_misses);
+	}
+	fprintf(output_file, "}");
+}
+
+void _stats_print_json_string(FILE *output_file, const char *str)
+{
+	fputc('"', output_file);
+	for (; *str != NULL_TERMINATOR; ++str)
+	{
+		if (*str == '"' || *str == '\\')
+		{
+			fputc('\\', output_file);
+		}
+		fputc(*str, output_file);
+	}
+	fputc('"', output_file);
+}
+
+void _stats_print_json_file(FILE *output_file, const stats_file_t *stats_file)
+{
+	int i;
+
+	fprintf(output_file, "{\"name\": ");
+	_stats_print_json_string(output_file, stats_file->file_name);
+	fprintf(output_file, ", \"timers_ms\": {");
+	for (i = 0; i < MAX_STATS_TIMER; ++i)
+	{
+		fprintf(output_file, "%s\"%s\": %.3f", i == 0 ? "" : ", ", STATS_TIMERS_NAMES[i], stats_file->timers[i] / USEC_IN_MSEC);
+	}
+	fprintf(output_file, "}, \"counters\": {");
+	for (i = 0; i < MAX_STATS_COUNTER; ++i)
+	{
+		fprintf(output_file, "%s\"%s\": %lu", i == 0 ? "" : ", ", STATS_COUNTERS_NAMES[i], stats_file->counters[i]);
+	}
+	fprintf(output_file, "}");
+	_stats_print_json_hash_tables(output_file, stats_file);
+	fprintf(output_file, "}");
+}
+
+/*=============================================================================== */
+
+void stats_set_mode(stats_mode_t mode)
+{
+	g_stats.mode = mode;
+}
+
+stats_mode_t stats_get_mode()
+{
+	return g_stats.mode;
+}
+
+int stats_begin_file(const char *file_name)
+{
+	stats_file_t *new_files = NULL;
+	int new_capacity = 0;
+
+	if (g_stats.mode == STATS_MODE__OFF)
+	{
+		return SUCCESS;
+	}
+
+	if (g_stats.num_files == g_stats.capacity)
+	{
+		new_capacity = g_stats.capacity == 0 ? INITIAL_FILES_CAPACITY : g_stats.capacity * 2;
+		new_files = (stats_file_t *)realloc(g_stats.files, new_capacity * sizeof(stats_file_t));
+		CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(new_files, "Memory allocation failed in stats_begin_file", FUNC_ERR);
+		g_stats.files = new_files;
+		g_stats.capacity = new_capacity;
+	}
+
+	g_stats.current_file = &g_stats.files[g_stats.num_files];
+	memset(g_stats.current_file, 0, sizeof(stats_file_t));
+	g_stats.current_file->file_name = str_dup(file_name);
+	if (g_stats.current_file->file_name == NULL)
+	{
+		LOG(ERROR, PARAMS, "Memory allocation failed in stats_begin_file for file_name");
+		g_stats.current_file = NULL;
+		return FUNC_ERR;
+	}
+	++g_stats.num_files;
+	return SUCCESS;
+}
+
+void stats_end_file()
+{
+	g_stats.current_file = NULL;
+}
+
+void stats_add(stats_counter_t counter, unsigned long value)
+{
+	if (g_stats.mode == STATS_MODE__OFF)
+	{
+		return;
+	}
+	if (g_stats.current_file != NULL)
+	{
+		g_stats.current_file->counters[counter] += value;
+	}
+	else
+	{
+		g_stats.outside_files.counters[counter] += value;
+	}
+}
+
+unsigned long stats_get_counter(stats_counter_t counter)
+{
+	return g_stats.current_file != NULL ? g_stats.current_file->counters[counter] : g_stats.outside_files.counters[counter];
+}
+
+void stats_timer_start(stats_timer_t timer)
+{
+	if (g_stats.mode == STATS_MODE__OFF || g_stats.current_file == NULL)
+	{
+		return;
+	}
+	g_stats.current_file->timers_start[timer] = get_monotonic_time_usec();
+}
+
+void stats_timer_stop(stats_timer_t timer)
+{
+	if (g_stats.mode == STATS_MODE__OFF || g_stats.current_file == NULL)
+	{
+		return;
+	}
+	g_stats.current_file->timers[timer] += get_monotonic_time_usec() - g_stats.current_file->timers_start[timer];
+}
+
+void stats_set_hash_table(stats_hash_table_t table, const HashTableStats *table_stats)
+{
+	if (g_stats.mode == STATS_MODE__OFF || g_stats.current_file == NULL)
+	{
+		return;
+	}
+	g_stats.current_file->hash_tables[table] = *table_stats;
+	g_stats.current_file->has_hash_tables = TRUE;
+}
+
+const char *stats_timer_name(stats_timer_t timer)
+{
+	return STATS_TIMERS_NAMES[timer];
+}
+
+void stats_print(FILE *output_file)
+{
+	int i;
+	stats_file_t aggregate;
+
+	if (g_stats.mode == STATS_MODE__OFF)
+	{
+		return;
+	}
+	_stats_sum_files(&aggregate);
+
+	if (g_stats.mode == STATS_MODE__JSON)
+	{
+		fprintf(output_file, "{\"files\": [");
+		for (i = 0; i < g_stats.num_files; ++i)
+		{
+			fprintf(output_file, "%s", i == 0 ? "" : ", ");
+			_stats_print_json_file(output_file, &g_stats.files[i]);
+		}
+		fprintf(output_file, "], \"aggregate\": ");
+		_stats_print_json_file(output_file, &aggregate);
+		fprintf(output_file, "}\n");
+		return;
+	}
+
+	for (i = 0; i < g_stats.num_files; ++i)
+	{
+		_stats_print_table_file(output_file, &g_stats.files[i]);
+		if (g_stats.mode == STATS_MODE__VERBOSE)
+		{
+			_stats_print_table_hash_tables(output_file, &g_stats.files[i]);
+		}
+	}
+	_stats_print_table_file(output_file, &aggregate);
+}
+
+void stats_free()
+{
+	int i;
+
+	for (i = 0; i < g_stats.num_files; ++i)
+	{
+		free(g_stats.files[i].file_name);
+	}
+	free(g_stats.files);
+	g_stats.files = NULL;
+	g_stats.num_files = 0;
+	g_stats.capacity = 0;
+	g_stats.current_file = NULL;
+}
+
+void *stats_malloc(size_t size)
+{
+	stats_add(STATS_COUNTER__MALLOC_CALLS, 1);
+	stats_add(STATS_COUNTER__MALLOC_BYTES, size);
+	return malloc(size);
+}
+
+void *stats_calloc(size_t num_elements, size_t element_size)
+{
+	stats_add(STATS_COUNTER__MALLOC_CALLS, 1);
+	stats_add(STATS_COUNTER__MALLOC_BYTES, num_elements * element_size);
+	return calloc(num_elements, element_size);
+}
+
+void *stats_realloc(void *ptr, size_t size)
+{
+	stats_add(STATS_COUNTER__MALLOC_CALLS, 1);
+	stats_add(STATS_COUNTER__MALLOC_BYTES, size);
+	return realloc(ptr, size);
+}
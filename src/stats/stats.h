@@ -0,0 +1,171 @@
+/* *******************************************************************
+ * Authors: Daniel Oren, Elisheva Cirota
+ *
+ * @file stats.h
+ * @brief This file contains the declarations of the stats module.
+ *
+ * The stats module collects per file timers and counters of the assembler
+ * process (time spent in every stage, lines by type, hash table and queue
+ * activity, memory allocations) and prints them when the user asked for it
+ * with the --stats flag.
+ *
+ *********************************************************************/
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../hash_table/hash_table.h"
+
+/* possible output modes of the collected stats */
+typedef enum stats_mode
+{
+	STATS_MODE__OFF, /* stats are not collected at all */
+	STATS_MODE__TABLE, /* human readable table, --stats */
+	STATS_MODE__JSON, /* machine readable output, --stats=json */
+	STATS_MODE__VERBOSE /* human readable table with the statistics of the hash tables, --stats=verbose */
+} stats_mode_t;
+
+/* timed stages of the assembler process */
+typedef enum stats_timer
+{
+	STATS_TIMER__PRE_PROCESS,
+	STATS_TIMER__FIRST_PASS,
+	STATS_TIMER__SECOND_PASS,
+	STATS_TIMER__OBJ_FILE,
+	STATS_TIMER__ENT_FILE,
+	STATS_TIMER__EXT_FILE,
+	MAX_STATS_TIMER
+} stats_timer_t;
+
+/* counted events of the assembler process */
+typedef enum stats_counter
+{
+	/* the line counters must keep the order of line_type_t,
+	 * so a line type can be counted with STATS_COUNTER__LINE_EMPTY + line_type */
+	STATS_COUNTER__LINE_EMPTY,
+	STATS_COUNTER__LINE_COMMENT,
+	STATS_COUNTER__LINE_DIRECTIVE,
+	STATS_COUNTER__LINE_INSTRUCTION,
+	STATS_COUNTER__LINE_CONST_DEFINE,
+	STATS_COUNTER__LINE_UNKNOWN,
+	STATS_COUNTER__MACRO_EXPANSIONS,
+	STATS_COUNTER__MACRO_LINES_REUSED,
+	STATS_COUNTER__MACRO_EXPANSIONS_CACHED,
+	STATS_COUNTER__HASH_INSERTS,
+	STATS_COUNTER__HASH_LOOKUPS,
+	STATS_COUNTER__HASH_PROBES,
+	STATS_COUNTER__QUEUE_RESIZES,
+	STATS_COUNTER__DEQUE_BLOCKS,
+	STATS_COUNTER__MALLOC_CALLS,
+	STATS_COUNTER__MALLOC_BYTES,
+	MAX_STATS_COUNTER
+} stats_counter_t;
+
+/* hash tables whose statistics are kept for every file */
+typedef enum stats_hash_table
+{
+	STATS_HASH_TABLE__SYMBOLS,
+	STATS_HASH_TABLE__MACROS,
+	MAX_STATS_HASH_TABLE
+} stats_hash_table_t;
+
+/**
+ * Sets the mode of the stats module. Must be called before the first input file is processed.
+ * When the mode is STATS_MODE__OFF (the default) all the other functions return immediately.
+ *
+ * @param mode The requested stats mode.
+ */
+void stats_set_mode(stats_mode_t mode);
+
+/**
+ * Returns the mode of the stats module.
+ *
+ * @return The current stats mode.
+ */
+stats_mode_t stats_get_mode();
+
+/**
+ * Starts collecting stats for a new input file.
+ * Counters that are added while no file is active are counted only in the aggregate.
+ *
+ * @param file_name The name of the input file.
+ * @return SUCCESS, or FUNC_ERR if memory allocation failed.
+ */
+int stats_begin_file(const char *file_name);
+
+/**
+ * Stops collecting stats for the current input file.
+ */
+void stats_end_file();
+
+/**
+ * Adds a value to a counter of the current file.
+ *
+ * @param counter The counter to update.
+ * @param value The value to add.
+ */
+void stats_add(stats_counter_t counter, unsigned long value);
+
+/**
+ * Returns a counter of the current file, or of the work outside the files when no file is assembled.
+ *
+ * @param counter The counter to return.
+ * @return The value of the counter, it grows only while the stats are on.
+ */
+unsigned long stats_get_counter(stats_counter_t counter);
+
+/**
+ * Starts measuring a stage of the current file with the monotonic clock.
+ *
+ * @param timer The measured stage.
+ */
+void stats_timer_start(stats_timer_t timer);
+
+/**
+ * Stops measuring a stage of the current file and adds the elapsed time to it.
+ *
+ * @param timer The measured stage.
+ */
+void stats_timer_stop(stats_timer_t timer);
+
+/**
+ * Keeps the statistics of a hash table of the current file, they are printed in the JSON and the verbose modes.
+ * Should be called once the file is assembled, before the table is cleared.
+ *
+ * @param table The hash table the statistics belong to.
+ * @param table_stats The statistics, from hash_table_get_stats.
+ */
+void stats_set_hash_table(stats_hash_table_t table, const HashTableStats *table_stats);
+
+/**
+ * Returns the name of a timed stage, as it is printed by stats_print.
+ *
+ * @param timer The timed stage.
+ * @return The name of the stage.
+ */
+const char *stats_timer_name(stats_timer_t timer);
+
+/**
+ * Prints the per file and the aggregate stats in the format of the current mode.
+ *
+ * @param output_file The stream to print to.
+ */
+void stats_print(FILE *output_file);
+
+/**
+ * Frees all the collected stats.
+ */
+void stats_free();
+
+/**
+ * Wrappers for malloc, calloc and realloc which count the number of calls and the allocated bytes.
+ * They behave exactly like the functions they wrap.
+ */
+void *stats_malloc(size_t size);
+void *stats_calloc(size_t num_elements, size_t element_size);
+void *stats_realloc(void *ptr, size_t size);
+
+#endif /* STATS_H */
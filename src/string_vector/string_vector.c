@@ -13,19 +13,20 @@
 #include "string_vector.h"
 #include "../logger/logger.h"
 #include "../general_const/general_const.h"
+#include "../stats/stats.h"
 #include "../utils/utils.h"
 
 #define INITIAL_CAPACITY 10
 
 StringVector *string_vector_create()
 {
-    StringVector *vec = (StringVector *)malloc(sizeof(StringVector));
+    StringVector *vec = (StringVector *)stats_malloc(sizeof(StringVector));
     if (vec == NULL)
     {
         LOG(ERROR, PARAMS, "Memory allocation failed in string_vector_create for vec");
         return NULL;
     }
-    vec->data = malloc(INITIAL_CAPACITY * sizeof(char *));
+    vec->data = stats_malloc(INITIAL_CAPACITY * sizeof(char *));
     memset(vec->data, 0, INITIAL_CAPACITY * sizeof(char *));
     if (vec->data == NULL)
     {
@@ -35,20 +36,30 @@ StringVector *string_vector_create()
     }
     vec->size = 0;
     vec->capacity = INITIAL_CAPACITY;
+    vec->num_bytes = 0;
+    vec->max_bytes = 0;
+    vec->num_dropped = 0;
     return vec;
 }
 
 int string_vector_push_back(StringVector *vec, const char *str)
 {
     size_t new_capacity;
+    size_t str_bytes = strlen(str) + 1 + sizeof(char *);
     char *new_str = NULL;
     char **new_data = NULL;
 
+    if (vec->max_bytes != 0 && vec->size > 0 && vec->num_bytes + str_bytes > vec->max_bytes)
+    {
+        ++vec->num_dropped;
+        return SUCCESS;
+    }
+
     if (vec->size == vec->capacity)
     {
         /* Need to reallocate memory */
         new_capacity = vec->capacity * 2;
-        new_data = realloc(vec->data, new_capacity * sizeof(char *));
+        new_data = stats_realloc(vec->data, new_capacity * sizeof(char *));
         if (new_data == NULL)
         {
             LOG(ERROR, PARAMS, "Memory reallocation failed in string_vector_push_back");
@@ -67,6 +78,7 @@ int string_vector_push_back(StringVector *vec, const char *str)
     }
     vec->data[vec->size] = new_str;
     vec->size++;
+    vec->num_bytes += str_bytes;
     return SUCCESS;
 }
 const char *string_vector_at(StringVector *vec, size_t index)
@@ -122,4 +134,21 @@ void string_vector_clear(StringVector *vec)
         vec->data[i] = NULL;
     }
     vec->size = 0;
+    vec->num_bytes = 0;
+    vec->num_dropped = 0;
+}
+
+void string_vector_set_max_bytes(StringVector *vec, size_t max_bytes)
+{
+    vec->max_bytes = max_bytes;
+}
+
+size_t string_vector_get_num_bytes(const StringVector *vec)
+{
+    return vec->num_bytes;
+}
+
+int string_vector_get_num_dropped(const StringVector *vec)
+{
+    return vec->num_dropped;
 }
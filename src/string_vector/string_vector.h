@@ -9,11 +9,16 @@
 #ifndef STRING_VECTOR_H
 #define STRING_VECTOR_H
 
+#include <stdlib.h>
+
 /* Structure representing a vector of strings */
 typedef struct {
     int size;
     int capacity;
     char **data;
+    size_t num_bytes; /* bytes of the strings and their pointers */
+    size_t max_bytes; /* strings that would pass this are dropped, 0 for no limit */
+    int num_dropped; /* number of strings dropped since the vector was created or cleared */
 
 } StringVector;
 
@@ -68,6 +73,29 @@ int string_vector_get_capacity(StringVector* vec);
 */
 void string_vector_print_vector(StringVector* vec);
 
+/* limit the bytes the strings of the vector may take, a string that would pass the limit is counted
+   and dropped instead of added. The first string is always added, so a vector with dropped strings is never empty.
+   Parameters:
+   vec: Pointer to the StringVector
+   max_bytes: The limit, 0 for no limit
+   Complexity: O(1)
+*/
+void string_vector_set_max_bytes(StringVector *vec, size_t max_bytes);
+
+/* return the bytes taken by the strings of the vector
+   Parameters:
+   vec: Pointer to the StringVector
+   Complexity: O(1)
+*/
+size_t string_vector_get_num_bytes(const StringVector *vec);
+
+/* return the number of strings that were dropped since the vector was created or cleared, see string_vector_set_max_bytes
+   Parameters:
+   vec: Pointer to the StringVector
+   Complexity: O(1)
+*/
+int string_vector_get_num_dropped(const StringVector *vec);
+
 /**
  * Clears all elements from the StringVector.
  *
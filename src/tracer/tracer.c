@@ -0,0 +1,251 @@
+/* *******************************************************************
+ * Authors: Daniel Oren, Elisheva Cirota
+ *
+ * @file tracer.c
+ * @brief This file contains the implementation of the tracer module.
+ *
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "tracer.h"
+#include "../utils/utils.h"
+#include "../logger/logger.h"
+#include "../general_const/general_const.h"
+
+#define INITIAL_EVENTS_CAPACITY (64)
+#define MAIN_THREAD_ID (1)
+#define TRACE_PHASE_BEGIN ('B')
+#define TRACE_PHASE_END ('E')
+
+/* one recorded begin/end event */
+typedef struct trace_event
+{
+	char *name;
+	const char *category;
+	char phase;
+	double timestamp; /* microseconds since tracer_enable */
+} trace_event_t;
+
+/* the events recorded by one thread, buffers of all threads are kept in a linked list */
+typedef struct tracer_buffer
+{
+	int thread_id;
+	trace_event_t *events;
+	int size;
+	int capacity;
+	struct tracer_buffer *next;
+} tracer_buffer_t;
+
+typedef struct tracer_data
+{
+	char *output_file_name;
+	double start_time;
+	tracer_buffer_t *buffers; /* list of the buffers of all threads */
+	tracer_buffer_t *main_buffer; /* buffer of the main thread */
+	int last_thread_id; /* id of the last thread that got a buffer */
+	pthread_key_t buffer_key; /* the buffer of every thread, so recording needs no locking */
+	pthread_mutex_t buffers_mutex; /* protects buffers and last_thread_id */
+} tracer_data_t;
+
+int tracer_enabled = FALSE;
+static tracer_data_t g_tracer = {NULL, 0, NULL, NULL, 0};
+
+/* =========================== internal functions declarations ================== */
+tracer_buffer_t *_tracer_create_buffer();
+tracer_buffer_t *_tracer_get_thread_buffer();
+void _tracer_add_event(const char *name, const char *category, char phase);
+void _tracer_write_json_string(FILE *output_file, const char *str);
+
+/* =========================== internal functions implementations ================= */
+
+tracer_buffer_t *_tracer_create_buffer()
+{
+	tracer_buffer_t *buffer = (tracer_buffer_t *)malloc(sizeof(tracer_buffer_t));
+	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(buffer, "Memory allocation failed in _tracer_create_buffer", NULL);
+
+	buffer->events = (trace_event_t *)malloc(INITIAL_EVENTS_CAPACITY * sizeof(trace_event_t));
+	if (buffer->events == NULL)
+	{
+		LOG(ERROR, PARAMS, "Memory allocation failed in _tracer_create_buffer for events");
+		free(buffer);
+		return NULL;
+	}
+	buffer->size = 0;
+	buffer->capacity = INITIAL_EVENTS_CAPACITY;
+
+	pthread_mutex_lock(&g_tracer.buffers_mutex);
+	buffer->thread_id = ++g_tracer.last_thread_id;
+	buffer->next = g_tracer.buffers;
+	g_tracer.buffers = buffer;
+	pthread_mutex_unlock(&g_tracer.buffers_mutex);
+
+	pthread_setspecific(g_tracer.buffer_key, buffer);
+	return buffer;
+}
+
+tracer_buffer_t *_tracer_get_thread_buffer()
+{
+	tracer_buffer_t *buffer = (tracer_buffer_t *)pthread_getspecific(g_tracer.buffer_key);
+
+	if (buffer == NULL)
+	{
+		/* first span of this thread */
+		buffer = _tracer_create_buffer();
+	}
+	return buffer;
+}
+
+void _tracer_add_event(const char *name, const char *category, char phase)
+{
+	tracer_buffer_t *buffer = _tracer_get_thread_buffer();
+	trace_event_t *new_events = NULL;
+	trace_event_t *event = NULL;
+
+	if (buffer == NULL)
+	{
+		return;
+	}
+	if (buffer->size == buffer->capacity)
+	{
+		new_events = (trace_event_t *)realloc(buffer->events, buffer->capacity * 2 * sizeof(trace_event_t));
+		if (new_events == NULL)
+		{
+			/* losing a span is better than failing the assembler */
+			LOG(ERROR, PARAMS, "Memory allocation failed in _tracer_add_event, span is dropped");
+			return;
+		}
+		buffer->events = new_events;
+		buffer->capacity *= 2;
+	}
+
+	event = &buffer->events[buffer->size];
+	event->name = str_dup(name);
+	if (event->name == NULL)
+	{
+		LOG(ERROR, PARAMS, "Memory allocation failed in _tracer_add_event for name, span is dropped");
+		return;
+	}
+	event->category = category;
+	event->phase = phase;
+	event->timestamp = get_monotonic_time_usec() - g_tracer.start_time;
+	++buffer->size;
+}
+
+void _tracer_write_json_string(FILE *output_file, const char *str)
+{
+	fputc('"', output_file);
+	for (; *str != NULL_TERMINATOR; ++str)
+	{
+		if (*str == '"' || *str == '\\')
+		{
+			fputc('\\', output_file);
+		}
+		fputc(*str, output_file);
+	}
+	fputc('"', output_file);
+}
+
+/*=============================================================================== */
+
+int tracer_enable(const char *output_file_name)
+{
+	g_tracer.output_file_name = str_dup(output_file_name);
+	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(g_tracer.output_file_name, "Memory allocation failed in tracer_enable", FUNC_ERR);
+
+	if (pthread_key_create(&g_tracer.buffer_key, NULL) != SUCCESS || pthread_mutex_init(&g_tracer.buffers_mutex, NULL) != SUCCESS)
+	{
+		LOG(ERROR, PARAMS, "failed to create the thread buffers key in tracer_enable");
+		return FUNC_ERR;
+	}
+	g_tracer.last_thread_id = MAIN_THREAD_ID - 1;
+	g_tracer.main_buffer = _tracer_create_buffer();
+	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(g_tracer.main_buffer, "Failed to create the main thread buffer in tracer_enable", FUNC_ERR);
+
+	g_tracer.start_time = get_monotonic_time_usec();
+	tracer_enabled = TRUE;
+	return SUCCESS;
+}
+
+void tracer_begin(const char *name, const char *category)
+{
+	_tracer_add_event(name, category, TRACE_PHASE_BEGIN);
+}
+
+void tracer_end(const char *name, const char *category)
+{
+	_tracer_add_event(name, category, TRACE_PHASE_END);
+}
+
+int tracer_write()
+{
+	FILE *output_file = NULL;
+	tracer_buffer_t *buffer = NULL;
+	trace_event_t *event = NULL;
+	int is_first_event = TRUE;
+	int i = 0;
+
+	if (!tracer_enabled)
+	{
+		return SUCCESS;
+	}
+
+	output_file = fopen(g_tracer.output_file_name, "w");
+	if (output_file == NULL)
+	{
+		LOG(ERROR, PARAMS, "Error opening trace file %s", g_tracer.output_file_name);
+		return FUNC_ERR;
+	}
+
+	fprintf(output_file, "{\"traceEvents\": [\n");
+	for (buffer = g_tracer.buffers; buffer != NULL; buffer = buffer->next)
+	{
+		for (i = 0; i < buffer->size; ++i)
+		{
+			event = &buffer->events[i];
+			fprintf(output_file, "%s{\"name\": ", is_first_event ? "" : ",\n");
+			_tracer_write_json_string(output_file, event->name);
+			fprintf(output_file, ", \"cat\": \"%s\", \"ph\": \"%c\", \"ts\": %.3f, \"pid\": 1, \"tid\": %d}",
+					event->category, event->phase, event->timestamp, buffer->thread_id);
+			is_first_event = FALSE;
+		}
+	}
+	fprintf(output_file, "\n], \"displayTimeUnit\": \"ms\"}\n");
+
+	fclose(output_file);
+	return SUCCESS;
+}
+
+void tracer_free()
+{
+	tracer_buffer_t *buffer = g_tracer.buffers;
+	tracer_buffer_t *next = NULL;
+	int i = 0;
+
+	if (!tracer_enabled)
+	{
+		return;
+	}
+	while (buffer != NULL)
+	{
+		next = buffer->next;
+		for (i = 0; i < buffer->size; ++i)
+		{
+			free(buffer->events[i].name);
+		}
+		free(buffer->events);
+		free(buffer);
+		buffer = next;
+	}
+	free(g_tracer.output_file_name);
+	pthread_key_delete(g_tracer.buffer_key);
+	pthread_mutex_destroy(&g_tracer.buffers_mutex);
+
+	g_tracer.output_file_name = NULL;
+	g_tracer.buffers = NULL;
+	g_tracer.main_buffer = NULL;
+	tracer_enabled = FALSE;
+}
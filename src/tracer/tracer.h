@@ -0,0 +1,78 @@
+/* *******************************************************************
+ * Authors: Daniel Oren, Elisheva Cirota
+ *
+ * @file tracer.h
+ * @brief This file contains the declarations of the tracer module.
+ *
+ * The tracer records begin/end spans of the input files and of the stages of
+ * the assembler, and writes them at exit as a Chrome trace_event JSON file
+ * (can be opened with chrome://tracing or https://ui.perfetto.dev).
+ * The tracer is always compiled in, but when it is disabled every span costs
+ * a single branch, see TRACE_BEGIN and TRACE_END.
+ *
+ *********************************************************************/
+
+#ifndef TRACER_H
+#define TRACER_H
+
+#define TRACE_CATEGORY_FILE ("file")
+#define TRACE_CATEGORY_STAGE ("stage")
+
+/* TRUE when spans should be recorded, set by tracer_enable. */
+extern int tracer_enabled;
+
+/* Records the beginning of a span, only when the tracer is enabled. */
+#define TRACE_BEGIN(name, category) \
+	do { \
+		if (tracer_enabled) { \
+			tracer_begin(name, category); \
+		} \
+	} while (0)
+
+/* Records the end of the last span that began, only when the tracer is enabled. */
+#define TRACE_END(name, category) \
+	do { \
+		if (tracer_enabled) { \
+			tracer_end(name, category); \
+		} \
+	} while (0)
+
+/**
+ * Enables the tracer. The recorded spans are written to output_file_name by tracer_write.
+ *
+ * @param output_file_name The name of the trace file to create.
+ * @return SUCCESS, or FUNC_ERR if memory allocation failed.
+ */
+int tracer_enable(const char *output_file_name);
+
+/**
+ * Records the beginning of a span in the buffer of the calling thread.
+ * Prefer TRACE_BEGIN, which does not call this function when the tracer is disabled.
+ *
+ * @param name The name of the span, copied by the tracer.
+ * @param category The category of the span, must be a string literal.
+ */
+void tracer_begin(const char *name, const char *category);
+
+/**
+ * Records the end of a span in the buffer of the calling thread.
+ * Prefer TRACE_END, which does not call this function when the tracer is disabled.
+ *
+ * @param name The name of the span, copied by the tracer.
+ * @param category The category of the span, must be a string literal.
+ */
+void tracer_end(const char *name, const char *category);
+
+/**
+ * Writes all the recorded spans of all threads to the trace file given to tracer_enable.
+ *
+ * @return SUCCESS, or FUNC_ERR if the file could not be written.
+ */
+int tracer_write();
+
+/**
+ * Frees all the memory of the tracer and disables it.
+ */
+void tracer_free();
+
+#endif /* TRACER_H */
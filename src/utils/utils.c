@@ -5,12 +5,15 @@
  * @brief This file contains utility functions declarations.
  * 
  *********************************************************************/
+#define _POSIX_C_SOURCE 199309L /* for clock_gettime */
+
 #include <stdlib.h>
 #include <string.h>
 #include <limits.h>
 #include <stdio.h>
 #include <ctype.h>
 #include <unistd.h>
+#include <time.h>
 
 
 #include "utils.h"
@@ -18,11 +21,48 @@
 #include "../string_vector/string_vector.h"
 #include "../logger/logger.h"
 #include "../general_const/general_const.h"
+#include "../stats/stats.h"
+
+#define SPC (CHAR_CLASS__SPACE)
+#define DIG (CHAR_CLASS__DIGIT)
+#define ALP (CHAR_CLASS__ALPHA)
+#define FNV_OFFSET_BASIS (2166136261UL)
+#define FNV_PRIME (16777619UL)
+#define FNV_MASK32 (0xFFFFFFFFUL)
+
+const unsigned char char_class_table[256] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, SPC, SPC, SPC, SPC, SPC, 0, 0,		  /* 0x00 - 0x0f, '\t' to '\r' */
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,					  /* 0x10 - 0x1f */
+	SPC, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,				  /* 0x20 - 0x2f, ' ' */
+	DIG, DIG, DIG, DIG, DIG, DIG, DIG, DIG, DIG, DIG, 0, 0, 0, 0, 0, 0, /* 0x30 - 0x3f, '0' to '9' */
+	0, ALP, ALP, ALP, ALP, ALP, ALP, ALP, ALP, ALP, ALP, ALP, ALP, ALP, ALP, ALP, /* 0x40 - 0x4f, 'A' to 'O' */
+	ALP, ALP, ALP, ALP, ALP, ALP, ALP, ALP, ALP, ALP, ALP, 0, 0, 0, 0, 0, /* 0x50 - 0x5f, 'P' to 'Z' */
+	0, ALP, ALP, ALP, ALP, ALP, ALP, ALP, ALP, ALP, ALP, ALP, ALP, ALP, ALP, ALP, /* 0x60 - 0x6f, 'a' to 'o' */
+	ALP, ALP, ALP, ALP, ALP, ALP, ALP, ALP, ALP, ALP, ALP, 0, 0, 0, 0, 0, /* 0x70 - 0x7f, 'p' to 'z' */
+	0 /* 0x80 - 0xff, the rest are zeros */
+};
+
+#undef SPC
+#undef DIG
+#undef ALP
+
+/* SWAR (SIMD within a register) helpers, for scanning a string a word at a time */
+#define SWAR_ONES (~0UL / UCHAR_MAX)			  /* 0x0101...01 */
+#define SWAR_HIGHS (SWAR_ONES << (CHAR_BIT - 1)) /* 0x8080...80 */
+#define SWAR_LOWS (~SWAR_HIGHS)				  /* 0x7f7f...7f */
+/* non zero if the word has a byte smaller than n, for n up to 128. Used as a filter, it may find a false byte above the first real one */
+#define SWAR_HAS_BYTE_LESS_THAN(word, n) (((word) - SWAR_ONES * (n)) & ~(word) & SWAR_HIGHS)
+#define SWAR_HAS_ZERO_BYTE(word) SWAR_HAS_BYTE_LESS_THAN(word, 1)
+/* the high bit of exactly the zero bytes of the word is set */
+#define SWAR_ZERO_BYTES(word) (~((((word) & SWAR_LOWS) + SWAR_LOWS) | (word) | SWAR_LOWS))
+/* the number of the bytes of a SWAR_ZERO_BYTES result, summed into its top byte */
+#define SWAR_COUNT_BYTES(bytes) ((((bytes) >> (CHAR_BIT - 1)) * SWAR_ONES) >> ((sizeof(unsigned long) - 1) * CHAR_BIT))
+#define IS_WORD_ALIGNED(ptr) (((size_t)(ptr) % sizeof(unsigned long)) == 0)
 
 char *str_dup(const char *s)
 {
 	size_t len = strlen(s) + 1;
-	char *dup = malloc(len);
+	char *dup = stats_malloc(len);
 	if (dup != NULL)
 	{
 		strcpy(dup, s);
@@ -57,14 +97,26 @@ short set_bits_short(short num, short value_to_set_at_specific_bits, short num_b
 
 short string_to_short(const char *str, int *error)
 {
-	long num;
-	char *end;
+	long num = 0;
+	int is_negative = FALSE;
+	int is_overflow = FALSE;
+	const char *end = NULL;
 
-	num = strtol(str, &end, 10); /* Base 10 for decimal numbers */
+	while (IS_SPACE_CHAR(*str))
+	{
+		++str;
+	}
+	is_negative = *str == '-';
+	if (*str == '-' || *str == '+')
+	{
+		++str;
+	}
+	end = scan_decimal_digits(str, -(long)SHRT_MIN, &num, &is_overflow);
+	num = is_negative ? -num : num;
 
 	/* Check for conversion errors: no digits were found,
 	   remaining characters after number, or value out of short range */
-	if (end == str || *end != '\0' || num > SHRT_MAX || num < SHRT_MIN)
+	if (end == str || *end != '\0' || is_overflow || num > SHRT_MAX || num < SHRT_MIN)
 	{
 		*error = ERR;
 		return 0; /* Return value is irrelevant when error is indicated */
@@ -76,8 +128,10 @@ short string_to_short(const char *str, int *error)
 
 void get_output_file_name(const char *input_file_name, char *output_file_name, const char *postfix)
 {
+	/* only a dot of the last path component starts an extension, the directories may have dots too */
 	const char *dot_position = strrchr(input_file_name, '.');
-	if (dot_position != NULL)
+	const char *slash_position = strrchr(input_file_name, '/');
+	if (dot_position != NULL && (slash_position == NULL || dot_position > slash_position))
 	{
 		size_t length = dot_position - input_file_name;
 		strncpy(output_file_name, input_file_name, length);
@@ -144,20 +198,140 @@ int compare_files(FILE *file1, FILE *file2, int should_close_files)
     return ret_val;
 }
 
-int count_commas(const char *line)
+int count_char(const char *str, char c)
 {
-    int count = 0;
-    /* Iterate through each character in the line */
-    while (*line != NULL_TERMINATOR)
+	unsigned long pattern = SWAR_ONES * (unsigned char)c;
+	unsigned long word = 0;
+	int count = 0;
+
+	/* char by char up to a word boundary, so that the word reads never cross a page */
+	for (; !IS_WORD_ALIGNED(str); ++str)
 	{
-        /*  If the character is a comma, increment the count */
-        if (*line == ',') {
-            count++;
-        }
-        /* Move to the next character */
-        line++;
-    }
-    return count;
+		if (*str == NULL_TERMINATOR)
+		{
+			return count;
+		}
+		count += *str == c;
+	}
+
+	for (;; str += sizeof(unsigned long))
+	{
+		memcpy(&word, str, sizeof(unsigned long));
+		if (SWAR_HAS_ZERO_BYTE(word))
+		{
+			break;
+		}
+		count += SWAR_COUNT_BYTES(SWAR_ZERO_BYTES(word ^ pattern));
+	}
+
+	for (; *str != NULL_TERMINATOR; ++str)
+	{
+		count += *str == c;
+	}
+	return count;
+}
+
+const char *find_char(const char *str, char c)
+{
+	unsigned long pattern = SWAR_ONES * (unsigned char)c;
+	unsigned long word = 0;
+
+	for (; !IS_WORD_ALIGNED(str); ++str)
+	{
+		if (*str == c || *str == NULL_TERMINATOR)
+		{
+			return str;
+		}
+	}
+
+	for (;; str += sizeof(unsigned long))
+	{
+		memcpy(&word, str, sizeof(unsigned long));
+		if (SWAR_HAS_ZERO_BYTE(word) || SWAR_HAS_ZERO_BYTE(word ^ pattern))
+		{
+			break;
+		}
+	}
+
+	for (; *str != c && *str != NULL_TERMINATOR; ++str)
+		;
+	return str;
+}
+
+const char *find_space_char(const char *str)
+{
+	unsigned long word = 0;
+
+	for (; !IS_WORD_ALIGNED(str); ++str)
+	{
+		if (IS_SPACE_CHAR(*str) || *str == NULL_TERMINATOR)
+		{
+			return str;
+		}
+	}
+
+	/* the whitespaces and the null terminator are all below '!', skip the words without such a byte */
+	for (;; str += sizeof(unsigned long))
+	{
+		memcpy(&word, str, sizeof(unsigned long));
+		if (SWAR_HAS_BYTE_LESS_THAN(word, ' ' + 1))
+		{
+			break;
+		}
+	}
+
+	for (; !IS_SPACE_CHAR(*str) && *str != NULL_TERMINATOR; ++str)
+		;
+	return str;
+}
+
+int label_char_span(const char *str)
+{
+	const char *runner = str;
+
+	while (IS_LABEL_CHAR(*runner))
+	{
+		++runner;
+	}
+	return runner - str;
+}
+
+const char *scan_decimal_digits(const char *str, long limit, long *value, int *is_overflow)
+{
+	unsigned int digit = 0;
+
+	*value = 0;
+	*is_overflow = FALSE;
+	/* a char is a digit when its distance from '0' is at most 9, the unsigned cast catches the chars below '0' */
+	for (; (digit = (unsigned int)(*str - '0')) <= 9; ++str)
+	{
+		if (*value > limit / 10 || (*value == limit / 10 && (long)digit > limit % 10))
+		{
+			*value = limit;
+			*is_overflow = TRUE;
+		}
+		else if (!*is_overflow)
+		{
+			*value = *value * 10 + digit;
+		}
+	}
+	return str;
+}
+
+unsigned long fnv1a_hash(const char *str)
+{
+	unsigned long hash = FNV_OFFSET_BASIS;
+
+	for (; *str != NULL_TERMINATOR; ++str)
+	{
+		hash = ((hash ^ (unsigned char)*str) * FNV_PRIME) & FNV_MASK32;
+	}
+	return hash;
+}
+
+int count_commas(const char *line)
+{
+	return count_char(line, ',');
 }
 
 
@@ -165,7 +339,7 @@ int skip_whitespace(char **line, int line_count ,StringVector *error_founds)
 {
 	char log_error[MAX_LINE_SIZE];
 	int index = 0;
-	for (; isspace((*line)[index]); index++)
+	for (; IS_SPACE_CHAR((*line)[index]); index++)
 	{
 		if ((*line)[index] == NEWLINE_CHARACTER)
 		{
@@ -207,3 +381,76 @@ int is_line_too_long(char *line, int line_count, StringVector *warning_founds)
 
 	return SUCCESS;
 }
+
+
+int read_file_to_buffer(const char *file_name, char **buffer, size_t *size)
+{
+	FILE *file = fopen(file_name, "rb");
+	long file_size = 0;
+
+	*buffer = NULL;
+	*size = 0;
+	if (file == NULL)
+	{
+		return USER_ERR;
+	}
+
+	if (fseek(file, 0, SEEK_END) != SUCCESS || (file_size = ftell(file)) < 0 || fseek(file, 0, SEEK_SET) != SUCCESS)
+	{
+		LOG(ERROR, PARAMS, "failed to get the size of file %s", file_name);
+		fclose(file);
+		return FUNC_ERR;
+	}
+
+	*buffer = (char *)stats_malloc(file_size + 1);
+	if (*buffer == NULL)
+	{
+		LOG(ERROR, PARAMS, "Memory allocation failed in read_file_to_buffer");
+		fclose(file);
+		return FUNC_ERR;
+	}
+
+	*size = fread(*buffer, 1, file_size, file);
+	(*buffer)[*size] = NULL_TERMINATOR;
+	fclose(file);
+	return SUCCESS;
+}
+
+int read_stream_to_buffer(FILE *stream, char **buffer, size_t *size)
+{
+	long stream_size = ftell(stream);
+
+	*buffer = NULL;
+	*size = 0;
+	if (stream_size < 0 || fseek(stream, 0, SEEK_SET) != SUCCESS)
+	{
+		LOG(ERROR, PARAMS, "failed to get the size of the stream");
+		return FUNC_ERR;
+	}
+
+	*buffer = (char *)stats_malloc(stream_size + 1);
+	CHECK_RET_VAL_PTR_AND_LOG_AND_RETURN(*buffer, "Memory allocation failed in read_stream_to_buffer", FUNC_ERR);
+
+	*size = fread(*buffer, 1, stream_size, stream);
+	(*buffer)[*size] = NULL_TERMINATOR;
+	if (*size != (size_t)stream_size)
+	{
+		LOG(ERROR, PARAMS, "failed to read the stream");
+		free(*buffer);
+		*buffer = NULL;
+		return FUNC_ERR;
+	}
+	return SUCCESS;
+}
+
+double get_monotonic_time_usec()
+{
+	struct timespec now;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &now) != SUCCESS)
+	{
+		LOG(ERROR, PARAMS, "clock_gettime failed");
+		return 0;
+	}
+	return now.tv_sec * 1000000.0 + now.tv_nsec / 1000.0;
+}
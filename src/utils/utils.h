@@ -18,6 +18,21 @@ enum msg_type
     MSG_TYPE__WARNING
 };
 
+/* the classes of char_class_table, a char may belong to none of them */
+#define CHAR_CLASS__SPACE (1) /* ' ', '\t', '\n', '\v', '\f' and '\r', like isspace in the "C" locale */
+#define CHAR_CLASS__DIGIT (2)
+#define CHAR_CLASS__ALPHA (4)
+
+/* Locale free replacements of isspace, isdigit, isalpha and isalnum, one table load each.
+ * Unlike the ctype functions, they accept a negative char. */
+#define IS_SPACE_CHAR(c) (char_class_table[(unsigned char)(c)] & CHAR_CLASS__SPACE)
+#define IS_DIGIT_CHAR(c) (char_class_table[(unsigned char)(c)] & CHAR_CLASS__DIGIT)
+#define IS_ALPHA_CHAR(c) (char_class_table[(unsigned char)(c)] & CHAR_CLASS__ALPHA)
+#define IS_LABEL_CHAR(c) (char_class_table[(unsigned char)(c)] & (CHAR_CLASS__ALPHA | CHAR_CLASS__DIGIT))
+
+/* the classes of every char, indexed by the char as an unsigned char */
+extern const unsigned char char_class_table[256];
+
 /** @brief Duplicates a string.
  *  Allocates memory, copies content, returns pointer. Frees memory later.
  *  @param src The source string to duplicate.
@@ -72,8 +87,8 @@ short set_bits_short(short num, short value_to_set_at_specific_bits, short num_b
  * @param error Set to 1 on error (invalid input, out of range), 0 otherwise.
  * @return The converted value on success, 0 on error.
  *
- * Uses strtol to ensure validity and range. Checks for extra characters and
- * handles conversion errors by setting *error accordingly.
+ * Accepts the same text as strtol in base 10: leading whitespaces, an optional sign and digits.
+ * Checks for extra characters and handles conversion errors by setting *error accordingly.
  */
 short string_to_short(const char *str, int *error);
 
@@ -81,6 +96,7 @@ short string_to_short(const char *str, int *error);
  * @brief Generates the output file name by appending a postfix to the input file name.
  *
  * This function takes the input file name and appends a postfix to it to generate the output file name.
+ * An extension of the last path component is replaced, the dots of the directories are kept.
  *
  * @param input_file_name The name of the input file.
  * @param output_file_name The buffer to store the generated output file name.
@@ -119,6 +135,63 @@ int compare_files(FILE *file1, FILE *file2, int should_close_files);
  */
 int count_commas(const char *line);
 
+/**
+ * Counts the occurrences of a char in a string.
+ *
+ * The string is scanned a word (sizeof(unsigned long) chars) at a time. The word reads are
+ * aligned, so they never cross into a page that the string doesn't reach.
+ *
+ * @param str The string to count in.
+ * @param c The char to count, not the null terminator.
+ * @return The number of occurrences of c in the string.
+ */
+int count_char(const char *str, char c);
+
+/**
+ * Finds the first occurrence of a char in a string, a word at a time (see count_char).
+ *
+ * @param str The string to search.
+ * @param c The char to find.
+ * @return A pointer to the first occurrence of c, or to the null terminator if c is not in the string.
+ */
+const char *find_char(const char *str, char c);
+
+/**
+ * Finds the first whitespace char (IS_SPACE_CHAR) in a string, a word at a time (see count_char).
+ *
+ * @param str The string to search.
+ * @return A pointer to the first whitespace char, or to the null terminator if there is none.
+ */
+const char *find_space_char(const char *str);
+
+/**
+ * Returns the number of chars at the beginning of a string that may be a part of a label name,
+ * letters and digits.
+ *
+ * @param str The string to scan.
+ * @return The length of the span of letters and digits.
+ */
+int label_char_span(const char *str);
+
+/**
+ * Parses the decimal digits at the beginning of a string, without a sign.
+ *
+ * @param str The string to parse.
+ * @param limit The biggest value that may be parsed.
+ * @param value Set to the parsed value, 0 when there are no digits, or limit when is_overflow is set.
+ * @param is_overflow Set to TRUE if the digits are bigger than limit, FALSE otherwise.
+ * @return A pointer to the first char after the digits.
+ */
+const char *scan_decimal_digits(const char *str, long limit, long *value, int *is_overflow);
+
+/**
+ * Hashes a string with the 32 bit FNV-1a hash.
+ *
+ * @param str The string to hash.
+ * @return The hash of the string.
+ */
+unsigned long fnv1a_hash(const char *str);
+
 /**
  * Skips whitespace characters in a string.
  *
@@ -144,4 +217,40 @@ int skip_whitespace(char **line, int line_count ,StringVector *error_founds);
  */
 int is_line_too_long(char *line, int line_count, StringVector *warning_founds);
 
+/**
+ * Reads the whole content of a file into a newly allocated buffer.
+ *
+ * The buffer is null terminated (the terminator is not counted in size), so text files
+ * can be used as strings. The caller is responsible to free the buffer.
+ *
+ * @param file_name The name of the file to read.
+ * @param buffer Set to the allocated buffer.
+ * @param size Set to the number of bytes read.
+ * @return SUCCESS, USER_ERR if the file could not be opened, or FUNC_ERR if reading or memory allocation failed.
+ */
+int read_file_to_buffer(const char *file_name, char **buffer, size_t *size);
+
+/**
+ * Reads a seekable stream, from its beginning to its current position, into a newly allocated buffer.
+ *
+ * Used to read back what was written to a temporary file. The buffer is null terminated
+ * (the terminator is not counted in size). The caller is responsible to free the buffer.
+ *
+ * @param stream The stream to read.
+ * @param buffer Set to the allocated buffer.
+ * @param size Set to the number of bytes read.
+ * @return SUCCESS, or FUNC_ERR if reading or memory allocation failed.
+ */
+int read_stream_to_buffer(FILE *stream, char **buffer, size_t *size);
+
+/**
+ * Returns the current time of the monotonic clock.
+ *
+ * The returned value is meaningful only when compared to another value returned by this function,
+ * for example to measure the time a stage of the assembler took.
+ *
+ * @return The current monotonic time in microseconds, or 0 if the clock could not be read.
+ */
+double get_monotonic_time_usec();
+
 #endif /* UTILS_H */
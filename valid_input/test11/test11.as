@@ -0,0 +1,29 @@
+; macro parameters, nested calls and stored expansions
+mcr m_move src, dst
+	mov src, dst
+endmcr
+mcr m_twice val
+	m_move val, r1
+	m_move val, r2
+endmcr
+mcr m_plain
+	inc r3
+endmcr
+mcr m_word S
+	prn S
+	prn STR
+endmcr
+mcr m_str src
+	.string "src"
+endmcr
+MAIN:	mov r1, r2
+	m_move #3, r1
+	m_twice #5
+	m_twice #5
+	m_twice STR
+	m_plain
+	m_plain
+	m_word #7
+	hlt
+	m_str r1
+STR: .string "src"
@@ -0,0 +1,18 @@
+; constant expressions
+.define N = 3
+.define M = 2+3*4
+.define P = (2+3)*4
+.define Q = -7/2
+.define R = -7%2
+.define S = 1<<4|N
+.define T = 100>>2&15
+.define U = -(N+1)
+.define V = N
+MAIN:	mov #N*2+1, ARR[N-1]
+	prn #-(M-P)
+	prn #Q
+	cmp #R, #S
+	prn #T
+	prn #U
+	hlt
+ARR: .data M, P, Q, R, S, T, U, V, 1+1